@@ -12,7 +12,7 @@
 #include <practical/practical.h>
 
 namespace Tokenizer {
-    struct Token;
+    class TokenRef;
 }
 
 namespace PracticalSemanticAnalyzer {
@@ -103,22 +103,22 @@ public:
 
 class CannotTakeValueOfFunction : public compile_error {
 public:
-    CannotTakeValueOfFunction(const Tokenizer::Token *identifier);
+    CannotTakeValueOfFunction(const Tokenizer::TokenRef &identifier);
 };
 
 class TryToCallNonCallable : public compile_error {
 public:
-    TryToCallNonCallable(const Tokenizer::Token *identifier);
+    TryToCallNonCallable(const Tokenizer::TokenRef &identifier);
 };
 
 class NoMatchingOverload : public compile_error {
 public:
-    NoMatchingOverload(const Tokenizer::Token *identifier);
+    NoMatchingOverload(const Tokenizer::TokenRef &identifier);
 };
 
 class AmbiguousOverloads : public compile_error {
 public:
-    AmbiguousOverloads(const Tokenizer::Token *identifier);
+    AmbiguousOverloads(const Tokenizer::TokenRef &identifier);
 };
 
 class CastError : public compile_error {
@@ -167,6 +167,13 @@ public:
     {}
 };
 
+class NestingTooDeep : public compile_error {
+public:
+    NestingTooDeep( const SourceLocation &location ) :
+        compile_error( "Expressions or statements nested too deeply", location )
+    {}
+};
+
 class CircularDependency : public compile_error {
 public:
     CircularDependency( const SourceLocation &location ) :
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <variant>
+#include <vector>
 
 // An unsigned int type long enough to be castable to any int type without losing precision
 using LongEnoughInt = std::uintmax_t;
@@ -34,6 +35,30 @@ DECL_TYPED_NS( PracticalSemanticAnalyzer, JumpPointId, unsigned long, 0, Practic
 namespace PracticalSemanticAnalyzer {
     class CompilerArguments {
     public:
+        // Number of threads used to tokenize the source file. 0 means one per CPU core
+        unsigned tokenizerThreads = 1;
+        // Remember the results of rules the parser backtracked over, so that no rule is parsed twice at the same place
+        bool parserMemoization = true;
+        // Number of parts the module's global definitions are split into, to be parsed in parallel. 0 means one per CPU
+        // core. The parts are parsed by a pool of threads shared by all compilations.
+        unsigned parserThreads = 1;
+        // Only find where function bodies end when parsing the module. Each body is parsed when it is first needed, so
+        // syntax errors inside bodies are reported after those found outside of them. If there are errors outside of
+        // bodies and maxErrors asks for more than one, all bodies are parsed to report the same errors an eager parse
+        // would.
+        bool lazyFunctionBodies = false;
+        static constexpr size_t DefaultMaxNestingDepth = 1000;
+        // How deeply expressions and statements may nest. Deeper source is a compile error, rather than a stack overflow
+        size_t maxNestingDepth = DefaultMaxNestingDepth;
+        // How many syntax errors to report when compile is given a diagnostics list. Past the first error, the parser
+        // skips to the end of the failed statement or definition and carries on looking for more.
+        size_t maxErrors = 20;
+        // Trace the parser, keeping its last parserTraceRecords steps. 0 disables tracing. A traced module is parsed on
+        // a single thread.
+        size_t parserTraceRecords = 0;
+        // Directory in which to keep parsed modules, so that an unchanged source is not parsed again. Empty disables the
+        // cache.
+        std::string parseTreeCache;
     };
 
     struct SourceLocation {
@@ -56,13 +81,19 @@ namespace PracticalSemanticAnalyzer {
         }
     };
 
+    struct Diagnostic {
+        SourceLocation location;
+        // Includes the location
+        std::string message;
+    };
+
     // Cookie type used by the backend to identify types. Backend can choose whether to use an integer or a pointer
     union TypeId {
         uintptr_t n;
         void *p;
     };
 
-    class StaticType : private NoCopy, public boost::intrusive_ref_counter<StaticType, boost::thread_unsafe_counter> {
+    class StaticType : private NoCopy, public boost::intrusive_ref_counter<StaticType, boost::thread_safe_counter> {
     public:
         using CPtr = boost::intrusive_ptr<const StaticType>;
 
@@ -190,6 +221,7 @@ namespace PracticalSemanticAnalyzer {
         static size_t ptrSize();
         static size_t ptrAlignment();
 
+        // Equal types are always the same instance, so this compares addresses
         bool operator==( const StaticType &rhs ) const;
         bool operator!=( const StaticType &rhs ) const {
             return ! (*this==rhs);
@@ -338,7 +370,10 @@ namespace PracticalSemanticAnalyzer {
     // Must be called exactly once, before starting actual compilation
     void prepare( BuiltinContextGen *ctxGen ); // This is the lookup context used for the builtin types
     // XXX Should path actually be a buffer?
-    int compile(std::string path, const CompilerArguments *arguments, ModuleGen *codeGen);
+    // Compile errors are thrown, unless diagnostics is given. They are then added to it, and their number is returned.
+    int compile(
+            std::string path, const CompilerArguments *arguments, ModuleGen *codeGen,
+            std::vector<Diagnostic> *diagnostics = nullptr);
 } // End namespace PracticalSemanticAnalyzer
 
 namespace std {
@@ -360,13 +395,7 @@ inline bool operator==(
         const PracticalSemanticAnalyzer::StaticType::CPtr &lhs,
         const PracticalSemanticAnalyzer::StaticType::CPtr &rhs )
 {
-    if( !lhs && !rhs )
-        return true;
-
-    if( !lhs || !rhs )
-        return false;
-
-    return *lhs==*rhs;
+    return lhs.get()==rhs.get();
 }
 
 inline bool operator!=(
@@ -9,6 +9,7 @@
 #ifndef PRACTICAL_TYPED_H
 #define PRACTICAL_TYPED_H
 
+#include <atomic>
 #include <cstddef>
 #include <functional>
 #include <iostream>
@@ -42,9 +43,10 @@ public:
         return val!=rhs.val;
     }
 
+    // Allocators are shared by all compilations, so allocating is atomic
     template <Type startValue = initValue>
     class Allocator {
-        Type index = startValue;
+        std::atomic<Type> index{ startValue };
 
     public:
         Typed allocate() {
@@ -15,10 +15,13 @@ namespace AST {
 
 class ArrayValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::Array;
+
     // TODO switch to sparse array?
     std::vector<ValueRangeBase::CPtr> elementsValueRange;
 
     explicit ArrayValueRange( ValueRangeBase::CPtr elementsDefaultRange, size_t numElements ) :
+        ValueRangeBase( StaticKind ),
         elementsValueRange( numElements, elementsDefaultRange )
     {}
 
@@ -27,6 +27,7 @@ bool AST::_prepared = false;
 // Public methods
 void AST::prepare( BuiltinContextGen *ctxGen ) {
     registerBuiltinTypes( ctxGen );
+    builtinCtx.precomputeCastPaths();
     _prepared = true;
 }
 
@@ -34,8 +35,17 @@ bool AST::prepared() {
     return _prepared;
 }
 
-void AST::codeGen( const NonTerminals::Module &parserModule, PracticalSemanticAnalyzer::ModuleGen *codeGen ) {
+void AST::codeGen(
+        const NonTerminals::Module &parserModule, PracticalSemanticAnalyzer::ModuleGen *codeGen,
+        const PracticalSemanticAnalyzer::CompilerArguments &arguments )
+{
     ASSERT( prepared() )<<"codegen called without calling prepare first";
+    // Limits both the expressions built below and the function bodies parsed while generating code
+    NonTerminals::NestingLimit nestingLimit( arguments.maxNestingDepth );
+    SymbolTable::Scope symbolScope( parserModule.symbols );
+    // The parse tree's nodes are resolved through the module's arena. Function bodies that were not parsed with the
+    // module are parsed into it.
+    NonTerminals::ParseArena::Scope arenaScope( parserModule.arena );
     module = new Module( parserModule, builtinCtx );
 
     module->symbolsPass1();
@@ -32,7 +32,9 @@ public:
         return builtinCtx;
     }
 
-    void codeGen(const NonTerminals::Module &module, PracticalSemanticAnalyzer::ModuleGen *codeGen);
+    void codeGen(
+            const NonTerminals::Module &module, PracticalSemanticAnalyzer::ModuleGen *codeGen,
+            const PracticalSemanticAnalyzer::CompilerArguments &arguments);
 
 private:
     static void registerBuiltinTypes( BuiltinContextGen *ctxGen );
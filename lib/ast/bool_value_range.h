@@ -18,10 +18,13 @@ namespace AST {
 
 class BoolValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::Bool;
+
     bool falseAllowed = true;
     bool trueAllowed = true;
 
     BoolValueRange( bool falseAllowed, bool trueAllowed ) :
+        ValueRangeBase( StaticKind ),
         falseAllowed(falseAllowed), trueAllowed(trueAllowed)
     {}
 
@@ -13,6 +13,8 @@
 
 #include <practical/errors.h>
 
+#include <algorithm>
+
 using namespace PracticalSemanticAnalyzer;
 
 namespace AST {
@@ -36,7 +38,7 @@ CastChain::CastChain(
         std::unique_ptr<CastChain> &&previousCast,
         const LookupContext::CastDescriptor &cast
     ) :
-        CastChain( std::move(previousCast), cast, { .type = cast.destType } )
+        CastChain( std::move(previousCast), cast, { .type = cast.destType, .valueRange = nullptr } )
 {}
 
 std::unique_ptr<CastChain> CastChain::allocate(
@@ -66,16 +68,60 @@ std::unique_ptr<CastChain> CastChain::allocate(
         }
     }
 
+    // A path's weight limit only prunes the search, so the cheapest path is the same whatever the limit is. That lets
+    // paths be searched in advance, or once for many casts.
+    const LookupContext::CastPath *path = &lookupContext.lookupCastPath( srcMetadata.type, destinationType );
+
+    if( path->steps.empty() ) {
+        // Had the search been limited, it would have stopped short of the farthest path and not known the
+        // destination is unreachable
+        if( weight+path->farthest > weightLimit )
+            throw ExpressionImpl::Base::ExpressionTooExpensive();
+
+        return nullptr;
+    }
+
+    if( weight+path->weight > weightLimit )
+        throw ExpressionImpl::Base::ExpressionTooExpensive();
+
+    if( path->ambiguous )
+        throw AmbiguousCast(srcMetadata.type, destinationType, implicit, location);
+
+    std::unique_ptr<CastChain> ret;
+    for( const auto &step : path->steps ) {
+        std::unique_ptr<CastChain> nextCast( new CastChain( std::move(ret), *step.cast, { .type = step.type, .valueRange = nullptr } ) );
+        ret = std::move( nextCast );
+    }
+
+    try {
+        ret->calcVrp( srcMetadata, implicit, location );
+    } catch( CastNotAllowed &ex ) {
+        return nullptr;
+    }
+
+    ASSERT( ret );
+
+    weight += path->weight;
+    return ret;
+}
+
+LookupContext::CastPath CastChain::findPath(
+        const LookupContext &lookupContext,
+        StaticTypeImpl::CPtr sourceType, StaticTypeImpl::CPtr destinationType )
+{
+    LookupContext::CastPath ret;
+
     std::unordered_map< StaticTypeImpl::CPtr, Junction > paths;
 
     std::vector< StaticTypeImpl::CPtr > pendingCandidates, candidates;
 
-    paths.emplace( srcMetadata.type, Junction{ .pathWeight = weight } );
-    pendingCandidates.push_back( srcMetadata.type );
+    paths.emplace( sourceType, Junction{} );
+    pendingCandidates.push_back( sourceType );
 
     std::vector< const Junction * > validPaths;
 
-    bool possiblyTooExpensive = false;
+    // Once the destination is found, only paths as cheap as it are of interest
+    Weight weightLimit = Weight::max();
 
     do {
         candidates = std::move( pendingCandidates );
@@ -84,10 +130,11 @@ std::unique_ptr<CastChain> CastChain::allocate(
         for( auto candidate : candidates ) {
             const Junction &path = paths.at( candidate );
 
-            if( path.pathWeight>weightLimit ) {
-                possiblyTooExpensive = true;
+            if( path.pathWeight>weightLimit )
                 continue;
-            }
+
+            if( path.pathWeight>ret.farthest )
+                ret.farthest = path.pathWeight;
 
             if( *candidate == *destinationType ) {
                 if( path.pathWeight < weightLimit ) {
@@ -108,44 +155,24 @@ std::unique_ptr<CastChain> CastChain::allocate(
         }
     } while(! pendingCandidates.empty());
 
-    if( validPaths.empty() ) {
-        if( possiblyTooExpensive )
-            throw ExpressionImpl::Base::ExpressionTooExpensive();
-
-        return nullptr;
-    }
+    if( validPaths.empty() )
+        return ret;
 
-    if( validPaths.size()>1 )
-        throw AmbiguousCast(srcMetadata.type, destinationType, implicit, location);
+    ret.weight = weightLimit;
+    ret.ambiguous = validPaths.size()>1;
 
     const Junction *currentJunction = validPaths[0];
-    std::unique_ptr<CastChain> ret( new CastChain( nullptr, *currentJunction->descriptor ) );
-    CastChain *currentChain = ret.get();
     StaticTypeImpl::CPtr currentType = destinationType;
-
-    goto skipAllocation;
-
     while( currentJunction->predecessor ) {
-        currentChain->previousCast = std::unique_ptr<CastChain>(
-                new CastChain(nullptr, *currentJunction->descriptor) );
-        currentChain = currentChain->previousCast.get();
-
-skipAllocation:
-        currentChain->metadata.type = currentType;
+        ret.steps.emplace_back( LookupContext::CastPath::Step{
+                .cast = currentJunction->descriptor,
+                .type = currentType } );
 
         currentType = currentJunction->predecessor;
         currentJunction = &paths.at(currentType);
     }
+    std::reverse( ret.steps.begin(), ret.steps.end() );
 
-    try {
-        ret->calcVrp( srcMetadata, implicit, location );
-    } catch( CastNotAllowed &ex ) {
-        return nullptr;
-    }
-
-    ASSERT( ret );
-
-    weight = weightLimit;
     return ret;
 }
 
@@ -206,12 +233,9 @@ static std::vector< StaticTypeImpl::CPtr > castCandidates(
         auto pathWeight = weight + Weight( candidates->weight );
         auto previousIter = paths.find( candidates->destType );
         if( previousIter!=paths.end() ) {
-            if( pathWeight > previousIter->second.pathWeight )
+            // Of equally cheap paths, the first one found is kept
+            if( pathWeight >= previousIter->second.pathWeight )
                 continue;
-            if( pathWeight == previousIter->second.pathWeight ) {
-                previousIter->second.multiplePaths = true;
-                continue;
-            }
 
             paths.erase( previousIter );
         } else {
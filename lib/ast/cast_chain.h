@@ -42,6 +42,11 @@ public:
             Weight &weight, Weight weightLimit,
             bool implicit, const SourceLocation &location );
 
+    // Search for the cheapest path of casts from sourceType to destinationType, regardless of weight limits
+    static LookupContext::CastPath findPath(
+            const LookupContext &lookupContext,
+            StaticTypeImpl::CPtr sourceType, StaticTypeImpl::CPtr destinationType );
+
     ExpressionId codeGen(
             PracticalSemanticAnalyzer::StaticType::CPtr sourceType, ExpressionId sourceExpression,
             PracticalSemanticAnalyzer::FunctionGen *functionGen
@@ -55,7 +60,6 @@ public:
         const LookupContext::CastDescriptor *descriptor = nullptr;
         StaticTypeImpl::CPtr predecessor;
         Weight pathWeight;
-        bool multiplePaths = false;
     };
 
 private:
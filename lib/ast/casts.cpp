@@ -58,12 +58,12 @@ ValueRangeBase::CPtr unsignedToSignedIdentityVrp(
             "VRP for unsigned->signed called on input of type "<<
             std::get<const StaticType::Scalar *>(sourceType->getType())->getType();
 
-    ASSERT( dynamic_cast<const UnsignedIntValueRange *>(inputRangeBase.get())!=nullptr );
+    ASSERT( inputRangeBase->is<UnsignedIntValueRange>() );
 
     auto inputRange = static_cast<const UnsignedIntValueRange *>(inputRangeBase.get());
 
     auto maximalRange = destType->defaultRange();
-    ASSERT( dynamic_cast<const SignedIntValueRange *>( maximalRange.get() )!=nullptr );
+    ASSERT( maximalRange->is<SignedIntValueRange>() );
 
     ASSERT(
             inputRange->maximum <=
@@ -96,12 +96,12 @@ ValueRangeBase::CPtr unsignedReductionVrp(
             "VRP for unsigned->signed called on input of type "<<
             std::get<const StaticType::Scalar *>(sourceType->getType())->getType();
 
-    ASSERT( dynamic_cast<const UnsignedIntValueRange *>(inputRangeBase.get())!=nullptr );
+    ASSERT( inputRangeBase->is<UnsignedIntValueRange>() );
 
     auto inputRange = static_cast<const UnsignedIntValueRange *>(inputRangeBase.get());
 
     auto maximalRange = destType->defaultRange();
-    ASSERT( dynamic_cast<const UnsignedIntValueRange *>( maximalRange.get() )!=nullptr );
+    ASSERT( maximalRange->is<UnsignedIntValueRange>() );
 
     if( inputRange->maximum > static_cast<const UnsignedIntValueRange *>(maximalRange.get())->maximum ) {
         // Values out of range
@@ -127,12 +127,12 @@ ValueRangeBase::CPtr signedReductionVrp(
             "VRP for signed->signed called on input of type "<<
             std::get<const StaticType::Scalar *>(sourceType->getType())->getType();
 
-    ASSERT( dynamic_cast<const SignedIntValueRange *>(inputRangeBase.get())!=nullptr );
+    ASSERT( inputRangeBase->is<SignedIntValueRange>() );
 
     auto inputRange = static_cast<const SignedIntValueRange *>(inputRangeBase.get());
 
     auto maximalRangeBase = destType->defaultRange();
-    ASSERT( dynamic_cast<const SignedIntValueRange *>( maximalRangeBase.get() )!=nullptr );
+    ASSERT( maximalRangeBase->is<SignedIntValueRange>() );
     auto maximalRange = static_cast<const SignedIntValueRange *>(maximalRangeBase.get());
 
     if(
@@ -163,12 +163,12 @@ ValueRangeBase::CPtr signed2UnsignedVrp(
             "VRP for signed->unsigned called on input of type "<<
             std::get<const StaticType::Scalar *>(sourceType->getType())->getType();
 
-    ASSERT( dynamic_cast<const SignedIntValueRange *>(inputRangeBase.get())!=nullptr );
+    ASSERT( inputRangeBase->is<SignedIntValueRange>() );
 
     auto inputRange = static_cast<const SignedIntValueRange *>(inputRangeBase.get());
 
     auto maximalRangeBase = destType->defaultRange();
-    ASSERT( dynamic_cast<const UnsignedIntValueRange *>( maximalRangeBase.get() )!=nullptr );
+    ASSERT( maximalRangeBase->is<UnsignedIntValueRange>() );
     auto maximalRange = static_cast<const UnsignedIntValueRange *>(maximalRangeBase.get());
 
     if(
@@ -198,12 +198,12 @@ ValueRangeBase::CPtr unsigned2SignedVrp(
             "VRP for unsigned->signed ("<<(*sourceType)<<" to "<<(*destType)<<") called on input of type "<<
             std::get<const StaticType::Scalar *>(sourceType->getType())->getType();
 
-    ASSERT( dynamic_cast<const UnsignedIntValueRange *>(inputRangeBase.get())!=nullptr );
+    ASSERT( inputRangeBase->is<UnsignedIntValueRange>() );
 
     auto inputRange = static_cast<const UnsignedIntValueRange *>(inputRangeBase.get());
 
     auto maximalRangeBase = destType->defaultRange();
-    ASSERT( dynamic_cast<const SignedIntValueRange *>( maximalRangeBase.get() )!=nullptr );
+    ASSERT( maximalRangeBase->is<SignedIntValueRange>() );
     auto maximalRange = static_cast<const SignedIntValueRange *>(maximalRangeBase.get());
 
     if(
@@ -13,7 +13,7 @@
 namespace AST {
 
 ConditionalStatement::ConditionalStatement( const NonTerminals::Statement::ConditionalStatement &parserCondition ) :
-    condition( parserCondition.condition )
+    condition( *parserCondition.condition )
 {
     ASSERT( parserCondition.ifClause );
     ifClause = safenew<Statement>( *parserCondition.ifClause );
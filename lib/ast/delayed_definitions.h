@@ -56,7 +56,6 @@ using ReverseDependencies =
     std::unordered_map<PracticalSemanticAnalyzer::StaticType::Types, ReverseDependency>;
 
 struct DelayedDefinitions {
-    std::vector< StructTypeImpl * > hashless;
     ReadyTypes ready;
     PendingTypes pending;
     ReverseDependencies reverseDependencies;
@@ -17,104 +17,284 @@
 #include "ast/expression/literal.h"
 #include "ast/expression/unary_op.h"
 
+#include "operators.h"
+
+#include <practical/errors.h>
+
 using namespace PracticalSemanticAnalyzer;
 
 namespace AST {
 
-Expression::Expression( const NonTerminals::Expression &parserExpression ) :
-    parserExpression( parserExpression )
+// An operand of a chain of operators, built before the operator using it
+struct BuiltOperand : private NoCopy {
+    const NonTerminals::Expression *parserExpression = nullptr;
+    std::unique_ptr<ExpressionImpl::Base> expression;
+    Weight weight;
+    // The operands of the chain inside expression, innermost first
+    std::vector<Expression *> chain;
+    // The operator's argument that took the operand over
+    Expression *adoptedBy = nullptr;
+
+    ~BuiltOperand() {
+        Expression::freeChain( chain );
+    }
+};
+
+namespace {
+
+// The operand the operator being built on this thread takes rather than building it
+thread_local BuiltOperand *builtOperand = nullptr;
+
+class OfferOperand : private NoCopy {
+    BuiltOperand *previous;
+
+public:
+    explicit OfferOperand( BuiltOperand &operand ) : previous( builtOperand ) {
+        builtOperand = &operand;
+    }
+
+    ~OfferOperand() {
+        builtOperand = previous;
+    }
+};
+
+// The operand that continues expression's chain of operators, if expression's overload is settled before its operands
+// are built. A flat `a + b + c` is a left nested tree of operators with the same precedence, and a prefix operator may
+// be applied any number of times.
+const NonTerminals::Expression *chainOperand(
+        const NonTerminals::Expression &expression, LookupContext &lookupContext, ExpectedResult expectedResult,
+        ExpectedResult &operandExpectedResult )
 {
-}
+    using NonTerminals::Expression;
 
-SourceLocation Expression::getLocation() const {
-    return actualExpression->getLocation();
+    std::optional<ExpectedResult> expectation;
+    const Expression *operand = nullptr;
+
+    if( auto unary = std::get_if<Expression::UnaryOperator>( &expression.value ) ) {
+        operand = unary->operand.get();
+        if( !std::holds_alternative<Expression::UnaryOperator>( operand->value ) )
+            return nullptr;
+
+        expectation = ExpressionImpl::UnaryOp::operandExpectation( *unary, lookupContext, expectedResult );
+    } else if( auto binary = std::get_if<Expression::BinaryOperator>( &expression.value ) ) {
+        const Operators::OperatorInfo &info = Operators::lookup( binary->op.kind() );
+        operand = binary->operands[0].get();
+        auto operandOp = std::get_if<Expression::BinaryOperator>( &operand->value );
+        if( info.rightToLeft || operandOp==nullptr ||
+                Operators::lookup( operandOp->op.kind() ).binaryPrecedence!=info.binaryPrecedence )
+            return nullptr;
+
+        expectation = ExpressionImpl::BinaryOp::leftOperandExpectation( *binary, lookupContext, expectedResult );
+    }
+
+    if( !expectation )
+        return nullptr;
+
+    operandExpectedResult = *expectation;
+    return operand;
 }
 
-// Protected memthods
-void Expression::buildASTImpl(
-        LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit )
+std::unique_ptr<ExpressionImpl::Base> buildActualExpression(
+        const NonTerminals::Expression &parserExpression, LookupContext &lookupContext, ExpectedResult expectedResult,
+        Weight &weight, Weight weightLimit )
 {
     struct Visitor {
-        Expression *_this;
         LookupContext &lookupContext;
         ExpectedResult expectedResult;
         Weight &weight;
         const Weight weightLimit;
 
-        void operator()( const std::unique_ptr<NonTerminals::CompoundExpression> &parserExpression ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()(
+                NonTerminals::NodeIndex<NonTerminals::CompoundExpression> parserExpression )
+        {
             auto expression = safenew<ExpressionImpl::CompoundExpression>( *parserExpression, lookupContext );
 
             expression->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(expression);
+            return expression;
         }
 
-        void operator()( const NonTerminals::Literal &parserLiteral ) {
-            auto literal = safenew<ExpressionImpl::Literal>( parserLiteral );
+        std::unique_ptr<ExpressionImpl::Base> operator()(
+                NonTerminals::NodeIndex<NonTerminals::Literal> parserLiteral )
+        {
+            auto literal = safenew<ExpressionImpl::Literal>( *parserLiteral );
 
             literal->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(literal);
+            return literal;
         }
 
-        void operator()( const NonTerminals::Identifier &parserIdentifier ) {
-            auto identifier = safenew<ExpressionImpl::Identifier>( parserIdentifier );
+        std::unique_ptr<ExpressionImpl::Base> operator()(
+                NonTerminals::NodeIndex<NonTerminals::Identifier> parserIdentifier )
+        {
+            auto identifier = safenew<ExpressionImpl::Identifier>( *parserIdentifier );
 
             identifier->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(identifier);
+            return identifier;
         }
 
-        void operator()( const NonTerminals::Expression::UnaryOperator &op ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()( const NonTerminals::Expression::UnaryOperator &op ) {
             auto unaryOp = safenew<ExpressionImpl::UnaryOp>(op);
 
             unaryOp->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(unaryOp);
+            return unaryOp;
         }
 
-        void operator()( const NonTerminals::Expression::BinaryOperator &op ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()( const NonTerminals::Expression::BinaryOperator &op ) {
             auto binaryOp = safenew<ExpressionImpl::BinaryOp>(op);
 
             binaryOp->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(binaryOp);
+            return binaryOp;
         }
 
-        void operator()( const NonTerminals::Expression::CastOperator &cast ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()( const NonTerminals::Expression::CastOperator &cast ) {
             auto castOp = safenew<ExpressionImpl::CastOp>(cast);
 
             castOp->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(castOp);
+            return castOp;
         }
 
-        void operator()( const NonTerminals::Expression::FunctionCall &parserFuncCall ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()(
+                const NonTerminals::Expression::FunctionCall &parserFuncCall )
+        {
             auto functionCall = safenew<ExpressionImpl::FunctionCall>( parserFuncCall );
 
             functionCall->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(functionCall);
+            return functionCall;
         }
 
-        void operator()( const std::unique_ptr<NonTerminals::ConditionalExpression> &parserCondition ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()(
+                NonTerminals::NodeIndex<NonTerminals::ConditionalExpression> parserCondition )
+        {
             auto condition = safenew<ExpressionImpl::ConditionalExpression>( *parserCondition );
 
             condition->buildAST( lookupContext, expectedResult, weight, weightLimit );
-            _this->actualExpression = std::move(condition);
+            return condition;
         }
 
-        void operator()( const NonTerminals::Type &type ) {
+        std::unique_ptr<ExpressionImpl::Base> operator()( NonTerminals::NodeIndex<NonTerminals::Type> type ) {
             ABORT()<<"TODO implement";
         }
     };
 
-    std::visit(
+    return std::visit(
             Visitor{
-                ._this = this, .lookupContext = lookupContext, .expectedResult = expectedResult,
+                .lookupContext = lookupContext, .expectedResult = expectedResult,
                 .weight = weight, .weightLimit = weightLimit
             },
             parserExpression.value );
+}
+
+} // Anonymous namespace
+
+Expression::Expression( const NonTerminals::Expression &parserExpression ) :
+    parserExpression( parserExpression )
+{
+}
+
+Expression::~Expression() {
+    freeChain( chain );
+}
+
+SourceLocation Expression::getLocation() const {
+    return actualExpression->getLocation();
+}
+
+// Protected memthods
+void Expression::buildASTImpl(
+        LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit )
+{
+    // Operators nest without the parser recursing, so the parser's limit does not bound how deep the expression is.
+    // Chains of operators are built without recursing, so only the operands that are built recursively count.
+    NonTerminals::NestingLimit::Level nesting;
+    if( nesting.tooDeep() ) {
+        auto tokens = parserExpression.getNTTokens();
+        throw NestingTooDeep( tokens.size()>0 ? tokens[0].location() : SourceLocation() );
+    }
+
+    if( builtOperand!=nullptr && builtOperand->parserExpression==&parserExpression ) {
+        ASSERT( builtOperand->adoptedBy==nullptr )<<"Chain operand built twice";
+        // Holds the chain until its operator is built, so that the chain is freed innermost first should that fail
+        actualExpression = std::move( builtOperand->expression );
+        chain = std::move( builtOperand->chain );
+        weight += builtOperand->weight;
+        builtOperand->adoptedBy = this;
+    } else {
+        buildChain( lookupContext, expectedResult, weight, weightLimit );
+    }
 
     metadata.type = actualExpression->getType();
     metadata.valueRange = actualExpression->getValueRange();
 }
 
 ExpressionId Expression::codeGenImpl( PracticalSemanticAnalyzer::FunctionGen *functionGen ) const {
+    // An operand of a chain, generated by the chain's outermost expression
+    if( generated ) {
+        ExpressionId id = *generated;
+        generated.reset();
+
+        return id;
+    }
+
+    // Each operator uses the code of the operand generated before it
+    for( Expression *operand : chain )
+        operand->generated = operand->actualExpression->codeGen( functionGen );
+
     return actualExpression->codeGen( functionGen );
 }
 
+// Private methods
+void Expression::buildChain(
+        LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit )
+{
+    struct Link {
+        const NonTerminals::Expression *parserExpression;
+        ExpectedResult expectedResult;
+    };
+
+    // Each operator's overload tells what its operand continuing the chain is expected to be
+    std::vector<Link> links{ Link{ .parserExpression = &parserExpression, .expectedResult = expectedResult } };
+    ExpectedResult operandExpectedResult;
+    while( const NonTerminals::Expression *operand =
+            chainOperand( *links.back().parserExpression, lookupContext, links.back().expectedResult,
+                    operandExpectedResult ) )
+    {
+        links.emplace_back( Link{ .parserExpression = operand, .expectedResult = operandExpectedResult } );
+    }
+
+    BuiltOperand operand;
+    operand.expression = buildActualExpression(
+            *links.back().parserExpression, lookupContext, links.back().expectedResult, operand.weight, weightLimit );
+
+    // Each operator takes over the operand built before it
+    for( size_t link = links.size()-1; link>0; --link ) {
+        operand.parserExpression = links[link].parserExpression;
+
+        Weight operatorWeight;
+        std::unique_ptr<ExpressionImpl::Base> op;
+        {
+            OfferOperand offer( operand );
+            op = buildActualExpression(
+                    *links[link-1].parserExpression, lookupContext, links[link-1].expectedResult, operatorWeight,
+                    weightLimit );
+        }
+        ASSERT( operand.adoptedBy!=nullptr )<<"Operator did not take over its chain operand "<<op->getLocation();
+
+        operand.chain = std::move( operand.adoptedBy->chain );
+        operand.chain.emplace_back( operand.adoptedBy );
+        operand.expression = std::move( op );
+        operand.weight = operatorWeight;
+        operand.adoptedBy = nullptr;
+    }
+
+    actualExpression = std::move( operand.expression );
+    chain = std::move( operand.chain );
+    weight += operand.weight;
+}
+
+void Expression::freeChain( std::vector<Expression *> &chain ) {
+    for( Expression *operand : chain )
+        operand->actualExpression.reset();
+
+    chain.clear();
+}
+
 } // namespace AST
@@ -17,14 +17,26 @@
 
 #include <practical/practical.h>
 
+#include <optional>
+#include <vector>
+
 namespace AST {
 
+struct BuiltOperand;
+
 class Expression final : public ExpressionImpl::Base {
     const NonTerminals::Expression &parserExpression;
     std::unique_ptr< ExpressionImpl::Base > actualExpression;
+    // The operands continuing this expression's chain of operators, innermost first. A chain is built, generated and
+    // freed from its innermost operand out, so that its length costs no native stack.
+    std::vector<Expression *> chain;
+    // The code of an operand in a chain, generated before the operator using it
+    mutable std::optional<ExpressionId> generated;
 
 public:
     explicit Expression( const NonTerminals::Expression &parserExpression );
+    Expression( Expression &&that ) = default;
+    ~Expression();
 
     template<typename T>
     const T *tryGetActualExpression() const {
@@ -38,6 +50,12 @@ protected:
             LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit
         ) override;
     ExpressionId codeGenImpl( PracticalSemanticAnalyzer::FunctionGen *functionGen ) const override;
+
+private:
+    friend BuiltOperand;
+
+    void buildChain( LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit );
+    static void freeChain( std::vector<Expression *> &chain );
 };
 
 } // namespace AST
@@ -55,7 +55,7 @@ void AddressOf::buildASTImpl(
     if( (operand.getType()->getFlags() & StaticType::Flags::Reference)==0 )
         throw LValueRequired( operand.getType(), operand.getLocation() );
 
-    metadata.type = StaticTypeImpl::allocate( PointerTypeImpl( operand.getType() ) );
+    metadata.type = StaticTypeImpl::intern( PointerTypeImpl( operand.getType() ) );
     metadata.valueRange = new PointerValueRange( operand.getValueRange() );
 }
 
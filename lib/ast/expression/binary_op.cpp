@@ -17,12 +17,12 @@
 namespace AST::ExpressionImpl {
 
 // Non member private helpers
-static std::unordered_map< Tokenizer::Tokens, std::string > operatorNames;
+static std::unordered_map< Tokenizer::Tokens, Symbol > operatorNames;
 
 static void defineMatchingPairs(
         LookupContext::Function::Definition::CodeGenProto *codeGenerator,
         LookupContext::Function::Definition::VrpProto *calcVrp,
-        const std::string &name,
+        Symbol name,
         StaticTypeImpl::CPtr retType,
         Slice<const StaticTypeImpl::CPtr> types,
         LookupContext &builtinCtx)
@@ -38,7 +38,7 @@ static void defineMatchingPairs(
 static void defineMatchingPairs(
         LookupContext::Function::Definition::CodeGenProto *codeGenerator,
         LookupContext::Function::Definition::VrpProto *calcVrp,
-        const std::string &name,
+        Symbol name,
         Slice<const StaticTypeImpl::CPtr> types,
         LookupContext &builtinCtx)
 {
@@ -50,10 +50,20 @@ static void defineMatchingPairs(
     }
 }
 
-static String opToFuncName( Tokenizer::Tokens token ) {
+static Symbol opToFuncName( Tokenizer::Tokens token ) {
     return operatorNames.at(token);
 }
 
+static const LookupContext::Function &lookupFunction(
+        const NonTerminals::Expression::BinaryOperator &parserOp, LookupContext &lookupContext )
+{
+    Symbol baseName = opToFuncName( parserOp.op.kind() );
+    auto identifier = lookupContext.lookupIdentifier( baseName );
+    ASSERT( identifier )<<"Binary operator "<<parserOp.op.kind()<<" is not yet implemented by the compiler";
+
+    return std::get<LookupContext::Function>(*identifier);
+}
+
 // Static methods
 void BinaryOp::init(LookupContext &builtinCtx) {
     auto unsignedTypes = std::experimental::make_array<const StaticTypeImpl::CPtr>(
@@ -70,71 +80,84 @@ void BinaryOp::init(LookupContext &builtinCtx) {
     );
     const StaticTypeImpl::CPtr boolType = builtinCtx.lookupType( "Bool" );
 
-    auto inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ARROW, "__opArrow" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN, "__opAssign" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_AND, "__opAssignBitAnd" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_OR, "__opAssignBitOr" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_XOR, "__opAssignBitXor" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_DIVIDE, "__opAssignDivide" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_LEFT_SHIFT, "__opAssignShiftLeft" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MINUS, "__opAssignMinus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MODULOUS, "__opAssignMod" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MULTIPLY, "__opAssignMultiply" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_PLUS, "__opAssignPlus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_RIGHT_SHIFT, "__opAssignShiftRight" );
-
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MULTIPLY, "__opMultiply" );
+    auto inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ARROW, Symbol::intern("__opArrow") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN, Symbol::intern("__opAssign") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_AND, Symbol::intern("__opAssignBitAnd") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_OR, Symbol::intern("__opAssignBitOr") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_BIT_XOR, Symbol::intern("__opAssignBitXor") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_DIVIDE, Symbol::intern("__opAssignDivide") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_LEFT_SHIFT, Symbol::intern("__opAssignShiftLeft") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MINUS, Symbol::intern("__opAssignMinus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MODULOUS, Symbol::intern("__opAssignMod") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_MULTIPLY, Symbol::intern("__opAssignMultiply") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_PLUS, Symbol::intern("__opAssignPlus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ASSIGN_RIGHT_SHIFT, Symbol::intern("__opAssignShiftRight") );
+
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MULTIPLY, Symbol::intern("__opMultiply") );
     defineMatchingPairs( Operators::bMultiplyCodegenUnsigned, Operators::bMultiplyUnsignedVrp, inserter.first->second, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::bMultiplyCodegenSigned, Operators::bMultiplySignedVrp, inserter.first->second, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_AND, "__opBitAnd" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_OR, "__opBitOr" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_XOR, "__opBitXor" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_DIVIDE, "__opDiv" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_AND, Symbol::intern("__opBitAnd") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_OR, Symbol::intern("__opBitOr") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_XOR, Symbol::intern("__opBitXor") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_DIVIDE, Symbol::intern("__opDiv") );
     defineMatchingPairs( Operators::bDivideCodegenUnsigned, Operators::bDivideUnsignedVrp, inserter.first->second, unsignedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_EQUALS, "__opEquals" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_EQUALS, Symbol::intern("__opEquals") );
     defineMatchingPairs( Operators::equalsCodegenInt, Operators::equalsVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::equalsCodegenInt, Operators::equalsVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_GREATER_THAN, "__opGT" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_GREATER_THAN, Symbol::intern("__opGT") );
     defineMatchingPairs( Operators::greaterThenCodegenUInt, Operators::greaterThenVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::greaterThenCodegenSInt, Operators::greaterThenVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_GREATER_THAN_EQ, "__opGE" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_GREATER_THAN_EQ, Symbol::intern("__opGE") );
     defineMatchingPairs( Operators::greaterThenOrEqualsCodegenUInt, Operators::greaterThenOrEqualsVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::greaterThenOrEqualsCodegenSInt, Operators::greaterThenOrEqualsVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LESS_THAN, "__opLT" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LESS_THAN, Symbol::intern("__opLT") );
     defineMatchingPairs( Operators::lessThanCodegenUInt, Operators::lessThanVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::lessThanCodegenSInt, Operators::lessThanVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LESS_THAN_EQ, "__opLE" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LESS_THAN_EQ, Symbol::intern("__opLE") );
     defineMatchingPairs( Operators::lessThanOrEqualsCodegenUInt, Operators::lessThanOrEqualsVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::lessThanOrEqualsCodegenSInt, Operators::lessThanOrEqualsVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_AND, "__opAnd" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_AND, Symbol::intern("__opAnd") );
     builtinCtx.addBuiltinFunction(
             inserter.first->second, boolType, { boolType, boolType }, Operators::logicalAnd, Operators::logicalAndVrp );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_OR, "__opOr" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_OR, Symbol::intern("__opOr") );
     builtinCtx.addBuiltinFunction(
             inserter.first->second, boolType, { boolType, boolType }, Operators::logicalOr, Operators::logicalOrVrp );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS, "__opMinus" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS, Symbol::intern("__opMinus") );
     defineMatchingPairs( Operators::bMinusCodegenUnsigned, Operators::bMinusUnsignedVrp, inserter.first->second, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::bMinusCodegenSigned, Operators::bMinusSignedVrp, inserter.first->second, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MODULOUS, "__opMod" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_NOT_EQUALS, "__opNE" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MODULOUS, Symbol::intern("__opMod") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_NOT_EQUALS, Symbol::intern("__opNE") );
     defineMatchingPairs( Operators::notEqualsCodegenInt, Operators::notEqualsVrpUnsigned, inserter.first->second, boolType, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::notEqualsCodegenInt, Operators::notEqualsVrpSigned, inserter.first->second, boolType, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS, "__opPlus" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS, Symbol::intern("__opPlus") );
     defineMatchingPairs( Operators::bPlusCodegenUnsigned, Operators::bPlusUnsignedVrp, inserter.first->second, unsignedTypes, builtinCtx );
     defineMatchingPairs( Operators::bPlusCodegenSigned, Operators::bPlusSignedVrp, inserter.first->second, signedTypes, builtinCtx );
 
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_SHIFT_LEFT, "__opShiftLeft" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_SHIFT_RIGHT, "__opShiftRight" );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_SHIFT_LEFT, Symbol::intern("__opShiftLeft") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_SHIFT_RIGHT, Symbol::intern("__opShiftRight") );
+}
+
+std::optional<ExpectedResult> BinaryOp::leftOperandExpectation(
+        const NonTerminals::Expression::BinaryOperator &parserOp, LookupContext &lookupContext,
+        ExpectedResult expectedResult )
+{
+    const LookupContext::Function::Definition *definition = OverloadResolver::soleCandidate(
+            expectedResult, lookupFunction( parserOp, lookupContext ).overloads, parserOp.operands.size() );
+    if( definition==nullptr )
+        return std::nullopt;
+
+    auto functionType = std::get<const StaticType::Function *>( definition->type->getType() );
+    return ExpectedResult( functionType->getArgumentType(0) );
 }
 
 BinaryOp::BinaryOp( const NonTerminals::Expression::BinaryOperator &parserOp ) :
@@ -142,18 +165,14 @@ BinaryOp::BinaryOp( const NonTerminals::Expression::BinaryOperator &parserOp ) :
 {}
 
 SourceLocation BinaryOp::getLocation() const {
-    return parserOp.op->location;
+    return parserOp.op.location();
 }
 
 // Protected methods
 void BinaryOp::buildASTImpl(
         LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit )
 {
-    String baseName = opToFuncName( parserOp.op->token );
-    auto identifier = lookupContext.lookupIdentifier( baseName );
-    ASSERT( identifier )<<"Binary operator "<<parserOp.op->token<<" is not yet implemented by the compiler";
-    const LookupContext::Function &function =
-            std::get<LookupContext::Function>(*identifier);
+    const LookupContext::Function &function = lookupFunction( parserOp, lookupContext );
 
     resolver.resolveOverloads(
             lookupContext, expectedResult, function.overloads, weight, weightLimit, metadata,
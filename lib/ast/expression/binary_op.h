@@ -13,6 +13,8 @@
 #include "ast/expression.h"
 #include "parser.h"
 
+#include <optional>
+
 namespace AST::ExpressionImpl {
 
 class BinaryOp final : public Base {
@@ -22,6 +24,12 @@ class BinaryOp final : public Base {
 public:
     static void init(LookupContext &builtinCtx);
 
+    // What the left operand is expected to be, if the overload is settled before building the operands. Lets a chain
+    // of operators be built from its innermost operand out.
+    static std::optional<ExpectedResult> leftOperandExpectation(
+            const NonTerminals::Expression::BinaryOperator &parserOp, LookupContext &lookupContext,
+            ExpectedResult expectedResult );
+
     explicit BinaryOp( const NonTerminals::Expression::BinaryOperator &parserOp );
 
     SourceLocation getLocation() const override;
@@ -17,16 +17,16 @@ CastOp::CastOp( const NonTerminals::Expression::CastOperator &parserCast ) :
 }
 
 SourceLocation CastOp::getLocation() const {
-    return parserCast.op->location;
+    return parserCast.op.location();
 }
 
 void CastOp::buildASTImpl(
         LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit
     )
 {
-    metadata.type = lookupContext.lookupType( parserCast.destType );
+    metadata.type = lookupContext.lookupType( *parserCast.destType );
 
-    switch( parserCast.op->token ) {
+    switch( parserCast.op.kind() ) {
     case Tokenizer::Tokens::RESERVED_EXPECT:
         {
             // Just give the expression a mandatory expected type
@@ -35,7 +35,7 @@ void CastOp::buildASTImpl(
         }
         break;
     default:
-        ABORT()<<"Unidentified token "<<parserCast.op->token<<" passed as cast";
+        ABORT()<<"Unidentified token "<<parserCast.op.kind()<<" passed as cast";
     }
 }
 
@@ -28,7 +28,7 @@ void Dereference::buildASTImpl(
 
     if( expectedResult ) {
         StaticTypeImpl::CPtr operandExpectedType =
-                StaticTypeImpl::allocate( PointerTypeImpl( expectedResult.getType() ) );
+                StaticTypeImpl::intern( PointerTypeImpl( expectedResult.getType() ) );
 
         expectedOperandResult = ExpectedResult( std::move(operandExpectedType), expectedResult.isMandatory() );
     }
@@ -22,7 +22,7 @@ FunctionCall::FunctionCall( const NonTerminals::Expression::FunctionCall &parser
 }
 
 SourceLocation FunctionCall::getLocation() const {
-    return parserFunctionCall.op->location;
+    return parserFunctionCall.op.location();
 }
 
 // protected methods
@@ -47,11 +47,11 @@ void FunctionCall::buildASTImpl(
         }
 
         void operator()( const LookupContext::Function &function ) {
-            size_t numArguments = _this->parserFunctionCall.arguments.arguments.size();
+            size_t numArguments = _this->parserFunctionCall.arguments->arguments.size();
             const NonTerminals::Expression *arguments[numArguments];
 
             for( unsigned i=0; i<numArguments; ++i ) {
-                arguments[i] = &_this->parserFunctionCall.arguments.arguments[i];
+                arguments[i] = &_this->parserFunctionCall.arguments->arguments[i];
             }
 
             _this->resolver.resolveOverloads(
@@ -21,21 +21,21 @@ Identifier::Identifier( const NonTerminals::Identifier &parserIdentifier ) :
 }
 
 String Identifier::getName() const {
-    return parserIdentifier.identifier->text;
+    return parserIdentifier.identifier.text();
 }
 
 SourceLocation Identifier::getLocation() const {
-    return parserIdentifier.identifier->location;
+    return parserIdentifier.identifier.location();
 }
 
 void Identifier::buildASTImpl(
         LookupContext &lookupContext, ExpectedResult expectedResult, Weight &weight, Weight weightLimit )
 {
-    identifier = lookupContext.lookupIdentifier( parserIdentifier.identifier->text );
+    identifier = lookupContext.lookupIdentifier( parserIdentifier.identifier.symbol() );
 
     if( identifier==nullptr ) {
         throw SymbolNotFound(
-                parserIdentifier.identifier->text, parserIdentifier.identifier->location );
+                parserIdentifier.identifier.text(), parserIdentifier.identifier.location() );
     }
 
     struct Visitor {
@@ -181,13 +181,13 @@ void Literal::buildAstPointer(
         ExpectedResult expectedResult )
 {
     if( ! expectedResult )
-        throw PointerExpected( nullptr, literal.token->location );
+        throw PointerExpected( nullptr, literal.token.location() );
 
     auto expectedType = expectedResult.getType();
     auto expectedTypeType = expectedType->getType();
     auto pointedType = std::get_if<const StaticType::Pointer *>(&expectedTypeType);
     if( pointedType == nullptr )
-        throw PointerExpected( expectedType, literal.token->location );
+        throw PointerExpected( expectedType, literal.token.location() );
 
     metadata.type = expectedType;
     metadata.valueRange = new PointerValueRange( nullptr );
@@ -198,7 +198,7 @@ void Literal::buildAstString(
         ExpectedResult expectedResult )
 {
     auto c8Type = AST::getBuiltinCtx().lookupType("C8");
-    metadata.type = StaticTypeImpl::allocate( PointerTypeImpl( c8Type ) );
+    metadata.type = StaticTypeImpl::intern( PointerTypeImpl( c8Type ) );
     metadata.valueRange = new PointerValueRange( c8Type->defaultRange() );
 }
 
@@ -227,7 +227,7 @@ ExpressionId Literal::codeGenString(
         PracticalSemanticAnalyzer::FunctionGen *functionGen ) const
 {
     ExpressionId id = allocateId();
-    functionGen->setLiteral( id, literal.value + '\0' );
+    functionGen->setLiteral( id, sliceToString( literal.getValue() ) + '\0' );
 
     return id;
 }
@@ -22,10 +22,15 @@ void OverloadResolver::resolveOverloads(
         Weight weightLimit,
         ExpressionMetadata &metadata,
         Slice<const NonTerminals::Expression *const> parserArguments,
-        const Tokenizer::Token *sourceLocation
+        Tokenizer::TokenRef sourceLocation
     )
 {
-    if( expectedResult ) {
+    const LookupContext::Function::Definition *candidate =
+            soleCandidate( expectedResult, overloads, parserArguments.size() );
+    if( candidate!=nullptr ) {
+        // Either it matches or compile error.
+        buildActualCall( lookupContext, weight, weightLimit, candidate, metadata, parserArguments );
+    } else if( expectedResult ) {
         resolveOverloadsByReturn(
                 lookupContext, expectedResult, overloads, weight, weightLimit, metadata, parserArguments,
                 sourceLocation );
@@ -35,6 +40,40 @@ void OverloadResolver::resolveOverloads(
     }
 }
 
+const LookupContext::Function::Definition *OverloadResolver::soleCandidate(
+        ExpectedResult expectedResult,
+        const LookupContext::Function::OverloadsContainer &overloads,
+        size_t numArguments
+    )
+{
+    const LookupContext::Function::Definition *onlyOverload = nullptr, *onlyReturning = nullptr;
+    size_t numOverloads = 0, numReturning = 0;
+
+    for( auto &overload : overloads ) {
+        auto overloadType = std::get<const StaticType::Function *>(overload.second.type->getType());
+        if( overloadType->getNumArguments() != numArguments )
+            continue;
+
+        onlyOverload = &overload.second;
+        ++numOverloads;
+
+        if( expectedResult && overloadType->getReturnType().get()==expectedResult.getType().get() ) {
+            onlyReturning = &overload.second;
+            ++numReturning;
+        }
+    }
+
+    // It's the only one that might match
+    if( numOverloads==1 )
+        return onlyOverload;
+
+    // Only one overload matches the return type exactly
+    if( numReturning==1 )
+        return onlyReturning;
+
+    return nullptr;
+}
+
 const FunctionTypeImpl &OverloadResolver::getType() const {
     ASSERT(definition)<<"Tried to getType from unresolved overloads";
 
@@ -97,7 +136,7 @@ void OverloadResolver::resolveOverloadsByReturn(
         Weight weightLimit,
         ExpressionMetadata &metadata,
         Slice<const NonTerminals::Expression *const> parserArguments,
-        const Tokenizer::Token *sourceLocation
+        Tokenizer::TokenRef sourceLocation
     )
 {
     std::unordered_map<
@@ -117,23 +156,9 @@ void OverloadResolver::resolveOverloadsByReturn(
         throw NoMatchingOverload( sourceLocation );
     }
 
-    if( sortedOverloads.size()==1 && sortedOverloads.begin()->second.size()==1 ) {
-        // It's the only one that might match. Either it matches or compile error.
-        buildActualCall(
-                lookupContext, weight, weightLimit, *sortedOverloads.begin()->second.begin(), metadata, parserArguments );
-        return;
-    }
-
     auto currentReturnCandidate = sortedOverloads.find( expectedResult.getType() );
     if( currentReturnCandidate!=sortedOverloads.end() ) {
-        ASSERT( ! currentReturnCandidate->second.empty() );
-
-        if( currentReturnCandidate->second.size()==1 ) {
-            // Only one overload matches the return type exactly
-            buildActualCall(
-                    lookupContext, weight, weightLimit, currentReturnCandidate->second[0], metadata, parserArguments );
-            return;
-        }
+        ASSERT( currentReturnCandidate->second.size()>1 );
 
         try {
             findBestOverloadByArgument(
@@ -160,7 +185,7 @@ void OverloadResolver::resolveOverloadsByArguments(
         Weight weightLimit,
         ExpressionMetadata &metadata,
         Slice<const NonTerminals::Expression *const> parserArguments,
-        const Tokenizer::Token *sourceLocation
+        Tokenizer::TokenRef sourceLocation
     )
 {
     std::vector<const LookupContext::Function::Definition *> relevantOverloads;
@@ -177,13 +202,6 @@ void OverloadResolver::resolveOverloadsByArguments(
         throw NoMatchingOverload( sourceLocation );
     }
 
-    if( relevantOverloads.size()==1 ) {
-        // It's the only one that might match. Either it matches or compile error.
-        buildActualCall(
-                lookupContext, weight, weightLimit, relevantOverloads[0], metadata, parserArguments );
-        return;
-    }
-
     findBestOverloadByArgument(
             lookupContext, relevantOverloads, weight, weightLimit, metadata, parserArguments, sourceLocation );
 }
@@ -195,7 +213,7 @@ void OverloadResolver::findBestOverloadByArgument(
         Weight weightLimit,
         ExpressionMetadata &metadata,
         Slice<const NonTerminals::Expression *const> parserArguments,
-        const Tokenizer::Token *sourceLocation
+        Tokenizer::TokenRef sourceLocation
     )
 {
     Weight callWeightLimit = weightLimit - weight;
@@ -28,7 +28,14 @@ public:
             Weight weightLimit,
             ExpressionMetadata &metadata,
             Slice<const NonTerminals::Expression *const> parserArguments,
-            const Tokenizer::Token *sourceLocation
+            Tokenizer::TokenRef sourceLocation
+        );
+
+    // The overload resolveOverloads settles on before building any of the arguments, if there is one
+    static const LookupContext::Function::Definition *soleCandidate(
+            ExpectedResult expectedResult,
+            const LookupContext::Function::OverloadsContainer &overloads,
+            size_t numArguments
         );
 
     const FunctionTypeImpl &getType() const;
@@ -50,7 +57,7 @@ private:
             Weight weightLimit,
             ExpressionMetadata &metadata,
             Slice<const NonTerminals::Expression *const> parserArguments,
-            const Tokenizer::Token *sourceLocation
+            Tokenizer::TokenRef sourceLocation
         );
     void resolveOverloadsByArguments(
             LookupContext &lookupContext,
@@ -59,7 +66,7 @@ private:
             Weight weightLimit,
             ExpressionMetadata &metadata,
             Slice<const NonTerminals::Expression *const> parserArguments,
-            const Tokenizer::Token *sourceLocation
+            Tokenizer::TokenRef sourceLocation
         );
     void findBestOverloadByArgument(
             LookupContext &lookupContext,
@@ -68,7 +75,7 @@ private:
             Weight weightLimit,
             ExpressionMetadata &metadata,
             Slice<const NonTerminals::Expression *const> parserArguments,
-            const Tokenizer::Token *sourceLocation
+            Tokenizer::TokenRef sourceLocation
         );
 };
 
@@ -15,12 +15,22 @@
 namespace AST::ExpressionImpl {
 
 // Non member private helpers
-static std::unordered_map< Tokenizer::Tokens, std::string > operatorNames;
+static std::unordered_map< Tokenizer::Tokens, Symbol > operatorNames;
 
-static String opToFuncName( Tokenizer::Tokens token ) {
+static Symbol opToFuncName( Tokenizer::Tokens token ) {
     return operatorNames.at(token);
 }
 
+static const LookupContext::Function &lookupFunction(
+        const NonTerminals::Expression::UnaryOperator &parserOp, LookupContext &lookupContext )
+{
+    Symbol baseName = opToFuncName( parserOp.op.kind() );
+    auto identifier = lookupContext.lookupIdentifier( baseName );
+    ASSERT( identifier )<<"Unary operator "<<parserOp.op.kind()<<" is not yet implemented by the compiler";
+
+    return std::get<LookupContext::Function>(*identifier);
+}
+
 // Static methods
 void UnaryOp::init(LookupContext &builtinCtx) {
     auto unsignedTypes = std::experimental::make_array<const StaticTypeImpl::CPtr>(
@@ -37,24 +47,46 @@ void UnaryOp::init(LookupContext &builtinCtx) {
     );
     const StaticTypeImpl::CPtr boolType = builtinCtx.lookupType( "Bool" );
 
-    auto inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ARROW, "__opArrow" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_AMPERSAND, "__opAmpersand" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PTR, "__opDereference" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_NOT, "__opOneComplement" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS, "__opMinus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS_MINUS, "__opMinusMinus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS, "__opPlus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS_PLUS, "__opPlusPlus" );
-    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_NOT, "__opNot" );
+    auto inserter = operatorNames.emplace( Tokenizer::Tokens::OP_ARROW, Symbol::intern("__opArrow") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_AMPERSAND, Symbol::intern("__opAmpersand") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PTR, Symbol::intern("__opDereference") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_BIT_NOT, Symbol::intern("__opOneComplement") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS, Symbol::intern("__opMinus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_MINUS_MINUS, Symbol::intern("__opMinusMinus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS, Symbol::intern("__opPlus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_PLUS_PLUS, Symbol::intern("__opPlusPlus") );
+    inserter = operatorNames.emplace( Tokenizer::Tokens::OP_LOGIC_NOT, Symbol::intern("__opNot") );
     builtinCtx.addBuiltinFunction( inserter.first->second, boolType, { boolType }, Operators::logicalNot, Operators::logicalNotVrp );
 }
 
+std::optional<ExpectedResult> UnaryOp::operandExpectation(
+        const NonTerminals::Expression::UnaryOperator &parserOp, LookupContext &lookupContext,
+        ExpectedResult expectedResult )
+{
+    switch( parserOp.op.kind() ) {
+    case Tokenizer::Tokens::OP_AMPERSAND:
+    case Tokenizer::Tokens::OP_PTR:
+        // The special cases don't resolve overloads
+        return std::nullopt;
+    default:
+        break;
+    }
+
+    const LookupContext::Function::Definition *definition = OverloadResolver::soleCandidate(
+            expectedResult, lookupFunction( parserOp, lookupContext ).overloads, 1 );
+    if( definition==nullptr )
+        return std::nullopt;
+
+    auto functionType = std::get<const StaticType::Function *>( definition->type->getType() );
+    return ExpectedResult( functionType->getArgumentType(0) );
+}
+
 UnaryOp::UnaryOp( const NonTerminals::Expression::UnaryOperator &parserOp ) :
     parserOp(parserOp)
 {}
 
 SourceLocation UnaryOp::getLocation() const {
-    return parserOp.op->location;
+    return parserOp.op.location();
 }
 
 // Protected methods
@@ -64,7 +96,7 @@ void UnaryOp::buildASTImpl(
     bool defaultHandling = true;
 
     // The special cases
-    switch( parserOp.op->token ) {
+    switch( parserOp.op.kind() ) {
     case Tokenizer::Tokens::OP_AMPERSAND:
         defaultHandling = false;
         body.emplace<AddressOf>( *parserOp.operand ).
@@ -88,11 +120,7 @@ void UnaryOp::buildASTFromTemplate(
         OverloadResolver &resolver, LookupContext &lookupContext, ExpectedResult expectedResult,
         Weight &weight, Weight weightLimit )
 {
-    String baseName = opToFuncName( parserOp.op->token );
-    auto identifier = lookupContext.lookupIdentifier( baseName );
-    ASSERT( identifier )<<"Unary operator "<<parserOp.op->token<<" is not yet implemented by the compiler";
-    const LookupContext::Function &function =
-            std::get<LookupContext::Function>(*identifier);
+    const LookupContext::Function &function = lookupFunction( parserOp, lookupContext );
 
     resolver.resolveOverloads( lookupContext, expectedResult, function.overloads, weight, weightLimit, metadata,
             { parserOp.operand.get() }, parserOp.op );
@@ -15,6 +15,8 @@
 #include "ast/expression.h"
 #include "parser.h"
 
+#include <optional>
+
 namespace AST::ExpressionImpl {
 
 class UnaryOp final : public Base {
@@ -24,6 +26,12 @@ class UnaryOp final : public Base {
 public:
     static void init(LookupContext &builtinCtx);
 
+    // What the operand is expected to be, if the overload is settled before building the operand. Lets a run of
+    // prefix operators be built from its innermost operand out.
+    static std::optional<ExpectedResult> operandExpectation(
+            const NonTerminals::Expression::UnaryOperator &parserOp, LookupContext &lookupContext,
+            ExpectedResult expectedResult );
+
     explicit UnaryOp( const NonTerminals::Expression::UnaryOperator &parserOp );
 
     SourceLocation getLocation() const override;
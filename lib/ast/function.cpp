@@ -19,10 +19,10 @@ namespace AST {
 
 Function::Function( const NonTerminals::FuncDef &parserFunction, const LookupContext &parentCtx ) :
     parserFunction( parserFunction ),
-    name( parserFunction.decl.name.identifier->text ),
+    name( parserFunction.decl.name.identifier.text() ),
     lookupCtx( &parentCtx )
 {
-    const LookupContext::Identifier *identifierDef = parentCtx.lookupIdentifier( name );
+    const LookupContext::Identifier *identifierDef = parentCtx.lookupIdentifier( parserFunction.decl.name.identifier.symbol() );
     ASSERT( identifierDef );
     const LookupContext::Function *funcDef = std::get_if<LookupContext::Function>( identifierDef );
     ASSERT( funcDef );
@@ -48,19 +48,22 @@ Function::Function( const NonTerminals::FuncDef &parserFunction, const LookupCon
                 varExpressionId );
         arguments.emplace_back(
                 (*function)->getArgumentType( i ),
-                parserFunction.decl.arguments.arguments[i].name.identifier->text,
+                parserFunction.decl.arguments.arguments[i].name.identifier.text(),
                 varExpressionId
         );
     }
 }
 
 void Function::codeGen( std::shared_ptr<FunctionGen> functionGen ) {
+    // May parse the body now, so must happen before any code is generated for the function
+    const NonTerminals::FuncDef::Body &body = parserFunction.getBody();
+
     functionGen->functionEnter(
             String(mangledName),
             getReturnType(),
             arguments,
             "",
-            parserFunction.decl.name.identifier->location );
+            parserFunction.decl.name.identifier.location() );
 
     struct Visitor {
         Function *_this;
@@ -88,7 +91,7 @@ void Function::codeGen( std::shared_ptr<FunctionGen> functionGen ) {
         }
     };
 
-    std::visit( Visitor{ ._this = this, .functionGen = functionGen.get() }, parserFunction.body );
+    std::visit( Visitor{ ._this = this, .functionGen = functionGen.get() }, body );
 
     functionGen->functionLeave();
 }
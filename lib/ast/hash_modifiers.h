@@ -15,8 +15,6 @@ namespace AST {
     static constexpr size_t MutableModifier = 10;
     static constexpr size_t ArrayModifier = 14;
     static constexpr size_t StructModifier = 22;
-
-    static constexpr size_t RecursiveStructHash = 0x2bcdadbd0483cb7c;
 } // namespace AST
 
 #endif // AST_HASH_MODIFIERS_H
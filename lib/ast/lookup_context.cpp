@@ -8,6 +8,7 @@
  */
 #include "lookup_context.h"
 
+#include "ast/cast_chain.h"
 #include "ast/expression.h"
 #include "ast/mangle.h"
 #include "ast/pointers.h"
@@ -31,18 +32,18 @@ StaticType::CPtr LookupContext::Function::Definition::returnType() const {
 }
 
 StaticTypeImpl::CPtr LookupContext::_genericFunctionType =
-    StaticTypeImpl::allocate( FunctionTypeImpl( nullptr, {} ) );
+    StaticTypeImpl::intern( FunctionTypeImpl( nullptr, {} ) );
 ValueRangeBase::CPtr LookupContext::_genericFunctionRange =
     new PointerValueRange( nullptr, BoolValueRange(false, false) );
 
-StaticTypeImpl::CPtr LookupContext::lookupType( String name, const SourceLocation &location ) const {
-    auto iter = _types.find( sliceToString(name) );
+StaticTypeImpl::CPtr LookupContext::lookupType( Symbol name, const SourceLocation &location ) const {
+    auto iter = _types.find( name );
 
     if( iter==_types.end() ) {
         if( _parent )
             return _parent->lookupType(name, location);
         else
-            throw SymbolNotFound( name, location );
+            throw SymbolNotFound( name.getName(), location );
     }
 
     return iter->second;
@@ -51,7 +52,7 @@ StaticTypeImpl::CPtr LookupContext::lookupType( String name, const SourceLocatio
 StaticTypeImpl::CPtr LookupContext::lookupType( String name ) const {
     ASSERT( ! _parent )<<"Lookup type without location only valid on built-in context";
 
-    auto iter = _types.find( sliceToString(name) );
+    auto iter = _types.find( Symbol::intern(name) );
     ASSERT( iter != _types.end() )<<"Lookup failed on built-in type "<<name;
 
     return iter->second;
@@ -67,7 +68,7 @@ StaticTypeImpl::CPtr LookupContext::lookupType( const NonTerminals::Type &type )
 
 
         StaticTypeImpl::CPtr operator()( const NonTerminals::Identifier &id ) {
-            return _this->lookupType( id.identifier->text, id.identifier->location );
+            return _this->lookupType( id.identifier.symbol(), id.identifier.location() );
         }
 
         StaticTypeImpl::CPtr operator()( const NonTerminals::Type::Array &array )
@@ -77,7 +78,7 @@ StaticTypeImpl::CPtr LookupContext::lookupType( const NonTerminals::Type &type )
             if( !ret )
                 return StaticTypeImpl::CPtr();
 
-            return StaticTypeImpl::allocate( ArrayTypeImpl( std::move(ret), array.dimension.value ) );
+            return StaticTypeImpl::intern( ArrayTypeImpl( std::move(ret), array.dimension.value ) );
         }
 
         StaticTypeImpl::CPtr operator()( const NonTerminals::Type::Pointer &ptr )
@@ -87,7 +88,7 @@ StaticTypeImpl::CPtr LookupContext::lookupType( const NonTerminals::Type &type )
             if( !ret )
                 return StaticTypeImpl::CPtr();
 
-            return StaticTypeImpl::allocate( PointerTypeImpl( std::move(ret) ) );
+            return StaticTypeImpl::intern( PointerTypeImpl( std::move(ret) ) );
         }
     };
 
@@ -103,7 +104,7 @@ StaticTypeImpl::CPtr LookupContext::lookupType( const NonTerminals::TransientTyp
 }
 
 StaticTypeImpl::CPtr LookupContext::registerScalarType( ScalarTypeImpl &&type, ValueRangeBase::CPtr defaultValueRange ) {
-    std::string name = sliceToString(type.getName());
+    Symbol name = Symbol::intern( type.getName() );
     auto iter = _types.emplace(
             name,
             StaticTypeImpl::allocate( std::move(type), std::move(defaultValueRange) ) );
@@ -113,7 +114,7 @@ StaticTypeImpl::CPtr LookupContext::registerScalarType( ScalarTypeImpl &&type, V
 }
 
 void LookupContext::addBuiltinFunction(
-        const std::string &name, StaticTypeImpl::CPtr returnType, Slice<const StaticTypeImpl::CPtr> argumentTypes,
+        Symbol name, StaticTypeImpl::CPtr returnType, Slice<const StaticTypeImpl::CPtr> argumentTypes,
         Function::Definition::CodeGenProto *codeGen, Function::Definition::VrpProto *calcVrp)
 {
     auto iter = _symbols.find( name );
@@ -127,7 +128,7 @@ void LookupContext::addBuiltinFunction(
         function = &std::get<Function>(inserter.first->second);
     }
 
-    StaticTypeImpl::CPtr type = StaticTypeImpl::allocate(
+    StaticTypeImpl::CPtr type = StaticTypeImpl::intern(
                     FunctionTypeImpl(
                         std::move(returnType),
                         std::vector(argumentTypes.begin(), argumentTypes.end())
@@ -136,7 +137,7 @@ void LookupContext::addBuiltinFunction(
     auto insertIter = function->overloads.emplace(
             std::piecewise_construct,
             std::make_tuple( type ),
-            std::make_tuple( nullptr, name ) );
+            std::make_tuple( Tokenizer::TokenRef(), sliceToString( name.getName() ) ) );
     ASSERT( insertIter.second )<<"Builtin function "<<name<<" "<<*type<<" added twice";
 
     Function::Definition &definition = insertIter.first->second;
@@ -160,21 +161,21 @@ std::ostream &operator<<( std::ostream &out, LookupContext::AbiType abi ) {
     return out<<"AbiType("<< static_cast<int>(abi) << ")";
 }
 
-void LookupContext::addFunctionDeclarationPass1( const Tokenizer::Token *token ) {
+void LookupContext::addFunctionDeclarationPass1( Tokenizer::TokenRef token ) {
     addFunctionDefinitionPass1(token);
 }
 
-void LookupContext::addFunctionDefinitionPass1( const Tokenizer::Token *token ) {
-    auto iter = _symbols.find( token->text );
+void LookupContext::addFunctionDefinitionPass1( Tokenizer::TokenRef token ) {
+    auto iter = _symbols.find( token.symbol() );
 
     Function *function = nullptr;
     if( iter!=_symbols.end() ) {
         function = std::get_if<Function>( &iter->second );
         if( function==nullptr )
-            throw pass1_error( "Function is trying to overload a variable", token->location );
+            throw pass1_error( "Function is trying to overload a variable", token.location() );
             // More info: where variable was first declared
     } else {
-        auto inserter = _symbols.emplace( token->text, Function{} );
+        auto inserter = _symbols.emplace( token.symbol(), Function{} );
         function = &std::get<Function>(inserter.first->second);
     }
 
@@ -183,22 +184,22 @@ void LookupContext::addFunctionDefinitionPass1( const Tokenizer::Token *token )
 
 void LookupContext::addStructPass1( const NonTerminals::StructDef &def ) {
     auto inserter = _typesUnderConstruction.emplace(
-            sliceToString(def.identifier.identifier->text),
-            StaticTypeImpl::allocate( StructTypeImpl{ def.identifier.identifier->text, this } ) );
+            def.identifier.identifier.symbol(),
+            StaticTypeImpl::allocate( StructTypeImpl{ def.identifier.identifier.text(), this } ) );
     if( !inserter.second )
-        throw pass1_error( "Type redefinition", def.identifier.identifier->location );
+        throw pass1_error( "Type redefinition", def.identifier.identifier.location() );
 
     StructTypeImpl *strct = inserter.first->second->getMutableStruct();
 
-    auto inserter2 = _types.emplace( sliceToString(def.identifier.identifier->text), inserter.first->second );
+    auto inserter2 = _types.emplace( def.identifier.identifier.symbol(), inserter.first->second );
     if( !inserter2.second )
-        throw pass1_error( "Type redefinition", def.identifier.identifier->location );
+        throw pass1_error( "Type redefinition", def.identifier.identifier.location() );
 
     strct->definitionPass1( def );
 }
 
 void LookupContext::addStructPass2( const NonTerminals::StructDef &def, DelayedDefinitions &delayedDefs ) {
-    auto iter = _typesUnderConstruction.find( sliceToString(def.identifier.identifier->text) );
+    auto iter = _typesUnderConstruction.find( def.identifier.identifier.symbol() );
     ASSERT( iter!=_typesUnderConstruction.end() );
     StructTypeImpl *strct = iter->second->getMutableStruct();
 
@@ -209,18 +210,18 @@ void LookupContext::addStructPass2( const NonTerminals::StructDef &def, DelayedD
 }
 
 void LookupContext::addFunctionDeclarationPass2(
-        const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi )
+        Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi )
 {
     addFunctionPass2( token, type, abi, false );
 }
 
 void LookupContext::addFunctionDefinitionPass2(
-        const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi )
+        Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi )
 {
     Function::Definition &definition = addFunctionPass2( token, type, abi, true );
 
     if( !definition.declarationOnly ) {
-        throw MultipleDefinitions( token->location );
+        throw MultipleDefinitions( token.location() );
     }
 
     definition.declarationOnly = false;
@@ -234,7 +235,7 @@ void LookupContext::declareFunctions( PracticalSemanticAnalyzer::ModuleGen *modu
             continue;
 
         for( const auto &overload : function->overloads ) {
-            moduleGen->declareIdentifier( overload.second.token->text, overload.second.mangledName, overload.first );
+            moduleGen->declareIdentifier( overload.second.token.text(), overload.second.mangledName, overload.first );
         }
     }
 }
@@ -273,7 +274,7 @@ LookupContext::AbiType LookupContext::parseAbiString( String abiString, const So
     return abiType->second;
 }
 
-const LookupContext::Identifier *LookupContext::lookupIdentifier( String name ) const {
+const LookupContext::Identifier *LookupContext::lookupIdentifier( Symbol name ) const {
     auto iter = _symbols.find(name);
     if( iter==_symbols.end() ) {
         if( getParent()==nullptr )
@@ -293,25 +294,25 @@ ValueRangeBase::CPtr LookupContext::genericFunctionRange() {
     return _genericFunctionRange;
 }
 
-void LookupContext::addLocalVar( const Tokenizer::Token *token, StaticTypeImpl::CPtr type, ExpressionId lvalue )
+void LookupContext::addLocalVar( Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, ExpressionId lvalue )
 {
-    auto iter = _symbols.emplace( token->text, Variable(token, type, lvalue) );
+    auto iter = _symbols.emplace( token.symbol(), Variable(token, type, lvalue) );
 
     if( !iter.second ) {
-        throw SymbolRedefined(token->text, token->location);
+        throw SymbolRedefined(token.text(), token.location());
     }
 }
 
-String LookupContext::addStructMember(
-        const Tokenizer::Token *token, StaticTypeImpl::CPtr type, size_t offset )
+Symbol LookupContext::addStructMember(
+        Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, size_t offset )
 {
-    auto iter = _symbols.emplace( token->text, StructMember(token, type, offset) );
+    auto iter = _symbols.emplace( token.symbol(), StructMember(token, type, offset) );
 
     if( !iter.second ) {
-        throw SymbolRedefined(token->text, token->location);
+        throw SymbolRedefined(token.text(), token.location());
     }
 
-    return token->text;
+    return token.symbol();
 }
 
 void LookupContext::addCast(
@@ -411,7 +412,78 @@ LookupContext::CastsList LookupContext::allCastsFrom(
     return ret;
 }
 
+void LookupContext::precomputeCastPaths() {
+    ASSERT( getParent()==nullptr )<<"Non-builtin lookups not yet implemented";
+    ASSERT( _castPaths.empty() )<<"Cast paths precomputed twice";
+
+    std::vector< StaticTypeImpl::CPtr > types;
+    auto addType = [&]( const StaticType::CPtr &type ) {
+        for( StaticType::Flags::Type flags = 0; flags<StaticTypeImpl::NumFlagVariants; ++flags ) {
+            StaticType::CPtr variant = type->setFlags( flags );
+            if( _castPathIndex.emplace( variant, types.size() ).second )
+                types.emplace_back( downCast(variant) );
+        }
+    };
+
+    for( const auto &source : _typeConversionsFrom ) {
+        addType( source.first );
+        for( const auto &dest : source.second )
+            addType( dest.first );
+    }
+
+    const size_t numTypes = types.size();
+    _castPaths.resize( numTypes*numTypes );
+    for( size_t source=0; source<numTypes; ++source ) {
+        for( size_t dest=0; dest<numTypes; ++dest ) {
+            if( source!=dest )
+                _castPaths[ source*numTypes + dest ] = CastChain::findPath( *this, types[source], types[dest] );
+        }
+    }
+}
+
+const LookupContext::CastPath &LookupContext::lookupCastPath(
+        const PracticalSemanticAnalyzer::StaticType::CPtr &sourceType,
+        const PracticalSemanticAnalyzer::StaticType::CPtr &destType
+    ) const
+{
+    const CastPath *path = precomputedCastPath( sourceType, destType );
+    if( path!=nullptr )
+        return *path;
+
+    CastPathKey key{ .sourceType = sourceType, .destType = destType };
+    auto cacheIter = _castPathCache.find( key );
+    if( cacheIter==_castPathCache.end() ) {
+        CastPath path = CastChain::findPath( *this, downCast(sourceType), downCast(destType) );
+        cacheIter = _castPathCache.emplace( std::move(key), std::move(path) ).first;
+    }
+
+    return cacheIter->second;
+}
+
 // Private methods
+const LookupContext::CastPath *LookupContext::precomputedCastPath(
+        const PracticalSemanticAnalyzer::StaticType::CPtr &sourceType,
+        const PracticalSemanticAnalyzer::StaticType::CPtr &destType
+    ) const
+{
+    if( _castPathIndex.empty() ) {
+        if( getParent()==nullptr )
+            return nullptr;
+
+        return getParent()->precomputedCastPath( sourceType, destType );
+    }
+
+    auto sourceIter = _castPathIndex.find( sourceType );
+    if( sourceIter==_castPathIndex.end() )
+        return nullptr;
+
+    auto destIter = _castPathIndex.find( destType );
+    if( destIter==_castPathIndex.end() )
+        return nullptr;
+
+    return &_castPaths[ sourceIter->second*_castPathIndex.size() + destIter->second ];
+}
+
 ExpressionId LookupContext::globalFunctionCall(
         Slice<const Expression> arguments, const Function::Definition *definition,
         PracticalSemanticAnalyzer::FunctionGen *functionGen)
@@ -430,17 +502,17 @@ ExpressionId LookupContext::globalFunctionCall(
 }
 
 LookupContext::Function::Definition &LookupContext::addFunctionPass2(
-        const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi, bool isDefinition )
+        Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi, bool isDefinition )
 {
-    auto iter = _symbols.find( token->text );
-    ASSERT( iter!=_symbols.end() )<<"addFunctionPass2 called for "<<token->text<<" without 1st pass";
+    auto iter = _symbols.find( token.symbol() );
+    ASSERT( iter!=_symbols.end() )<<"addFunctionPass2 called for "<<token.text()<<" without 1st pass";
     Function *function = std::get_if<Function>( &iter->second );
     ASSERT( function!=nullptr );
 
     auto insertIter = function->overloads.emplace(
             std::piecewise_construct,
             std::make_tuple( type ),
-            std::make_tuple( token, sliceToString(token->text) ) );
+            std::make_tuple( token, sliceToString(token.text()) ) );
     Function::Definition &definition = insertIter.first->second;
 
     if( ! insertIter.second && ( !definition.declarationOnly || !isDefinition ) ) {
@@ -454,7 +526,7 @@ LookupContext::Function::Definition &LookupContext::addFunctionPass2(
         firstPassIter->second = insertIter.first;
     }
 
-    definition.mangledName = getFunctionMangledName( token->text, type, abi );
+    definition.mangledName = getFunctionMangledName( token.text(), type, abi );
     definition.type = std::move(type);
     definition.codeGen = globalFunctionCall;
 
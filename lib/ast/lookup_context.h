@@ -12,9 +12,11 @@
 #include "ast/delayed_definitions.h"
 #include "ast/static_type.h"
 #include "ast/struct_member.h"
+#include "ast/weight.h"
 #include "parser/struct.h"
 #include "parser.h"
-#include "tokenizer.h"
+#include "symbol.h"
+#include "token_stream.h"
 
 #include <practical/slice.h>
 
@@ -30,12 +32,12 @@ class Expression;
 class LookupContext : private NoCopy {
 public:
     struct Variable {
-        const Tokenizer::Token *token;
+        Tokenizer::TokenRef token;
         StaticTypeImpl::CPtr type;
         ExpressionId lvalueId;
 
-        explicit Variable( const Tokenizer::Token *token ) : token(token) {}
-        explicit Variable( const Tokenizer::Token *token, StaticTypeImpl::CPtr type, ExpressionId lvalueId ) :
+        explicit Variable( Tokenizer::TokenRef token ) : token(token) {}
+        explicit Variable( Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, ExpressionId lvalueId ) :
             token(token), type(type), lvalueId(lvalueId)
         {}
     };
@@ -49,14 +51,14 @@ public:
                     ValueRangeBase::CPtr(StaticTypeImpl::CPtr functType, Slice<ValueRangeBase::CPtr> inputRanges);
 
 
-            const Tokenizer::Token *token = nullptr;
+            Tokenizer::TokenRef token;
             StaticTypeImpl::CPtr type;
             std::string mangledName;
             CodeGenProto *codeGen = nullptr;
             VrpProto *calcVrp = nullptr;
             bool declarationOnly = true;
 
-            Definition( const Tokenizer::Token *token, const std::string &name ) :
+            Definition( Tokenizer::TokenRef token, const std::string &name ) :
                 token(token), mangledName(name)
             {}
 
@@ -64,7 +66,7 @@ public:
         };
 
         using OverloadsContainer = std::unordered_map< StaticTypeImpl::CPtr, Definition >;
-        std::unordered_map<const Tokenizer::Token *, OverloadsContainer::const_iterator> firstPassOverloads;
+        std::unordered_map<Tokenizer::TokenRef, OverloadsContainer::const_iterator> firstPassOverloads;
         OverloadsContainer overloads;
     };
 
@@ -125,7 +127,7 @@ public:
     }
 
 private:
-    StaticTypeImpl::CPtr lookupType( String name, const SourceLocation &location ) const;
+    StaticTypeImpl::CPtr lookupType( Symbol name, const SourceLocation &location ) const;
 public:
     StaticTypeImpl::CPtr lookupType( String name ) const;
     StaticTypeImpl::CPtr lookupType( const NonTerminals::Type &type ) const;
@@ -134,7 +136,7 @@ public:
     StaticTypeImpl::CPtr registerScalarType( ScalarTypeImpl &&type, ValueRangeBase::CPtr defaultValueRange );
 
     void addBuiltinFunction(
-            const std::string &name, StaticTypeImpl::CPtr returnType, Slice<const StaticTypeImpl::CPtr> argumentTypes,
+            Symbol name, StaticTypeImpl::CPtr returnType, Slice<const StaticTypeImpl::CPtr> argumentTypes,
             Function::Definition::CodeGenProto *codeGen,
             Function::Definition::VrpProto *calcVrp
 
@@ -143,13 +145,13 @@ public:
     enum class AbiType { Practical, C };
     friend std::ostream &operator<<( std::ostream &out, AbiType abi );
 
-    void addFunctionDeclarationPass1( const Tokenizer::Token *token );
-    void addFunctionDefinitionPass1( const Tokenizer::Token *token );
+    void addFunctionDeclarationPass1( Tokenizer::TokenRef token );
+    void addFunctionDefinitionPass1( Tokenizer::TokenRef token );
     void addStructPass1( const NonTerminals::StructDef &token );
     void addFunctionDeclarationPass2(
-            const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi = AbiType::Practical );
+            Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi = AbiType::Practical );
     void addFunctionDefinitionPass2(
-            const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi = AbiType::Practical );
+            Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi = AbiType::Practical );
     void addStructPass2( const NonTerminals::StructDef &token, DelayedDefinitions &delayedDefs );
 
     void declareFunctions( PracticalSemanticAnalyzer::ModuleGen *moduleGen ) const;
@@ -158,11 +160,11 @@ public:
 
     static AbiType parseAbiString( String abiString, const SourceLocation &location );
 
-    void addLocalVar( const Tokenizer::Token *token, StaticTypeImpl::CPtr type, ExpressionId lvalue );
-    String addStructMember(
-            const Tokenizer::Token *token, StaticTypeImpl::CPtr type, size_t offset );
+    void addLocalVar( Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, ExpressionId lvalue );
+    Symbol addStructMember(
+            Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, size_t offset );
 
-    const Identifier *lookupIdentifier( String name ) const;
+    const Identifier *lookupIdentifier( Symbol name ) const;
 
     // Generic type and range to use for unspecified function
     static StaticTypeImpl::CPtr genericFunctionType();
@@ -217,6 +219,30 @@ public:
     CastsList allCastsTo( PracticalSemanticAnalyzer::StaticType::CPtr destType ) const;
     CastsList allCastsFrom( PracticalSemanticAnalyzer::StaticType::CPtr sourceType ) const;
 
+    // The cheapest chain of casts from one type to another. Weights are relative to the source's.
+    struct CastPath {
+        struct Step {
+            const CastDescriptor *cast;
+            StaticTypeImpl::CPtr type;          // The type this step casts to
+        };
+
+        std::vector<Step> steps;                // Empty if the destination is unreachable
+        Weight weight;
+        Weight farthest;                        // Heaviest path explored while searching
+        bool ambiguous = false;
+    };
+
+    // Search the path between every two types that have casts (and their flagged variants) once, so that the cast
+    // chain needs no search for them. Call after all casts were added.
+    void precomputeCastPaths();
+
+    // The cheapest path from sourceType to destType. Paths that were not precomputed are searched once per context and
+    // remembered, so only the value range check is repeated for each cast. Whether the cast is implicit does not change
+    // the path, only whether its value range checks pass.
+    const CastPath &lookupCastPath(
+            const PracticalSemanticAnalyzer::StaticType::CPtr &sourceType,
+            const PracticalSemanticAnalyzer::StaticType::CPtr &destType ) const;
+
 private:
     static ExpressionId globalFunctionCall(
             Slice<const Expression>,
@@ -224,17 +250,39 @@ private:
             PracticalSemanticAnalyzer::FunctionGen *functionGen);
 
     Function::Definition &addFunctionPass2(
-            const Tokenizer::Token *token, StaticTypeImpl::CPtr type, AbiType abi, bool isDefinition );
+            Tokenizer::TokenRef token, StaticTypeImpl::CPtr type, AbiType abi, bool isDefinition );
+
+    const CastPath *precomputedCastPath(
+            const PracticalSemanticAnalyzer::StaticType::CPtr &sourceType,
+            const PracticalSemanticAnalyzer::StaticType::CPtr &destType ) const;
+
+    struct CastPathKey {
+        PracticalSemanticAnalyzer::StaticType::CPtr sourceType, destType;
+
+        bool operator==( const CastPathKey &that ) const {
+            return sourceType==that.sourceType && destType==that.destType;
+        }
+    };
+
+    struct CastPathKeyHash {
+        size_t operator()( const CastPathKey &key ) const {
+            size_t result = std::hash<const PracticalSemanticAnalyzer::StaticType *>{}( key.sourceType.get() );
+            result *= FibonacciHashMultiplier;
+            result += std::hash<const PracticalSemanticAnalyzer::StaticType *>{}( key.destType.get() );
+
+            return result;
+        }
+    };
 
     // Members
     static StaticTypeImpl::CPtr _genericFunctionType;
     static ValueRangeBase::CPtr _genericFunctionRange;
 
-    std::unordered_map< std::string, StaticTypeImpl::Ptr > _typesUnderConstruction;
-    std::unordered_map< std::string, StaticTypeImpl::CPtr > _types;
+    std::unordered_map< Symbol, StaticTypeImpl::Ptr > _typesUnderConstruction;
+    std::unordered_map< Symbol, StaticTypeImpl::CPtr > _types;
     const LookupContext *_parent = nullptr;
 
-    std::unordered_map< String, Identifier > _symbols;
+    std::unordered_map< Symbol, Identifier > _symbols;
 
     std::unordered_map<
             PracticalSemanticAnalyzer::StaticType::CPtr,
@@ -245,6 +293,13 @@ private:
             PracticalSemanticAnalyzer::StaticType::CPtr,
             std::unordered_set< PracticalSemanticAnalyzer::StaticType::CPtr >
     > _typeConversionsTo;
+
+    // Precomputed cast paths. The path from type a to type b is at _castPaths[ index(a)*numTypes + index(b) ]
+    std::unordered_map< PracticalSemanticAnalyzer::StaticType::CPtr, unsigned > _castPathIndex;
+    std::vector< CastPath > _castPaths;
+
+    // Searched paths that were not precomputed. Lookups are const, so this is filled in as a side effect.
+    mutable std::unordered_map< CastPathKey, CastPath, CastPathKeyHash > _castPathCache;
 };
 
 } // End namespace AST
@@ -53,23 +53,19 @@ void Module::symbolsPass2() {
         }
 
         if( !delayedDefs.pending.empty() ) {
-            throw CircularDependency( delayedDefs.pending.begin()->first->keyword->location );
-        }
-
-        for( StructTypeImpl *needHash : delayedDefs.hashless ) {
-            needHash->calcHash();
+            throw CircularDependency( delayedDefs.pending.begin()->first->keyword.location() );
         }
     }
 
     for( const auto &funcDecl : parserModule.functionDeclarations ) {
         StaticTypeImpl::CPtr funcType = constructFunctionType( funcDecl.decl );
 
-        if( funcDecl.abiSpecifier.token != nullptr ) {
+        if( funcDecl.abiSpecifier.token ) {
             lookupContext.addFunctionDeclarationPass2(
                     funcDecl.decl.name.identifier,
                     funcType,
                     LookupContext::parseAbiString(
-                        funcDecl.abiSpecifier.value, funcDecl.abiSpecifier.token->location)
+                        funcDecl.abiSpecifier.getValue(), funcDecl.abiSpecifier.token.location())
                 );
         } else {
             lookupContext.addFunctionDeclarationPass2( funcDecl.decl.name.identifier, funcType );
@@ -113,7 +109,7 @@ StaticTypeImpl::CPtr Module::constructFunctionType( const NonTerminals::FuncDecl
         arguments.emplace_back( lookupContext.lookupType( argument.type ) );
     }
 
-    return StaticTypeImpl::allocate(
+    return StaticTypeImpl::intern(
             FunctionTypeImpl(
                 std::move(returnType),
                 std::move(arguments)
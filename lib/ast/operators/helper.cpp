@@ -23,7 +23,7 @@ const UnsignedIntValueRange *getUnsignedOverloadRange(
 
     auto firstArgType = static_cast< const StaticTypeImpl * >(function->getArgumentType(0).get());
     auto firstArgRange = firstArgType->defaultRange();
-    ASSERT( dynamic_cast< const UnsignedIntValueRange * >(firstArgRange.get()) != nullptr );
+    ASSERT( firstArgRange->is<UnsignedIntValueRange>() );
 
     return static_cast< const UnsignedIntValueRange * >(firstArgRange.get());
 }
@@ -37,7 +37,7 @@ const SignedIntValueRange *getSignedOverloadRange(
 
     auto firstArgType = static_cast< const StaticTypeImpl * >(function->getArgumentType(0).get());
     auto firstArgRange = firstArgType->defaultRange();
-    ASSERT( dynamic_cast< const SignedIntValueRange * >(firstArgRange.get()) != nullptr );
+    ASSERT( firstArgRange->is<SignedIntValueRange>() );
 
     return static_cast< const SignedIntValueRange * >(firstArgRange.get());
 }
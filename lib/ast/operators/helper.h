@@ -20,14 +20,8 @@ std::vector<const T *> downcastValueRanges(Slice<ValueRangeBase::CPtr> baseRange
     std::vector<const T *> ret;
     ret.reserve( baseRanges.size() );
 
-    for( auto baseRange : baseRanges ) {
-#ifndef NDEBUG
-        const T *ptr = dynamic_cast<const T *>( baseRange.get() );
-        ASSERT( ptr!=nullptr )<<"Downcast did from incorrect type";
-#else
-        const T *ptr = static_cast<const T *>( baseRange.get() );
-#endif
-        ret.emplace_back( ptr );
+    for( const auto &baseRange : baseRanges ) {
+        ret.emplace_back( baseRange->as<T>() );
     }
 
     return ret;
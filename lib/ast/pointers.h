@@ -15,20 +15,25 @@ namespace AST {
 
 class PointerValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::Pointer;
+
     ValueRangeBase::CPtr pointedValueRange;
     BoolValueRange initialized;
 
     explicit PointerValueRange( ValueRangeBase::CPtr pointedRange ) :
+        ValueRangeBase( StaticKind ),
         pointedValueRange( std::move( pointedRange ) ),
         initialized( false, true )
     {}
 
     explicit PointerValueRange( ValueRangeBase::CPtr pointedRange, const BoolValueRange &initialized ) :
+        ValueRangeBase( StaticKind ),
         pointedValueRange( std::move(pointedRange) ),
         initialized( initialized.falseAllowed, initialized.trueAllowed )
     {}
 
     explicit PointerValueRange( std::nullptr_t null ) :
+        ValueRangeBase( StaticKind ),
         initialized( true, false )
     {}
 
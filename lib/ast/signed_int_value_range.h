@@ -20,8 +20,12 @@ namespace AST {
 
 class SignedIntValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::SignedInt;
+
     LongEnoughIntSigned minimum, maximum;
 
+    SignedIntValueRange() : ValueRangeBase( StaticKind ) {}
+
     bool isLiteral() const override {
         return minimum==maximum;
     }
@@ -37,14 +37,14 @@ void Statement::buildAST( LookupContext &lookupCtx ) {
             ABORT()<<"Statement is in monostate";
         }
 
-        void operator()( const NonTerminals::Expression &parserExpression ) {
-            auto &expression = _this.underlyingStatement.emplace<Expression>(parserExpression);
+        void operator()( NonTerminals::NodeIndex<NonTerminals::Expression> parserExpression ) {
+            auto &expression = _this.underlyingStatement.emplace<Expression>(*parserExpression);
             Weight weight;
             expression.buildAST(lookupCtx, ExpectedResult(), weight, Expression::NoWeightLimit);
         }
 
-        void operator()( const NonTerminals::VariableDefinition &parserVarDef ) {
-            auto &varDef = _this.underlyingStatement.emplace<VariableDefinition>(parserVarDef);
+        void operator()( NonTerminals::NodeIndex<NonTerminals::VariableDefinition> parserVarDef ) {
+            auto &varDef = _this.underlyingStatement.emplace<VariableDefinition>(*parserVarDef);
             varDef.buildAST(lookupCtx);
         }
 
@@ -53,7 +53,7 @@ void Statement::buildAST( LookupContext &lookupCtx ) {
             condition.buildAST(lookupCtx);
         }
 
-        void operator()( const std::unique_ptr<NonTerminals::CompoundStatement> &parserCompound ) {
+        void operator()( NonTerminals::NodeIndex<NonTerminals::CompoundStatement> parserCompound ) {
             auto &compound = _this.underlyingStatement.emplace<
                     std::unique_ptr<CompoundStatement>
                 >(
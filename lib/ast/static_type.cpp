@@ -12,12 +12,122 @@
 #include "ast/hash_modifiers.h"
 #include "ast/pointers.h"
 
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 using namespace PracticalSemanticAnalyzer;
 
 namespace AST {
 
+namespace {
+
+size_t hashOf( const StaticTypeImpl::CPtr &type ) {
+    if( !type )
+        return 0;
+
+    return type->getHash();
+}
+
+size_t hashFunction( const FunctionTypeImpl *function ) {
+    size_t result = 0;
+
+    auto numArguments = function->getNumArguments();
+    for( unsigned i=0; i<numArguments; ++i ) {
+        result += hashOf( downCast( function->getArgumentType(i) ) );
+        result *= FibonacciHashMultiplier;
+    }
+
+    result += hashOf( downCast( function->getReturnType() ) );
+
+    return result;
+}
+
+size_t hashPointer( const StaticTypeImpl::CPtr &pointed ) {
+    return hashOf( pointed ) * (FibonacciHashMultiplier - PointerModifier);
+}
+
+size_t hashArray( const StaticTypeImpl::CPtr &element, size_t numElements ) {
+    return hashOf( element ) * (FibonacciHashMultiplier - ArrayModifier) + numElements;
+}
+
+// The components of a canonical type are themselves canonical, so the tables compare them by address
+struct FunctionKeyHash {
+    size_t operator()( const FunctionTypeImpl *function ) const {
+        size_t result = std::hash<const StaticType *>{}( function->getReturnType().get() );
+
+        auto numArguments = function->getNumArguments();
+        for( unsigned i=0; i<numArguments; ++i ) {
+            result *= FibonacciHashMultiplier;
+            result += std::hash<const StaticType *>{}( function->getArgumentType(i).get() );
+        }
+
+        return result;
+    }
+};
+
+struct FunctionKeyEqual {
+    bool operator()( const FunctionTypeImpl *lhs, const FunctionTypeImpl *rhs ) const {
+        auto numArguments = lhs->getNumArguments();
+        if( numArguments!=rhs->getNumArguments() || lhs->getReturnType()!=rhs->getReturnType() )
+            return false;
+
+        for( unsigned i=0; i<numArguments; ++i ) {
+            if( lhs->getArgumentType(i)!=rhs->getArgumentType(i) )
+                return false;
+        }
+
+        return true;
+    }
+};
+
+struct ArrayKeyHash {
+    size_t operator()( const std::pair<const StaticType *, size_t> &array ) const {
+        return std::hash<const StaticType *>{}( array.first ) * FibonacciHashMultiplier + array.second;
+    }
+};
+
+} // Anonymous namespace
+
+// Types shared by all compilations are kept alive by the table they are in. Those made of a struct are kept weakly, as
+// each of them keeps the struct, which holds their table, alive. Each table has a lock of its own.
+struct InternTables {
+    std::mutex functionsLock, arraysLock, pointersLock;
+    std::unordered_map<
+            const FunctionTypeImpl *, const StaticTypeImpl *, FunctionKeyHash, FunctionKeyEqual > functions;
+    std::unordered_map< std::pair<const StaticType *, size_t>, const StaticTypeImpl *, ArrayKeyHash > arrays;
+    std::unordered_map< const StaticType *, const StaticTypeImpl * > pointers;
+};
+
+namespace {
+
+// Constructed on first use, as static types are created during static initialization. Never destructed.
+InternTables &processWideTables() {
+    static InternTables *tables = new InternTables;
+
+    return *tables;
+}
+
+// Only taken to create a flag variant
+std::mutex flagVariantsLock;
+
+// A type made of a struct stays in its table until its destructor removes it, so it might be on its way out
+bool live( const StaticTypeImpl *type ) {
+    return type!=nullptr && type->use_count()>0;
+}
+
+template<typename Map, typename Key>
+void forget( std::mutex &lock, Map &map, const StaticTypeImpl *type, const Key &key ) {
+    std::lock_guard<std::mutex> guard( lock );
+
+    // Might have been replaced already, if it was looked up after its last reference was dropped
+    auto iter = map.find( key );
+    if( iter!=map.end() && iter->second==type )
+        map.erase( iter );
+}
+
+} // Anonymous namespace
+
 ScalarTypeImpl::ScalarTypeImpl(
         String name, String mangledName, size_t size, size_t alignment, Scalar::Type type,
         PracticalSemanticAnalyzer::TypeId backendType, unsigned literalWeight
@@ -58,6 +168,106 @@ PracticalSemanticAnalyzer::StaticType::CPtr PointerTypeImpl::getPointedType() co
     return pointed;
 }
 
+StaticTypeImpl::CPtr StaticTypeImpl::intern( FunctionTypeImpl &&function ) {
+    // Made of the first struct among the return and argument types, if any
+    const StaticTypeImpl *owner = ownerOf( function.getReturnType() );
+    for( unsigned i=0; owner==nullptr && i<function.getNumArguments(); ++i )
+        owner = ownerOf( function.getArgumentType(i) );
+
+    InternTables &tables = internTables( owner );
+    std::lock_guard<std::mutex> lock( tables.functionsLock );
+
+    auto iter = tables.functions.find( &function );
+    if( iter!=tables.functions.end() ) {
+        if( live( iter->second ) )
+            return iter->second;
+
+        tables.functions.erase( iter );
+    }
+
+    StaticTypeImpl *type = new StaticTypeImpl( std::move(function) );
+    tables.functions.emplace( std::get< std::unique_ptr<FunctionTypeImpl> >( type->content ).get(), type );
+
+    return interned( type, owner );
+}
+
+StaticTypeImpl::CPtr StaticTypeImpl::intern( ArrayTypeImpl &&array ) {
+    const StaticTypeImpl *owner = ownerOf( array.getElementType() );
+    InternTables &tables = internTables( owner );
+    std::lock_guard<std::mutex> lock( tables.arraysLock );
+
+    const StaticTypeImpl *&type =
+            tables.arrays[ std::make_pair( array.getElementType().get(), array.getNumElements() ) ];
+    if( !live( type ) )
+        type = interned( new StaticTypeImpl( std::move(array) ), owner );
+
+    return type;
+}
+
+StaticTypeImpl::CPtr StaticTypeImpl::intern( PointerTypeImpl &&ptr ) {
+    const StaticTypeImpl *owner = ownerOf( ptr.getPointedType() );
+    InternTables &tables = internTables( owner );
+    std::lock_guard<std::mutex> lock( tables.pointersLock );
+
+    const StaticTypeImpl *&type = tables.pointers[ ptr.getPointedType().get() ];
+    if( !live( type ) )
+        type = interned( new StaticTypeImpl( std::move(ptr) ), owner );
+
+    return type;
+}
+
+const StaticTypeImpl *StaticTypeImpl::ownerOf( const StaticType::CPtr &type ) {
+    return type ? downCast(type)->owner : nullptr;
+}
+
+InternTables &StaticTypeImpl::internTables( const StaticTypeImpl *owner ) {
+    return owner!=nullptr ? *owner->derivedTypes : processWideTables();
+}
+
+StaticTypeImpl *StaticTypeImpl::interned( StaticTypeImpl *type, const StaticTypeImpl *owner ) {
+    type->owner = owner;
+    if( owner==nullptr )
+        intrusive_ptr_add_ref( type );
+
+    return type;
+}
+
+void StaticTypeImpl::forgetInterned() const {
+    InternTables &tables = *owner->derivedTypes;
+
+    struct Visitor {
+        const StaticTypeImpl *_this;
+        InternTables &tables;
+
+        void operator()( const std::unique_ptr<ScalarTypeImpl> &scalar ) {
+            ABORT()<<"Scalar types are not interned";
+        }
+
+        void operator()( const std::unique_ptr<FunctionTypeImpl> &function ) {
+            forget( tables.functionsLock, tables.functions, _this, function.get() );
+        }
+
+        void operator()( const PointerTypeImpl &pointer ) {
+            forget( tables.pointersLock, tables.pointers, _this, pointer.getPointedType().get() );
+        }
+
+        void operator()( const ArrayTypeImpl &array ) {
+            forget( tables.arraysLock, tables.arrays, _this,
+                    std::make_pair( array.getElementType().get(), array.getNumElements() ) );
+        }
+
+        void operator()( const StructTypeImpl::Ptr &strct ) {
+            ABORT()<<"Struct types are not interned";
+        }
+
+        void operator()( const StructTypeImpl::CPtr &strct ) {
+            ABORT()<<"Struct types are not interned";
+        }
+    };
+
+    std::visit( Visitor{ ._this=this, .tables=tables }, content );
+}
+
 StaticType::Types StaticTypeImpl::getType() const {
     struct Visitor {
         Types operator()( const std::unique_ptr<ScalarTypeImpl> &scalar ) {
@@ -113,12 +323,13 @@ StaticTypeImpl::CPtr StaticTypeImpl::coreType() const {
 }
 
 String StaticTypeImpl::getMangledName() const {
-    if( mangledName.empty() ) {
-        std::ostringstream formatter;
-        getMangledName(formatter);
+    // Types are shared between threads
+    std::call_once( mangledNameOnce, [this]() {
+                std::ostringstream formatter;
+                getMangledName(formatter);
 
-        mangledName = std::move(formatter).str();
-    }
+                mangledName = std::move(formatter).str();
+            } );
 
     return mangledName;
 }
@@ -240,48 +451,34 @@ size_t StaticTypeImpl::getAlignment() const {
     return std::visit( Visitor{}, getType() );
 }
 
-size_t StaticTypeImpl::getHash() const {
+size_t StaticTypeImpl::calcHash() const {
     auto typeType = getType();
 
     struct Visitor {
-        const StaticTypeImpl &_this;
-
         size_t operator()( const StaticType::Scalar *scalar ) {
             return std::hash<String>{}( scalar->getName() );
         }
 
         size_t operator()( const StaticType::Function *function ) {
-            size_t result = 0;
-
-            auto numArguments = function->getNumArguments();
-            for( unsigned i=0; i<numArguments; ++i ) {
-                result += downCast( function->getArgumentType(i) )->getHash();
-                result *= FibonacciHashMultiplier;
-            }
-
-            result += downCast( function->getReturnType() )->getHash();
-
-            return result;
+            return hashFunction( downCast(function) );
         }
 
         size_t operator()( const StaticType::Pointer *pointer ) {
-            return
-                    downCast( pointer->getPointedType() )->getHash() *
-                    (FibonacciHashMultiplier - PointerModifier);
+            return hashPointer( downCast( pointer->getPointedType() ) );
         }
 
         size_t operator()( const StaticType::Array *array ) {
-            return downCast( array->getElementType() )->getHash() * (FibonacciHashMultiplier - ArrayModifier) +
-                   array->getNumElements();
+            return hashArray( downCast( array->getElementType() ), array->getNumElements() );
         }
 
         size_t operator()( const StaticType::Struct *strct ) {
-            return downCast( strct )->getHash();
+            // Structs are nominal. Their members might not be known yet.
+            return ( FibonacciHashMultiplier - StructModifier ) + std::hash<String>{}( strct->getName() );
         }
     };
 
     size_t retVal =
-            typeType.index() * FibonacciHashMultiplier + std::visit( Visitor{._this = *this}, typeType );
+            typeType.index() * FibonacciHashMultiplier + std::visit( Visitor{}, typeType );
 
     size_t asserter = 0;
     if( (getFlags() & Flags::Reference) != 0 ) {
@@ -297,38 +494,43 @@ size_t StaticTypeImpl::getHash() const {
     return retVal;
 }
 
-size_t StaticTypeImpl::calcHashInternal( const StructTypeImpl *anchor ) const {
-    struct Visitor {
-        const StructTypeImpl *anchor;
-        const StaticTypeImpl &this_;
+StaticType::CPtr StaticTypeImpl::setFlags( Flags::Type newFlags ) const {
+    if( flags==newFlags )
+        return this;
 
-        size_t operator()( const Scalar *scalar ) const {
-            return this_.getHash();
-        }
+    const StaticTypeImpl *base = unflagged ? unflagged.get() : this;
+    if( newFlags==0 )
+        return base;
 
-        size_t operator()( const Function *function ) const {
-            return this_.getHash();
-        }
+    ASSERT( newFlags<NumFlagVariants )<<"Unhandled type flags "<<newFlags;
+    std::atomic<const StaticTypeImpl *> &slot = base->flagVariants[newFlags];
+    const StaticTypeImpl *variant = slot.load( std::memory_order_acquire );
+    if( variant!=nullptr )
+        return variant;
 
-        size_t operator()( const Pointer *pointer ) const {
-            return
-                    downCast( pointer->getPointedType() )->calcHashInternal( anchor ) *
-                    (FibonacciHashMultiplier - PointerModifier);
-        }
+    std::lock_guard<std::mutex> lock( flagVariantsLock );
+    variant = slot.load( std::memory_order_relaxed );
+    if( variant==nullptr ) {
+        variant = new StaticTypeImpl( *base, newFlags );
 
-        size_t operator()( const Array *array ) const {
-            return
-                    downCast( array->getElementType() )->calcHashInternal( anchor ) *
-                    (FibonacciHashMultiplier - ArrayModifier) +
-                    array->getNumElements();
-        }
+        // Structs belong to the module defining them, and the variants of types made of them go with them. The
+        // variants of all other types are kept forever, as another thread might be using them.
+        if( base->owner==nullptr )
+            intrusive_ptr_add_ref( variant );
 
-        size_t operator()( const Struct *strct ) const {
-            return downCast( strct )->calcHash( anchor );
-        }
-    };
+        slot.store( variant, std::memory_order_release );
+    }
+
+    return variant;
+}
 
-    return std::visit( Visitor{.anchor = anchor, .this_ = *this}, getType() );
+StaticTypeImpl::~StaticTypeImpl() {
+    if( unflagged ) {
+        std::lock_guard<std::mutex> lock( flagVariantsLock );
+        unflagged->flagVariants[flags].store( nullptr, std::memory_order_relaxed );
+    } else if( owner!=nullptr && owner!=this ) {
+        forgetInterned();
+    }
 }
 
 void FunctionTypeImpl::getMangledName(std::ostringstream &formatter) const {
@@ -360,9 +562,11 @@ size_t ArrayTypeImpl::getNumElements() const {
     return dimension;
 }
 
-StaticTypeImpl::StaticTypeImpl( const StaticTypeImpl &that ) :
+StaticTypeImpl::StaticTypeImpl( const StaticTypeImpl &that, Flags::Type flags ) :
     valueRange( that.valueRange ),
-    flags( that.flags )
+    flags( flags ),
+    unflagged( &that ),
+    owner( that.owner )
 {
     struct Visitor {
         StaticTypeImpl *_this;
@@ -393,17 +597,20 @@ StaticTypeImpl::StaticTypeImpl( const StaticTypeImpl &that ) :
     };
 
     std::visit( Visitor{ ._this=this }, that.content );
+    hash = calcHash();
 }
 
 StaticTypeImpl::StaticTypeImpl( ScalarTypeImpl &&scalar, ValueRangeBase::CPtr valueRange ) :
     content( std::unique_ptr<ScalarTypeImpl>( new ScalarTypeImpl( std::move(scalar) ) ) ),
     valueRange(valueRange)
 {
+    hash = calcHash();
 }
 
 StaticTypeImpl::StaticTypeImpl( FunctionTypeImpl &&function ) :
     content( safenew<FunctionTypeImpl>( std::move(function) ) )
 {
+    hash = calcHash();
 }
 
 StaticTypeImpl::StaticTypeImpl( PointerTypeImpl &&ptr ) :
@@ -416,6 +623,7 @@ StaticTypeImpl::StaticTypeImpl( PointerTypeImpl &&ptr ) :
 {
     // Easier to initialize content after the value range
     content = std::move(ptr);
+    hash = calcHash();
 }
 
 StaticTypeImpl::StaticTypeImpl( ArrayTypeImpl &&ptr ) :
@@ -428,11 +636,16 @@ StaticTypeImpl::StaticTypeImpl( ArrayTypeImpl &&ptr ) :
 {
     // Easier to initialize content after the value range
     content = std::move(ptr);
+    hash = calcHash();
 }
 
 StaticTypeImpl::StaticTypeImpl( StructTypeImpl &&strct ) :
-    content( StructTypeImpl::Ptr(new StructTypeImpl( std::move(strct) )) )
-{}
+    content( StructTypeImpl::Ptr(new StructTypeImpl( std::move(strct) )) ),
+    owner( this ),
+    derivedTypes( new InternTables )
+{
+    hash = calcHash();
+}
 
 void StaticTypeImpl::completeConstruction() {
     StructTypeImpl::CPtr typeUnderConstruction( getMutableStruct() );
@@ -444,45 +657,6 @@ std::ostream &operator<<( std::ostream &out, const AST::StaticTypeImpl::CPtr &ty
     return out<<static_cast<PracticalSemanticAnalyzer::StaticType::CPtr>(type);
 }
 
-StaticTypeImpl::CPtr downCast( StaticType::CPtr ptr ) {
-    auto downCasted = dynamic_cast<const StaticTypeImpl *>( ptr.get() );
-    ASSERT( downCasted || !ptr );
-
-    return downCasted;
-}
-
-const PointerTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Pointer * ptr ) {
-    ASSERT( ptr );
-    auto downCasted = dynamic_cast<const PointerTypeImpl *>( ptr );
-    ASSERT( downCasted );
-
-    return downCasted;
-}
-
-const FunctionTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Function * ptr ) {
-    ASSERT( ptr );
-    auto downCasted = dynamic_cast<const FunctionTypeImpl *>( ptr );
-    ASSERT( downCasted );
-
-    return downCasted;
-}
-
-const ArrayTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Array * ptr ) {
-    ASSERT( ptr );
-    auto downCasted = dynamic_cast<const ArrayTypeImpl *>( ptr );
-    ASSERT( downCasted );
-
-    return downCasted;
-}
-
-const StructTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Struct * ptr ) {
-    ASSERT( ptr );
-    auto downCasted = dynamic_cast<const StructTypeImpl *>( ptr );
-    ASSERT( downCasted );
-
-    return downCasted;
-}
-
 size_t alignUp( size_t ptr, size_t alignment ) {
     ASSERT( alignment>0 );
     ptr += alignment - 1;
@@ -15,12 +15,16 @@
 
 #include <practical/practical.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <type_traits>
 
 namespace AST {
 
 class StaticTypeImpl;
+struct InternTables;
 
 class ScalarTypeImpl final : public PracticalSemanticAnalyzer::StaticType::Scalar {
     std::string name;
@@ -100,7 +104,14 @@ public:
 };
 
 class StaticTypeImpl final : public PracticalSemanticAnalyzer::StaticType {
+public:
+    using CPtr = boost::intrusive_ptr<const StaticTypeImpl>;
+    using Ptr = boost::intrusive_ptr<StaticTypeImpl>;
+
+    static constexpr size_t NumFlagVariants = (Flags::Reference | Flags::Mutable) + 1;
+
 private:
+
     // Members
     std::variant<
             std::unique_ptr<ScalarTypeImpl>,
@@ -112,16 +123,41 @@ private:
     > content;
     ValueRangeBase::CPtr valueRange;
     mutable std::string mangledName;
+    mutable std::once_flag mangledNameOnce;
+    size_t hash = 0;
     Flags::Type flags = 0;
 
-public:
-    using CPtr = boost::intrusive_ptr<const StaticTypeImpl>;
-    using Ptr = boost::intrusive_ptr<StaticTypeImpl>;
+    // Each flag variant of a type is created once. The unflagged type points at its live variants, and each variant
+    // keeps the unflagged type alive. Variants of types shared by all compilations are never freed, so that any thread
+    // may use them without a lock.
+    CPtr unflagged;
+    mutable std::atomic<const StaticTypeImpl *> flagVariants[NumFlagVariants] = {};
 
-    template<typename... Args>
-    static Ptr allocate(Args&&... args) {
-        return new StaticTypeImpl( std::forward<Args>(args)... );
+    // The struct this type is made of, or the type itself for a struct. Null for types shared by all compilations.
+    const StaticTypeImpl *owner = nullptr;
+    // Of a struct: the interned types made of it. They belong to the module defining the struct, so they are kept
+    // here rather than in the process wide tables, and each is removed when it is freed.
+    std::unique_ptr<InternTables> derivedTypes;
+
+public:
+    // Scalars and structs are told apart by name, so each one is allocated once, when it is defined. All other types
+    // must be interned.
+    static Ptr allocate( ScalarTypeImpl &&scalar, ValueRangeBase::CPtr valueRange ) {
+        return new StaticTypeImpl( std::move(scalar), std::move(valueRange) );
     }
+    static Ptr allocate( StructTypeImpl &&strct ) {
+        return new StaticTypeImpl( std::move(strct) );
+    }
+
+    // Function, array and pointer types are hash consed: structurally equal types are the same instance. Two types are,
+    // therefore, equal only if they are the same object. Types made of builtin types only are shared by all
+    // compilations and never freed. Types made of a struct are freed once unused, like the struct itself. Thread safe,
+    // but a type made of a struct must only be interned by the thread compiling the struct's module.
+    static CPtr intern( FunctionTypeImpl &&function );
+    static CPtr intern( ArrayTypeImpl &&array );
+    static CPtr intern( PointerTypeImpl &&ptr );
+
+    ~StaticTypeImpl();
 
     virtual Types getType() const override final;
     CPtr coreType() const;
@@ -132,9 +168,9 @@ public:
     bool sizeKnown() const;
     virtual size_t getSize() const override;
     virtual size_t getAlignment() const override;
-    size_t getHash() const;
-
-    size_t calcHashInternal(const StructTypeImpl *anchor) const;
+    size_t getHash() const {
+        return hash;
+    }
 
     ValueRangeBase::CPtr defaultRange() const {
         return valueRange;
@@ -144,15 +180,7 @@ public:
         return flags;
     }
 
-    virtual StaticType::CPtr setFlags( Flags::Type newFlags ) const override {
-        if( flags==newFlags )
-            return this;
-
-        Ptr ret = allocate( *this );
-        ret->flags = newFlags;
-
-        return ret;
-    }
+    virtual StaticType::CPtr setFlags( Flags::Type newFlags ) const override;
 
     // For use during construction
     StructTypeImpl *getMutableStruct() {
@@ -168,35 +196,63 @@ public:
     friend std::ostream &operator<<( std::ostream &out, const AST::StaticTypeImpl::CPtr &type );
 
 private:
-    // Copy
-    explicit StaticTypeImpl( const StaticTypeImpl &that );
+    // Flag variant
+    explicit StaticTypeImpl( const StaticTypeImpl &unflagged, Flags::Type flags );
 
     explicit StaticTypeImpl( ScalarTypeImpl &&scalar, ValueRangeBase::CPtr valueRange );
     explicit StaticTypeImpl( FunctionTypeImpl &&function );
     explicit StaticTypeImpl( ArrayTypeImpl &&array );
     explicit StaticTypeImpl( PointerTypeImpl &&ptr );
     explicit StaticTypeImpl( StructTypeImpl &&strct );
+
+    size_t calcHash() const;
+
+    // The struct whose table types made of type are interned into, or null for the process wide tables
+    static const StaticTypeImpl *ownerOf( const StaticType::CPtr &type );
+    static InternTables &internTables( const StaticTypeImpl *owner );
+    // Finish interning a new type
+    static StaticTypeImpl *interned( StaticTypeImpl *type, const StaticTypeImpl *owner );
+    // Remove a type made of a struct from the struct's table
+    void forgetInterned() const;
 };
 
-StaticTypeImpl::CPtr downCast( PracticalSemanticAnalyzer::StaticType::CPtr ptr );
-const PointerTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Pointer * ptr );
-const FunctionTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Function * ptr );
-const ArrayTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Array * ptr );
-const StructTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Struct * ptr );
+// Each of the type interfaces has exactly one, final, implementation, so these need no run time check. Which
+// interface a type implements is told by its getType().
+static_assert( std::is_final_v<StaticTypeImpl> && std::is_final_v<PointerTypeImpl> &&
+        std::is_final_v<FunctionTypeImpl> && std::is_final_v<ArrayTypeImpl> && std::is_final_v<StructTypeImpl> );
+
+inline StaticTypeImpl::CPtr downCast( const PracticalSemanticAnalyzer::StaticType::CPtr &ptr ) {
+    return static_cast<const StaticTypeImpl *>( ptr.get() );
+}
+
+inline const PointerTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Pointer * ptr ) {
+    ASSERT( ptr );
+    return static_cast<const PointerTypeImpl *>( ptr );
+}
+
+inline const FunctionTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Function * ptr ) {
+    ASSERT( ptr );
+    return static_cast<const FunctionTypeImpl *>( ptr );
+}
+
+inline const ArrayTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Array * ptr ) {
+    ASSERT( ptr );
+    return static_cast<const ArrayTypeImpl *>( ptr );
+}
+
+inline const StructTypeImpl *downCast( const PracticalSemanticAnalyzer::StaticType::Struct * ptr ) {
+    ASSERT( ptr );
+    return static_cast<const StructTypeImpl *>( ptr );
+}
 
 size_t alignUp( size_t ptr, size_t alignment );
 size_t alignDown( size_t ptr, size_t alignment );
 
 } // End namespace AST
 
+// Types are canonical, so comparing them is comparing their addresses
 inline bool operator==( const AST::StaticTypeImpl::CPtr &lhs, const AST::StaticTypeImpl::CPtr &rhs ) {
-    if( !lhs && !rhs )
-        return true;
-
-    if( !lhs || !rhs )
-        return false;
-
-    return *lhs == *rhs;
+    return lhs.get() == rhs.get();
 }
 
 inline bool operator!=( const AST::StaticTypeImpl::CPtr &lhs, const AST::StaticTypeImpl::CPtr &rhs ) {
@@ -212,7 +268,7 @@ namespace std {
     class hash< AST::StaticTypeImpl::CPtr > {
     public:
         size_t operator()( const AST::StaticTypeImpl::CPtr &ptr ) const {
-            return hash< PracticalSemanticAnalyzer::StaticType::CPtr >()( ptr.get() );
+            return ptr->getHash();
         }
     };
 }
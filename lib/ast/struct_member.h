@@ -9,7 +9,7 @@
 #ifndef AST_STRUCT_MEMBER_H
 #define AST_STRUCT_MEMBER_H
 
-#include "tokenizer.h"
+#include "token_stream.h"
 
 #include <boost/intrusive_ptr.hpp>
 
@@ -18,11 +18,11 @@ namespace AST {
 class StaticTypeImpl;
 
 struct StructMember {
-    const Tokenizer::Token *token;
+    Tokenizer::TokenRef token;
     boost::intrusive_ptr<const StaticTypeImpl> type;
     size_t offset;
 
-    StructMember(const Tokenizer::Token *token, boost::intrusive_ptr<const StaticTypeImpl> type, size_t offset) :
+    StructMember(Tokenizer::TokenRef token, boost::intrusive_ptr<const StaticTypeImpl> type, size_t offset) :
         token(token),
         type(std::move(type)),
         offset(offset)
@@ -20,8 +20,12 @@ namespace AST {
 
 class UnsignedIntValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::UnsignedInt;
+
     LongEnoughInt minimum, maximum;
 
+    UnsignedIntValueRange() : ValueRangeBase( StaticKind ) {}
+
     bool isLiteral() const override {
         return minimum==maximum;
     }
@@ -15,10 +15,22 @@
 #include <boost/smart_ptr/intrusive_ref_counter.hpp>
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 
+#include <cstdint>
+#include <type_traits>
+
 namespace AST {
 
-class ValueRangeBase : private NoCopy, public boost::intrusive_ref_counter<ValueRangeBase, boost::thread_unsafe_counter>
+class ValueRangeBase : private NoCopy, public boost::intrusive_ref_counter<ValueRangeBase, boost::thread_safe_counter>
 {
+public:
+    // The concrete class of a value range. Each class keeps its own kind in StaticKind.
+    enum class Kind : uint8_t {
+        Void, Bool, SignedInt, UnsignedInt, Pointer, Array
+    };
+
+private:
+    const Kind kind;
+
 public:
     virtual ~ValueRangeBase() {}
 
@@ -26,15 +38,32 @@ public:
 
     using CPtr = boost::intrusive_ptr<const ValueRangeBase>;
 
+    Kind getKind() const {
+        return kind;
+    }
+
     template<typename ChildType>
-    boost::intrusive_ptr<const ChildType> downCast() const {
+    bool is() const {
         static_assert( std::is_base_of_v< ValueRangeBase, ChildType > );
 
-        const ChildType *child = dynamic_cast<const ChildType *>(this);
-        ASSERT(child != nullptr);
+        return kind==ChildType::StaticKind;
+    }
 
-        return boost::intrusive_ptr<const ChildType>( child );
+    template<typename ChildType>
+    const ChildType *as() const {
+        ASSERT( is<ChildType>() )<<"Value range of kind "<<static_cast<unsigned>(kind)<<" downcast to kind "<<
+                static_cast<unsigned>(ChildType::StaticKind);
+
+        return static_cast<const ChildType *>(this);
     }
+
+    template<typename ChildType>
+    boost::intrusive_ptr<const ChildType> downCast() const {
+        return boost::intrusive_ptr<const ChildType>( as<ChildType>() );
+    }
+
+protected:
+    explicit ValueRangeBase( Kind kind ) : kind(kind) {}
 };
 
 } // namespace AST
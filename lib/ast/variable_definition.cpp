@@ -33,10 +33,10 @@ void VariableDefinition::buildAST( LookupContext &lookupCtx ) {
 void VariableDefinition::codeGen(
         const LookupContext &lookupCtx, PracticalSemanticAnalyzer::FunctionGen *functionGen ) const
 {
-    const LookupContext::Identifier *identifier = lookupCtx.lookupIdentifier( parserVarDef.body.name.identifier->text );
+    const LookupContext::Identifier *identifier = lookupCtx.lookupIdentifier( parserVarDef.body.name.identifier.symbol() );
     const auto &varDef = std::get< LookupContext::Variable >(*identifier);
 
-    functionGen->allocateStackVar(varDef.lvalueId, varDef.type, parserVarDef.body.name.identifier->text);
+    functionGen->allocateStackVar(varDef.lvalueId, varDef.type, parserVarDef.body.name.identifier.text());
 
     if( initValue ) {
         ExpressionId initValueExpressionId = initValue->codeGen(functionGen);
@@ -15,6 +15,10 @@ namespace AST {
 
 class VoidValueRange final : public ValueRangeBase {
 public:
+    static constexpr Kind StaticKind = Kind::Void;
+
+    VoidValueRange() : ValueRangeBase( StaticKind ) {}
+
     bool isLiteral() const override {
         return true;
     }
@@ -0,0 +1,174 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "dummy_codegen_impl.h"
+
+#include "ast/ast.h"
+#include "ast/cast_chain.h"
+#include "ast/expression/base.h"
+#include "ast/signed_int_value_range.h"
+#include "ast/unsigned_int_value_range.h"
+#include "parser/module.h"
+
+#include "bench/bench.h"
+
+#include <practical/errors.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace PracticalSemanticAnalyzer;
+
+namespace {
+
+// Generate a module whose functions mix integer types, so that most expressions need casts, value range propagation
+// and overload resolution
+std::string castHeavySource( size_t numFunctions ) {
+    std::ostringstream source;
+    for( size_t i=0; i<numFunctions; ++i ) {
+        source <<
+                "def helper" << i << "( a : U32, b : U16 ) -> U32 {\n"
+                "    a + b\n"
+                "}\n"
+                "\n"
+                "def func" << i << "( a : U32, b : U16, c : S32 ) -> S64 {\n"
+                "    def x : U8 = 3;\n"
+                "    def y : U16 = x * 2 + b;\n"
+                "    def z : U64 = y + a * 3 - 1;\n"
+                "    def s : S32 = c - 1;\n"
+                "    def t : S64 = expect!S64( s ) * 2 + c;\n"
+                "    def cmp : Bool = (x < 4) && (y >= 2) || !(s != 3) || (z <= 1);\n"
+                "    def p : U8@ = x&;\n"
+                "    def r : U8 = p@;\n"
+                "    def q : U16 = r + y;\n"
+                "    def w : U32 = if( cmp ) { a } else { helper" << i << "( a, q ) };\n"
+                "    def v : U64 = { def k : U32 = w * 2; k + z };\n"
+                "    t\n"
+                "}\n\n";
+    }
+
+    return source.str();
+}
+
+} // Anonymous namespace
+
+BENCHMARK(buildAST) {
+    static constexpr size_t NumFunctions = 1000;
+
+    prepareDummyCodeGen();
+
+    std::string sourceText = castHeavySource( NumFunctions );
+    CompilerArguments arguments;
+    NonTerminals::Module module;
+    module.parse( String( sourceText ), arguments );
+
+    DummyModuleGen moduleGen;
+    double time = Bench::measure( [&]() {
+                try {
+                    AST::AST ast;
+                    ast.codeGen( module, &moduleGen, arguments );
+                } catch( compile_error &error ) {
+                    std::cerr << "Benchmark source failed to compile: " << error.what() << "\n";
+                    abort();
+                }
+            } );
+
+    Bench::report( "build AST (cast heavy)", time, NumFunctions, "function" );
+}
+
+BENCHMARK(valueRangeDowncast) {
+    static constexpr size_t NumRanges = 1000000;
+
+    std::vector<AST::ValueRangeBase::CPtr> ranges;
+    ranges.reserve( NumRanges );
+    for( size_t i=0; i<NumRanges; ++i ) {
+        if( i%2 == 0 )
+            ranges.emplace_back( AST::SignedIntValueRange::allocate( 0, i ) );
+        else
+            ranges.emplace_back( AST::UnsignedIntValueRange::allocate( 0, i ) );
+    }
+
+    // Reference point: the downcast used to be a dynamic_cast
+    double rttiTime = Bench::measure( [&]() {
+                for( const auto &range : ranges ) {
+                    const AST::SignedIntValueRange *signedRange =
+                            dynamic_cast<const AST::SignedIntValueRange *>( range.get() );
+                    Bench::doNotOptimize( signedRange );
+                }
+            } );
+    Bench::report( "value range downcast (dynamic_cast)", rttiTime, NumRanges, "range" );
+
+    double tagTime = Bench::measure( [&]() {
+                for( const auto &range : ranges ) {
+                    const AST::SignedIntValueRange *signedRange =
+                            range->is<AST::SignedIntValueRange>() ? range->as<AST::SignedIntValueRange>() : nullptr;
+                    Bench::doNotOptimize( signedRange );
+                }
+            } );
+    Bench::report( "value range downcast (kind tag)", tagTime, NumRanges, "range" );
+}
+
+BENCHMARK(implicitCast) {
+    static constexpr size_t NumRounds = 10000;
+    static const char *const typeNames[] = { "U8", "U16", "U32", "U64", "S8", "S16", "S32", "S64" };
+
+    prepareDummyCodeGen();
+    const AST::LookupContext &lookupContext = AST::AST::getBuiltinCtx();
+
+    // Cast sources are variables, so are references that need to decay first. Their values fit every type, so that
+    // no cast fails the value range check.
+    std::vector<AST::ExpressionImpl::ExpressionMetadata> sources, pointerSources;
+    std::vector<AST::StaticTypeImpl::CPtr> destinations, pointerDestinations;
+    for( const char *name : typeNames ) {
+        AST::StaticTypeImpl::CPtr type = lookupContext.lookupType( String(name) );
+        destinations.emplace_back( type );
+
+        AST::ValueRangeBase::CPtr valueRange;
+        if( name[0]=='S' )
+            valueRange = AST::SignedIntValueRange::allocate( 0, 100 );
+        else
+            valueRange = AST::UnsignedIntValueRange::allocate( 0, 100 );
+
+        sources.emplace_back( AST::ExpressionImpl::ExpressionMetadata{
+                .type = AST::downCast( type->addFlags( StaticType::Flags::Reference ) ),
+                .valueRange = valueRange } );
+
+        AST::StaticTypeImpl::CPtr pointerType = AST::StaticTypeImpl::intern( AST::PointerTypeImpl( type ) );
+        pointerDestinations.emplace_back( pointerType );
+        pointerSources.emplace_back( AST::ExpressionImpl::ExpressionMetadata{
+                .type = AST::downCast( pointerType->addFlags( StaticType::Flags::Reference ) ),
+                .valueRange = pointerType->defaultRange() } );
+    }
+
+    auto measureCasts = [&](
+            const std::vector<AST::ExpressionImpl::ExpressionMetadata> &sources,
+            const std::vector<AST::StaticTypeImpl::CPtr> &destinations ) -> double
+    {
+        return Bench::measure( [&]() {
+                    for( size_t round=0; round<NumRounds; ++round ) {
+                        for( const auto &source : sources ) {
+                            for( const auto &destination : destinations ) {
+                                AST::Weight weight;
+                                auto chain = AST::CastChain::allocate(
+                                        lookupContext, destination, source, weight,
+                                        AST::ExpressionImpl::Base::NoWeightLimit, true, SourceLocation() );
+                                Bench::doNotOptimize( chain );
+                            }
+                        }
+                    }
+                } );
+    };
+
+    size_t numCasts = NumRounds * sources.size() * destinations.size();
+    Bench::report( "implicit cast chain (integers)", measureCasts( sources, destinations ), numCasts, "cast" );
+    // Pointer types have no precomputed paths
+    Bench::report(
+            "implicit cast chain (pointers)", measureCasts( pointerSources, pointerDestinations ), numCasts, "cast" );
+}
@@ -0,0 +1,77 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "dummy_codegen_impl.h"
+
+#include "ut/parse_helpers.h"
+
+#include "ast/ast.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class AstNestingTest : public CppUnit::TestFixture  {
+    static void compile(const std::string &source, size_t maxNestingDepth) {
+        prepareDummyCodeGen();
+
+        CompilerArguments arguments = UT::arguments( &CompilerArguments::maxNestingDepth, maxNestingDepth );
+
+        NonTerminals::Module module;
+        UT::parse( module, source, arguments );
+
+        DummyModuleGen moduleGen;
+        AST::AST ast;
+        ast.codeGen( module, &moduleGen, arguments );
+    }
+
+    void longOperatorChain() {
+        // A flat chain is as deep as it is long in the tree, but it is not nested source
+        size_t defaultDepth = CompilerArguments().maxNestingDepth;
+        for( size_t numOperands : { 1001, 1500, 5000 } ) {
+            compile( UT::nested( "x + ", "x", "", numOperands-1 ), defaultDepth );
+            compile( UT::nested( "x * 2 + ", "x", "", numOperands-1 ), defaultDepth );
+        }
+
+        // Built and generated without recursing down the chain
+        compile( UT::nested( "x + ", "x", "", 100000 ), defaultDepth );
+    }
+
+    void longPrefixRun() {
+        size_t defaultDepth = CompilerArguments().maxNestingDepth;
+        compile( "def f( b : Bool ) -> Bool {\n  " + std::string( 5000, '!' ) + "b\n}\n", defaultDepth );
+    }
+
+    void tooDeep() {
+        std::string source = UT::nested( "x + (", "x", ")", 100 );
+        compile( source, 200 );
+
+        UT::expectThrow<NestingTooDeep>(
+                [&]() { compile( source, 50 ); }, "Nesting deeper than the limit compiled without errors" );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "AstNestingTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<AstNestingTest>(
+                    "longOperatorChain",
+                    &AstNestingTest::longOperatorChain ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<AstNestingTest>(
+                    "longPrefixRun",
+                    &AstNestingTest::longPrefixRun ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<AstNestingTest>(
+                    "tooDeep",
+                    &AstNestingTest::tooDeep ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AstNestingTest );
@@ -0,0 +1,83 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+struct Benchmark {
+    const char *name;
+    void (*function)();
+};
+
+inline std::vector<Benchmark> &registry() {
+    static std::vector<Benchmark> benchmarks;
+
+    return benchmarks;
+}
+
+class Registrar {
+public:
+    Registrar( const char *name, void (*function)() ) {
+        registry().push_back( Benchmark{ .name=name, .function=function } );
+    }
+};
+
+// Prevent the compiler from optimizing away a computed value
+template<typename T>
+inline void doNotOptimize( const T &value ) {
+    asm volatile( "" : : "g"(&value) : "memory" );
+}
+
+// Runs the function repeatedly and returns the best observed wall time, in nanoseconds, of a single run
+inline double measure( const std::function<void()> &function, unsigned repetitions = 5 ) {
+    double best = 0;
+
+    for( unsigned i=0; i<repetitions; ++i ) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        double elapsed = std::chrono::duration<double, std::nano>( end-start ).count();
+        if( i==0 || elapsed<best )
+            best = elapsed;
+    }
+
+    return best;
+}
+
+inline void report( const char *name, double nanoseconds, size_t operations, const char *unit ) {
+    std::cout << std::left << std::setw(48) << name << std::right <<
+            std::setw(12) << std::fixed << std::setprecision(3) << nanoseconds/1000000 << " ms " <<
+            std::setw(10) << std::setprecision(2) << nanoseconds/operations << " ns/" << unit << "\n";
+}
+
+// Report the size of something, in bytes, and how much of it each of operations takes
+inline void reportSize( const char *name, size_t bytes, size_t operations, const char *unit ) {
+    std::cout << std::left << std::setw(48) << name << std::right <<
+            std::setw(12) << bytes << " B  " <<
+            std::setw(10) << std::fixed << std::setprecision(2) << double(bytes)/operations << " B/" << unit << "\n";
+}
+
+} // namespace Bench
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static Bench::Registrar name##Registrar( #name, name ); \
+    static void name()
+
+#endif // BENCH_BENCH_H
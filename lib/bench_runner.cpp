@@ -0,0 +1,26 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "bench/bench.h"
+
+// Usage: practical-sa-bench [substring]
+// Runs all registered benchmarks, or only those whose name contains the substring
+int main( int argc, char **argv )
+{
+    const char *filter = argc>1 ? argv[1] : nullptr;
+
+    for( const Bench::Benchmark &benchmark : Bench::registry() ) {
+        if( filter!=nullptr && strstr( benchmark.name, filter )==nullptr )
+            continue;
+
+        std::cout << "Running " << benchmark.name << "\n";
+        benchmark.function();
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "dummy_codegen_impl.h"
+
+#include "ast/ast.h"
+#include "ast/cast_chain.h"
+#include "ast/casts.h"
+#include "ast/expression/base.h"
+#include "ast/struct.h"
+#include "ast/unsigned_int_value_range.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+class CastChainTest : public CppUnit::TestFixture  {
+    static const AST::LookupContext &builtinCtx() {
+        prepareDummyCodeGen();
+
+        return AST::AST::getBuiltinCtx();
+    }
+
+    // A variable of type name, so a reference that must decay before it is cast
+    static AST::ExpressionImpl::ExpressionMetadata variable( const AST::LookupContext &ctx, const char *name ) {
+        AST::StaticTypeImpl::CPtr type = ctx.lookupType( String(name) );
+
+        return AST::ExpressionImpl::ExpressionMetadata{
+                .type = AST::downCast( type->addFlags( StaticType::Flags::Reference ) ),
+                .valueRange = type->defaultRange() };
+    }
+
+    static std::unique_ptr<AST::CastChain> cast(
+            const AST::LookupContext &ctx, const AST::ExpressionImpl::ExpressionMetadata &source, const char *dest,
+            AST::Weight &weight, AST::Weight weightLimit = AST::ExpressionImpl::Base::NoWeightLimit )
+    {
+        return AST::CastChain::allocate(
+                ctx, ctx.lookupType( String(dest) ), source, weight, weightLimit, true, SourceLocation() );
+    }
+
+    static void assertSamePath( const AST::LookupContext::CastPath &lhs, const AST::LookupContext::CastPath &rhs ) {
+        CPPUNIT_ASSERT( lhs.weight==rhs.weight );
+        CPPUNIT_ASSERT( lhs.farthest==rhs.farthest );
+        CPPUNIT_ASSERT( lhs.ambiguous==rhs.ambiguous );
+        CPPUNIT_ASSERT( lhs.steps.size()==rhs.steps.size() );
+        for( size_t i=0; i<lhs.steps.size(); ++i ) {
+            CPPUNIT_ASSERT( lhs.steps[i].cast==rhs.steps[i].cast );
+            CPPUNIT_ASSERT( lhs.steps[i].type==rhs.steps[i].type );
+        }
+    }
+
+    void cheapPath() {
+        const AST::LookupContext &ctx = builtinCtx();
+        auto source = variable( ctx, "U8" );
+
+        AST::Weight weight;
+        auto chain = cast( ctx, source, "U32", weight );
+
+        CPPUNIT_ASSERT( chain );
+        CPPUNIT_ASSERT( chain->getMetadata().type==ctx.lookupType( String("U32") ) );
+        CPPUNIT_ASSERT( weight==ctx.lookupCastPath( source.type, chain->getMetadata().type ).weight );
+    }
+
+    void tooExpensive() {
+        const AST::LookupContext &ctx = builtinCtx();
+        auto source = variable( ctx, "U8" );
+
+        AST::Weight pathWeight;
+        CPPUNIT_ASSERT( cast( ctx, source, "U32", pathWeight ) );
+
+        // Exactly the limit is allowed
+        AST::Weight weight;
+        CPPUNIT_ASSERT( cast( ctx, source, "U32", weight, pathWeight ) );
+
+        weight = AST::Weight();
+        try {
+            cast( ctx, source, "U32", weight, pathWeight - AST::Weight(1, 0) );
+        } catch( AST::ExpressionImpl::Base::ExpressionTooExpensive &error ) {
+            CPPUNIT_ASSERT( weight==AST::Weight() );
+            return;
+        }
+
+        CPPUNIT_FAIL( "Cast heavier than the limit allocated" );
+    }
+
+    void unreachable() {
+        const AST::LookupContext &ctx = builtinCtx();
+        auto source = variable( ctx, "U8" );
+
+        AST::Weight weight;
+        CPPUNIT_ASSERT( !cast( ctx, source, "Bool", weight ) );
+        CPPUNIT_ASSERT( weight==AST::Weight() );
+
+        // The search had to go past a limit this low to find out, so it does not know the destination is unreachable
+        try {
+            cast( ctx, source, "Bool", weight, AST::Weight(1, 1) );
+        } catch( AST::ExpressionImpl::Base::ExpressionTooExpensive &error ) {
+            return;
+        }
+
+        CPPUNIT_FAIL( "Unreachable destination reported as such past the weight limit" );
+    }
+
+    void equallyCheapPaths() {
+        // Two paths of the same weight: A -> B -> D and A -> C -> D. The search keeps the first one it finds.
+        AST::LookupContext ctx;
+        std::vector<AST::StaticTypeImpl::CPtr> types;
+        for( const char *name : { "A", "B", "C", "D" } ) {
+            types.emplace_back( ctx.registerScalarType(
+                        AST::ScalarTypeImpl(
+                            name, name, 8, 1, StaticType::Scalar::Type::UnsignedInt, TypeId(), types.size() ),
+                        AST::UnsignedIntValueRange::allocate<uint8_t>() ) );
+        }
+
+        using ImplicitCastAllowed = AST::LookupContext::CastDescriptor::ImplicitCastAllowed;
+        ctx.addCast( types[0], types[1], 1, nullptr, AST::identityVrp, ImplicitCastAllowed::Always );
+        ctx.addCast( types[0], types[2], 1, nullptr, AST::identityVrp, ImplicitCastAllowed::Always );
+        ctx.addCast( types[1], types[3], 1, nullptr, AST::identityVrp, ImplicitCastAllowed::Always );
+        ctx.addCast( types[2], types[3], 1, nullptr, AST::identityVrp, ImplicitCastAllowed::Always );
+        ctx.precomputeCastPaths();
+
+        const AST::LookupContext::CastPath &path = ctx.lookupCastPath( types[0], types[3] );
+        CPPUNIT_ASSERT( !path.ambiguous );
+        CPPUNIT_ASSERT( path.weight==AST::Weight(2, 2) );
+        CPPUNIT_ASSERT( path.steps.size()==2 );
+        CPPUNIT_ASSERT( path.steps[0].type==types[1] || path.steps[0].type==types[2] );
+        CPPUNIT_ASSERT( path.steps[1].type==types[3] );
+
+        AST::ExpressionImpl::ExpressionMetadata source{ .type = types[0], .valueRange = types[0]->defaultRange() };
+        AST::Weight weight;
+        std::unique_ptr<AST::CastChain> chain = cast( ctx, source, "D", weight );
+        CPPUNIT_ASSERT( chain );
+        CPPUNIT_ASSERT( chain->getMetadata().type==types[3] );
+        CPPUNIT_ASSERT( weight==AST::Weight(2, 2) );
+    }
+
+    void precomputedMatchSearch() {
+        const AST::LookupContext &ctx = builtinCtx();
+
+        std::vector<AST::StaticTypeImpl::CPtr> types;
+        for( const char *name : { "Bool", "C8", "U8", "U16", "U32", "U64", "S8", "S16", "S32", "S64" } ) {
+            AST::StaticTypeImpl::CPtr type = ctx.lookupType( String(name) );
+            types.emplace_back( type );
+            types.emplace_back( AST::downCast( type->addFlags( StaticType::Flags::Reference ) ) );
+        }
+
+        for( auto source : types ) {
+            for( auto dest : types ) {
+                if( source==dest )
+                    continue;
+
+                assertSamePath(
+                        ctx.lookupCastPath( source, dest ), AST::CastChain::findPath( ctx, source, dest ) );
+            }
+        }
+    }
+
+    void cachedPathsMatchSearch() {
+        // Paths between pointers and structs are not precomputed. They are searched on first use and remembered.
+        const AST::LookupContext &builtin = builtinCtx();
+        AST::LookupContext ctx( &builtin );
+
+        AST::StaticTypeImpl::CPtr u8 = builtin.lookupType( String("U8") );
+        AST::StaticTypeImpl::CPtr u16 = builtin.lookupType( String("U16") );
+        AST::StaticTypeImpl::CPtr structType =
+                AST::StaticTypeImpl::allocate( AST::StructTypeImpl( String("S"), &ctx ) );
+
+        std::vector<AST::StaticTypeImpl::CPtr> types;
+        for( auto type : { u8, u16, structType } ) {
+            AST::StaticTypeImpl::CPtr pointer = AST::StaticTypeImpl::intern( AST::PointerTypeImpl( type ) );
+
+            types.emplace_back( type );
+            types.emplace_back( AST::downCast( type->addFlags( StaticType::Flags::Reference ) ) );
+            types.emplace_back( pointer );
+            types.emplace_back( AST::downCast( pointer->addFlags( StaticType::Flags::Reference ) ) );
+        }
+
+        for( auto source : types ) {
+            for( auto dest : types ) {
+                if( source==dest )
+                    continue;
+
+                const AST::LookupContext::CastPath &first = ctx.lookupCastPath( source, dest );
+                const AST::LookupContext::CastPath &second = ctx.lookupCastPath( source, dest );
+
+                CPPUNIT_ASSERT( &first==&second );
+                assertSamePath( first, AST::CastChain::findPath( ctx, source, dest ) );
+            }
+        }
+
+        // A pointer variable decays to the pointer, the same way every time
+        AST::StaticTypeImpl::CPtr pointer = AST::StaticTypeImpl::intern( AST::PointerTypeImpl( u8 ) );
+        AST::ExpressionImpl::ExpressionMetadata source{
+                .type = AST::downCast( pointer->addFlags( StaticType::Flags::Reference ) ),
+                .valueRange = pointer->defaultRange() };
+        for( unsigned i=0; i<2; ++i ) {
+            AST::Weight weight;
+            auto chain = AST::CastChain::allocate(
+                    ctx, pointer, source, weight, AST::ExpressionImpl::Base::NoWeightLimit, true, SourceLocation() );
+
+            CPPUNIT_ASSERT( chain );
+            CPPUNIT_ASSERT( chain->getMetadata().type==pointer );
+            CPPUNIT_ASSERT( weight==AST::CastChain::findPath( ctx, source.type, pointer ).weight );
+        }
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "CastChainTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "cheapPath",
+                    &CastChainTest::cheapPath ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "tooExpensive",
+                    &CastChainTest::tooExpensive ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "unreachable",
+                    &CastChainTest::unreachable ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "equallyCheapPaths",
+                    &CastChainTest::equallyCheapPaths ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "precomputedMatchSearch",
+                    &CastChainTest::precomputedMatchSearch ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<CastChainTest>(
+                    "cachedPathsMatchSearch",
+                    &CastChainTest::cachedPathsMatchSearch ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CastChainTest );
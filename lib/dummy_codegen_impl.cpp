@@ -1,6 +1,6 @@
 /* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
  *
- * This file is file is copyright (C) 2018-2019 by its authors.
+ * This file is file is copyright (C) 2018-2020 by its authors.
  * You can see the file's authors in the AUTHORS file in the project's home repository.
  *
  * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
@@ -8,4 +8,11 @@
  */
 #include "dummy_codegen_impl.h"
 
-DummyFunctionGen dummyFunctionGen;
+#include "ast/ast.h"
+
+void prepareDummyCodeGen() {
+    static DummyBuiltinContextGen builtinContext;
+
+    if( !AST::AST::prepared() )
+        prepare( &builtinContext );
+}
@@ -1,6 +1,6 @@
 /* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
  *
- * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2018-2019 by its authors
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2018-2020 by its authors
  * You can see the file's authors in the AUTHORS file in the project's home repository.
  *
  * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
@@ -9,53 +9,115 @@
 #ifndef DUMMY_CODEGEN_IMPL_H
 #define DUMMY_CODEGEN_IMPL_H
 
-#include <practical-sa.h>
+#include <practical/practical.h>
 
-using PracticalSemanticAnalyzer::ArgumentDeclaration;
-using PracticalSemanticAnalyzer::ExpressionId;
-using PracticalSemanticAnalyzer::IdentifierId;
-using PracticalSemanticAnalyzer::StaticType;
-using PracticalSemanticAnalyzer::JumpPointId;
+using namespace PracticalSemanticAnalyzer;
 
-class DummyFunctionGen : public PracticalSemanticAnalyzer::FunctionGen {
+// Code generation that does nothing, for testing and measuring only the semantic analysis
+class DummyBuiltinContextGen : public BuiltinContextGen {
+    uintptr_t lastId = 0;
+
+    TypeId nextId() {
+        TypeId id;
+        id.n = ++lastId;
+
+        return id;
+    }
+
+public:
+    TypeId registerVoidType() override {
+        return nextId();
+    }
+    TypeId registerBoolType() override {
+        return nextId();
+    }
+    TypeId registerIntegerType( size_t bitSize, size_t alignment, bool _signed ) override {
+        return nextId();
+    }
+    TypeId registerCharType( size_t bitSize, size_t alignment, bool _signed ) override {
+        return nextId();
+    }
+};
+
+class DummyFunctionGen : public FunctionGen {
+public:
     void functionEnter(
-            IdentifierId id, String name, StaticType::Ptr returnType, Slice<const ArgumentDeclaration> arguments,
-            String file, size_t line, size_t col) override
-    {}
-    void functionLeave(IdentifierId id) override {}
+            String name, StaticType::CPtr returnType, Slice<const ArgumentDeclaration> arguments,
+            String file, const SourceLocation &location) override {}
+    void functionLeave() override {}
 
     void returnValue(ExpressionId id) override {}
     void returnValue() override {}
-    virtual void conditionalBranch(
-            ExpressionId id, StaticType::Ptr type, ExpressionId conditionExpression, JumpPointId elsePoint,
-            JumpPointId continuationPoint
-        ) override {}
-    virtual void setConditionClauseResult( ExpressionId id ) override {}
-    virtual void setJumpPoint(JumpPointId id, String name) override {}
-    virtual void jump(JumpPointId destination) override {}
-    void setLiteral(ExpressionId id, LongEnoughInt value, StaticType::Ptr type) override {}
+
+    void conditionalBranch(
+            ExpressionId id, StaticType::CPtr type, ExpressionId conditionExpression, JumpPointId elsePoint,
+            JumpPointId continuationPoint ) override {}
+    void setConditionClauseResult( ExpressionId id ) override {}
+    void setJumpPoint(JumpPointId id, String name) override {}
+    void jump(JumpPointId destination) override {}
+
+    void setLiteral(ExpressionId id, LongEnoughInt value, StaticType::CPtr type) override {}
     void setLiteral(ExpressionId id, bool value) override {}
+    void setLiteral(ExpressionId id, String value) override {}
+    void setLiteralNull(ExpressionId id, StaticType::CPtr type) override {}
 
-    // The ExpressionId refers to a pointer to the resulting allocated variable
-    void allocateStackVar(ExpressionId id, StaticType::Ptr type, String name) override {}
+    void allocateStackVar(ExpressionId id, StaticType::CPtr type, String name) override {}
     void assign( ExpressionId lvalue, ExpressionId rvalue ) override {}
-    void dereferencePointer( ExpressionId id, StaticType::Ptr type, ExpressionId addr ) override {}
+    void dereferencePointer( ExpressionId id, StaticType::CPtr type, ExpressionId addr ) override {}
 
     void truncateInteger(
-            ExpressionId id, ExpressionId source, StaticType::Ptr sourceType, StaticType::Ptr destType ) override {}
+            ExpressionId id, ExpressionId source, StaticType::CPtr sourceType, StaticType::CPtr destType ) override {}
+    void changeIntegerSign(
+            ExpressionId id, ExpressionId source, StaticType::CPtr sourceType, StaticType::CPtr destType ) override {}
     void expandIntegerSigned(
-            ExpressionId id, ExpressionId source, StaticType::Ptr sourceType, StaticType::Ptr destType ) override {}
+            ExpressionId id, ExpressionId source, StaticType::CPtr sourceType, StaticType::CPtr destType ) override {}
     void expandIntegerUnsigned(
-            ExpressionId id, ExpressionId source, StaticType::Ptr sourceType, StaticType::Ptr destType ) override {}
+            ExpressionId id, ExpressionId source, StaticType::CPtr sourceType, StaticType::CPtr destType ) override {}
+
     void callFunctionDirect(
-            ExpressionId id, String name, Slice<const ExpressionId> arguments, StaticType::Ptr returnType ) override {}
+            ExpressionId id, String name, Slice<const ExpressionId> arguments, StaticType::CPtr returnType ) override {}
+
+#define BINARY_OPERATOR(name) \
+    void name( ExpressionId id, ExpressionId left, ExpressionId right, StaticType::CPtr resultType ) override {}
+
+    BINARY_OPERATOR(binaryOperatorPlusUnsigned)
+    BINARY_OPERATOR(binaryOperatorPlusSigned)
+    BINARY_OPERATOR(binaryOperatorMinusUnsigned)
+    BINARY_OPERATOR(binaryOperatorMinusSigned)
+    BINARY_OPERATOR(binaryOperatorMultiplyUnsigned)
+    BINARY_OPERATOR(binaryOperatorMultiplySigned)
+    BINARY_OPERATOR(binaryOperatorDivideUnsigned)
+    BINARY_OPERATOR(operatorEquals)
+    BINARY_OPERATOR(operatorNotEquals)
+    BINARY_OPERATOR(operatorLessThanUnsigned)
+    BINARY_OPERATOR(operatorLessThanSigned)
+    BINARY_OPERATOR(operatorLessThanOrEqualsUnsigned)
+    BINARY_OPERATOR(operatorLessThanOrEqualsSigned)
+    BINARY_OPERATOR(operatorGreaterThanUnsigned)
+    BINARY_OPERATOR(operatorGreaterThanSigned)
+    BINARY_OPERATOR(operatorGreaterThanOrEqualsUnsigned)
+    BINARY_OPERATOR(operatorGreaterThanOrEqualsSigned)
+
+#undef BINARY_OPERATOR
+
+    void operatorLogicalNot( ExpressionId id, ExpressionId argument ) override {}
+};
+
+class DummyModuleGen : public ModuleGen {
+public:
+    void moduleEnter(ModuleId id, String name, String file, size_t line, size_t col) override {}
+    void moduleLeave(ModuleId id) override {}
+
+    void declareIdentifier(String name, String mangledName, StaticType::CPtr type) override {}
+    void declareStruct(StaticType::CPtr structType) override {}
+    void defineStruct(StaticType::CPtr structType) override {}
 
-    virtual void binaryOperatorPlus(
-            ExpressionId id, ExpressionId left, ExpressionId right, StaticType::Ptr resultType ) override {}
-    virtual void binaryOperatorMinus(
-            ExpressionId id, ExpressionId left, ExpressionId right, StaticType::Ptr resultType ) override {}
+    std::shared_ptr<FunctionGen> handleFunction() override {
+        return std::make_shared<DummyFunctionGen>();
+    }
 };
 
-extern DummyFunctionGen dummyFunctionGen;
+// Prepare the semantic analyzer with a dummy builtin context, unless it was already prepared
+void prepareDummyCodeGen();
 
 #endif // DUMMY_CODEGEN_IMPL_H
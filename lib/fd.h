@@ -28,6 +28,12 @@ public:
 
     FD(const std::string &path, int flags, mode_t mode = 0666 ) : FD(path.c_str(), flags, mode) {}
 
+    // Take ownership of an already open file descriptor
+    explicit FD(int fd) : fd(fd) {
+        if( fd<0 )
+            throw std::runtime_error("Open failed");
+    }
+
     // Move
     FD(FD &&rhs) : fd(rhs.fd) {
         rhs.fd = -1;
@@ -0,0 +1,85 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "line_index.h"
+
+#include "asserts.h"
+#include "tokenizer_scan.h"
+
+#include <algorithm>
+
+namespace Tokenizer {
+
+LineIndex::LineIndex(String source) {
+    lineStarts.reserve( Scan::countNewlines( source ).count + 1 );
+    lineStarts.push_back( 0 );
+
+    size_t position = 0;
+    while( true ) {
+        position += Scan::findByte( source.subslice(position), '\n' );
+        if( position>=source.size() )
+            break;
+
+        position++;
+        lineStarts.push_back( position );
+    }
+}
+
+SourceLocation LineIndex::location(size_t offset) const {
+    // Find the last line that starts at or before offset
+    auto nextLine = std::upper_bound( lineStarts.begin(), lineStarts.end(), offset );
+
+    return makeLocation( offset, nextLine - lineStarts.begin() - 1 );
+}
+
+SourceLocation LineIndex::location(size_t offset, size_t &line) const {
+    while( line+1<lineStarts.size() && lineStarts[line+1]<=offset )
+        line++;
+
+    return makeLocation( offset, line );
+}
+
+LineIndex LineIndex::edited(size_t offset, size_t removedLength, String insertedText) const {
+    LineIndex ret;
+
+    // Lines starting at or before offset are preceded by a new line that the edit didn't touch
+    auto firstMoved = std::upper_bound( lineStarts.begin(), lineStarts.end(), offset );
+    // Lines starting after offset+removedLength are preceded by a new line that was only moved
+    auto firstKept = std::upper_bound( firstMoved, lineStarts.end(), offset + removedLength );
+
+    ret.lineStarts.reserve(
+            (firstMoved - lineStarts.begin()) + Scan::countNewlines( insertedText ).count +
+            (lineStarts.end() - firstKept) );
+    ret.lineStarts.assign( lineStarts.begin(), firstMoved );
+
+    size_t position = 0;
+    while( true ) {
+        position += Scan::findByte( insertedText.subslice(position), '\n' );
+        if( position>=insertedText.size() )
+            break;
+
+        position++;
+        ret.lineStarts.push_back( offset + position );
+    }
+
+    for( auto lineStart = firstKept; lineStart!=lineStarts.end(); ++lineStart )
+        ret.lineStarts.push_back( *lineStart - removedLength + insertedText.size() );
+
+    return ret;
+}
+
+void LineIndex::append(const LineIndex &that, size_t offset) {
+    ASSERT( lineStarts.back()==offset ) << "Appended line index does not start at a line start: " << offset;
+
+    // that's first line is this index's last one
+    lineStarts.reserve( lineStarts.size() + that.lineStarts.size() - 1 );
+    for( auto lineStart = that.lineStarts.begin()+1; lineStart!=that.lineStarts.end(); ++lineStart )
+        lineStarts.push_back( *lineStart + offset );
+}
+
+} // namespace Tokenizer
@@ -0,0 +1,59 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <practical/practical.h>
+#include <practical/slice.h>
+
+#include <vector>
+
+namespace Tokenizer {
+
+using PracticalSemanticAnalyzer::SourceLocation;
+
+// Offsets at which each line of a source file starts. Translates byte offsets into SourceLocation on demand, so that
+// the tokenizer need not track line and column as it goes.
+class LineIndex {
+    // lineStarts[0] is always 0
+    std::vector<size_t> lineStarts;
+
+public:
+    LineIndex() : lineStarts{0} {}
+    explicit LineIndex(String source);
+
+    size_t numLines() const {
+        return lineStarts.size();
+    }
+
+    SourceLocation location(size_t offset) const;
+
+    // Same as location, but searches forward starting at line (0 based), and updates line to the offset's line.
+    // Cheaper than location for lookups done in increasing offset order.
+    SourceLocation location(size_t offset, size_t &line) const;
+
+    // The index of the source after replacing removedLength bytes at offset with insertedText. Only the inserted text
+    // is scanned.
+    LineIndex edited(size_t offset, size_t removedLength, String insertedText) const;
+
+    // Extend the index with the index of the text that follows this one's at offset. This index's text must end with a
+    // new line, so that offset is the start of its last line.
+    void append(const LineIndex &that, size_t offset);
+
+private:
+    SourceLocation makeLocation(size_t offset, size_t line) const {
+        return SourceLocation{
+            .line = static_cast<unsigned>( line+1 ),
+            .col = static_cast<unsigned>( offset - lineStarts[line] + 1 ) };
+    }
+};
+
+} // namespace Tokenizer
+
+#endif // LINE_INDEX_H
@@ -0,0 +1,75 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "lookahead.h"
+
+using namespace Tokenizer;
+
+namespace Lookahead {
+
+namespace {
+
+// Tokens that start an expression without being an operator
+constexpr Tokens expressionStarts[] = {
+    Tokens::BRACKET_ROUND_OPEN,
+    Tokens::BRACKET_CURLY_OPEN,                 // Compound expression
+    Tokens::RESERVED_IF,                        // Conditional expression
+    Tokens::IDENTIFIER,
+    Tokens::LITERAL_INT_2,
+    Tokens::LITERAL_INT_8,
+    Tokens::LITERAL_INT_10,
+    Tokens::LITERAL_INT_16,
+    Tokens::LITERAL_FP,
+    Tokens::LITERAL_STRING,
+    Tokens::RESERVED_TRUE,
+    Tokens::RESERVED_FALSE,
+    Tokens::RESERVED_NULL,
+};
+
+LookaheadTable buildTable() {
+    LookaheadTable table{};
+
+    auto add = [&table]( Tokens token, Rule rule ) {
+        table.first[ static_cast<size_t>(token) ] |= static_cast<uint8_t>(rule);
+    };
+
+    for( Tokens token : expressionStarts )
+        add( token, Rule::Expression );
+
+    for( size_t token=0; token<Operators::NumTokens; ++token ) {
+        if( Operators::operatorsTable.tokens[token].prefixPrecedence!=0 )
+            add( static_cast<Tokens>(token), Rule::Expression );
+    }
+
+    add( Tokens::IDENTIFIER, Rule::Type );
+    add( Tokens::RESERVED_DEF, Rule::VariableDefinition );
+
+    // A statement is an expression, a variable definition, a compound statement or a condition
+    for( size_t token=0; token<Operators::NumTokens; ++token ) {
+        uint8_t &first = table.first[token];
+        if( first & ( static_cast<uint8_t>(Rule::Expression) | static_cast<uint8_t>(Rule::VariableDefinition) ) )
+            first |= static_cast<uint8_t>(Rule::Statement);
+    }
+
+    return table;
+}
+
+} // Anonymous namespace
+
+// Built at run time, as the prefix operators come from operatorsTable. Nothing parses before main.
+const LookaheadTable lookaheadTable = buildTable();
+
+Scope::Scope(Statistics &statistics) : previous(activeStatistics) {
+    activeStatistics = &statistics;
+}
+
+Scope::~Scope() {
+    activeStatistics = previous;
+}
+
+} // Namespace Lookahead
@@ -0,0 +1,86 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include "nocopy.h"
+#include "operators.h"
+#include "token_stream.h"
+
+#include <practical/slice.h>
+
+#include <cstdint>
+
+// Lets the parser choose between alternatives by looking at the next token, instead of trying each alternative in turn
+// and backtracking when it fails. Where one token is not enough to decide, the parser still has to speculate.
+namespace Lookahead {
+
+// The rules whose alternatives the parser chooses between. Used as bits in the FIRST sets.
+enum class Rule : uint8_t {
+    Expression = 1<<0,
+    Type = 1<<1,
+    VariableDefinition = 1<<2,
+    Statement = 1<<3,
+};
+
+struct LookaheadTable {
+    // For each token, the bits of the rules that can start with it
+    uint8_t first[Operators::NumTokens];
+};
+
+extern const LookaheadTable lookaheadTable;
+
+// Whether rule can start with token
+inline bool canStart( Rule rule, Tokenizer::Tokens token ) {
+    return ( lookaheadTable.first[ static_cast<size_t>(token) ] & static_cast<uint8_t>(rule) ) != 0;
+}
+
+// Whether rule can start at source[index]. Nothing starts at EOF.
+inline bool canStart( Rule rule, Tokenizer::TokenSlice source, size_t index ) {
+    return index<source.size() && canStart( rule, source.kind(index) );
+}
+
+struct Statistics {
+    // Alternatives the parser skipped because the next token could not start them
+    size_t predictions = 0;
+    // Alternatives the parser tried and then had to backtrack from
+    size_t backtracks = 0;
+
+    Statistics &operator+=(const Statistics &rhs) {
+        predictions += rhs.predictions;
+        backtracks += rhs.backtracks;
+
+        return *this;
+    }
+};
+
+// Count the decisions of parses on the current thread into statistics for the scope's lifetime
+class Scope : private NoCopy {
+    Statistics *previous;
+
+public:
+    explicit Scope(Statistics &statistics);
+    ~Scope();
+};
+
+inline thread_local Statistics *activeStatistics = nullptr;
+
+inline void predicted() {
+    if( activeStatistics!=nullptr )
+        activeStatistics->predictions++;
+}
+
+inline void backtracked() {
+    if( activeStatistics!=nullptr )
+        activeStatistics->backtracks++;
+}
+
+} // Namespace Lookahead
+
+#endif // LOOKAHEAD_H
@@ -0,0 +1,64 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parser/module.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class LookaheadTest : public CppUnit::TestFixture  {
+    void firstSets() {
+        using Lookahead::Rule;
+        using Tokenizer::Tokens;
+
+        CPPUNIT_ASSERT( Lookahead::canStart( Rule::Expression, Tokens::OP_MINUS ) );
+        CPPUNIT_ASSERT( Lookahead::canStart( Rule::Expression, Tokens::RESERVED_EXPECT ) );
+        CPPUNIT_ASSERT( Lookahead::canStart( Rule::Expression, Tokens::LITERAL_STRING ) );
+        CPPUNIT_ASSERT( !Lookahead::canStart( Rule::Expression, Tokens::RESERVED_DEF ) );
+        CPPUNIT_ASSERT( !Lookahead::canStart( Rule::Expression, Tokens::BRACKET_CURLY_CLOSE ) );
+
+        CPPUNIT_ASSERT( Lookahead::canStart( Rule::Statement, Tokens::RESERVED_DEF ) );
+        CPPUNIT_ASSERT( !Lookahead::canStart( Rule::Statement, Tokens::SEMICOLON ) );
+
+        CPPUNIT_ASSERT( Lookahead::canStart( Rule::Type, Tokens::IDENTIFIER ) );
+        CPPUNIT_ASSERT( !Lookahead::canStart( Rule::Type, Tokens::LITERAL_INT_10 ) );
+    }
+
+    void onlyAmbiguousSpeculation() {
+        // The only alternative that can't be chosen by the next token is whether `x + 1` is a statement or the
+        // compound's value
+        std::string source =
+                "def f( x : U32 ) -> U32 {\n"
+                "    def y : U32 = 3;\n"
+                "    y = y * 2;\n"
+                "    x + 1\n"
+                "}\n";
+
+        NonTerminals::Module module;
+        module.parse( String(source.c_str(), source.size()) );
+
+        CPPUNIT_ASSERT( module.lookaheadStatistics.predictions>0 );
+        CPPUNIT_ASSERT( module.lookaheadStatistics.backtracks==1 );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "LookaheadTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<LookaheadTest>(
+                    "firstSets",
+                    &LookaheadTest::firstSets ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<LookaheadTest>(
+                    "onlyAmbiguousSpeculation",
+                    &LookaheadTest::onlyAmbiguousSpeculation ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LookaheadTest );
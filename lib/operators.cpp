@@ -8,124 +8,156 @@
  */
 #include "operators.h"
 
-#include "asserts.h"
-
 using namespace Tokenizer;
 
 namespace Operators {
 
-const std::vector< OperatorPriority > operators = {
-    {
-        // 1
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_DOUBLE_COLON, OperatorType::Regular }
-        }
-    },
-    {
-        // 2
-        .kind = OperatorPriority::OpKind::Postfix,
-        .operators = {
-            { Tokens::OP_PLUS_PLUS, OperatorType::Regular },
-            { Tokens::OP_MINUS_MINUS, OperatorType::Regular },
-            { Tokens::BRACKET_ROUND_OPEN, OperatorType::Function },
-            { Tokens::BRACKET_SQUARE_OPEN, OperatorType::SliceSubscript },
-            { Tokens::OP_DOT, OperatorType::Regular },
-            { Tokens::OP_ARROW, OperatorType::Regular },
-            { Tokens::OP_PTR, OperatorType::Regular },    // Pointer dereference
-            { Tokens::OP_AMPERSAND, OperatorType::Regular },   // Address of
-        }
-    },
-    {
-        // 3
-        .kind = OperatorPriority::OpKind::Prefix,
-        .operators = {
-            { Tokens::OP_PLUS_PLUS, OperatorType::Regular },
-            { Tokens::OP_MINUS_MINUS, OperatorType::Regular },
-            { Tokens::OP_PLUS, OperatorType::Regular },        // Unary plus
-            { Tokens::OP_MINUS, OperatorType::Regular },       // Unary minus
-            { Tokens::OP_BIT_NOT, OperatorType::Regular },
-            { Tokens::OP_LOGIC_NOT, OperatorType::Regular },
-            { Tokens::RESERVED_EXPECT, OperatorType::Cast },
-        }
-    },
-    {
-        // 5
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_MULTIPLY, OperatorType::Regular },
-            { Tokens::OP_DIVIDE, OperatorType::Regular },
-            { Tokens::OP_MODULOUS, OperatorType::Regular },
-            { Tokens::OP_AMPERSAND, OperatorType::Regular },   // Bitwise AND
-        }
-    },
-    {
-        // 6
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_PLUS, OperatorType::Regular },
-            { Tokens::OP_MINUS, OperatorType::Regular },
-            { Tokens::OP_BIT_OR, OperatorType::Regular },
-            { Tokens::OP_BIT_XOR, OperatorType::Regular },
-        }
-    },
-    {
-        // 7
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_SHIFT_LEFT, OperatorType::Regular },
-            { Tokens::OP_SHIFT_RIGHT, OperatorType::Regular },
-        }
-    },
-    {
-        // 8
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_LESS_THAN, OperatorType::Regular },
-            { Tokens::OP_LESS_THAN_EQ, OperatorType::Regular },
-            { Tokens::OP_GREATER_THAN, OperatorType::Regular },
-            { Tokens::OP_GREATER_THAN_EQ, OperatorType::Regular },
-        }
-    },
-    {
-        // 9
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_EQUALS, OperatorType::Regular },
-            { Tokens::OP_NOT_EQUALS, OperatorType::Regular },
-        }
-    },
-    {
-        // 10
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_LOGIC_AND, OperatorType::Regular },
+namespace {
+
+enum class Position { Prefix, Postfix, Infix, InfixRight2Left };
+
+struct OperatorDefinition {
+    uint8_t precedence;
+    Position position;
+    Tokens token;
+    OperatorType type = OperatorType::Regular;
+};
+
+// Precedence 1 binds the tightest. Operators of the same precedence must all be in the same position.
+constexpr OperatorDefinition definitions[] = {
+    { 1, Position::Infix, Tokens::OP_DOUBLE_COLON },
+
+    { 2, Position::Postfix, Tokens::OP_PLUS_PLUS },
+    { 2, Position::Postfix, Tokens::OP_MINUS_MINUS },
+    { 2, Position::Postfix, Tokens::BRACKET_ROUND_OPEN, OperatorType::Function },
+    { 2, Position::Postfix, Tokens::BRACKET_SQUARE_OPEN, OperatorType::SliceSubscript },
+    { 2, Position::Postfix, Tokens::OP_DOT },
+    { 2, Position::Postfix, Tokens::OP_ARROW },
+    { 2, Position::Postfix, Tokens::OP_PTR },                  // Pointer dereference
+    { 2, Position::Postfix, Tokens::OP_AMPERSAND },            // Address of
+
+    { 3, Position::Prefix, Tokens::OP_PLUS_PLUS },
+    { 3, Position::Prefix, Tokens::OP_MINUS_MINUS },
+    { 3, Position::Prefix, Tokens::OP_PLUS },                  // Unary plus
+    { 3, Position::Prefix, Tokens::OP_MINUS },                 // Unary minus
+    { 3, Position::Prefix, Tokens::OP_BIT_NOT },
+    { 3, Position::Prefix, Tokens::OP_LOGIC_NOT },
+    { 3, Position::Prefix, Tokens::RESERVED_EXPECT, OperatorType::Cast },
+
+    { 4, Position::Infix, Tokens::OP_MULTIPLY },
+    { 4, Position::Infix, Tokens::OP_DIVIDE },
+    { 4, Position::Infix, Tokens::OP_MODULOUS },
+    { 4, Position::Infix, Tokens::OP_AMPERSAND },              // Bitwise AND
+
+    { 5, Position::Infix, Tokens::OP_PLUS },
+    { 5, Position::Infix, Tokens::OP_MINUS },
+    { 5, Position::Infix, Tokens::OP_BIT_OR },
+    { 5, Position::Infix, Tokens::OP_BIT_XOR },
+
+    { 6, Position::Infix, Tokens::OP_SHIFT_LEFT },
+    { 6, Position::Infix, Tokens::OP_SHIFT_RIGHT },
+
+    { 7, Position::Infix, Tokens::OP_LESS_THAN },
+    { 7, Position::Infix, Tokens::OP_LESS_THAN_EQ },
+    { 7, Position::Infix, Tokens::OP_GREATER_THAN },
+    { 7, Position::Infix, Tokens::OP_GREATER_THAN_EQ },
+
+    { 8, Position::Infix, Tokens::OP_EQUALS },
+    { 8, Position::Infix, Tokens::OP_NOT_EQUALS },
+
+    { 9, Position::Infix, Tokens::OP_LOGIC_AND },
+
+    { 10, Position::Infix, Tokens::OP_LOGIC_OR },
+
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_PLUS },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_MINUS },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_MULTIPLY },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_DIVIDE },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_MODULOUS },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_LEFT_SHIFT },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_RIGHT_SHIFT },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_BIT_AND },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_BIT_OR },
+    { 11, Position::InfixRight2Left, Tokens::OP_ASSIGN_BIT_XOR },
+};
+
+// Whether the definitions can be turned into a table: each token appears at most once per position, the operator
+// types make sense for the position, and each precedence has only one position
+constexpr bool definitionsValid() {
+    OperatorsTable seen{};
+
+    for( const OperatorDefinition &definition : definitions ) {
+        if( definition.precedence==0 || static_cast<size_t>(definition.token)>=NumTokens )
+            return false;
+
+        for( const OperatorDefinition &other : definitions ) {
+            if( other.precedence==definition.precedence && other.position!=definition.position )
+                return false;
         }
-    },
-    {
-        // 11
-        .kind = OperatorPriority::OpKind::Infix,
-        .operators = {
-            { Tokens::OP_LOGIC_OR, OperatorType::Regular },
+
+        OperatorInfo &info = seen.tokens[ static_cast<size_t>(definition.token) ];
+        switch( definition.position ) {
+        case Position::Prefix:
+            if( info.prefixPrecedence!=0 )
+                return false;
+            if( definition.type!=OperatorType::Regular && definition.type!=OperatorType::Cast )
+                return false;
+            info.prefixPrecedence = definition.precedence;
+            break;
+        case Position::Postfix:
+            if( info.postfixPrecedence!=0 || definition.type==OperatorType::Cast )
+                return false;
+            info.postfixPrecedence = definition.precedence;
+            break;
+        case Position::Infix:
+        case Position::InfixRight2Left:
+            if( info.binaryPrecedence!=0 || definition.type!=OperatorType::Regular )
+                return false;
+            info.binaryPrecedence = definition.precedence;
+            break;
         }
-    },
-    {
-        // 12
-        .kind = OperatorPriority::OpKind::InfixRight2Left,
-        .operators = {
-            { Tokens::OP_ASSIGN, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_PLUS, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_MINUS, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_MULTIPLY, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_DIVIDE, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_MODULOUS, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_LEFT_SHIFT, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_RIGHT_SHIFT, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_BIT_AND, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_BIT_OR, OperatorType::Regular },
-            { Tokens::OP_ASSIGN_BIT_XOR, OperatorType::Regular },
+    }
+
+    return true;
+}
+
+static_assert( definitionsValid(), "Invalid operator definitions" );
+
+constexpr OperatorsTable buildTable() {
+    OperatorsTable table{};
+
+    for( const OperatorDefinition &definition : definitions ) {
+        OperatorInfo &info = table.tokens[ static_cast<size_t>(definition.token) ];
+
+        switch( definition.position ) {
+        case Position::Prefix:
+            info.prefixPrecedence = definition.precedence;
+            info.prefixType = definition.type;
+
+            if( table.minPrefixPrecedence==0 || definition.precedence<table.minPrefixPrecedence )
+                table.minPrefixPrecedence = definition.precedence;
+            break;
+        case Position::Postfix:
+            info.postfixPrecedence = definition.precedence;
+            info.postfixType = definition.type;
+            break;
+        case Position::Infix:
+        case Position::InfixRight2Left:
+            info.binaryPrecedence = definition.precedence;
+            info.rightToLeft = definition.position==Position::InfixRight2Left;
+            break;
         }
-    },
-};
+
+        if( definition.precedence>table.maxPrecedence )
+            table.maxPrecedence = definition.precedence;
+    }
+
+    return table;
+}
+
+} // Anonymous namespace
+
+constexpr OperatorsTable operatorsTable = buildTable();
 
 } // Namespace Operators
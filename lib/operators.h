@@ -1,6 +1,6 @@
 /* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
  *
- * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2018-2019 by its authors
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2018-2020 by its authors
  * You can see the file's authors in the AUTHORS file in the project's home repository.
  *
  * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
@@ -11,23 +11,44 @@
 
 #include "tokenizer.h"
 
-#include <practical/slice.h>
-
-#include <unordered_map>
-#include <vector>
+#include <cstdint>
 
 namespace Operators {
 
-enum class OperatorType { Regular, Function, SliceSubscript, Cast };
+enum class OperatorType : uint8_t { Regular, Function, SliceSubscript, Cast };
+
+// How a token behaves when the parser finds it where an operator might be. The same token can be an operator in more
+// than one position (e.g. `-` is both unary and binary).
+//
+// Precedences count from 1, which binds the tightest. 0 means the token is not an operator in that position.
+struct OperatorInfo {
+    uint8_t prefixPrecedence = 0;
+    OperatorType prefixType = OperatorType::Regular;
+
+    uint8_t postfixPrecedence = 0;
+    OperatorType postfixType = OperatorType::Regular;
 
-struct OperatorPriority {
-    enum class OpKind { Prefix, Infix, InfixRight2Left, Postfix } kind;
+    uint8_t binaryPrecedence = 0;
+    // Associativity of the binary operator
+    bool rightToLeft = false;
+};
+
+// Tokens are numbered consecutively, and RESERVED_STRUCT is the last one
+static constexpr size_t NumTokens = static_cast<size_t>( Tokenizer::Tokens::RESERVED_STRUCT ) + 1;
 
-    using OperatorsMap = std::unordered_map< Tokenizer::Tokens, OperatorType >;
-    OperatorsMap operators;
+struct OperatorsTable {
+    OperatorInfo tokens[NumTokens];
+    // The loosest binding of all operators
+    uint8_t maxPrecedence = 0;
+    // The tightest binding of all prefix operators
+    uint8_t minPrefixPrecedence = 0;
 };
 
-extern const std::vector< OperatorPriority > operators;
+extern const OperatorsTable operatorsTable;
+
+inline const OperatorInfo &lookup( Tokenizer::Tokens token ) {
+    return operatorsTable.tokens[ static_cast<size_t>(token) ];
+}
 
 } // Namespace Operators
 
@@ -0,0 +1,99 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parse_arena.h"
+
+namespace NonTerminals {
+
+ParseArena::Scope::Scope(ParseArena &arena) : previous(active) {
+    active = &arena;
+}
+
+ParseArena::Scope::~Scope() {
+    active = previous;
+}
+
+void ParseArena::grow(size_t minimalSize) {
+    size_t blockSize = std::max( nextBlockSize, minimalSize );
+
+    blocks.emplace_back( new char[blockSize] );
+    current = blocks.back().get();
+    remaining = blockSize;
+
+    if( nextBlockSize<MaxBlockSize )
+        nextBlockSize *= 2;
+}
+
+NodePool::~NodePool() {
+    for( auto &segment : segments )
+        delete[] segment.load( std::memory_order_relaxed );
+}
+
+uint32_t NodePool::reserve(uint32_t count) {
+    uint32_t first = reserved.fetch_add( count, std::memory_order_relaxed );
+    ASSERT( uint64_t(first) + count <= UINT32_MAX ) << "Too many parse tree nodes";
+
+    for( unsigned segment = segmentOf(first); segment <= segmentOf( uint64_t(first) + count - 1 ); ++segment ) {
+        if( segments[segment].load( std::memory_order_acquire )!=nullptr )
+            continue;
+
+        std::lock_guard<std::mutex> lock( growLock );
+        if( segments[segment].load( std::memory_order_relaxed )==nullptr )
+            segments[segment].store( new char[ (FirstSegmentSize<<segment) * nodeSize ], std::memory_order_release );
+    }
+
+    return first;
+}
+
+// 0 is left for no pools
+static std::atomic<uint32_t> nextPoolsId{1};
+
+ParseArena::NodePools::NodePools() : id( nextPoolsId++ ) {
+    ASSERT( id!=0 ) << "Too many parse tree node pools";
+}
+
+ParseArena::NodePools::~NodePools() {
+    for( auto &pool : pools )
+        delete pool.load( std::memory_order_relaxed );
+}
+
+NodePool *ParseArena::NodePools::create(unsigned nodeType, size_t nodeSize) {
+    std::lock_guard<std::mutex> lock( createLock );
+
+    NodePool *pool = pools[nodeType].load( std::memory_order_relaxed );
+    if( pool==nullptr ) {
+        pool = new NodePool( nodeSize );
+        pools[nodeType].store( pool, std::memory_order_release );
+    }
+
+    return pool;
+}
+
+unsigned ParseArena::allocateNodeType() {
+    static std::atomic<unsigned> nextNodeType{0};
+
+    unsigned type = nextNodeType++;
+    ASSERT( type<MaxNodeTypes ) << "Too many parse tree node types";
+
+    return type;
+}
+
+void ParseArena::adopt(ParseArena &&that) {
+    ASSERT( that.pools==pools ) << "Adopted arena made its nodes in other pools";
+
+    for( auto &block : that.blocks )
+        blocks.emplace_back( std::move(block) );
+    used += that.used;
+
+    that.blocks.clear();
+    that.current = nullptr;
+    that.remaining = 0;
+    that.used = 0;
+}
+
+} // namespace NonTerminals
@@ -0,0 +1,365 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef PARSE_ARENA_H
+#define PARSE_ARENA_H
+
+#include "asserts.h"
+#include "nocopy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace NonTerminals {
+
+// A node in one of the pools of a ParseArena. Nodes point at their children with these rather than with pointers, which
+// keeps them small. Index 0 is no node. Resolving an index requires an arena sharing the pools the node was made in to
+// be active. The index records which pools those are, so that resolving it under any other arena aborts.
+template<typename T>
+class NodeIndex {
+    uint32_t index = 0;
+    uint32_t pools = 0;
+
+public:
+    NodeIndex() = default;
+    NodeIndex(uint32_t index, uint32_t pools) : index(index), pools(pools) {}
+
+    explicit operator bool() const {
+        return index!=0;
+    }
+
+    bool operator==(NodeIndex rhs) const {
+        return index==rhs.index && pools==rhs.pools;
+    }
+
+    bool operator!=(NodeIndex rhs) const {
+        return !( *this==rhs );
+    }
+
+    uint32_t getIndex() const {
+        return index;
+    }
+
+    // The id of the pools the node was made in
+    uint32_t getPools() const {
+        return pools;
+    }
+
+    T *get() const;
+
+    T &operator*() const {
+        return *get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+};
+
+// The nodes of a single type. Nodes never move, and are never destructed. Indexes are reserved in runs, so that several
+// arenas may make nodes in the same pool concurrently.
+class NodePool : private NoCopy {
+    // Segment i holds FirstSegmentSize<<i nodes, so that the segments never move and can cover all 32 bit indexes
+    static constexpr unsigned FirstSegmentBits = 8;
+    static constexpr size_t FirstSegmentSize = 1<<FirstSegmentBits;
+    static constexpr size_t NumSegments = 32 - FirstSegmentBits + 1;
+
+    const size_t nodeSize;
+    // Index 0 is never handed out
+    std::atomic<uint32_t> reserved{1};
+    std::atomic<char *> segments[NumSegments] = {};
+    std::mutex growLock;
+
+public:
+    explicit NodePool(size_t nodeSize) : nodeSize(nodeSize) {}
+    ~NodePool();
+
+    // Reserve count consecutive indexes, returning the first of them. Thread safe.
+    uint32_t reserve(uint32_t count);
+
+    void *at(uint32_t index) const {
+        ASSERT( index!=0 && index<reserved.load( std::memory_order_relaxed ) ) << "Invalid node index " << index;
+
+        unsigned segment = segmentOf(index);
+        uint64_t offset = index + FirstSegmentSize - ( uint64_t(FirstSegmentSize) << segment );
+
+        return segments[segment].load( std::memory_order_acquire ) + offset*nodeSize;
+    }
+
+private:
+    // Segment i starts at index FirstSegmentSize*(2^i - 1)
+    static unsigned segmentOf(uint64_t index) {
+        return 63 - __builtin_clzll( index + FirstSegmentSize ) - FirstSegmentBits;
+    }
+};
+
+// Monotonic memory for the nodes of a parse tree. All of it is released together when the arena is destroyed.
+//
+// Destructors of objects placed in the arena are never called. Such objects must not own any memory outside the arena.
+//
+// Nodes are kept in pools, one per node type, so that nodes of the same type are contiguous. They point at their
+// children with NodeIndex and hold lists as ArenaVector. Anything else is allocated by bumping a pointer.
+//
+// Allocation is done from the arena that is active on the current thread. Use a Scope to make an arena active.
+class ParseArena : private NoCopy {
+public:
+    // Make arena the active arena of the current thread for the scope's lifetime
+    class Scope : private NoCopy {
+        ParseArena *previous;
+
+    public:
+        explicit Scope(ParseArena &arena);
+        ~Scope();
+    };
+
+private:
+    static constexpr size_t FirstBlockSize = 16*1024;
+    static constexpr size_t MaxBlockSize = 1024*1024;
+    static constexpr unsigned MaxNodeTypes = 32;
+    // Indexes an arena reserves in a pool at a time
+    static constexpr uint32_t RunSize = 64;
+
+    // The pools of all node types. Shared by arenas that parse parts of the same module.
+    class NodePools : private NoCopy {
+        std::atomic<NodePool *> pools[MaxNodeTypes] = {};
+        std::mutex createLock;
+
+    public:
+        // Unique to each set of pools, so that nodes resolved in the wrong set can be caught
+        const uint32_t id;
+
+        NodePools();
+        ~NodePools();
+
+        NodePool &get(unsigned nodeType, size_t nodeSize) {
+            NodePool *pool = pools[nodeType].load( std::memory_order_acquire );
+            if( pool==nullptr )
+                pool = create( nodeType, nodeSize );
+
+            return *pool;
+        }
+
+    private:
+        NodePool *create(unsigned nodeType, size_t nodeSize);
+    };
+
+    // Indexes reserved by this arena and not yet used
+    struct Run {
+        uint32_t next = 0, end = 0;
+    };
+
+    std::vector< std::unique_ptr<char[]> > blocks;
+    char *current = nullptr;
+    size_t remaining = 0;
+    size_t nextBlockSize = FirstBlockSize;
+    size_t used = 0;
+    std::shared_ptr<NodePools> pools = std::make_shared<NodePools>();
+    Run runs[MaxNodeTypes];
+
+    static inline thread_local ParseArena *active = nullptr;
+
+public:
+    ParseArena() = default;
+    ParseArena(ParseArena &&that) = default;
+    ParseArena &operator=(ParseArena &&that) = default;
+
+    // A new arena that makes its nodes in this arena's pools. Each arena resolves the nodes made by the other, so
+    // several threads can parse parts of one tree, each into an arena of its own.
+    ParseArena sharingPools() {
+        ParseArena arena;
+        arena.pools = pools;
+
+        return arena;
+    }
+
+    void *allocate(size_t size, size_t alignment) {
+        size_t padding = ( alignment - reinterpret_cast<uintptr_t>(current) % alignment ) % alignment;
+        if( size + padding > remaining ) {
+            grow( size + alignment );
+            padding = ( alignment - reinterpret_cast<uintptr_t>(current) % alignment ) % alignment;
+        }
+
+        char *ret = current + padding;
+        current = ret + size;
+        remaining -= size + padding;
+        used += size;
+
+        return ret;
+    }
+
+    // Bytes handed out by the arena, not counting alignment padding or unused block space
+    size_t bytesUsed() const {
+        return used;
+    }
+
+    size_t numBlocks() const {
+        return blocks.size();
+    }
+
+    // Take over all of that's memory. Objects allocated by that stay valid for as long as this arena lives. that must
+    // share this arena's pools.
+    void adopt(ParseArena &&that);
+
+    static ParseArena &getActive() {
+        ASSERT( active!=nullptr ) << "Parse tree node allocated with no active arena";
+        return *active;
+    }
+
+    // Construct a T in the active arena
+    template<typename T, typename... Args>
+    static T *make(Args&&... args) {
+        return new( getActive().allocate( sizeof(T), alignof(T) ) ) T( std::forward<Args>(args)... );
+    }
+
+    // Construct a node in the active arena's pool of Ts
+    template<typename T, typename... Args>
+    static NodeIndex<T> makeNode(Args&&... args) {
+        static_assert( alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ );
+
+        ParseArena &arena = getActive();
+        unsigned type = nodeType<T>();
+        NodePool &pool = arena.pools->get( type, sizeof(T) );
+
+        Run &run = arena.runs[type];
+        if( run.next==run.end ) {
+            run.next = pool.reserve( RunSize );
+            run.end = run.next + RunSize;
+        }
+
+        uint32_t index = run.next++;
+        new( pool.at(index) ) T( std::forward<Args>(args)... );
+        arena.used += sizeof(T);
+
+        return NodeIndex<T>( index, arena.pools->id );
+    }
+
+    // The node at index of the active arena's pool of Ts. The active arena must share the pools with the given id.
+    template<typename T>
+    static T *node(uint32_t index, uint32_t pools) {
+        NodePools &activePools = *getActive().pools;
+        ASSERT( activePools.id==pools ) << "Node made in pools " << pools << " resolved in pools " << activePools.id;
+
+        return static_cast<T *>( activePools.get( nodeType<T>(), sizeof(T) ).at(index) );
+    }
+
+private:
+    void grow(size_t minimalSize);
+
+    template<typename T>
+    static unsigned nodeType() {
+        static const unsigned type = allocateNodeType();
+
+        return type;
+    }
+
+    static unsigned allocateNodeType();
+};
+
+template<typename T>
+T *NodeIndex<T>::get() const {
+    return ParseArena::node<T>( index, pools );
+}
+
+// A growable array whose elements live in the active ParseArena. Like the arena itself, it never destroys its elements.
+template<typename T>
+class ArenaVector {
+    T *elements = nullptr;
+    size_t count = 0, capacity = 0;
+
+public:
+    ArenaVector() = default;
+    ArenaVector(const ArenaVector &that) = delete;
+    ArenaVector &operator=(const ArenaVector &that) = delete;
+
+    ArenaVector(ArenaVector &&that) : elements(that.elements), count(that.count), capacity(that.capacity) {
+        that.elements = nullptr;
+        that.count = that.capacity = 0;
+    }
+
+    ArenaVector &operator=(ArenaVector &&that) {
+        std::swap( elements, that.elements );
+        std::swap( count, that.count );
+        std::swap( capacity, that.capacity );
+
+        return *this;
+    }
+
+    template<typename... Args>
+    T &emplace_back(Args&&... args) {
+        if( count==capacity )
+            grow();
+
+        return *new( &elements[count++] ) T( std::forward<Args>(args)... );
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count==0;
+    }
+
+    T &operator[](size_t index) {
+        ASSERT( index<count ) << "Arena vector access out of bounds: " << index << ">=" << count;
+        return elements[index];
+    }
+
+    const T &operator[](size_t index) const {
+        ASSERT( index<count ) << "Arena vector access out of bounds: " << index << ">=" << count;
+        return elements[index];
+    }
+
+    T &back() {
+        return (*this)[count-1];
+    }
+
+    const T &back() const {
+        return (*this)[count-1];
+    }
+
+    T *begin() {
+        return elements;
+    }
+
+    T *end() {
+        return elements + count;
+    }
+
+    const T *begin() const {
+        return elements;
+    }
+
+    const T *end() const {
+        return elements + count;
+    }
+
+private:
+    void grow() {
+        size_t newCapacity = capacity==0 ? 4 : capacity*2;
+        T *newElements = static_cast<T *>(
+                ParseArena::getActive().allocate( newCapacity*sizeof(T), alignof(T) ) );
+
+        // The old elements stay in the arena, moved from
+        for( size_t i=0; i<count; ++i )
+            new( &newElements[i] ) T( std::move( elements[i] ) );
+
+        elements = newElements;
+        capacity = newCapacity;
+    }
+};
+
+} // namespace NonTerminals
+
+#endif // PARSE_ARENA_H
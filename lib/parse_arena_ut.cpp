@@ -0,0 +1,156 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parser/module.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ParseArenaTest : public CppUnit::TestFixture  {
+    void alignment() {
+        NonTerminals::ParseArena arena;
+
+        for( size_t size=1; size<100; ++size ) {
+            void *ptr = arena.allocate( size, alignof(uint64_t) );
+            CPPUNIT_ASSERT( reinterpret_cast<uintptr_t>(ptr) % alignof(uint64_t) == 0 );
+        }
+
+        // Larger than any block the arena would otherwise allocate
+        static constexpr size_t HugeSize = 16*1024*1024;
+        char *huge = static_cast<char *>( arena.allocate( HugeSize, 1 ) );
+        huge[0] = huge[HugeSize-1] = 'x';
+    }
+
+    void vectorGrowth() {
+        NonTerminals::ParseArena arena;
+        NonTerminals::ParseArena::Scope scope( arena );
+
+        NonTerminals::ArenaVector<size_t> vector;
+        for( size_t i=0; i<1000; ++i )
+            vector.emplace_back( i );
+
+        CPPUNIT_ASSERT( vector.size()==1000 );
+        for( size_t i=0; i<vector.size(); ++i )
+            CPPUNIT_ASSERT( vector[i]==i );
+
+        NonTerminals::ArenaVector<size_t> moved( std::move(vector) );
+        CPPUNIT_ASSERT( vector.empty() );
+        CPPUNIT_ASSERT( moved.back()==999 );
+    }
+
+    void nodePools() {
+        NonTerminals::ParseArena arena;
+        NonTerminals::ParseArena::Scope scope( arena );
+
+        // Enough nodes to fill several of the pool's segments
+        static constexpr uint32_t NumNodes = 100*1000;
+        std::vector< NonTerminals::NodeIndex<uint64_t> > nodes;
+        std::vector< const uint64_t * > addresses;
+        for( uint32_t i=0; i<NumNodes; ++i ) {
+            nodes.emplace_back( NonTerminals::ParseArena::makeNode<uint64_t>( i ) );
+            addresses.emplace_back( nodes.back().get() );
+        }
+
+        // Nodes never move, and nodes made one after the other are contiguous
+        for( uint32_t i=0; i<NumNodes; ++i ) {
+            CPPUNIT_ASSERT( nodes[i] );
+            CPPUNIT_ASSERT( nodes[i].get()==addresses[i] );
+            CPPUNIT_ASSERT( *nodes[i]==i );
+        }
+        CPPUNIT_ASSERT( addresses[1]==addresses[0]+1 );
+        CPPUNIT_ASSERT( arena.bytesUsed()==NumNodes*sizeof(uint64_t) );
+        CPPUNIT_ASSERT( !NonTerminals::NodeIndex<uint64_t>() );
+    }
+
+    void sharedPools() {
+        NonTerminals::ParseArena arena;
+        NonTerminals::ParseArena part = arena.sharingPools();
+
+        NonTerminals::NodeIndex<uint32_t> inArena, inPart;
+        {
+            NonTerminals::ParseArena::Scope scope( arena );
+            inArena = NonTerminals::ParseArena::makeNode<uint32_t>( 1 );
+        }
+        {
+            NonTerminals::ParseArena::Scope scope( part );
+            inPart = NonTerminals::ParseArena::makeNode<uint32_t>( 2 );
+            CPPUNIT_ASSERT( *inArena==1 );
+        }
+
+        CPPUNIT_ASSERT( inArena!=inPart );
+        CPPUNIT_ASSERT( inArena.getPools()==inPart.getPools() );
+        arena.adopt( std::move(part) );
+
+        NonTerminals::ParseArena::Scope scope( arena );
+        CPPUNIT_ASSERT( *inArena==1 );
+        CPPUNIT_ASSERT( *inPart==2 );
+    }
+
+    void separatePools() {
+        // Arenas that don't share pools hand out the same indexes. Their nodes are told apart by the pools they were
+        // made in.
+        NonTerminals::ParseArena first, second;
+
+        NonTerminals::NodeIndex<uint32_t> inFirst, inSecond;
+        {
+            NonTerminals::ParseArena::Scope scope( first );
+            inFirst = NonTerminals::ParseArena::makeNode<uint32_t>( 1 );
+        }
+        {
+            NonTerminals::ParseArena::Scope scope( second );
+            inSecond = NonTerminals::ParseArena::makeNode<uint32_t>( 2 );
+            CPPUNIT_ASSERT( *inSecond==2 );
+        }
+
+        CPPUNIT_ASSERT( inFirst.getIndex()==inSecond.getIndex() );
+        CPPUNIT_ASSERT( inFirst.getPools()!=inSecond.getPools() );
+        CPPUNIT_ASSERT( inFirst!=inSecond );
+    }
+
+    void moduleOwnsTree() {
+        std::string source =
+                "def f( x : U32 ) -> U32 { x + 1 }\n"
+                "def g( x : U32 ) -> U32 { if( x>3 ) { f( x ) } else { 2 * x } }\n";
+
+        NonTerminals::Module module;
+        module.parse( String(source.c_str(), source.size()) );
+
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==2 );
+        CPPUNIT_ASSERT( module.arena.bytesUsed()>0 );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParseArenaTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "alignment",
+                    &ParseArenaTest::alignment ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "vectorGrowth",
+                    &ParseArenaTest::vectorGrowth ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "nodePools",
+                    &ParseArenaTest::nodePools ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "sharedPools",
+                    &ParseArenaTest::sharedPools ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "separatePools",
+                    &ParseArenaTest::separatePools ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseArenaTest>(
+                    "moduleOwnsTree",
+                    &ParseArenaTest::moduleOwnsTree ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParseArenaTest );
@@ -0,0 +1,1030 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parse_tree_cache.h"
+
+#include "config.h"
+
+#include "fd.h"
+#include "mmap.h"
+#include "operators.h"
+#include "parser/module.h"
+#include "token_stream.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NonTerminals {
+
+namespace {
+
+// Change whenever the layout of an entry, or of any node, changes
+static constexpr uint32_t FormatVersion = 2;
+static constexpr char Magic[8] = { 'P', 'R', 'A', 'C', 'T', 'P', 'T', 'C' };
+
+struct Header {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t lazyFunctionBodies;
+    char libraryVersion[16];
+    uint64_t maxNestingDepth;
+    uint64_t sourceSize, sourceHash, sourceCheck;
+    uint64_t numTokens;
+    // Sizes, in bytes, of the tokens and of the tree that follow the header
+    uint64_t tokensSize, treeSize;
+};
+
+size_t entrySize(const Header &header) {
+    return sizeof(Header) + header.tokensSize + header.treeSize;
+}
+
+// The entry does not keep the source, so it is identified by two independent hashes. A wrong tree would need both of
+// them to collide.
+uint64_t checkSource(String source) {
+    static constexpr uint64_t Multiplier = 0x9e3779b97f4a7c15;
+    uint64_t hash = 0x2545f4914f6cdd1d + source.size();
+
+    size_t i = 0;
+    for( ; i+sizeof(uint64_t)<=source.size(); i+=sizeof(uint64_t) ) {
+        uint64_t word;
+        memcpy( &word, source.get()+i, sizeof(word) );
+        hash = ( hash + word ) * Multiplier;
+        hash ^= hash>>29;
+    }
+    for( ; i<source.size(); ++i ) {
+        hash = ( hash + static_cast<unsigned char>( source[i] ) ) * Multiplier;
+        hash ^= hash>>29;
+    }
+
+    return hash;
+}
+
+// Everything in an entry past its header is a sequence of variable length integers: seven bits to a byte, least
+// significant first, with the top bit set on all bytes but the last. Most values are small, so most take one byte.
+void putVarint(std::vector<uint8_t> &bytes, uint64_t value) {
+    while( value>=0x80 ) {
+        bytes.push_back( static_cast<uint8_t>( value | 0x80 ) );
+        value >>= 7;
+    }
+    bytes.push_back( static_cast<uint8_t>( value ) );
+}
+
+void fillHeader(Header &header, String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments) {
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, Magic, sizeof(Magic) );
+    header.formatVersion = FormatVersion;
+    header.lazyFunctionBodies = arguments.lazyFunctionBodies;
+    strncpy( header.libraryVersion, PACKAGE_VERSION, sizeof(header.libraryVersion) );
+    header.maxNestingDepth = arguments.maxNestingDepth;
+    header.sourceSize = source.size();
+    header.sourceHash = ParseTreeCache::hashSource( source );
+    header.sourceCheck = checkSource( source );
+}
+
+// Entries parsed with different arguments are kept apart, so that they don't replace each other
+std::string pathOf(const std::string &directory, const Header &header) {
+    char name[64];
+    snprintf(
+            name, sizeof(name), "/%016llx-%s-%llu.ptc",
+            static_cast<unsigned long long>(header.sourceHash),
+            header.lazyFunctionBodies ? "lazy" : "eager",
+            static_cast<unsigned long long>(header.maxNestingDepth) );
+
+    return directory + name;
+}
+
+// The tree is too deep to write without overflowing the stack. It is not cached.
+struct TooDeep {};
+// The entry does not hold a valid tree
+struct Corrupt {};
+
+class VarintReader {
+    Slice<const uint8_t> bytes;
+    size_t position = 0;
+
+public:
+    explicit VarintReader(Slice<const uint8_t> bytes) : bytes(bytes) {}
+
+    bool atEnd() const {
+        return position==bytes.size();
+    }
+
+    uint64_t get() {
+        uint64_t value = 0;
+        for( unsigned shift=0; shift<64; shift+=7 ) {
+            if( position>=bytes.size() )
+                throw Corrupt();
+
+            uint8_t byte = bytes[position++];
+            value |= uint64_t( byte & 0x7f ) << shift;
+            if( (byte & 0x80)==0 )
+                return value;
+        }
+
+        throw Corrupt();
+    }
+
+    // Raw bytes, as written after their count
+    Slice<const uint8_t> getBytes(size_t size) {
+        if( size>bytes.size()-position )
+            throw Corrupt();
+
+        Slice<const uint8_t> ret = bytes.subslice( position, position+size );
+        position += size;
+
+        return ret;
+    }
+};
+
+} // Anonymous namespace
+
+class ParseTreeCache::Writer {
+    std::vector<uint8_t> bytes;
+    const Tokenizer::TokenStream &tokens;
+    // The index of the last token written. Nodes mostly refer to tokens in source order, so each token is written
+    // relative to the previous one.
+    size_t lastToken = 0;
+
+public:
+    explicit Writer(const Tokenizer::TokenStream &tokens) : tokens(tokens) {}
+
+    const std::vector<uint8_t> &getBytes() const {
+        return bytes;
+    }
+
+    void write(const Module &module) {
+        writeBase( module );
+        writeVector( module.functionDefinitions );
+        writeVector( module.functionDeclarations );
+        writeVector( module.structureDefinitions );
+    }
+
+private:
+    void put(uint64_t value) {
+        putVarint( bytes, value );
+    }
+
+    // Tokens are written as the zigzag encoded distance from the last token written, plus one. 0 is no token.
+    void putTokenIndex(size_t index) {
+        int64_t delta = int64_t(index) - int64_t(lastToken);
+        lastToken = index;
+
+        put( ( uint64_t(delta)<<1 ^ uint64_t(delta>>63) ) + 1 );
+    }
+
+    void writeToken(Tokenizer::TokenRef token) {
+        if( !token ) {
+            put( 0 );
+            return;
+        }
+
+        ASSERT( &token.getStream()==&tokens ) << "Parse tree points outside its tokens";
+        putTokenIndex( token.getIndex() );
+    }
+
+    void writeSlice(Tokenizer::TokenSlice slice) {
+        put( slice.size() );
+        if( slice.getStream()==nullptr ) {
+            put( 0 );
+            return;
+        }
+
+        ASSERT( slice.getStream()==&tokens ) << "Parse tree points outside its tokens";
+        putTokenIndex( slice.getStart() );
+    }
+
+    void writeBase(const NonTerminal &node) {
+        writeSlice( node.parsedSlice );
+    }
+
+    template<typename T>
+    void writeVector(const ArenaVector<T> &vector) {
+        put( vector.size() );
+        for( const T &element : vector )
+            write( element );
+    }
+
+    // Pointers to nodes are written as a flag, followed by the node if it's there
+    template<typename T>
+    void writePointer(const T *node) {
+        put( node!=nullptr );
+        if( node!=nullptr )
+            write( *node );
+    }
+
+    template<typename T>
+    void writePointer(NodeIndex<T> node) {
+        writePointer( node ? node.get() : nullptr );
+    }
+
+    void write(const Identifier &identifier) {
+        writeBase( identifier );
+        writeToken( identifier.identifier );
+    }
+
+    void write(const LiteralInt &literal) {
+        writeBase( literal );
+        writeToken( literal.token );
+        put( literal.value );
+    }
+
+    void write(const LiteralBool &literal) {
+        writeBase( literal );
+        writeToken( literal.token );
+        put( literal.value );
+    }
+
+    void write(const LiteralPointer &literal) {
+        writeBase( literal );
+        writeToken( literal.token );
+    }
+
+    void write(const LiteralString &literal) {
+        writeBase( literal );
+        writeToken( literal.token );
+        put( literal.value.size() );
+        bytes.insert( bytes.end(), literal.value.begin(), literal.value.end() );
+    }
+
+    void write(const Literal &literal) {
+        writeBase( literal );
+        put( literal.literal.index() );
+        std::visit( [this]( const auto &value ) { write( value ); }, literal.literal );
+    }
+
+    void write(const Type &type) {
+        writeBase( type );
+        put( type.type.index() );
+        switch( type.type.index() ) {
+        case 0:
+            break;
+        case 1:
+            write( std::get<Identifier>( type.type ) );
+            break;
+        case 2:
+            {
+                const Type::Array &array = std::get<Type::Array>( type.type );
+                writePointer( array.elementType );
+                writeToken( array.token );
+                write( array.dimension );
+            }
+            break;
+        case 3:
+            {
+                const Type::Pointer &pointer = std::get<Type::Pointer>( type.type );
+                writePointer( pointer.pointed );
+                writeToken( pointer.token );
+            }
+            break;
+        default:
+            ABORT() << "Unknown type variant " << type.type.index();
+        }
+    }
+
+    void write(const TransientType &type) {
+        writeBase( type );
+        write( type.type );
+        writeToken( type.ref );
+    }
+
+    void write(const Expression &expression) {
+        NestingLimit::Level nesting;
+        if( nesting.tooDeep() )
+            throw TooDeep();
+
+        writeBase( expression );
+        put( expression.value.index() );
+        switch( expression.value.index() ) {
+        case 0:
+            writePointer( std::get< NodeIndex<CompoundExpression> >( expression.value ) );
+            break;
+        case 1:
+            writePointer( std::get< NodeIndex<Literal> >( expression.value ) );
+            break;
+        case 2:
+            write( *std::get< NodeIndex<Identifier> >( expression.value ) );
+            break;
+        case 3:
+            {
+                const Expression::UnaryOperator &op = std::get<Expression::UnaryOperator>( expression.value );
+                writeToken( op.op );
+                writePointer( op.operand );
+            }
+            break;
+        case 4:
+            {
+                const Expression::BinaryOperator &op = std::get<Expression::BinaryOperator>( expression.value );
+                writeToken( op.op );
+                writePointer( op.operands[0] );
+                writePointer( op.operands[1] );
+            }
+            break;
+        case 5:
+            {
+                const Expression::CastOperator &op = std::get<Expression::CastOperator>( expression.value );
+                writeToken( op.op );
+                writePointer( op.destType );
+                writePointer( op.expression );
+            }
+            break;
+        case 6:
+            {
+                const Expression::FunctionCall &call = std::get<Expression::FunctionCall>( expression.value );
+                writeToken( call.op );
+                writePointer( call.expression );
+                writePointer( call.arguments );
+            }
+            break;
+        case 7:
+            writePointer( std::get< NodeIndex<ConditionalExpression> >( expression.value ) );
+            break;
+        case 8:
+            writePointer( std::get< NodeIndex<Type> >( expression.value ) );
+            break;
+        default:
+            ABORT() << "Unknown expression variant " << expression.value.index();
+        }
+    }
+
+    void write(const FunctionArguments &arguments) {
+        writeBase( arguments );
+        writeVector( arguments.arguments );
+    }
+
+    void write(const ConditionalExpression &condition) {
+        write( condition.condition );
+        write( condition.ifClause );
+        write( condition.elseClause );
+    }
+
+    void write(const Statement &statement) {
+        NestingLimit::Level nesting;
+        if( nesting.tooDeep() )
+            throw TooDeep();
+
+        writeBase( statement );
+        put( statement.content.index() );
+        switch( statement.content.index() ) {
+        case 0:
+            break;
+        case 1:
+            write( *std::get< NodeIndex<Expression> >( statement.content ) );
+            break;
+        case 2:
+            writePointer( std::get< NodeIndex<VariableDefinition> >( statement.content ) );
+            break;
+        case 3:
+            {
+                const Statement::ConditionalStatement &condition =
+                        std::get<Statement::ConditionalStatement>( statement.content );
+                write( *condition.condition );
+                writePointer( condition.ifClause );
+                writePointer( condition.elseClause );
+            }
+            break;
+        case 4:
+            writePointer( std::get< NodeIndex<CompoundStatement> >( statement.content ) );
+            break;
+        default:
+            ABORT() << "Unknown statement variant " << statement.content.index();
+        }
+    }
+
+    void write(const StatementList &statementList) {
+        writeBase( statementList );
+        writeVector( statementList.statements );
+    }
+
+    void write(const CompoundExpression &compound) {
+        writeBase( compound );
+        write( compound.statementList );
+        write( compound.expression );
+    }
+
+    void write(const CompoundStatement &compound) {
+        writeBase( compound );
+        write( compound.statements );
+    }
+
+    void write(const VariableDeclBody &body) {
+        writeBase( body );
+        write( body.name );
+        write( body.type );
+    }
+
+    void write(const VariableDefinition &definition) {
+        writeBase( definition );
+        write( definition.body );
+        writePointer( definition.initValue );
+    }
+
+    void write(const FuncDeclArg &argument) {
+        writeBase( argument );
+        write( argument.name );
+        write( argument.type );
+    }
+
+    void write(const FuncDeclBody &decl) {
+        writeBase( decl );
+        write( decl.name );
+        writeBase( decl.arguments );
+        writeVector( decl.arguments.arguments );
+        writeBase( decl.returnType );
+        write( decl.returnType.type );
+    }
+
+    void write(const FuncDef &function) {
+        writeBase( function );
+        write( function.decl );
+        put( function.body.index() );
+        switch( function.body.index() ) {
+        case 0:
+            break;
+        case 1:
+            write( std::get<CompoundExpression>( function.body ) );
+            break;
+        case 2:
+            write( std::get<CompoundStatement>( function.body ) );
+            break;
+        default:
+            ABORT() << "Unknown function body variant " << function.body.index();
+        }
+        writeSlice( function.bodyTokens );
+    }
+
+    void write(const FuncDecl &function) {
+        writeBase( function );
+        write( function.decl );
+        write( function.abiSpecifier );
+    }
+
+    void write(const StructDef &strct) {
+        writeBase( strct );
+        writeToken( strct.keyword );
+        write( strct.identifier );
+        writeVector( strct.variables );
+    }
+};
+
+class ParseTreeCache::Reader {
+    VarintReader bytes;
+    const Tokenizer::TokenStream &tokens;
+    size_t lastToken = 0;
+
+public:
+    Reader(Slice<const uint8_t> bytes, const Tokenizer::TokenStream &tokens) : bytes(bytes), tokens(tokens) {}
+
+    void read(Module &module) {
+        readBase( module );
+        readVector( module.functionDefinitions );
+        readVector( module.functionDeclarations );
+        readVector( module.structureDefinitions );
+
+        if( !bytes.atEnd() )
+            throw Corrupt();
+    }
+
+private:
+    uint64_t get() {
+        return bytes.get();
+    }
+
+    // The index of a token written with Writer::putTokenIndex, given the value read. The index must be below end.
+    size_t tokenIndex(uint64_t value, size_t end) {
+        uint64_t zigzag = value-1;
+        size_t index = lastToken + ( zigzag>>1 ^ -( zigzag & 1 ) );
+        if( index>=end )
+            throw Corrupt();
+
+        lastToken = index;
+        return index;
+    }
+
+    // Read a variant index, which must be below numAlternatives
+    size_t getIndex(size_t numAlternatives) {
+        size_t index = get();
+        if( index>=numAlternatives )
+            throw Corrupt();
+
+        return index;
+    }
+
+    Tokenizer::TokenRef readToken() {
+        uint64_t value = get();
+        if( value==0 )
+            return Tokenizer::TokenRef();
+
+        return Tokenizer::TokenRef( tokens, tokenIndex( value, tokens.size() ) );
+    }
+
+    // Tokens that must be there
+    Tokenizer::TokenRef readRequiredToken() {
+        Tokenizer::TokenRef token = readToken();
+        if( !token )
+            throw Corrupt();
+
+        return token;
+    }
+
+    Tokenizer::TokenSlice readSlice() {
+        uint64_t size = get();
+        uint64_t value = get();
+        if( value==0 ) {
+            if( size!=0 )
+                throw Corrupt();
+
+            return Tokenizer::TokenSlice();
+        }
+
+        // An empty slice may start at the end of the tokens
+        size_t start = tokenIndex( value, tokens.size()+1 );
+        if( size > tokens.size()-start )
+            throw Corrupt();
+
+        return Tokenizer::TokenSlice( tokens ).subslice( start, start+size );
+    }
+
+    void readBase(NonTerminal &node) {
+        node.parsedSlice = readSlice();
+    }
+
+    template<typename T>
+    void readVector(ArenaVector<T> &vector) {
+        uint64_t size = get();
+        for( size_t i=0; i<size; ++i )
+            read( vector.emplace_back() );
+    }
+
+    template<typename T>
+    void readPointer(T *&node) {
+        if( get()==0 ) {
+            node = nullptr;
+            return;
+        }
+
+        T *newNode = ParseArena::make<T>();
+        read( *newNode );
+        node = newNode;
+    }
+
+    template<typename T>
+    void readPointer(const T *&node) {
+        T *newNode = nullptr;
+        readPointer( newNode );
+        node = newNode;
+    }
+
+    template<typename T>
+    void readPointer(NodeIndex<T> &node) {
+        node = NodeIndex<T>();
+        if( get()==0 )
+            return;
+
+        node = readNode<T>();
+    }
+
+    // Read a node into a new node of the active arena
+    template<typename T>
+    NodeIndex<T> readNode() {
+        NodeIndex<T> node = ParseArena::makeNode<T>();
+        read( *node );
+
+        return node;
+    }
+
+    void read(Identifier &identifier) {
+        readBase( identifier );
+        identifier.identifier = readRequiredToken();
+    }
+
+    void read(LiteralInt &literal) {
+        readBase( literal );
+        literal.token = readToken();
+        literal.value = get();
+    }
+
+    void read(LiteralBool &literal) {
+        readBase( literal );
+        literal.token = readRequiredToken();
+        literal.value = get();
+    }
+
+    void read(LiteralPointer &literal) {
+        readBase( literal );
+        literal.token = readRequiredToken();
+    }
+
+    void read(LiteralString &literal) {
+        readBase( literal );
+        literal.token = readToken();
+
+        Slice<const uint8_t> value = bytes.getBytes( get() );
+        for( uint8_t byte : value )
+            literal.value.emplace_back( static_cast<char>( byte ) );
+    }
+
+    void read(Literal &literal) {
+        readBase( literal );
+        switch( getIndex( std::variant_size_v< decltype(literal.literal) > ) ) {
+        case 0:
+            read( literal.literal.emplace<LiteralInt>() );
+            break;
+        case 1:
+            read( literal.literal.emplace<LiteralBool>() );
+            break;
+        case 2:
+            read( literal.literal.emplace<LiteralPointer>() );
+            break;
+        case 3:
+            read( literal.literal.emplace<LiteralString>() );
+            break;
+        }
+    }
+
+    void read(Type &type) {
+        readBase( type );
+        switch( getIndex( std::variant_size_v< decltype(type.type) > ) ) {
+        case 0:
+            type.type.emplace<std::monostate>();
+            break;
+        case 1:
+            read( type.type.emplace<Identifier>() );
+            break;
+        case 2:
+            {
+                NodeIndex<Type> elementType;
+                readPointer( elementType );
+                Tokenizer::TokenRef token = readRequiredToken();
+                read( type.type.emplace<Type::Array>( elementType, token ).dimension );
+            }
+            break;
+        case 3:
+            {
+                NodeIndex<Type> pointed;
+                readPointer( pointed );
+                Tokenizer::TokenRef token = readRequiredToken();
+                type.type.emplace<Type::Pointer>( pointed, token );
+            }
+            break;
+        }
+    }
+
+    void read(TransientType &type) {
+        readBase( type );
+        read( type.type );
+        type.ref = readToken();
+    }
+
+    void read(Expression &expression) {
+        NestingLimit::Level nesting;
+        if( nesting.tooDeep() )
+            throw Corrupt();
+
+        readBase( expression );
+        switch( getIndex( std::variant_size_v< decltype(expression.value) > ) ) {
+        case 0:
+            readPointer( expression.value.emplace< NodeIndex<CompoundExpression> >() );
+            break;
+        case 1:
+            readPointer( expression.value.emplace< NodeIndex<Literal> >() );
+            break;
+        case 2:
+            expression.value = readNode<Identifier>();
+            break;
+        case 3:
+            {
+                Expression::UnaryOperator &op = expression.value.emplace<Expression::UnaryOperator>();
+                op.op = readRequiredToken();
+                readPointer( op.operand );
+            }
+            break;
+        case 4:
+            {
+                Expression::BinaryOperator &op = expression.value.emplace<Expression::BinaryOperator>();
+                op.op = readRequiredToken();
+                readPointer( op.operands[0] );
+                readPointer( op.operands[1] );
+            }
+            break;
+        case 5:
+            {
+                Expression::CastOperator &op = expression.value.emplace<Expression::CastOperator>();
+                op.op = readRequiredToken();
+                readPointer( op.destType );
+                readPointer( op.expression );
+            }
+            break;
+        case 6:
+            {
+                Expression::FunctionCall &call = expression.value.emplace<Expression::FunctionCall>();
+                call.op = readRequiredToken();
+                readPointer( call.expression );
+                readPointer( call.arguments );
+            }
+            break;
+        case 7:
+            readPointer( expression.value.emplace< NodeIndex<ConditionalExpression> >() );
+            break;
+        case 8:
+            readPointer( expression.value.emplace< NodeIndex<Type> >() );
+            break;
+        }
+    }
+
+    void read(FunctionArguments &arguments) {
+        readBase( arguments );
+        readVector( arguments.arguments );
+    }
+
+    void read(ConditionalExpression &condition) {
+        read( condition.condition );
+        read( condition.ifClause );
+        read( condition.elseClause );
+    }
+
+    void read(Statement &statement) {
+        NestingLimit::Level nesting;
+        if( nesting.tooDeep() )
+            throw Corrupt();
+
+        readBase( statement );
+        switch( getIndex( std::variant_size_v< decltype(statement.content) > ) ) {
+        case 0:
+            statement.content.emplace<std::monostate>();
+            break;
+        case 1:
+            statement.content = readNode<Expression>();
+            break;
+        case 2:
+            readPointer( statement.content.emplace< NodeIndex<VariableDefinition> >() );
+            break;
+        case 3:
+            {
+                Statement::ConditionalStatement &condition =
+                        statement.content.emplace<Statement::ConditionalStatement>();
+                condition.condition = readNode<Expression>();
+                readPointer( condition.ifClause );
+                readPointer( condition.elseClause );
+            }
+            break;
+        case 4:
+            readPointer( statement.content.emplace< NodeIndex<CompoundStatement> >() );
+            break;
+        }
+    }
+
+    void read(StatementList &statementList) {
+        readBase( statementList );
+        readVector( statementList.statements );
+    }
+
+    void read(CompoundExpression &compound) {
+        readBase( compound );
+        read( compound.statementList );
+        read( compound.expression );
+    }
+
+    void read(CompoundStatement &compound) {
+        readBase( compound );
+        read( compound.statements );
+    }
+
+    void read(VariableDeclBody &body) {
+        readBase( body );
+        read( body.name );
+        read( body.type );
+    }
+
+    void read(VariableDefinition &definition) {
+        readBase( definition );
+        read( definition.body );
+        readPointer( definition.initValue );
+    }
+
+    void read(FuncDeclArg &argument) {
+        readBase( argument );
+        read( argument.name );
+        read( argument.type );
+    }
+
+    void read(FuncDeclBody &decl) {
+        readBase( decl );
+        read( decl.name );
+        readBase( decl.arguments );
+        readVector( decl.arguments.arguments );
+        readBase( decl.returnType );
+        read( decl.returnType.type );
+    }
+
+    void read(FuncDef &function) {
+        readBase( function );
+        read( function.decl );
+        switch( getIndex( std::variant_size_v< FuncDef::Body > ) ) {
+        case 0:
+            function.body.emplace<std::monostate>();
+            break;
+        case 1:
+            read( function.body.emplace<CompoundExpression>() );
+            break;
+        case 2:
+            read( function.body.emplace<CompoundStatement>() );
+            break;
+        }
+        function.bodyTokens = readSlice();
+    }
+
+    void read(FuncDecl &function) {
+        readBase( function );
+        read( function.decl );
+        read( function.abiSpecifier );
+    }
+
+    void read(StructDef &strct) {
+        readBase( strct );
+        strct.keyword = readRequiredToken();
+        read( strct.identifier );
+        readVector( strct.variables );
+    }
+};
+
+bool ParseTreeCache::load(
+        Module &module, String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments)
+{
+    Header expected;
+    fillHeader( expected, source, arguments );
+
+    std::string path = pathOf( arguments.parseTreeCache, expected );
+    struct stat stat;
+    if( ::stat( path.c_str(), &stat )!=0 || static_cast<size_t>(stat.st_size)<sizeof(Header) )
+        return false;
+
+    try {
+        Mmap<MapMode::ReadOnly> entry( path );
+        Slice<const char> data = entry.getSlice<const char>();
+
+        Header header;
+        memcpy( &header, data.get(), sizeof(header) );
+        // Everything but the sizes of what follows the header must match exactly
+        expected.numTokens = header.numTokens;
+        expected.tokensSize = header.tokensSize;
+        expected.treeSize = header.treeSize;
+        if(
+                memcmp( &header, &expected, sizeof(header) )!=0 ||
+                header.tokensSize>data.size() || header.treeSize>data.size() || entrySize(header)!=data.size() ||
+                header.numTokens>header.tokensSize )
+        {
+            return false;
+        }
+
+        const uint8_t *tokensStart = reinterpret_cast<const uint8_t *>( data.get()+sizeof(Header) );
+        VarintReader packedTokens( Slice<const uint8_t>( tokensStart, header.tokensSize ) );
+        std::vector<Tokenizer::Tokens> kinds;
+        std::vector<uint32_t> offsets, lengths;
+        kinds.reserve( header.numTokens );
+        offsets.reserve( header.numTokens );
+        lengths.reserve( header.numTokens );
+        size_t end = 0;
+        for( size_t i=0; i<header.numTokens; ++i ) {
+            // Each token is its distance from the end of the previous one, its length and its kind
+            uint64_t gap = packedTokens.get();
+            uint64_t length = packedTokens.get();
+            uint64_t kind = packedTokens.get();
+            if( gap>source.size()-end || length>source.size()-end-gap || kind>=Operators::NumTokens )
+                throw Corrupt();
+
+            kinds.push_back( static_cast<Tokenizer::Tokens>( kind ) );
+            offsets.push_back( end+gap );
+            lengths.push_back( length );
+
+            end += gap+length;
+        }
+        if( !packedTokens.atEnd() )
+            throw Corrupt();
+
+        module.tokens = Tokenizer::TokenStream::restore(
+                source, std::move(kinds), std::move(offsets), std::move(lengths) );
+
+        ParseArena::Scope arenaScope( module.arena );
+        NestingLimit nestingLimit( arguments.maxNestingDepth );
+        Reader reader( Slice<const uint8_t>( tokensStart+header.tokensSize, header.treeSize ), module.tokens );
+        reader.read( module );
+    } catch( Corrupt & ) {
+        // Whatever was read so far stays in the arena, unreachable
+        module.tokens = Tokenizer::TokenStream();
+        module.functionDefinitions = ArenaVector<FuncDef>();
+        module.functionDeclarations = ArenaVector<FuncDecl>();
+        module.structureDefinitions = ArenaVector<StructDef>();
+
+        return false;
+    } catch( std::runtime_error & ) {
+        return false;
+    }
+
+    module.lazyFunctionBodies = arguments.lazyFunctionBodies;
+    return true;
+}
+
+void ParseTreeCache::store(
+        const Module &module, String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments)
+{
+    std::vector<uint8_t> packedTokens;
+    size_t end = 0;
+    for( size_t i=0; i<module.tokens.size(); ++i ) {
+        // Tokens must be in order, as the entry keeps only the gaps between them
+        size_t offset = module.tokens.offset(i);
+        if( offset<end || offset+module.tokens.length(i)>source.size() )
+            return;
+
+        putVarint( packedTokens, offset-end );
+        putVarint( packedTokens, module.tokens.length(i) );
+        putVarint( packedTokens, static_cast<uint64_t>( module.tokens.kind(i) ) );
+
+        end = offset + module.tokens.length(i);
+    }
+
+    Writer writer( module.tokens );
+    try {
+        NestingLimit nestingLimit( arguments.maxNestingDepth );
+        // Nodes are resolved through the arena they were parsed into
+        ParseArena::Scope arenaScope( module.arena );
+        writer.write( module );
+    } catch( TooDeep & ) {
+        return;
+    }
+
+    Header header;
+    fillHeader( header, source, arguments );
+    header.numTokens = module.tokens.size();
+    header.tokensSize = packedTokens.size();
+    header.treeSize = writer.getBytes().size();
+
+    std::vector<char> entry;
+    entry.reserve( entrySize(header) );
+    entry.insert( entry.end(), reinterpret_cast<const char *>( &header ), reinterpret_cast<const char *>( &header+1 ) );
+    entry.insert( entry.end(), packedTokens.begin(), packedTokens.end() );
+    entry.insert( entry.end(), writer.getBytes().begin(), writer.getBytes().end() );
+
+    // Write to a temporary file and rename it into place, so that a concurrent load never sees half an entry
+    mkdir( arguments.parseTreeCache.c_str(), 0777 );
+    std::string path = pathOf( arguments.parseTreeCache, header );
+    // Unique per store, as other threads and processes may be storing the same entry
+    std::string temporaryPath = path + ".XXXXXX";
+    try {
+        FD fd( mkstemp( temporaryPath.data() ) );
+        // mkstemp creates the file readable only by its owner. The cache may be shared.
+        fchmod( fd.get(), 0644 );
+        size_t written = 0;
+        while( written<entry.size() ) {
+            ssize_t result = ::write( fd.get(), entry.data()+written, entry.size()-written );
+            if( result<=0 ) {
+                unlink( temporaryPath.c_str() );
+                return;
+            }
+
+            written += result;
+        }
+    } catch( std::runtime_error & ) {
+        return;
+    }
+
+    if( rename( temporaryPath.c_str(), path.c_str() )!=0 )
+        unlink( temporaryPath.c_str() );
+}
+
+std::string ParseTreeCache::entryPath(String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments) {
+    Header header;
+    fillHeader( header, source, arguments );
+
+    return pathOf( arguments.parseTreeCache, header );
+}
+
+uint64_t ParseTreeCache::hashSource(String source) {
+    // FNV-1a, eight bytes at a time. It picks the entry, and checkSource confirms it.
+    static constexpr uint64_t Prime = 0x100000001b3;
+    uint64_t hash = 0xcbf29ce484222325 ^ source.size();
+
+    size_t i = 0;
+    for( ; i+sizeof(uint64_t)<=source.size(); i+=sizeof(uint64_t) ) {
+        uint64_t word;
+        memcpy( &word, source.get()+i, sizeof(word) );
+        hash = ( hash ^ word ) * Prime;
+        hash ^= hash>>32;
+    }
+    for( ; i<source.size(); ++i )
+        hash = ( hash ^ static_cast<unsigned char>( source[i] ) ) * Prime;
+
+    return hash;
+}
+
+} // namespace NonTerminals
@@ -0,0 +1,51 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef PARSE_TREE_CACHE_H
+#define PARSE_TREE_CACHE_H
+
+#include <practical/practical.h>
+#include <practical/slice.h>
+
+#include <cstdint>
+#include <string>
+
+namespace NonTerminals {
+
+struct Module;
+
+// Keeps parsed modules in a directory, so that a source that did not change is not tokenized and parsed again.
+//
+// An entry is a single file, named after a hash of the source and the arguments that change what is parsed. It holds
+// the tokens as offsets into the source, and the parse tree flattened into variable length integers, where nodes refer
+// to tokens by index. Loading an entry maps the file and rebuilds the tree into the module's arena in one pass. The
+// source itself is not kept: the entry records its size and a second, independent, hash of it, and is only used if
+// both match. Entries written by another version of the library are ignored.
+class ParseTreeCache {
+public:
+    // Fill module, which must be empty, from the entry for source. Returns false if there is no usable entry
+    static bool load(
+            Module &module, String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments);
+    // Write an entry for module, which was parsed from source. A cache that can't be written is not an error: the next
+    // load just misses.
+    static void store(
+            const Module &module, String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments);
+
+    // The file that holds the entry for source, parsed with arguments
+    static std::string entryPath(String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments);
+
+    static uint64_t hashSource(String source);
+
+private:
+    class Writer;
+    class Reader;
+};
+
+} // namespace NonTerminals
+
+#endif // PARSE_TREE_CACHE_H
@@ -0,0 +1,171 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parse_tree_cache.h"
+#include "parser/module.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <stdlib.h>
+
+class ParseTreeCacheTest : public CppUnit::TestFixture  {
+    static const std::string source;
+    std::string directory;
+
+    PracticalSemanticAnalyzer::CompilerArguments arguments() const {
+        PracticalSemanticAnalyzer::CompilerArguments arguments;
+        arguments.parseTreeCache = directory;
+
+        return arguments;
+    }
+
+    std::string entryPath(const std::string &source) const {
+        return NonTerminals::ParseTreeCache::entryPath( String(source), arguments() );
+    }
+
+    static std::string readFile(const std::string &path) {
+        std::ifstream file( path, std::ios::binary );
+        return std::string( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+    }
+
+    // A module that was loaded from the cache did not make any parser predictions
+    static bool loaded(const NonTerminals::Module &module) {
+        return module.lookaheadStatistics.predictions==0;
+    }
+
+public:
+    void setUp() override {
+        char name[] = "/tmp/parse_tree_cache_ut.XXXXXX";
+        CPPUNIT_ASSERT( mkdtemp( name )!=nullptr );
+        directory = name;
+    }
+
+    void tearDown() override {
+        std::string command = "rm -rf " + directory;
+        CPPUNIT_ASSERT( system( command.c_str() )==0 );
+    }
+
+    void roundTrip() {
+        NonTerminals::Module parsed;
+        parsed.parse( String(source), arguments() );
+        CPPUNIT_ASSERT( !loaded(parsed) );
+
+        NonTerminals::Module cached;
+        cached.parse( String(source), arguments() );
+        CPPUNIT_ASSERT( loaded(cached) );
+        CPPUNIT_ASSERT( cached.tokens.size()==parsed.tokens.size() );
+        CPPUNIT_ASSERT( cached.functionDefinitions.size()==2 );
+        CPPUNIT_ASSERT( cached.structureDefinitions.size()==1 );
+        CPPUNIT_ASSERT( cached.functionDefinitions[1].getName()==toSlice("main") );
+
+        // Storing the loaded tree gives back the very same entry
+        std::string firstEntry = readFile( entryPath(source) );
+        CPPUNIT_ASSERT( !firstEntry.empty() );
+        // The entry refers to the source, rather than keeping a copy of it
+        CPPUNIT_ASSERT( firstEntry.find( "square" )==std::string::npos );
+        CPPUNIT_ASSERT( system( ("rm " + entryPath(source)).c_str() )==0 );
+        NonTerminals::ParseTreeCache::store( cached, String(source), arguments() );
+        CPPUNIT_ASSERT( readFile( entryPath(source) )==firstEntry );
+    }
+
+    void changedSource() {
+        NonTerminals::Module parsed;
+        parsed.parse( String(source), arguments() );
+
+        std::string changed = source;
+        changed[ changed.find("42") ] = '7';
+        NonTerminals::Module changedModule;
+        changedModule.parse( String(changed), arguments() );
+        CPPUNIT_ASSERT( !loaded(changedModule) );
+
+        // Arguments that change the tree make the entry unusable
+        PracticalSemanticAnalyzer::CompilerArguments lazyArguments = arguments();
+        lazyArguments.lazyFunctionBodies = true;
+        NonTerminals::Module lazy;
+        lazy.parse( String(source), lazyArguments );
+        CPPUNIT_ASSERT( !loaded(lazy) );
+
+        // Each kind of parse keeps its own entry
+        CPPUNIT_ASSERT( !readFile( NonTerminals::ParseTreeCache::entryPath( String(source), lazyArguments ) ).empty() );
+        NonTerminals::Module eager;
+        eager.parse( String(source), arguments() );
+        CPPUNIT_ASSERT( loaded(eager) );
+    }
+
+    void corruptEntry() {
+        NonTerminals::Module parsed;
+        parsed.parse( String(source), arguments() );
+
+        std::string entry = readFile( entryPath(source) );
+        for( size_t size : { entry.size()-4, entry.size()/2, size_t(3) } ) {
+            std::ofstream( entryPath(source), std::ios::binary | std::ios::trunc ).write( entry.c_str(), size );
+
+            NonTerminals::Module module;
+            module.parse( String(source), arguments() );
+            CPPUNIT_ASSERT( !loaded(module) );
+            CPPUNIT_ASSERT( module.functionDefinitions.size()==2 );
+        }
+
+        // Garbage in the tree itself
+        std::string garbled = entry;
+        for( size_t i=garbled.size()-64; i<garbled.size(); ++i )
+            garbled[i] = 0xff;
+        std::ofstream( entryPath(source), std::ios::binary | std::ios::trunc ).write( garbled.c_str(), garbled.size() );
+
+        NonTerminals::Module module;
+        module.parse( String(source), arguments() );
+        CPPUNIT_ASSERT( !loaded(module) );
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==2 );
+    }
+
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParseTreeCacheTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseTreeCacheTest>(
+                    "roundTrip",
+                    &ParseTreeCacheTest::roundTrip ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseTreeCacheTest>(
+                    "changedSource",
+                    &ParseTreeCacheTest::changedSource ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParseTreeCacheTest>(
+                    "corruptEntry",
+                    &ParseTreeCacheTest::corruptEntry ) );
+        return suiteOfTests;
+    }
+};
+
+const std::string ParseTreeCacheTest::source =
+        "struct Point {\n"
+        "    def x : S32;\n"
+        "    def y : S32 = -1;\n"
+        "}\n"
+        "\n"
+        "decl (\"C\") puts( s : C8@ ) -> S32;\n"
+        "\n"
+        "def square( v : S32 ) -> S32 {\n"
+        "    v * v\n"
+        "}\n"
+        "\n"
+        "def main() -> S32 {\n"
+        "    def a : S32[4];\n"
+        "    def b : S32 = { 1 };\n"
+        "    def p : S32@ = b&;\n"
+        "    puts( \"hello\\n\" );\n"
+        "    if( p@ == 0 ) {\n"
+        "        square( expect!S32( 42 ) );\n"
+        "    } else\n"
+        "        square( b );\n"
+        "    def c : S32 = if( b == 1 ) { 1 } else { 2 };\n"
+        "    0\n"
+        "}\n";
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParseTreeCacheTest );
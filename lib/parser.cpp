@@ -9,42 +9,70 @@
 #include "parser.h"
 
 #include "parser_internal.h"
+#include "parser_memo.h"
 #include "scope_tracing.h"
 
 #include <practical/errors.h>
 
+#include <vector>
+
 using namespace InternalNonTerminals;
 
 namespace NonTerminals {
 
-size_t TransientType::parse(Slice<const Tokenizer::Token> source) {
+void ParseError::raise() const {
+    switch( kind ) {
+    case Kind::Syntax:
+        break;
+    case Kind::IllegalLiteral:
+        throw IllegalLiteral( msg, location );
+    case Kind::InvalidEscapeSequence:
+        throw InvalidEscapeSequence( location );
+    case Kind::NestingTooDeep:
+        throw NestingTooDeep( location );
+    }
+
+    throw parser_error( msg, location );
+}
+
+NestingLimit::NestingLimit(size_t limit) : previous(NestingLimit::limit) {
+    NestingLimit::limit = limit;
+}
+
+NestingLimit::~NestingLimit() {
+    limit = previous;
+}
+
+ParseResult TransientType::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    tokensConsumed = type.parse(source);
+    RULE_PARSE( tokensConsumed, type.parse(source) );
 
     ref = wishForToken( Tokenizer::Tokens::RESERVED_REF, source, tokensConsumed, true );
 
     RULE_LEAVE();
 }
 
-size_t LiteralPointer::parse(Slice<const Tokenizer::Token> source) {
+ParseResult LiteralPointer::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    token = &expectToken(
-            Tokenizer::Tokens::RESERVED_NULL, source, tokensConsumed,
-            "Expected null literal", "EOF while parsing literal");
+    token = wishForToken( Tokenizer::Tokens::RESERVED_NULL, source, tokensConsumed );
+    if( !token )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "Expected null literal", "EOF while parsing literal" ) );
 
     RULE_LEAVE();
 }
 
-size_t Literal::parse(Slice<const Tokenizer::Token> source) {
+ParseResult Literal::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    const Tokenizer::Token *currentToken = nextToken(source, tokensConsumed, "EOF while parsing literal");
+    Tokenizer::TokenRef currentToken = nextToken(source, tokensConsumed);
+    if( !currentToken )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "EOF while parsing literal" ) );
 
     NonTerminal *underlyingLiteral = nullptr;
 
-    switch( currentToken->token ) {
+    switch( currentToken.kind() ) {
     case Tokenizer::Tokens::LITERAL_INT_2:
     case Tokenizer::Tokens::LITERAL_INT_8:
     case Tokenizer::Tokens::LITERAL_INT_10:
@@ -65,12 +93,12 @@ size_t Literal::parse(Slice<const Tokenizer::Token> source) {
         underlyingLiteral = &literal.emplace<LiteralPointer>();
         break;
     default:
-        throw parser_error("Not a literal", currentToken->location);
+        RULE_FAIL( ParseError{ .msg = "Not a literal", .location = currentToken.location() } );
     }
 
     ASSERT( tokensConsumed>0 );
     tokensConsumed--;
-    tokensConsumed += underlyingLiteral->parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, underlyingLiteral->parse( source.subslice(tokensConsumed) ) );
 
     RULE_LEAVE();
 }
@@ -78,19 +106,19 @@ size_t Literal::parse(Slice<const Tokenizer::Token> source) {
 SourceLocation Literal::getLocation() const {
     struct Visitor {
         SourceLocation operator()( const LiteralInt &literal ) {
-            return literal.token->location;
+            return literal.token.location();
         }
 
         SourceLocation operator()( const LiteralBool &literal ) {
-            return literal.token->location;
+            return literal.token.location();
         }
 
         SourceLocation operator()( const LiteralPointer &literal ) {
-            return literal.token->location;
+            return literal.token.location();
         }
 
         SourceLocation operator()( const LiteralString &literal ) {
-            return literal.token->location;
+            return literal.token.location();
         }
 
     };
@@ -98,7 +126,7 @@ SourceLocation Literal::getLocation() const {
     return std::visit( Visitor{}, literal );
 }
 
-size_t FunctionArguments::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FunctionArguments::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     bool firstArgument = true;
@@ -106,26 +134,35 @@ size_t FunctionArguments::parse(Slice<const Tokenizer::Token> source) {
         if( firstArgument ) {
             firstArgument = false;
         } else {
-            expectToken(
+            RULE_EXPECT_TOKEN(
                     Tokenizer::Tokens::COMMA, source, tokensConsumed, "Function argument list needs to be delimited by commas",
                     "EOF while scanning arguments list" );
         }
 
         Expression *argument = &arguments.emplace_back();
-        tokensConsumed += argument->parse( source.subslice(tokensConsumed) );
+        RULE_PARSE( tokensConsumed, argument->parse( source.subslice(tokensConsumed) ) );
     }
 
     RULE_LEAVE();
 }
 
-size_t Expression::parse(Slice<const Tokenizer::Token> source) {
+ParseResult Expression::parse(Tokenizer::TokenSlice source) {
+    return ParseMemo::memoize( ParseMemo::Rule::Expression, *this, source, [&]() { return parseUncached(source); } );
+}
+
+ParseResult Expression::parseUncached(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
+    NestingLimit::Level nesting;
+    if( nesting.tooDeep() )
+        RULE_FAIL( nestingTooDeep( source ) );
+
     if( wishForToken(Tokenizer::Tokens::RESERVED_IF, source, tokensConsumed) ) {
         ConditionalExpressionOrStatement condition;
-        tokensConsumed = condition.parse( source, ExpectedResult::Expression );
+        tokensConsumed = 0;
+        RULE_PARSE( tokensConsumed, condition.parse( source, ExpectedResult::Expression ) );
 
-        value = safenew<ConditionalExpression>( condition.removeExpression() );
+        value = ParseArena::makeNode<ConditionalExpression>( condition.removeExpression() );
 
         RULE_LEAVE();
     }
@@ -133,331 +170,433 @@ size_t Expression::parse(Slice<const Tokenizer::Token> source) {
     tokensConsumed=0;
     if( wishForToken(Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed) ) {
         CompoundExpression compound;
-        tokensConsumed=compound.parse(source);
+        tokensConsumed=0;
+        RULE_PARSE( tokensConsumed, compound.parse(source) );
 
-        value = safenew<CompoundExpression>( std::move(compound) );
+        value = ParseArena::makeNode<CompoundExpression>( std::move(compound) );
 
         RULE_LEAVE();
     }
 
-    std::exception_ptr expressionParseError;
-    try {
-        tokensConsumed = actualParse(source, Operators::operators.size());
+    ParseResult expressionResult = parseOperators(source, Operators::operatorsTable.maxPrecedence);
+    if( expressionResult ) {
+        tokensConsumed = expressionResult.tokensConsumed();
         RULE_LEAVE();
-    } catch( parser_error &error ) {
-        EXCEPTION_CAUGHT(error);
-        expressionParseError = std::current_exception();
     }
 
-    try {
-        Type *type = &value.emplace<Type>();
-        tokensConsumed = type->parse(source);
-    } catch( parser_error &error ) {
-        EXCEPTION_CAUGHT(error);
+    RULE_PARSE( tokensConsumed, parseAsTypeInstead( source, expressionResult ) );
+    RULE_LEAVE();
+}
+
+ParseResult Expression::parseAsTypeInstead(Tokenizer::TokenSlice source, ParseResult expressionResult) {
+    RULE_ENTER(source);
+
+    if( !Lookahead::canStart( Lookahead::Rule::Type, source, 0 ) ) {
+        Lookahead::predicted();
+        RULE_FAIL( expressionResult.getError() );
+    }
+    RULE_BACKTRACK( expressionResult );
+
+    NodeIndex<Type> type = ParseArena::makeNode<Type>();
+    value = type;
+    ParseResult typeResult = type->parse(source);
+    if( !typeResult ) {
+        RULE_BACKTRACK( typeResult );
         // We only tried to parse as type as a hail Mary. If it failed, we want the original error
-        std::rethrow_exception(expressionParseError);
+        RULE_FAIL( expressionResult.getError() );
     }
 
+    tokensConsumed = typeResult.tokensConsumed();
     RULE_LEAVE();
 }
 
 const Type *Expression::reparseAsType() const {
-    const Type *ret = std::get_if<NonTerminals::Type>( &value );
+    const NodeIndex<Type> *type = std::get_if< NodeIndex<NonTerminals::Type> >( &value );
 
-    if( ret!=nullptr ) {
-        return ret;
+    if( type!=nullptr ) {
+        return type->get();
     }
 
     if( !altTypeParse ) {
-        altTypeParse = safenew<NonTerminals::Type>();
+        NodeIndex<Type> type = ParseArena::makeNode<NonTerminals::Type>();
+        altTypeParse = type;
 
-        size_t tokensConsumed = altTypeParse->parse( getNTTokens() );
+        ParseResult result = type->parse( getNTTokens() );
+        if( !result )
+            result.getError().raise();
+
+        size_t tokensConsumed = result.tokensConsumed();
         if( tokensConsumed != getNTTokens().size() ) {
             ASSERT( tokensConsumed < getNTTokens().size() ) <<
                     "Undetected range error during parse: " << tokensConsumed << "<" << getNTTokens().size();
-            const Tokenizer::Token *currentToken = &getNTTokens()[ tokensConsumed ];
-            throw parser_error("Type parsing did not consume entire range", currentToken->location);
+            Tokenizer::TokenRef currentToken = getNTTokens()[ tokensConsumed ];
+            throw parser_error("Type parsing did not consume entire range", currentToken.location());
         }
     }
 
     return altTypeParse.get();
 }
 
-size_t Expression::actualParse(Slice<const Tokenizer::Token> source, size_t level) {
-    using namespace Operators;
+namespace {
 
-    RULE_ENTER(source);
+// A parseOperators call that waits for a sub-expression, which it would otherwise have parsed by calling itself
+struct OperatorsFrame {
+    enum class Waiting : uint8_t {
+        PrefixOperand,          // The operand of a prefix operator
+        Parenthesized,          // What's inside a parenthesis. Parsed into the frame's own expression
+        RightOperand,           // The right operand of binaryOp
+    };
 
-    if( level==0 ) {
-        tokensConsumed += basicParse(source);
+    Tokenizer::TokenSlice source;
+    Expression *expression;
+    size_t tokensConsumed = 0;
+    unsigned maxPrecedence, precedence = 0;
+    // Set when the frame is suspended for a nested call
+    Waiting waiting = Waiting::PrefixOperand;
+    Expression::BinaryOperator binaryOp{};
 
-        RULE_LEAVE();
-    }
+    OperatorsFrame( Tokenizer::TokenSlice source, Expression *expression, unsigned maxPrecedence ) :
+        source(source), expression(expression), maxPrecedence(maxPrecedence)
+    {}
+};
 
-    // Operators
-    const OperatorPriority &priority = operators.at( level-1 );
+// The frames of all parseOperators calls in progress on this thread. A call only touches the frames it pushed.
+thread_local std::vector<OperatorsFrame> operatorsFrames;
 
-    switch( priority.kind ) {
-    case OperatorPriority::OpKind::Prefix:
-        tokensConsumed += parsePrefixOp( source, level, priority.operators );
-        break;
-    case OperatorPriority::OpKind::Infix:
-        tokensConsumed += parseInfixOp( source, level, priority.operators );
-        break;
-    case OperatorPriority::OpKind::InfixRight2Left:
-        tokensConsumed += parseInfixR2LOp( source, level, priority.operators );
-        break;
-    case OperatorPriority::OpKind::Postfix:
-        tokensConsumed += parsePostfixOp( source, level, priority.operators );
-        break;
-    }
+} // Anonymous namespace
 
-    RULE_LEAVE();
-}
-
-size_t Expression::basicParse(Slice<const Tokenizer::Token> source) {
-    RULE_ENTER(source);
-
-    // Parenthesis around expression?
-    if( wishForToken( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed ) ) {
-        tokensConsumed += parse( source.subslice(tokensConsumed) );
-        expectToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Unmatched (", "EOF searching for )" );
-
-        RULE_LEAVE();
-    }
+ParseResult Expression::parseOperators(Tokenizer::TokenSlice source, unsigned maxPrecedence) {
+    using namespace Operators;
 
-    try {
-        // Maybe an identifier
-        tokensConsumed += value.emplace<Identifier>().parse(source);
+    // Nesting of parenthesis and operators would have this function recurse as deep as the expression is. Instead, the
+    // calls it would have made are kept in operatorsFrames, and "current" is the one being parsed.
+    const size_t baseFrame = operatorsFrames.size();
+    OperatorsFrame current( source, this, maxPrecedence );
 
-        RULE_LEAVE();
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
-    }
-
-    // Or maybe a Literal
-    tokensConsumed = value.emplace<Literal>().parse(source);
+    auto call = [&current]( OperatorsFrame::Waiting waiting, Tokenizer::TokenSlice source, Expression *expression,
+            unsigned maxPrecedence )
+    {
+        current.waiting = waiting;
+        operatorsFrames.emplace_back( std::move(current) );
 
-    RULE_LEAVE();
-}
+        current = OperatorsFrame( source, expression, maxPrecedence );
+    };
 
-size_t Expression::parsePrefixOp(
-        Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators)
-{
-    RULE_ENTER(source);
+    // The closing parenthesis after the contents of the one current starts with
+    auto closeParenthesis = [&current]( ParseResult contents ) -> ParseResult {
+        size_t tokensConsumed = contents.tokensConsumed() + 1;
+        if( !wishForToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, current.source, tokensConsumed ) )
+            return unexpectedToken( current.source, tokensConsumed, "Unmatched (", "EOF searching for )" );
 
-    const Tokenizer::Token *op =nextToken( source, tokensConsumed, "End of file while looking for operator" );
+        return tokensConsumed;
+    };
 
-    auto operatorInfo = operators.find( op->token );
+    enum class Step { Operand, Operators, Return } step = Step::Operand;
+    // What the call that just returned returned
+    ParseResult result = 0;
 
-    if( operatorInfo!=operators.end() ) {
-        switch( operatorInfo->second ) {
-        case Operators::OperatorType::Regular:
+    while( true ) {
+        switch( step ) {
+        case Step::Operand:
             {
-                UnaryOperator &op1 = value.emplace< UnaryOperator >();
-                op1.op = op;
-                // The operator we found is a valid prefix operator for this level
-                op1.operand = safenew< Expression >();
-                tokensConsumed += op1.operand->parsePrefixOp( source.subslice(tokensConsumed), level, operators );
+                // What comes before the first postfix or binary operator: either a prefix operator and its operand, or a
+                // basic expression
+                Tokenizer::TokenSlice &source = current.source;
+                Expression *expression = current.expression;
+
+                if( operatorsTable.minPrefixPrecedence<=current.maxPrecedence ) {
+                    if( source.size()==0 ) {
+                        result = unexpectedToken( source, 0, "End of file while looking for operator" );
+                        step = Step::Return;
+                        break;
+                    }
+
+                    Tokenizer::TokenRef op = source[0];
+                    const OperatorInfo &info = lookup( op.kind() );
+                    if( info.prefixPrecedence!=0 && info.prefixPrecedence<=current.maxPrecedence ) {
+                        current.precedence = info.prefixPrecedence;
+
+                        switch( info.prefixType ) {
+                        case OperatorType::Regular:
+                            {
+                                UnaryOperator &unary = expression->value.emplace< UnaryOperator >();
+                                unary.op = op;
+                                unary.operand = ParseArena::makeNode< Expression >();
+                                call( OperatorsFrame::Waiting::PrefixOperand, source.subslice(1), unary.operand.get(),
+                                        info.prefixPrecedence );
+                            }
+                            break;
+                        case OperatorType::Cast:
+                            result = expression->parseCast( source );
+                            if( result ) {
+                                current.tokensConsumed = result.tokensConsumed();
+                                step = Step::Operators;
+                            } else {
+                                step = Step::Return;
+                            }
+                            break;
+                        case OperatorType::Function:
+                        case OperatorType::SliceSubscript:
+                            ABORT() << "Not a prefix operator type";
+                        }
+
+                        break;
+                    }
+                }
+
+                if( wishForToken( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, current.tokensConsumed, false ) ) {
+                    size_t contentsStart = 1;
+                    if(
+                            wishForToken( Tokenizer::Tokens::RESERVED_IF, source, contentsStart, false ) ||
+                            wishForToken( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, contentsStart, false )
+                      )
+                    {
+                        // Conditional and compound expressions are not made of operators. Parse them the usual way.
+                        result = expression->parse( source.subslice(1) );
+                        if( result )
+                            result = closeParenthesis( result );
+
+                        if( result ) {
+                            current.tokensConsumed = result.tokensConsumed();
+                            expression->parsedSlice = source.subslice( 0, current.tokensConsumed );
+                            step = Step::Operators;
+                        } else {
+                            step = Step::Return;
+                        }
+                    } else {
+                        call( OperatorsFrame::Waiting::Parenthesized, source.subslice(1), expression,
+                                operatorsTable.maxPrecedence );
+                    }
+
+                    break;
+                }
+
+                result = expression->parseAtom( source );
+                if( result ) {
+                    current.tokensConsumed = result.tokensConsumed();
+                    step = Step::Operators;
+                } else {
+                    step = Step::Return;
+                }
             }
-            RULE_LEAVE();
-        case Operators::OperatorType::Cast:
+            break;
+        case Step::Operators:
             {
-                CastOperator &cast = value.emplace< CastOperator >();
-                cast.op = op;
-                expectToken(
-                        Tokenizer::Tokens::OP_TEMPLATE_EXPAND,
-                        source,
-                        tokensConsumed,
-                        "Cast operator must be followed by `!`",
-                        "End of file looking for cast expression"
-                );
-                tokensConsumed += cast.destType.parse( source.subslice(tokensConsumed) );
-                expectToken(
-                        Tokenizer::Tokens::BRACKET_ROUND_OPEN,
-                        source,
-                        tokensConsumed,
-                        "Expected `(` after cast type",
-                        "End of file looking for cast expression"
-                );
-                cast.expression = safenew< Expression >();
-                tokensConsumed += cast.expression->parse( source.subslice( tokensConsumed ) );
-                expectToken(
-                        Tokenizer::Tokens::BRACKET_ROUND_CLOSE,
-                        source,
-                        tokensConsumed,
-                        "Expected ')'",
-                        "End of file looking for terminating ')'"
-                );
+                Tokenizer::TokenSlice &source = current.source;
+                size_t &tokensConsumed = current.tokensConsumed;
+                // Precedence of the operator at the root of what was parsed so far. Operators that bind tighter than it
+                // were already given their chance while parsing its operands, so only looser ones may extend it.
+                unsigned &precedence = current.precedence;
+                Expression *expression = current.expression;
+
+                step = Step::Return;
+                while( tokensConsumed<source.size() ) {
+                    Tokenizer::TokenRef op = source[tokensConsumed];
+                    const OperatorInfo &info = lookup( op.kind() );
+
+                    auto applies = [&]( unsigned operatorPrecedence ) {
+                        return
+                                operatorPrecedence!=0 &&
+                                operatorPrecedence>=precedence &&
+                                operatorPrecedence<=current.maxPrecedence;
+                    };
+
+                    bool postfix = applies( info.postfixPrecedence );
+                    bool binary = applies( info.binaryPrecedence );
+                    if( postfix && binary ) {
+                        // The tighter binding wins
+                        postfix = info.postfixPrecedence < info.binaryPrecedence;
+                        binary = !postfix;
+                    }
+
+                    if( postfix ) {
+                        Tokenizer::TokenSlice operandTokens = source.subslice(0, tokensConsumed);
+                        tokensConsumed++;
+
+                        switch( info.postfixType ) {
+                        case OperatorType::Regular:
+                            {
+                                UnaryOperator unary;
+                                unary.op = op;
+                                unary.operand = ParseArena::makeNode< Expression >( std::move( *expression ) );
+                                unary.operand->parsedSlice = operandTokens;
+                                expression->value = std::move( unary );
+                            }
+                            break;
+                        case OperatorType::Function:
+                            {
+                                FunctionCall funcCall;
+                                funcCall.op = op;
+                                funcCall.expression = ParseArena::makeNode< Expression >( std::move( *expression ) );
+                                funcCall.expression->parsedSlice = operandTokens;
+                                funcCall.arguments = ParseArena::makeNode< FunctionArguments >();
+                                result = funcCall.arguments->parse( source.subslice(tokensConsumed) );
+                                if( !result )
+                                    break;
+
+                                tokensConsumed += result.tokensConsumed();
+                                expression->value = std::move( funcCall );
+                            }
+                            break;
+                        case OperatorType::SliceSubscript:
+                            ABORT() << "TODO implement";
+                        case OperatorType::Cast:
+                            ABORT() << "Cast is not a postfix operator";
+                        }
+
+                        if( !result )
+                            break;
+
+                        precedence = info.postfixPrecedence;
+                    } else if( binary ) {
+                        BinaryOperator binaryOp;
+                        binaryOp.op = op;
+                        binaryOp.operands[0] = ParseArena::makeNode< Expression >( std::move( *expression ) );
+                        binaryOp.operands[0]->parsedSlice = source.subslice(0, tokensConsumed);
+                        tokensConsumed++;
+
+                        // A right to left operator's right operand may contain more operators of the same precedence
+                        unsigned operandPrecedence =
+                                info.rightToLeft ? info.binaryPrecedence : info.binaryPrecedence-1;
+                        binaryOp.operands[1] = ParseArena::makeNode< Expression >();
+
+                        Expression *rightOperand = binaryOp.operands[1].get();
+                        current.binaryOp = std::move( binaryOp );
+                        call( OperatorsFrame::Waiting::RightOperand, source.subslice(tokensConsumed), rightOperand,
+                                operandPrecedence );
+                        step = Step::Operand;
+
+                        break;
+                    } else {
+                        // This is not the operator you're looking for. Just make do with what we have without it
+                        break;
+                    }
+                }
+
+                if( step==Step::Return && result ) {
+                    expression->parsedSlice = source.subslice(0, tokensConsumed);
+                    result = tokensConsumed;
+                }
             }
-            RULE_LEAVE();
-        default:
-            ;
+            break;
+        case Step::Return:
+            if( operatorsFrames.size()==baseFrame )
+                return result;
+
+            current = std::move( operatorsFrames.back() );
+            operatorsFrames.pop_back();
+
+            switch( current.waiting ) {
+            case OperatorsFrame::Waiting::PrefixOperand:
+                if( result ) {
+                    current.tokensConsumed = result.tokensConsumed() + 1;
+                    current.expression->parsedSlice = current.source.subslice( 0, current.tokensConsumed );
+                    step = Step::Operators;
+                }
+                break;
+            case OperatorsFrame::Waiting::Parenthesized:
+                if( !result )
+                    result = current.expression->parseAsTypeInstead( current.source.subslice(1), result );
+
+                if( result )
+                    result = closeParenthesis( result );
+
+                if( result ) {
+                    current.tokensConsumed = result.tokensConsumed();
+                    current.precedence = 0;
+                    current.expression->parsedSlice = current.source.subslice( 0, current.tokensConsumed );
+                    step = Step::Operators;
+                }
+                break;
+            case OperatorsFrame::Waiting::RightOperand:
+                if( result ) {
+                    current.tokensConsumed += result.tokensConsumed();
+                    current.precedence = lookup( current.binaryOp.op.kind() ).binaryPrecedence;
+                    current.expression->value = std::move( current.binaryOp );
+                    step = Step::Operators;
+                }
+                break;
+            }
+            break;
         }
     }
-
-    // The use of = instead of += undoes the call to "nextToken" above, as does the use of "source" with no subslicing
-    tokensConsumed = actualParse( source, level-1 );
-
-    RULE_LEAVE();
 }
 
-size_t Expression::parseInfixOp(
-        Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators)
-{
+ParseResult Expression::parseCast(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    /*
-     * In regular grammer, this rule should say ExpressionN (where N is the level) -> ExpressionN OP ExpressionN-1
-     * The direct translation to code of the above is to start by calling op.operands[0]->actualParse( source, level )
-     * Doing this will result in an unterminated recursion (calling ourselves with the precise same arguments).
-     *
-     * Instead, We're parsing ExpressionN -> ExpressionN-1 OP ExpressionN-1, and if the next token after we're done is an operator
-     * of our level, we incorporate that entire previous expression as the right hand side of the higher expression.
-     *
-     * Rinse, repeat, and we've translated the recursive definition into a loop.
-     *
-     * One side effect is that the same operator cannot be used as binary operator in different levels. THAT IS A GOOD THING!
-     */
-
-    BinaryOperator op;
-    op.operands[0] = safenew<Expression>();
-    tokensConsumed = op.operands[0]->actualParse( source, level-1 );
-
-    size_t provisionalTokensConsumed = tokensConsumed;
-    op.op = nextToken( source, provisionalTokensConsumed );
-    if( op.op==nullptr ) {
-        *this = std::move(* op.operands[0]);
-        RULE_LEAVE();
-    }
-
-    auto opInfo = operators.find(op.op->token);
-    if( opInfo==operators.end() ) {
-        // This is not the operator you're looking for. Just make do with what we have without it
-        *this = std::move(* op.operands[0]);
-        RULE_LEAVE();
-    }
-
-    ASSERT( opInfo->second==Operators::OperatorType::Regular );
-    tokensConsumed = provisionalTokensConsumed;
-
-    op.operands[1] = safenew< Expression >();
-    tokensConsumed += op.operands[1]->actualParse( source.subslice(tokensConsumed), level-1 );
-
-    while( true ) {
-        BinaryOperator op2;
-
-        // If the next token is an operator of this level, we need to extend our parse tree to cover it as well
-        provisionalTokensConsumed = tokensConsumed;
-        op2.op = nextToken( source, provisionalTokensConsumed );
-        if( op2.op==nullptr || operators.find( op2.op->token ) == operators.end() ) {
-            break;
-        }
-
-        // Commit to extending
-        tokensConsumed = provisionalTokensConsumed;
-        op2.operands[0] = safenew< Expression >();
-        op2.operands[0]->value = std::move( op );
-        op = std::move( op2 );
-
-        op.operands[1] = safenew< Expression >();
-        tokensConsumed += op.operands[1]->actualParse( source.subslice( tokensConsumed ), level-1 );
-    }
-
-    value = std::move(op);
+    Tokenizer::TokenRef op = nextToken( source, tokensConsumed );
+    CastOperator &cast = value.emplace< CastOperator >();
+    cast.op = op;
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::OP_TEMPLATE_EXPAND,
+            source,
+            tokensConsumed,
+            "Cast operator must be followed by `!`",
+            "End of file looking for cast expression"
+    );
+    cast.destType = ParseArena::makeNode< Type >();
+    RULE_PARSE( tokensConsumed, cast.destType->parse( source.subslice(tokensConsumed) ) );
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::BRACKET_ROUND_OPEN,
+            source,
+            tokensConsumed,
+            "Expected `(` after cast type",
+            "End of file looking for cast expression"
+    );
+    cast.expression = ParseArena::makeNode< Expression >();
+    RULE_PARSE( tokensConsumed, cast.expression->parse( source.subslice( tokensConsumed ) ) );
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::BRACKET_ROUND_CLOSE,
+            source,
+            tokensConsumed,
+            "Expected ')'",
+            "End of file looking for terminating ')'"
+    );
 
     RULE_LEAVE();
 }
 
-size_t Expression::parseInfixR2LOp(
-        Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators)
-{
+ParseResult Expression::parseAtom(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    BinaryOperator op;
-    op.operands[0] = safenew< Expression >();
-    tokensConsumed += op.operands[0]->actualParse( source, level-1 );
+    // Maybe an identifier
+    if( wishForToken( Tokenizer::Tokens::IDENTIFIER, source, tokensConsumed, false ) ) {
+        NodeIndex<Identifier> identifier = ParseArena::makeNode<Identifier>();
+        value = identifier;
+        RULE_PARSE( tokensConsumed, identifier->parse(source) );
 
-    size_t provisionalTokensConsumed = tokensConsumed;
-    op.op = nextToken( source, provisionalTokensConsumed );
-    if( op.op==nullptr ) {
-        *this = std::move(* op.operands[0]);
         RULE_LEAVE();
     }
+    Lookahead::predicted();
 
-    auto opInfo = operators.find(op.op->token);
-    if( opInfo==operators.end() ) {
-        // This is not the operator you're looking for. Just make do with what we have without it
-        *this = std::move(* op.operands[0]);
-        RULE_LEAVE();
-    }
-    ASSERT( opInfo->second==Operators::OperatorType::Regular );
-
-    tokensConsumed = provisionalTokensConsumed;
-
-    op.operands[1] = safenew< Expression >();
-    tokensConsumed += op.operands[1]->actualParse( source.subslice(tokensConsumed), level );
-
-    value = std::move( op );
+    // Or maybe a Literal
+    NodeIndex<Literal> literal = ParseArena::makeNode<Literal>();
+    value = literal;
+    RULE_PARSE( tokensConsumed, literal->parse(source) );
 
     RULE_LEAVE();
 }
 
-size_t Expression::parsePostfixOp(
-        Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators)
-{
-    RULE_ENTER(source);
-
-    tokensConsumed = actualParse( source, level-1 );
-
-    UnaryOperator op;
-    size_t provisionalTokensConsumed = tokensConsumed;
-    op.op = nextToken( source, provisionalTokensConsumed );
-    if( op.op==nullptr ) {
-        RULE_LEAVE();
-    }
-
-    auto opInfo = operators.find( op.op->token );
-    while( opInfo!=operators.end() ) {
-        tokensConsumed = provisionalTokensConsumed;
-
-        switch( opInfo->second ) {
-        case Operators::OperatorType::Regular:
-            op.operand = safenew< Expression >( std::move( *this ) );
-            value = std::move( op );
-            ASSERT( ! op.operand );
-            break;
-        case Operators::OperatorType::Function:
-            {
-                FunctionCall funcCall;
-                funcCall.op = op.op;
-                funcCall.expression = safenew< Expression >( std::move( *this ) );
-                tokensConsumed += funcCall.arguments.parse( source.subslice(tokensConsumed) );
-                value = std::move( funcCall );
-            }
-            break;
-        case Operators::OperatorType::SliceSubscript:
-            ABORT() << "TODO implement";
-        case Operators::OperatorType::Cast:
-            ABORT() << "Cast is not a postfix operator";
-        }
-
-        provisionalTokensConsumed = tokensConsumed;
-        op.op = nextToken( source, provisionalTokensConsumed );
-        if( op.op==nullptr )
-            break;
-        opInfo = operators.find( op.op->token );
-    }
-
-    RULE_LEAVE();
+ParseResult Statement::parse(Tokenizer::TokenSlice source) {
+    return ParseMemo::memoize( ParseMemo::Rule::Statement, *this, source, [&]() { return parseUncached(source); } );
 }
 
-size_t Statement::parse(Slice<const Tokenizer::Token> source) {
+ParseResult Statement::parseUncached(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
+    NestingLimit::Level nesting;
+    if( nesting.tooDeep() )
+        RULE_FAIL( nestingTooDeep( source ) );
+
     ConditionalExpressionOrStatement condition;
     if( wishForToken(Tokenizer::Tokens::RESERVED_IF, source, tokensConsumed) ) {
-        tokensConsumed = condition.parse(source);
+        tokensConsumed = 0;
+        {
+            // A conditional expression is parsed again as an expression. Each of its parts is parsed the same way.
+            ParseMemo::Speculation speculation( ParseMemo::Speculative::Whole );
+            RULE_PARSE( tokensConsumed, condition.parse(source) );
+        }
         if( condition.isStatement() ) {
             content = condition.removeStatement();
         } else {
@@ -465,10 +604,13 @@ size_t Statement::parse(Slice<const Tokenizer::Token> source) {
             // XXX Don't handle conditional expression that is part of a larger expression
             //tokensConsumed += expression.continueParse( source.subslice(tokensConsumed) );
 
-            expectToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Statement does not end with a semicolon",
-                    "Unexpected EOF" );
+            if( !wishForToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, false ) ) {
+                RULE_FAIL( unexpectedToken(
+                            source, tokensConsumed, "Statement does not end with a semicolon", "Unexpected EOF" ) );
+            }
+            tokensConsumed++;
 
-            content = std::move(expression);
+            content = ParseArena::makeNode<Expression>( std::move(expression) );
         }
 
         RULE_LEAVE();
@@ -477,192 +619,307 @@ size_t Statement::parse(Slice<const Tokenizer::Token> source) {
     tokensConsumed=0;
     if( wishForToken(Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed) ) {
         CompoundStatement compound;
-        tokensConsumed=compound.parse(source);
+        tokensConsumed=0;
+        {
+            // Fails if the block is an expression, which is then parsed again as one
+            ParseMemo::Speculation speculation( ParseMemo::Speculative::Whole );
+            RULE_PARSE( tokensConsumed, compound.parse(source) );
+        }
 
-        content = safenew<CompoundStatement>( std::move(compound) );
+        content = ParseArena::makeNode<CompoundStatement>( std::move(compound) );
 
         RULE_LEAVE();
     }
 
-    try {
+    // No token starts both an expression and a variable definition
+    if( Lookahead::canStart( Lookahead::Rule::Expression, source, 0 ) ) {
         Expression expression;
 
-        tokensConsumed = expression.parse(source);
+        ParseResult result = 0;
+        {
+            // Without a semicolon, our caller is likely to parse the same expression next
+            ParseMemo::Speculation speculation( ParseMemo::Speculative::Outermost );
+            result = expression.parse(source);
+        }
+        if( result ) {
+            size_t expressionConsumed = result.tokensConsumed();
+            if( wishForToken( Tokenizer::Tokens::SEMICOLON, source, expressionConsumed ) ) {
+                tokensConsumed = expressionConsumed;
+                content = ParseArena::makeNode<Expression>( std::move(expression) );
 
-        expectToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Statement does not end with a semicolon",
-                "Unexpected EOF" );
+                RULE_LEAVE();
+            }
 
-        content = std::move(expression);
+            result = unexpectedToken(
+                    source, expressionConsumed, "Statement does not end with a semicolon", "Unexpected EOF" );
+        }
 
-        RULE_LEAVE();
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
+        RULE_FAIL( result.getError() );
     }
+    Lookahead::predicted();
 
-    VariableDefinition def;
+    NodeIndex<VariableDefinition> def = ParseArena::makeNode<VariableDefinition>();
 
-    tokensConsumed += def.parse(source);
-    expectToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Statement does not end with a semicolon",
+    tokensConsumed = 0;
+    RULE_PARSE( tokensConsumed, def->parse(source) );
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Statement does not end with a semicolon",
             "Unexpected EOF" );
 
-    content = std::move(def);
+    content = def;
     RULE_LEAVE();
 }
 
-size_t StatementList::parse(Slice<const Tokenizer::Token> source) {
+ParseResult StatementList::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    try {
-        // One of the disadvantages of using exceptions for signalling expected errors is "infinite" loops
-        while( true ) {
-            Statement statement;
-            tokensConsumed += statement.parse(source.subslice(tokensConsumed));
+    // The list ends with the first thing that isn't a statement
+    while( true ) {
+        if( !Lookahead::canStart( Lookahead::Rule::Statement, source, tokensConsumed ) ) {
+            Lookahead::predicted();
+            break;
+        }
 
-            statements.emplace_back( std::move(statement) );
+        Statement statement;
+        ParseResult result = statement.parse(source.subslice(tokensConsumed));
+        if( !result ) {
+            RULE_BACKTRACK( result );
+            break;
         }
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
+
+        tokensConsumed += result.tokensConsumed();
+        statements.emplace_back( std::move(statement) );
     }
 
     RULE_LEAVE();
 }
 
-size_t CompoundExpression::parse(Slice<const Tokenizer::Token> source) {
+ParseResult CompoundExpression::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     CompoundExpressionOrStatement compound;
-    tokensConsumed = compound.parseExpression(source);
+    RULE_PARSE( tokensConsumed, compound.parseExpression(source) );
 
     *this = compound.removeExpression();
 
     RULE_LEAVE();
 }
 
-size_t CompoundStatement::parse(Slice<const Tokenizer::Token> source) {
+ParseResult CompoundStatement::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     CompoundExpressionOrStatement compound;
-    tokensConsumed = compound.parseStatement(source);
+    RULE_PARSE( tokensConsumed, compound.parseStatement(source) );
 
     *this = compound.removeStatement();
 
     RULE_LEAVE();
 }
 
-size_t FuncDeclRet::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDeclRet::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    try {
-        expectToken(
-                Tokenizer::Tokens::OP_ARROW, source, tokensConsumed, "Expected ->",
-                "EOF while parsing function return type" );
+    if( wishForToken( Tokenizer::Tokens::OP_ARROW, source, tokensConsumed ) ) {
         // TODO If we found an arrow, probably best to fail if the rest doesn't match
+        ParseResult result = type.parse(source.subslice(tokensConsumed));
+        if( result ) {
+            tokensConsumed += result.tokensConsumed();
 
-        tokensConsumed += type.parse(source.subslice(tokensConsumed));
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
-        // Match ϵ
-        return 0;
+            RULE_LEAVE();
+        }
+        RULE_BACKTRACK( result );
     }
 
+    // Match ϵ
+    tokensConsumed = 0;
     RULE_LEAVE();
 }
 
-size_t FuncDeclArg::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDeclArg::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    tokensConsumed += name.parse( source.subslice(tokensConsumed) );
-    expectToken(
+    RULE_PARSE( tokensConsumed, name.parse( source.subslice(tokensConsumed) ) );
+    RULE_EXPECT_TOKEN(
             Tokenizer::Tokens::OP_COLON, source, tokensConsumed, "Expected colon in argument declaration",
             "EOF while parsing function declaration" );
-    tokensConsumed += type.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, type.parse( source.subslice(tokensConsumed) ) );
 
     RULE_LEAVE();
 }
 
-size_t FuncDeclArgsNonEmpty::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDeclArgsNonEmpty::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     bool more = false;
     do {
         FuncDeclArg arg;
-        tokensConsumed += arg.parse(source.subslice(tokensConsumed));
+        RULE_PARSE( tokensConsumed, arg.parse(source.subslice(tokensConsumed)) );
         arguments.emplace_back( std::move(arg) );
 
-        more = wishForToken( Tokenizer::Tokens::COMMA, source, tokensConsumed, true );
+        more = bool( wishForToken( Tokenizer::Tokens::COMMA, source, tokensConsumed, true ) );
     } while( more );
 
     RULE_LEAVE();
 }
 
-size_t FuncDeclArgs::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDeclArgs::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    try {
-        FuncDeclArgsNonEmpty args;
-        tokensConsumed += args.parse(source);
+    if( wishForToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, false ) ) {
+        Lookahead::predicted();
+        RULE_LEAVE();
+    }
+
+    FuncDeclArgsNonEmpty args;
+    ParseResult result = args.parse(source);
+    if( result ) {
+        tokensConsumed += result.tokensConsumed();
         arguments = std::move(args.arguments);
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
+    } else {
+        RULE_BACKTRACK( result );
         // That didn't match - use the empty match rule
     }
 
     RULE_LEAVE();
 }
 
-size_t FuncDeclBody::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDeclBody::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    tokensConsumed += name.parse( source  );
+    RULE_PARSE( tokensConsumed, name.parse( source  ) );
 
-    expectToken( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed, "Expected '('",
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed, "Expected '('",
             "EOF while parsing function declaration" );
 
-    tokensConsumed += arguments.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, arguments.parse( source.subslice(tokensConsumed) ) );
 
-    expectToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Expected ')'",
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Expected ')'",
             "EOF while parsing function declaration" );
 
-    tokensConsumed += returnType.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, returnType.parse( source.subslice(tokensConsumed) ) );
 
     RULE_LEAVE();
 }
 
-size_t FuncDef::parse(Slice<const Tokenizer::Token> source) {
-    RULE_ENTER(source);
+// Turn a parsed body into the form FuncDef holds it in
+static FuncDef::Body takeBody(CompoundExpressionOrStatement &body) {
+    if( body.isStatement() )
+        return body.removeStatement();
+    else
+        return body.removeExpression();
+}
 
-    const Tokenizer::Token *currentToken = nextToken(source, tokensConsumed, "EOF while looking for function definition");
-    if( currentToken->token!=Tokenizer::Tokens::RESERVED_DEF ) {
-        throw parser_error("Function definition should start with \"def\"", currentToken->location);
+// Number of tokens from the opening curly bracket at the start of source up to and including the bracket that closes it.
+// Returns 0 if source does not start with a curly bracket, if it is never closed, or if any bracket inside it is closed by
+// a bracket of a different kind.
+static size_t matchBody(Tokenizer::TokenSlice source) {
+    if( source.size()==0 || source.kind(0)!=Tokenizer::Tokens::BRACKET_CURLY_OPEN )
+        return 0;
+
+    // The closing bracket each open bracket expects
+    std::vector<Tokenizer::Tokens> expectedClose;
+    for( size_t i=0; i<source.size(); ++i ) {
+        switch( source.kind(i) ) {
+        case Tokenizer::Tokens::BRACKET_ROUND_OPEN:
+            expectedClose.push_back( Tokenizer::Tokens::BRACKET_ROUND_CLOSE );
+            break;
+        case Tokenizer::Tokens::BRACKET_SQUARE_OPEN:
+            expectedClose.push_back( Tokenizer::Tokens::BRACKET_SQUARE_CLOSE );
+            break;
+        case Tokenizer::Tokens::BRACKET_CURLY_OPEN:
+            expectedClose.push_back( Tokenizer::Tokens::BRACKET_CURLY_CLOSE );
+            break;
+        case Tokenizer::Tokens::BRACKET_ROUND_CLOSE:
+        case Tokenizer::Tokens::BRACKET_SQUARE_CLOSE:
+        case Tokenizer::Tokens::BRACKET_CURLY_CLOSE:
+            if( expectedClose.back()!=source.kind(i) )
+                return 0;
+
+            expectedClose.pop_back();
+            if( expectedClose.empty() )
+                return i+1;
+            break;
+        default:
+            break;
+        }
     }
 
-    tokensConsumed += decl.parse( source.subslice(tokensConsumed) );
+    return 0;
+}
+
+ParseResult FuncDef::parse(Tokenizer::TokenSlice source) {
+    RULE_ENTER(source);
+
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::RESERVED_DEF, source, tokensConsumed,
+            "Function definition should start with \"def\"", "EOF while looking for function definition" );
+
+    RULE_PARSE( tokensConsumed, decl.parse( source.subslice(tokensConsumed) ) );
     CompoundExpressionOrStatement body;
-    tokensConsumed += body.parse( source.subslice(tokensConsumed) );
-    if( body.isStatement() )
-        this->body = body.removeStatement();
-    else
-        this->body = body.removeExpression();
+    RULE_PARSE( tokensConsumed, body.parse( source.subslice(tokensConsumed) ) );
+    this->body = takeBody( body );
 
     RULE_LEAVE();
 }
 
-size_t FuncDecl::parse(Slice<const Tokenizer::Token> source) {
+ParseResult FuncDef::parseDeferringBody(Tokenizer::TokenSlice source) {
+    RULE_ENTER(source);
+
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::RESERVED_DEF, source, tokensConsumed,
+            "Function definition should start with \"def\"", "EOF while looking for function definition" );
+
+    RULE_PARSE( tokensConsumed, decl.parse( source.subslice(tokensConsumed) ) );
+
+    size_t bodyLength = matchBody( source.subslice(tokensConsumed) );
+    if( bodyLength!=0 ) {
+        bodyTokens = source.subslice( tokensConsumed, tokensConsumed+bodyLength );
+        tokensConsumed += bodyLength;
+    } else {
+        // Bodies with unmatched brackets are parsed right away, so that the error is reported where it always was
+        CompoundExpressionOrStatement body;
+        RULE_PARSE( tokensConsumed, body.parse( source.subslice(tokensConsumed) ) );
+        this->body = takeBody( body );
+    }
+
+    RULE_LEAVE();
+}
+
+const FuncDef::Body &FuncDef::getBody() const {
+    if( bodyTokens.size()==0 )
+        return body;
+
+    ParseMemo memo;
+    ParseMemo::Scope memoScope(memo);
+
+    CompoundExpressionOrStatement parsedBody;
+    ParseResult result = parsedBody.parse( bodyTokens );
+    if( !result )
+        result.getError().raise();
+    ASSERT( result.tokensConsumed()==bodyTokens.size() ) <<
+            "Function " << getName() << " body parsed " << result.tokensConsumed() << " tokens out of " <<
+            bodyTokens.size();
+
+    body = takeBody( parsedBody );
+    bodyTokens = Tokenizer::TokenSlice();
+
+    return body;
+}
+
+ParseResult FuncDecl::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    expectToken( Tokenizer::Tokens::RESERVED_DECL, source, tokensConsumed, "Expected `decl` keyword" );
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::RESERVED_DECL, source, tokensConsumed, "Expected `decl` keyword" );
 
-    const Tokenizer::Token *currentToken = wishForToken(
+    Tokenizer::TokenRef currentToken = wishForToken(
             Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed, true );
-    if( currentToken!=nullptr ) {
+    if( currentToken ) {
         // Declaration has qualifiers
-        tokensConsumed += abiSpecifier.parse( source.subslice(tokensConsumed) );
-        expectToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Unmatched `(`" );
+        RULE_PARSE( tokensConsumed, abiSpecifier.parse( source.subslice(tokensConsumed) ) );
+        RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Unmatched `(`" );
     }
 
-    tokensConsumed += decl.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, decl.parse( source.subslice(tokensConsumed) ) );
 
-    expectToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Function declaration must end with `;`" );
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::SEMICOLON, source, tokensConsumed, "Function declaration must end with `;`" );
 
     RULE_LEAVE();
 }
@@ -18,44 +18,44 @@
 
 #include "asserts.h"
 #include "operators.h"
+#include "parse_arena.h"
 
 #include <practical/defines.h>
 #include <practical/practical.h>
 #include <practical/slice.h>
 
-#include <memory>
+#include <array>
 #include <variant>
-#include <vector>
 
 using namespace PracticalSemanticAnalyzer;
 
 namespace NonTerminals {
     struct TransientType : public NonTerminal {
         Type type;
-        const Tokenizer::Token *ref = nullptr;
+        Tokenizer::TokenRef ref;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct LiteralPointer : public NonTerminal {
-        const Tokenizer::Token *token = nullptr;
+        Tokenizer::TokenRef token;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct Literal : public NonTerminal {
         std::variant<LiteralInt, LiteralBool, LiteralPointer, LiteralString> literal;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
 
         SourceLocation getLocation() const;
     };
 
     struct Expression;
     struct FunctionArguments : public NonTerminal {
-        std::vector<Expression> arguments;
+        ArenaVector<Expression> arguments;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct CompoundExpression;
@@ -63,74 +63,81 @@ namespace NonTerminals {
     struct ConditionalExpression;
     struct Expression : public NonTerminal {
         struct UnaryOperator {
-            const Tokenizer::Token *op;
-            std::unique_ptr<Expression> operand;
+            Tokenizer::TokenRef op;
+            NodeIndex<Expression> operand;
         };
 
         struct BinaryOperator {
-            const Tokenizer::Token *op;
-            std::array< std::unique_ptr<Expression>, 2 > operands;
+            Tokenizer::TokenRef op;
+            std::array< NodeIndex<Expression>, 2 > operands{};
         };
 
         struct CastOperator {
-            const Tokenizer::Token *op;
-            Type destType;
-            std::unique_ptr<Expression> expression;
+            Tokenizer::TokenRef op;
+            NodeIndex<Type> destType;
+            NodeIndex<Expression> expression;
         };
 
         struct FunctionCall {
-            const Tokenizer::Token *op;
-            std::unique_ptr<Expression> expression;
-            FunctionArguments arguments;
+            Tokenizer::TokenRef op;
+            NodeIndex<Expression> expression;
+            NodeIndex<FunctionArguments> arguments;
         };
 
+        // Expressions are the most numerous nodes of the tree. To keep them small, anything bigger than a token and a
+        // couple of node indexes is kept out of line, in the arena's pools.
         std::variant<
-                std::unique_ptr<::NonTerminals::CompoundExpression>,
-                ::NonTerminals::Literal,
-                Identifier,
+                NodeIndex<::NonTerminals::CompoundExpression>,
+                NodeIndex<::NonTerminals::Literal>,
+                NodeIndex<Identifier>,
                 UnaryOperator,
                 BinaryOperator,
                 CastOperator,
                 FunctionCall,
-                std::unique_ptr<ConditionalExpression>,
-                Type
+                NodeIndex<ConditionalExpression>,
+                NodeIndex<Type>
             > value;
     private:
-        mutable std::unique_ptr<Type> altTypeParse;
+        mutable NodeIndex<Type> altTypeParse;
 
     public:
         Expression() {}
         explicit Expression( ConditionalExpression &&condition ) :
-            value( safenew<ConditionalExpression>( std::move(condition) ) )
+            value( ParseArena::makeNode<ConditionalExpression>( std::move(condition) ) )
         {}
-        Expression( Expression &&that ) : value( std::move(that.value) ), altTypeParse( std::move(that.altTypeParse) )
+        Expression( Expression &&that ) : value( std::move(that.value) ), altTypeParse( that.altTypeParse )
         {}
+        // The copy shares the children, which live in the arena
+        Expression( const Expression &that ) : value( that.value ), altTypeParse( that.altTypeParse ) {
+            parsedSlice = that.parsedSlice;
+        }
         Expression &operator=( Expression &&that ) {
             value = std::move( that.value );
-            altTypeParse = std::move( that.altTypeParse );
+            altTypeParse = that.altTypeParse;
 
             return *this;
         }
 
-        explicit Expression( std::unique_ptr<CompoundExpression> &&compoundExpression ) :
-            value( std::move(compoundExpression) )
+        explicit Expression( NodeIndex<CompoundExpression> compoundExpression ) :
+            value( compoundExpression )
         {}
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
+        // Parse the expression's tokens as a type, unless it was parsed as one already. Must be called while the arena the
+        // expression was parsed into is active.
         const Type *reparseAsType() const;
 
     private:
-        size_t actualParse(Slice<const Tokenizer::Token> source, size_t level);
-        size_t basicParse(Slice<const Tokenizer::Token> source);
-
-        size_t parsePrefixOp(
-                Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators);
-        size_t parseInfixOp(
-                Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators);
-        size_t parseInfixR2LOp(
-                Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators);
-        size_t parsePostfixOp(
-                Slice<const Tokenizer::Token> source, size_t level, const Operators::OperatorPriority::OperatorsMap &operators);
+        ParseResult parseUncached(Tokenizer::TokenSlice source);
+        // Parse an expression whose operators all have precedence of at most maxPrecedence. Does not recurse, however
+        // deeply the parenthesis and operators nest.
+        ParseResult parseOperators(Tokenizer::TokenSlice source, unsigned maxPrecedence);
+        // Parse a cast operator and its operand
+        ParseResult parseCast(Tokenizer::TokenSlice source);
+        // Parse an identifier or a literal
+        ParseResult parseAtom(Tokenizer::TokenSlice source);
+        // Source failed to parse as an expression with expressionResult. Try parsing it as a type instead.
+        ParseResult parseAsTypeInstead(Tokenizer::TokenSlice source, ParseResult expressionResult);
     };
 
     struct ConditionalExpression {
@@ -142,31 +149,42 @@ namespace NonTerminals {
 
     struct Statement : public NonTerminal {
         struct ConditionalStatement {
-            Expression condition;
-            std::unique_ptr<Statement> ifClause, elseClause;
+            NodeIndex<Expression> condition;
+            NodeIndex<Statement> ifClause, elseClause;
         };
 
         Statement() {}
-        explicit Statement( std::unique_ptr<CompoundStatement> &&compoundStatement ) :
-            content( std::move(compoundStatement) )
+        Statement( Statement &&that ) = default;
+        Statement &operator=( Statement &&that ) = default;
+        // The copy shares the children, which live in the arena
+        Statement( const Statement &that ) : content( that.content ) {
+            parsedSlice = that.parsedSlice;
+        }
+        explicit Statement( NodeIndex<CompoundStatement> compoundStatement ) :
+            content( compoundStatement )
+        {}
+        explicit Statement( Expression &&expression ) :
+            content( ParseArena::makeNode<Expression>( std::move(expression) ) )
         {}
-        explicit Statement( Expression &&expression ) : content( std::move(expression) ) {}
 
         std::variant<
                 std::monostate,
-                Expression,
-                VariableDefinition,
+                NodeIndex<Expression>,
+                NodeIndex<VariableDefinition>,
                 ConditionalStatement,
-                std::unique_ptr<CompoundStatement>
+                NodeIndex<CompoundStatement>
             > content;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
+
+    private:
+        ParseResult parseUncached(Tokenizer::TokenSlice source);
     };
 
     struct StatementList : public NonTerminal {
-        std::vector<Statement> statements;
+        ArenaVector<Statement> statements;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct CompoundExpression : public NonTerminal {
@@ -191,7 +209,7 @@ namespace NonTerminals {
             return *this;
         }
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct CompoundStatement : public NonTerminal {
@@ -200,32 +218,32 @@ namespace NonTerminals {
         CompoundStatement() {}
         CompoundStatement( StatementList &&statements ) : statements( std::move(statements) ) {}
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDeclRet : public NonTerminal {
         TransientType type;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDeclArg : public NonTerminal {
         Identifier name;
         TransientType type;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDeclArgsNonEmpty : public NonTerminal {
-        std::vector<FuncDeclArg> arguments;
+        ArenaVector<FuncDeclArg> arguments;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDeclArgs : public NonTerminal {
-        std::vector<FuncDeclArg> arguments;
+        ArenaVector<FuncDeclArg> arguments;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDeclBody : public NonTerminal {
@@ -233,18 +251,36 @@ namespace NonTerminals {
         FuncDeclArgs arguments;
         FuncDeclRet returnType;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
     };
 
     struct FuncDef : public NonTerminal {
+        using Body = std::variant<std::monostate, CompoundExpression, CompoundStatement>;
+
         FuncDeclBody decl;
-        std::variant<std::monostate, CompoundExpression, CompoundStatement> body;
 
+    private:
+        friend ParseTreeCache;
+
+        mutable Body body;
+        // Tokens of a body that was not parsed yet. Empty once the body is parsed
+        mutable Tokenizer::TokenSlice bodyTokens;
+
+    public:
         FuncDef() : body{} {
         }
-        FuncDef( FuncDef &&that ) : decl( std::move(that.decl) ), body( std::move(that.body) ) {}
+        FuncDef( FuncDef &&that ) :
+            NonTerminal( std::move(that) ), decl( std::move(that.decl) ), body( std::move(that.body) ),
+            bodyTokens( that.bodyTokens )
+        {}
+
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
+        // Parse only the declaration, and find where the body ends by matching its brackets. The body is parsed by the
+        // first call to getBody.
+        ParseResult parseDeferringBody(Tokenizer::TokenSlice source);
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        // Parses a deferred body into the active arena, throwing a parser_error if it fails to parse
+        const Body &getBody() const;
 
         String getName() const {
             return decl.name.getName();
@@ -258,7 +294,7 @@ namespace NonTerminals {
         FuncDecl() {}
         FuncDecl( FuncDecl &&that ) = default;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
 
         String getName() const {
             return decl.name.getName();
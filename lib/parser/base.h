@@ -9,13 +9,103 @@
 #ifndef PARSER_BASE_H
 #define PARSER_BASE_H
 
-#include "tokenizer.h"
+#include "asserts.h"
+#include "parse_arena.h"
+#include "token_stream.h"
 
 namespace NonTerminals {
 
+// Why a non-terminal failed to parse
+struct ParseError {
+    enum class Kind : uint8_t {
+        // The tokens do not match the rule. The caller may try parsing them as something else
+        Syntax,
+        // The tokens match the rule, but the literal they contain is invalid. No other rule is going to do better
+        IllegalLiteral,
+        InvalidEscapeSequence,
+        // Expressions or statements are nested deeper than NestingLimit allows
+        NestingTooDeep,
+    };
+
+    const char *msg = nullptr;
+    SourceLocation location;
+    Kind kind = Kind::Syntax;
+
+    bool isSyntax() const {
+        return kind==Kind::Syntax;
+    }
+
+    // Throw the compile_error matching this error
+    [[noreturn]] void raise() const;
+};
+
+// Result of parsing a non-terminal: how many tokens were consumed or, if parsing failed, why
+class [[nodiscard]] ParseResult {
+    size_t consumed = 0;
+    ParseError error;
+    bool success = true;
+
+public:
+    /* implicit */ ParseResult( size_t tokensConsumed ) : consumed(tokensConsumed) {}
+    /* implicit */ ParseResult( const ParseError &error ) : error(error), success(false) {}
+
+    explicit operator bool() const {
+        return success;
+    }
+
+    size_t tokensConsumed() const {
+        ASSERT( success ) << "Tokens consumed requested from a failed parse";
+        return consumed;
+    }
+
+    const ParseError &getError() const {
+        ASSERT( !success ) << "Error requested from a successful parse";
+        return error;
+    }
+};
+
+// How deeply expressions and statements may nest when parsed or compiled on the current thread, for the scope's
+// lifetime. Deeper source is an error, rather than a stack overflow.
+class NestingLimit : private NoCopy {
+    size_t previous;
+
+    static inline thread_local size_t limit = PracticalSemanticAnalyzer::CompilerArguments::DefaultMaxNestingDepth;
+    static inline thread_local size_t depth = 0;
+
+public:
+    explicit NestingLimit(size_t limit);
+    ~NestingLimit();
+
+    static size_t get() {
+        return limit;
+    }
+
+    // One more level of nesting for the level's lifetime
+    class Level : private NoCopy {
+    public:
+        Level() {
+            depth++;
+        }
+
+        ~Level() {
+            depth--;
+        }
+
+        bool tooDeep() const {
+            return depth>limit;
+        }
+    };
+};
+
+class ParseMemo;
+class ParseTreeCache;
+
 struct NonTerminal : private NoCopy {
 protected:
-    Slice<const Tokenizer::Token> parsedSlice;
+    friend ParseMemo;
+    friend ParseTreeCache;
+
+    Tokenizer::TokenSlice parsedSlice;
 
 public:
     NonTerminal() = default;
@@ -23,13 +113,14 @@ public:
     NonTerminal &operator=( NonTerminal &&that ) = default;
 
     // This function is not really virtual. It's used this way to force all children to have the same signature
-    // Returns how many tokens were consumed
-    // Throws parser_error if fails to parse
-    virtual size_t parse(Slice<const Tokenizer::Token> source) = 0;
+    // Returns how many tokens were consumed, or the error if fails to parse. Failing is a normal part of trying
+    // alternative rules, so it does not throw. Use Module::parse(String) to get a parser_error instead.
+    // source is a range of a Tokenizer::TokenStream, which has no white space or comments tokens
+    virtual ParseResult parse(Tokenizer::TokenSlice source) = 0;
 
     virtual ~NonTerminal() {}
 
-    Slice<const Tokenizer::Token> getNTTokens() const {
+    Tokenizer::TokenSlice getNTTokens() const {
         return parsedSlice;
     }
 };
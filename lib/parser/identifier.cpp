@@ -14,11 +14,13 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t Identifier::parse(Slice<const Tokenizer::Token> source) {
+ParseResult Identifier::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    identifier = &expectToken(Tokenizer::Tokens::IDENTIFIER, source, tokensConsumed, "Expected an identifier",
-            "EOF while parsing an identifier" );
+    identifier = wishForToken( Tokenizer::Tokens::IDENTIFIER, source, tokensConsumed );
+    if( !identifier )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "Expected an identifier",
+                    "EOF while parsing an identifier" ) );
 
     RULE_LEAVE();
 }
@@ -16,17 +16,24 @@
 namespace NonTerminals {
 
 struct Identifier : public NonTerminal {
-    const Tokenizer::Token *identifier = nullptr;
+    Tokenizer::TokenRef identifier;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    Identifier() = default;
+    Identifier( Identifier &&that ) = default;
+    Identifier &operator=( Identifier &&that ) = default;
+    Identifier( const Identifier &that ) : identifier( that.identifier ) {
+        parsedSlice = that.parsedSlice;
+    }
+
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
 
     String getName() const {
-        return identifier->text;
+        return identifier.text();
     }
 
     SourceLocation getLocation() const {
-        ASSERT(identifier != nullptr) << "Dereferencing an unparsed identifier";
-        return identifier->location;
+        ASSERT(identifier) << "Dereferencing an unparsed identifier";
+        return identifier.location();
     }
 };
 
@@ -16,12 +16,14 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t LiteralBool::parse(Slice<const Tokenizer::Token> source) {
+ParseResult LiteralBool::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    const Tokenizer::Token *currentToken = nextToken(source, tokensConsumed, "EOF while parsing literal");
+    Tokenizer::TokenRef currentToken = nextToken(source, tokensConsumed);
+    if( !currentToken )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "EOF while parsing literal" ) );
 
-    switch( currentToken->token ) {
+    switch( currentToken.kind() ) {
     case Tokenizer::Tokens::RESERVED_FALSE:
         value = false;
         break;
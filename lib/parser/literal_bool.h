@@ -14,10 +14,10 @@
 namespace NonTerminals {
 
 struct LiteralBool : public NonTerminal {
-    const Tokenizer::Token *token = nullptr;
+    Tokenizer::TokenRef token;
     bool value = 0;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
 };
 
 } // namespace NonTerminals
@@ -18,12 +18,14 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t LiteralInt::parse(Slice<const Tokenizer::Token> source) {
+ParseResult LiteralInt::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    const Tokenizer::Token *currentToken = nextToken(source, tokensConsumed, "EOF while parsing literal");
+    Tokenizer::TokenRef currentToken = nextToken(source, tokensConsumed);
+    if( !currentToken )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "EOF while parsing literal" ) );
 
-    switch( currentToken->token ) {
+    switch( currentToken.kind() ) {
     case Tokenizer::Tokens::LITERAL_INT_2:
         token = currentToken;
         parseBinary();
@@ -34,14 +36,18 @@ size_t LiteralInt::parse(Slice<const Tokenizer::Token> source) {
         break;
     case Tokenizer::Tokens::LITERAL_INT_10:
         token = currentToken;
-        parseDecimal();
+        if( !parseDecimal() ) {
+            RULE_FAIL( ParseError{
+                    .msg = "Literal integer too big", .location = token.location(),
+                    .kind = ParseError::Kind::IllegalLiteral } );
+        }
         break;
     case Tokenizer::Tokens::LITERAL_INT_16:
         token = currentToken;
         parseHexadecimal();
         break;
     default:
-        throw parser_error("Invalid integer literal", currentToken->location);
+        RULE_FAIL( ParseError{ .msg = "Invalid integer literal", .location = currentToken.location() } );
     }
 
     RULE_LEAVE();
@@ -55,10 +61,10 @@ void LiteralInt::parseOctal() {
     ABORT()<<"TODO implement octal literals";
 }
 
-void LiteralInt::parseDecimal() {
+bool LiteralInt::parseDecimal() {
     value = 0;
 
-    for( char c: token->text ) {
+    for( char c: token.text() ) {
         static constexpr LongEnoughInt
                 LimitDivided = std::numeric_limits<LongEnoughInt>::max() / 10,
                 LimitTruncated = LimitDivided * 10,
@@ -68,16 +74,17 @@ void LiteralInt::parseDecimal() {
             continue;
 
         if( value > LimitDivided )
-            throw IllegalLiteral( "Literal integer too big", token->location );
+            return false;
 
         ASSERT( c>='0' && c<='9' ) << "Decimal literal has character '"<<c<<"' out of allowed range";
         value *= 10;
         if( value == LimitTruncated && c-'0'>LimitLastDigit )
-            throw IllegalLiteral( "Literal integer too big", token->location );
+            return false;
 
         value += c-'0';
     }
 
+    return true;
 }
 
 void LiteralInt::parseHexadecimal() {
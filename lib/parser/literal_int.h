@@ -14,15 +14,16 @@
 namespace NonTerminals {
 
 struct LiteralInt : public NonTerminal {
-    const Tokenizer::Token *token = nullptr;
+    Tokenizer::TokenRef token;
     LongEnoughInt value = 0;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
 
 private:
     void parseBinary();
     void parseOctal();
-    void parseDecimal();
+    // Returns false if the literal is too big
+    bool parseDecimal();
     void parseHexadecimal();
 };
 
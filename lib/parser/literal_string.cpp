@@ -17,12 +17,12 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t LiteralString::parse(Slice<const Tokenizer::Token> source) {
+ParseResult LiteralString::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    token = &expectToken(
-            Tokenizer::Tokens::LITERAL_STRING, source, tokensConsumed,
-            "Expected null literal", "EOF while parsing literal");
+    token = wishForToken( Tokenizer::Tokens::LITERAL_STRING, source, tokensConsumed );
+    if( !token )
+        RULE_FAIL( unexpectedToken( source, tokensConsumed, "Expected null literal", "EOF while parsing literal" ) );
 
     static const std::unordered_map<
             State,
@@ -33,15 +33,15 @@ size_t LiteralString::parse(Slice<const Tokenizer::Token> source) {
         { State::Backslash, &LiteralString::parserBackslash }
     };
 
-    ASSERT( token->token == Tokenizer::Tokens::LITERAL_STRING );
+    ASSERT( token.kind() == Tokenizer::Tokens::LITERAL_STRING );
     ASSERT( value.empty() );
 
-    String body = token->text;
+    String body = token.text();
     ASSERT( body.size()>2 );
     ASSERT( body[0]=='"' );
     ASSERT( body[body.size()-1]=='"' );
 
-    SourceLocation location = token->location;
+    SourceLocation location = token.location();
 
     // Strip leading and trailing quotes
     body = body.subslice( 1, body.size()-1 );
@@ -52,6 +52,12 @@ size_t LiteralString::parse(Slice<const Tokenizer::Token> source) {
     int stateData = 0;
     while( body.size()>0 ) {
         state = (this ->* stateParsers.at(state))( body, stateData, location );
+        if( state==State::Invalid ) {
+            RULE_FAIL( ParseError{
+                    .msg = "Invalid escape sequence in string literal", .location = location,
+                    .kind = ParseError::Kind::InvalidEscapeSequence } );
+        }
+
         body = body.subslice(1);
         ++location;
     }
@@ -67,7 +73,7 @@ LiteralString::State LiteralString::parserNone(
         return State::Backslash;
     }
 
-    value += source[0];
+    value.emplace_back( source[0] );
     return State::None;
 }
 
@@ -79,39 +85,39 @@ LiteralString::State LiteralString::parserBackslash(
     case '"':
     case '?':
     case '\\':
-        value += source[0];
+        value.emplace_back( source[0] );
         return State::None;
     case '0':
-        value += char(0); // NUL (Null)
+        value.emplace_back( char(0) ); // NUL (Null)
         return State::None;
     case 'a':
-        value += 7; // BEL (Bell)
+        value.emplace_back( 7 ); // BEL (Bell)
         return State::None;
     case 'b':
-        value += 8; // BS (Backspace)
+        value.emplace_back( 8 ); // BS (Backspace)
         return State::None;
     case 't':
-        value += 9; // HT (Horizontal tab)
+        value.emplace_back( 9 ); // HT (Horizontal tab)
         return State::None;
     case 'n':
-        value += 10; // NL (Newline)
+        value.emplace_back( 10 ); // NL (Newline)
         return State::None;
     case 'v':
-        value += 11; // VT (Vertical tab)
+        value.emplace_back( 11 ); // VT (Vertical tab)
         return State::None;
     case 'f':
-        value += 12; // FF (Form feed)
+        value.emplace_back( 12 ); // FF (Form feed)
         return State::None;
     case 'r':
-        value += 13; // CR (Carriage return)
+        value.emplace_back( 13 ); // CR (Carriage return)
         return State::None;
     case 'x':
         stateData = 0;
-        value += char(0);
+        value.emplace_back( char(0) );
         return State::Hex;
     }
 
-    throw InvalidEscapeSequence(location);
+    return State::Invalid;
 }
 
 } // namespace NonTerminals
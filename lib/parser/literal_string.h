@@ -9,19 +9,26 @@
 #ifndef PARSER_LITERAL_STRING_H
 #define PARSER_LITERAL_STRING_H
 
+#include "parse_arena.h"
 #include "parser/base.h"
 
 namespace NonTerminals {
 
 struct LiteralString : public NonTerminal {
 public:
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
+
+    String getValue() const {
+        return String( value.begin(), value.size() );
+    }
 
 private:
     enum class State {
         None,
         Backslash,
         Hex,
+        // Invalid escape sequence
+        Invalid,
     };
 
     State parserNone( String source, int &stateData, const SourceLocation &location );
@@ -30,8 +37,8 @@ private:
     // Members
     State state = State::None;
 public:
-    const Tokenizer::Token *token = nullptr;
-    std::string value;
+    Tokenizer::TokenRef token;
+    ArenaVector<char> value;
 };
 
 } // namespace NonTerminals
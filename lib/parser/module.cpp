@@ -8,35 +8,239 @@
  */
 #include "parser/module.h"
 
+#include "parse_tree_cache.h"
 #include "parser_internal.h"
+#include "token_stream.h"
+#include "worker_pool.h"
 
 #include <practical/errors.h>
 
+#include <optional>
+#include <thread>
+#include <utility>
+
 namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-void Module::parse(String source) {
-    tokens = Tokenizer::Tokenizer::tokenize(source);
-    parse(tokens);
+namespace {
+
+// Modules are not split into parts smaller than this. Smaller parts don't justify the cost of handing them to a worker.
+static constexpr size_t MinTokensPerThread = 16*1024;
+
+bool startsDefinition(Tokenizer::Tokens token) {
+    return
+            token==Tokenizer::Tokens::RESERVED_DEF ||
+            token==Tokenizer::Tokens::RESERVED_DECL ||
+            token==Tokenizer::Tokens::RESERVED_STRUCT;
+}
+
+ParseError unidentifiedDefinition(Tokenizer::TokenRef token) {
+    return ParseError{ .msg = "Unidentified statement in global context", .location = token.location() };
+}
+
+// A global definition found by scanDefinitions
+struct Definition {
+    Tokenizer::Tokens keyword;
+    size_t begin, end;
+};
+
+// Find the global definitions and where each one ends by matching brackets, without parsing them. Returns false if
+// source does not look like a sequence of definitions.
+bool scanDefinitions(Tokenizer::TokenSlice source, std::vector<Definition> &definitions) {
+    size_t position = 0;
+    while( position<source.size() ) {
+        Tokenizer::Tokens keyword = source.kind(position);
+        if( !startsDefinition( keyword ) )
+            return false;
+
+        // Declarations end with a semicolon. Function and struct definitions end with the bracket closing their body.
+        Tokenizer::Tokens terminator = keyword==Tokenizer::Tokens::RESERVED_DECL ?
+                Tokenizer::Tokens::SEMICOLON :
+                Tokenizer::Tokens::BRACKET_CURLY_CLOSE;
+
+        size_t depth = 0;
+        size_t end = position+1;
+        while( true ) {
+            if( end==source.size() )
+                return false;
+
+            Tokenizer::Tokens token = source.kind(end++);
+            switch( token ) {
+            case Tokenizer::Tokens::BRACKET_ROUND_OPEN:
+            case Tokenizer::Tokens::BRACKET_SQUARE_OPEN:
+            case Tokenizer::Tokens::BRACKET_CURLY_OPEN:
+                depth++;
+                break;
+            case Tokenizer::Tokens::BRACKET_ROUND_CLOSE:
+            case Tokenizer::Tokens::BRACKET_SQUARE_CLOSE:
+            case Tokenizer::Tokens::BRACKET_CURLY_CLOSE:
+                if( depth==0 )
+                    return false;
+                depth--;
+                break;
+            default:
+                break;
+            }
+
+            if( depth==0 && token==terminator )
+                break;
+        }
+
+        definitions.emplace_back( Definition{ .keyword = keyword, .begin = position, .end = end } );
+        position = end;
+    }
+
+    return true;
+}
+
+// Index of the token at location, looking from position on. Errors at EOF are at the end of source.
+size_t tokenAt(Tokenizer::TokenSlice source, size_t position, SourceLocation location) {
+    while( position<source.size() && source[position].location()!=location )
+        position++;
+
+    return position;
+}
+
+// The tokens of the statement holding the token at index, in the definition starting at definitionStart: from the end
+// of the previous statement, to the semicolon or block that ends this one. An empty range if there is no such
+// statement, such as when the error is in the definition's header. Only curly brackets are matched, as the statement
+// may be broken by an unbalanced bracket of another kind.
+std::pair<size_t, size_t> failedStatement(Tokenizer::TokenSlice source, size_t definitionStart, size_t index) {
+    size_t begin = index;
+    while( begin>definitionStart ) {
+        Tokenizer::Tokens token = source.kind(begin-1);
+        if(
+                token==Tokenizer::Tokens::SEMICOLON ||
+                token==Tokenizer::Tokens::BRACKET_CURLY_OPEN ||
+                token==Tokenizer::Tokens::BRACKET_CURLY_CLOSE )
+        {
+            break;
+        }
+
+        begin--;
+    }
+
+    if( begin==definitionStart )
+        return { index, index };
+
+    size_t end = index;
+    size_t depth = 0;
+    while( end<source.size() ) {
+        Tokenizer::Tokens token = source.kind(end);
+        // The block holding the statement stays
+        if( token==Tokenizer::Tokens::BRACKET_CURLY_CLOSE && depth==0 )
+            break;
+
+        end++;
+        if( token==Tokenizer::Tokens::BRACKET_CURLY_OPEN ) {
+            depth++;
+        } else if( token==Tokenizer::Tokens::BRACKET_CURLY_CLOSE ) {
+            // A condition's "then" block is followed by its "else" clause
+            if( --depth==0 && !wishForToken( Tokenizer::Tokens::RESERVED_ELSE, source, end, false ) )
+                break;
+        } else if( token==Tokenizer::Tokens::SEMICOLON && depth==0 ) {
+            break;
+        }
+    }
+
+    return { begin, end };
+}
+
+// Where the global definition after the one at position starts. Only definitions outside of curly brackets count.
+size_t nextDefinition(Tokenizer::TokenSlice source, size_t position) {
+    size_t depth = 0;
+    for( position++; position<source.size(); ++position ) {
+        Tokenizer::Tokens token = source.kind(position);
+        if( token==Tokenizer::Tokens::BRACKET_CURLY_OPEN )
+            depth++;
+        else if( token==Tokenizer::Tokens::BRACKET_CURLY_CLOSE && depth>0 )
+            depth--;
+        else if( depth==0 && startsDefinition( token ) )
+            return position;
+    }
+
+    return position;
 }
 
-size_t Module::parse(Slice<const Tokenizer::Token> source) {
+} // Anonymous namespace
+
+void Module::parse(String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments) {
+    SymbolTable::Scope symbolScope( symbols );
+
+    // A traced parse must actually run
+    bool useCache = !arguments.parseTreeCache.empty() && arguments.parserTraceRecords==0;
+    if( useCache && ParseTreeCache::load( *this, source, arguments ) )
+        return;
+
+    parseSource( source, arguments );
+
+    if( useCache )
+        ParseTreeCache::store( *this, source, arguments );
+}
+
+void Module::parseSource(String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments) {
+    tokens = Tokenizer::TokenStream::tokenize(source, arguments.tokenizerThreads);
+    lazyFunctionBodies = arguments.lazyFunctionBodies;
+    NestingLimit nestingLimit( arguments.maxNestingDepth );
+
+    unsigned threads = arguments.parserThreads;
+    if( threads==0 )
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+
+    std::optional<ParserTrace::Trace::Scope> traceScope;
+    if( arguments.parserTraceRecords>0 ) {
+        trace = safenew<ParserTrace::Trace>( arguments.parserTraceRecords );
+        traceScope.emplace( *trace, tokens );
+        threads = 1;
+    }
+
+    if( threads>1 && parseParallel( threads, arguments.parserMemoization, arguments.maxNestingDepth ) )
+        return;
+
+    Lookahead::Scope lookaheadScope( lookaheadStatistics );
+    ParseResult result = 0;
+    if( arguments.parserMemoization ) {
+        ParseMemo memo;
+        ParseMemo::Scope memoScope(memo);
+
+        result = parse(tokens);
+        memoStatistics = memo.getStatistics();
+    } else {
+        result = parse(tokens);
+    }
+    // The trace ends with the error. Looking for more errors is not part of it.
+    traceScope.reset();
+
+    if( !result ) {
+        if( arguments.maxErrors>1 ) {
+            recoverErrors( arguments.maxErrors );
+
+            // The recovery parses deferred bodies too, so it may find errors before the one the parse failed on
+            if( !errors.empty() )
+                errors.front().raise();
+        }
+
+        result.getError().raise();
+    }
+}
+
+ParseResult Module::parse(Tokenizer::TokenSlice source) {
+    ParseArena::Scope arenaScope(arena);
     RULE_ENTER(source);
 
-    skipWS(source, tokensConsumed);
     while( tokensConsumed<source.size() ) {
-        const Tokenizer::Token *currentToken = wishForToken(
+        Tokenizer::TokenRef currentToken = wishForToken(
                 Tokenizer::Tokens::RESERVED_DEF,
                 source, tokensConsumed,
                 false);
-        if( currentToken != nullptr ) {
+        if( currentToken ) {
             FuncDef func;
 
-            tokensConsumed += func.parse( source.subslice(tokensConsumed) );
+            RULE_PARSE( tokensConsumed, parseFunction( func, source.subslice(tokensConsumed) ) );
             functionDefinitions.emplace_back( std::move(func) );
-
-            skipWS(source, tokensConsumed);
+            // The parser never backtracks into a previous global definition
+            ParseMemo::forgetActive();
             continue;
         }
 
@@ -44,13 +248,12 @@ size_t Module::parse(Slice<const Tokenizer::Token> source) {
                 Tokenizer::Tokens::RESERVED_DECL,
                 source, tokensConsumed,
                 false);
-        if( currentToken != nullptr ) {
+        if( currentToken ) {
             FuncDecl func;
 
-            tokensConsumed += func.parse( source.subslice(tokensConsumed) );
+            RULE_PARSE( tokensConsumed, func.parse( source.subslice(tokensConsumed) ) );
             functionDeclarations.emplace_back( std::move(func) );
-
-            skipWS(source, tokensConsumed);
+            ParseMemo::forgetActive();
             continue;
         }
 
@@ -58,20 +261,195 @@ size_t Module::parse(Slice<const Tokenizer::Token> source) {
                 Tokenizer::Tokens::RESERVED_STRUCT,
                 source, tokensConsumed,
                 false);
-        if( currentToken != nullptr ) {
+        if( currentToken ) {
             StructDef strct;
 
-            tokensConsumed += strct.parse( source.subslice(tokensConsumed) );
+            RULE_PARSE( tokensConsumed, strct.parse( source.subslice(tokensConsumed) ) );
             structureDefinitions.emplace_back( std::move(strct) );
-
-            skipWS(source, tokensConsumed);
+            ParseMemo::forgetActive();
             continue;
         }
 
-        throw parser_error("Unidentified statement in global context", source[tokensConsumed].location );
+        RULE_FAIL( unidentifiedDefinition( source[tokensConsumed] ) );
     }
 
     RULE_LEAVE();
 }
 
+bool Module::parseParallel(unsigned threads, bool memoization, size_t maxNestingDepth) {
+    std::vector<Definition> definitions;
+    if( !scanDefinitions( tokens, definitions ) )
+        return false;
+
+    size_t numParts = std::min<size_t>( { threads, tokens.size() / MinTokensPerThread, definitions.size() } );
+    if( numParts<=1 )
+        return false;
+
+    // Each definition is parsed into a slot of its kind's array, so the results keep the source's order
+    std::vector<size_t> slots( definitions.size() );
+    size_t numFunctions = 0, numDeclarations = 0, numStructs = 0;
+    for( size_t i=0; i<definitions.size(); ++i ) {
+        switch( definitions[i].keyword ) {
+        case Tokenizer::Tokens::RESERVED_DEF:
+            slots[i] = numFunctions++;
+            break;
+        case Tokenizer::Tokens::RESERVED_DECL:
+            slots[i] = numDeclarations++;
+            break;
+        case Tokenizer::Tokens::RESERVED_STRUCT:
+            slots[i] = numStructs++;
+            break;
+        default:
+            ABORT() << "Scanned definition starts with " << definitions[i].keyword;
+        }
+    }
+
+    std::vector<FuncDef> functions( numFunctions );
+    std::vector<FuncDecl> declarations( numDeclarations );
+    std::vector<StructDef> structs( numStructs );
+
+    // Split the definitions into consecutive parts of about the same number of tokens. Part i is made of the
+    // definitions from partStarts[i] up to partStarts[i+1].
+    std::vector<size_t> partStarts;
+    for( size_t i=0; i<definitions.size(); ++i ) {
+        if( definitions[i].begin >= tokens.size() * partStarts.size() / numParts )
+            partStarts.push_back( i );
+    }
+    partStarts.push_back( definitions.size() );
+    numParts = partStarts.size()-1;
+
+    // Each part is parsed into its own arena, with its own memo. The arenas share the module arena's pools, so that the
+    // parts' nodes can point at each other once adopted.
+    struct Part {
+        ParseArena arena;
+        ParseMemo::Statistics memoStatistics;
+        Lookahead::Statistics lookaheadStatistics;
+        bool failed = false;
+    };
+    std::vector<Part> parts( numParts );
+    for( Part &part : parts )
+        part.arena = arena.sharingPools();
+
+    auto parsePart = [&]( size_t partIndex ) {
+        Part &part = parts[partIndex];
+        ParseArena::Scope arenaScope( part.arena );
+        Lookahead::Scope lookaheadScope( part.lookaheadStatistics );
+        NestingLimit nestingLimit( maxNestingDepth );
+        ParseMemo memo;
+        std::optional<ParseMemo::Scope> memoScope;
+        if( memoization )
+            memoScope.emplace( memo );
+
+        for( size_t i=partStarts[partIndex]; i<partStarts[partIndex+1]; ++i ) {
+            const Definition &definition = definitions[i];
+            // Give the definition the rest of the module, exactly like the sequential parse does
+            Tokenizer::TokenSlice source = Tokenizer::TokenSlice( tokens ).subslice( definition.begin );
+
+            ParseResult result = 0;
+            switch( definition.keyword ) {
+            case Tokenizer::Tokens::RESERVED_DEF:
+                result = parseFunction( functions[ slots[i] ], source );
+                break;
+            case Tokenizer::Tokens::RESERVED_DECL:
+                result = declarations[ slots[i] ].parse( source );
+                break;
+            case Tokenizer::Tokens::RESERVED_STRUCT:
+                result = structs[ slots[i] ].parse( source );
+                break;
+            default:
+                ABORT() << "Scanned definition starts with " << definition.keyword;
+            }
+            ParseMemo::forgetActive();
+
+            // The scan only guessed where the definition ends. If the parser disagrees, the sequential parse would not
+            // have looked for the next definition where the scan did.
+            if( !result || result.tokensConsumed() != definition.end - definition.begin ) {
+                part.failed = true;
+                break;
+            }
+        }
+
+        part.memoStatistics = memo.getStatistics();
+    };
+
+    WorkerPool::get().run( numParts, parsePart );
+
+    for( const Part &part : parts ) {
+        if( part.failed )
+            return false;
+    }
+
+    ParseArena::Scope arenaScope( arena );
+    for( FuncDef &function : functions )
+        functionDefinitions.emplace_back( std::move(function) );
+    for( FuncDecl &declaration : declarations )
+        functionDeclarations.emplace_back( std::move(declaration) );
+    for( StructDef &strct : structs )
+        structureDefinitions.emplace_back( std::move(strct) );
+
+    for( Part &part : parts ) {
+        arena.adopt( std::move(part.arena) );
+        memoStatistics += part.memoStatistics;
+        lookaheadStatistics += part.lookaheadStatistics;
+    }
+    parsedSlice = tokens;
+
+    return true;
+}
+
+void Module::recoverErrors(size_t maxErrors) {
+    // Failed statements are removed from a copy of the tokens, which is then parsed again. What parses is thrown away.
+    Tokenizer::TokenStream source = tokens;
+    ParseArena scratchArena;
+    ParseArena::Scope arenaScope( scratchArena );
+    // The re-parses are not part of the module's statistics
+    Lookahead::Statistics lookaheadStatistics;
+    Lookahead::Scope lookaheadScope( lookaheadStatistics );
+
+    size_t position = 0;
+    while( position<source.size() && errors.size()<maxErrors ) {
+        Tokenizer::TokenSlice remaining = Tokenizer::TokenSlice( source ).subslice( position );
+        // Memoized regardless of CompilerArguments::parserMemoization, as backtracking through nested blocks without a
+        // memo takes exponential time. Erasing tokens moves the ones after them, so each parse needs a memo of its own.
+        ParseMemo memo;
+        ParseMemo::Scope memoScope( memo );
+
+        ParseResult result = 0;
+        switch( source.kind(position) ) {
+        case Tokenizer::Tokens::RESERVED_DEF:
+            {
+                // Bodies are parsed even if lazyFunctionBodies defers them, or the errors inside them would be missed
+                FuncDef function;
+                result = function.parse( remaining );
+            }
+            break;
+        case Tokenizer::Tokens::RESERVED_DECL:
+            result = FuncDecl().parse( remaining );
+            break;
+        case Tokenizer::Tokens::RESERVED_STRUCT:
+            result = StructDef().parse( remaining );
+            break;
+        default:
+            result = unidentifiedDefinition( Tokenizer::TokenRef( source, position ) );
+            break;
+        }
+
+        if( result ) {
+            position += result.tokensConsumed();
+            continue;
+        }
+
+        // Parsing again without a failed statement may fail at the same place. That is the same error.
+        const ParseError &error = result.getError();
+        if( errors.empty() || errors.back().location!=error.location )
+            errors.push_back( error );
+
+        auto [ begin, end ] = failedStatement( source, position, tokenAt( source, position, error.location ) );
+        if( begin<end )
+            source.erase( begin, end );
+        else
+            position = nextDefinition( source, position );
+    }
+}
+
 } // namespace NonTerminals
@@ -12,19 +12,62 @@
 #include "parser/base.h"
 #include "parser/struct.h"
 #include "parser.h"
+#include "lookahead.h"
+#include "parse_arena.h"
+#include "parser_memo.h"
+#include "parser_trace.h"
 
 namespace NonTerminals {
     struct Module : public NonTerminal {
-        std::vector< FuncDef > functionDefinitions;
-        std::vector< FuncDecl > functionDeclarations;
-        std::vector< StructDef > structureDefinitions;
-        std::vector< Tokenizer::Token > tokens;
+        // Holds all of the module's parse tree, including function bodies parsed after the module. Must be destructed last
+        mutable ParseArena arena;
 
-        void parse(String source);
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ArenaVector< FuncDef > functionDefinitions;
+        ArenaVector< FuncDecl > functionDeclarations;
+        ArenaVector< StructDef > structureDefinitions;
+        // The module's identifiers. Active while the module is parsed, and while its AST is built.
+        mutable SymbolTable symbols;
+        // The parse tree refers to these by index
+        Tokenizer::TokenStream tokens;
+        ParseMemo::Statistics memoStatistics;
+        Lookahead::Statistics lookaheadStatistics;
+        // After parse throws a syntax error, all of the syntax errors found in the source, up to arguments.maxErrors of
+        // them and in source order. The first is the one thrown. Left empty if maxErrors asks for a single error.
+        std::vector< ParseError > errors;
+        // What the parser did, if CompilerArguments::parserTraceRecords asked for a trace
+        std::unique_ptr< ParserTrace::Trace > trace;
+
+        // Tokenize and parse source. This is where parsing errors are thrown as exceptions
+        void parse(
+                String source,
+                const PracticalSemanticAnalyzer::CompilerArguments &arguments =
+                        PracticalSemanticAnalyzer::CompilerArguments());
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
         String getName() const {
             return toSlice("__main");
         }
+
+    private:
+        friend class ParseTreeCache;
+
+        bool lazyFunctionBodies = false;
+
+        // Tokenize and parse source, without looking in the parse tree cache
+        void parseSource(String source, const PracticalSemanticAnalyzer::CompilerArguments &arguments);
+
+        ParseResult parseFunction(FuncDef &function, Tokenizer::TokenSlice source) const {
+            return lazyFunctionBodies ? function.parseDeferringBody( source ) : function.parse( source );
+        }
+
+        // Parse tokens' global definitions on several threads. Gives up, leaving the module untouched, if there is too
+        // little to parse or if anything fails to parse. The sequential parse should then be used, which also reports
+        // the error.
+        bool parseParallel(unsigned threads, bool memoization, size_t maxNestingDepth);
+
+        // Parse tokens again, function bodies included, skipping past each syntax error to the end of its statement or
+        // global definition, so that more errors can be found. Only runs once the module is known to be broken, so a
+        // valid module costs nothing.
+        void recoverErrors(size_t maxErrors);
     };
 } // NonTerminals
 
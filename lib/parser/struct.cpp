@@ -14,23 +14,26 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t StructDef::parse(Slice<const Tokenizer::Token> source) {
+ParseResult StructDef::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    keyword = &expectToken( Tokenizer::Tokens::RESERVED_STRUCT, source, tokensConsumed,
-            "Struct definition must start with the keyword `struct`", "EOF looking for struct definition" );
-    tokensConsumed += identifier.parse( source.subslice(tokensConsumed) );
+    keyword = wishForToken( Tokenizer::Tokens::RESERVED_STRUCT, source, tokensConsumed );
+    if( !keyword ) {
+        RULE_FAIL( unexpectedToken( source, tokensConsumed,
+                    "Struct definition must start with the keyword `struct`", "EOF looking for struct definition" ) );
+    }
+    RULE_PARSE( tokensConsumed, identifier.parse( source.subslice(tokensConsumed) ) );
 
-    expectToken( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed,
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed,
             "Struct definition starts with `{`", "EOF looking for `{` in struct definition" );
 
-    const Tokenizer::Token *closingBracket =
+    Tokenizer::TokenRef closingBracket =
             wishForToken( Tokenizer::Tokens::BRACKET_CURLY_CLOSE, source, tokensConsumed, true );
 
-    while(closingBracket==nullptr) {
+    while(!closingBracket) {
         VariableDefinition def;
-        tokensConsumed += def.parse( source.subslice(tokensConsumed) );
-        expectToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed,
+        RULE_PARSE( tokensConsumed, def.parse( source.subslice(tokensConsumed) ) );
+        RULE_EXPECT_TOKEN( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed,
                 "Struct definitions must end with semicolon", "EOF while defining a struct" );
 
         variables.emplace_back( std::move(def) );
@@ -9,20 +9,21 @@
 #ifndef PARSER_STRUCT_H
 #define PARSER_STRUCT_H
 
+#include "parse_arena.h"
 #include "parser/base.h"
 #include "parser/variable_definition.h"
 
 namespace NonTerminals {
 
 struct StructDef : public NonTerminal {
-    const Tokenizer::Token *keyword = nullptr;
+    Tokenizer::TokenRef keyword;
     Identifier identifier;
-    std::vector<VariableDefinition> variables;
+    ArenaVector<VariableDefinition> variables;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
     SourceLocation getLocation() const {
-        ASSERT(keyword != nullptr) << "Dereferencing an unparsed struct";
-        return keyword->location;
+        ASSERT(keyword) << "Dereferencing an unparsed struct";
+        return keyword.location();
     }
     String getName() const {
         return identifier.getName();
@@ -14,45 +14,47 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-Type::Array::Array( std::unique_ptr< const Type > elementType, const Tokenizer::Token *token ) :
-    elementType( std::move(elementType) ),
+Type::Array::Array( NodeIndex<Type> elementType, Tokenizer::TokenRef token ) :
+    elementType( elementType ),
     token(token)
 {}
 
-size_t Type::parse(Slice<const Tokenizer::Token> source) {
+ParseResult Type::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     Identifier &id = type.emplace<Identifier>();
 
-    tokensConsumed = id.parse( source );
+    RULE_PARSE( tokensConsumed, id.parse( source ) );
 
     bool done=false;
 
     do {
         size_t provisionalyConsumed = 0;
-        const Tokenizer::Token *token = nextToken( source.subslice(tokensConsumed), provisionalyConsumed, nullptr );
+        Tokenizer::TokenRef token = nextToken( source.subslice(tokensConsumed), provisionalyConsumed );
         if( !token )
             break;
 
-        switch( token->token ) {
+        switch( token.kind() ) {
         case Tokenizer::Tokens::BRACKET_SQUARE_OPEN:
             {
-                auto elementType = std::make_unique<Type>();
+                NodeIndex<Type> elementType = ParseArena::makeNode<Type>();
                 elementType->type = std::move(type);
 
-                Array &array = type.emplace< Array >( std::move(elementType), token );
-                provisionalyConsumed += array.dimension.parse( source.subslice(tokensConsumed + provisionalyConsumed) );
-                expectToken(
+                Array &array = type.emplace< Array >( elementType, token );
+                RULE_PARSE(
+                        provisionalyConsumed,
+                        array.dimension.parse( source.subslice(tokensConsumed + provisionalyConsumed) ) );
+                RULE_EXPECT_TOKEN(
                         Tokenizer::Tokens::BRACKET_SQUARE_CLOSE, source.subslice(tokensConsumed), provisionalyConsumed,
                         "Array type with no closing bracket", "Array type with no closing bracket" );
             }
             break;
         case Tokenizer::Tokens::OP_PTR:
             {
-                auto pointedType = std::make_unique<Type>();
+                NodeIndex<Type> pointedType = ParseArena::makeNode<Type>();
                 pointedType->type = std::move(type);
 
-                type.emplace< Pointer >( std::move(pointedType), token );
+                type.emplace< Pointer >( pointedType, token );
             }
             break;
         default:
@@ -78,11 +80,11 @@ SourceLocation Type::getLocation() const {
         }
 
         SourceLocation operator()( const Array &array ) {
-            return array.token->location;
+            return array.token.location();
         }
 
         SourceLocation operator()( const Pointer &ptr ) {
-            return ptr.token->location;
+            return ptr.token.location();
         }
     };
 
@@ -16,24 +16,24 @@ namespace NonTerminals {
 
 struct Type : public NonTerminal {
     struct Array {
-        std::unique_ptr< const Type > elementType;
+        NodeIndex<Type> elementType;
         LiteralInt dimension;
-        const Tokenizer::Token *token = nullptr;
+        Tokenizer::TokenRef token;
 
-        Array( std::unique_ptr< const Type > elementType, const Tokenizer::Token *token );
+        Array( NodeIndex<Type> elementType, Tokenizer::TokenRef token );
     };
 
     struct Pointer {
-        std::unique_ptr< const Type > pointed;
-        const Tokenizer::Token *token = nullptr;
+        NodeIndex<Type> pointed;
+        Tokenizer::TokenRef token;
 
-        Pointer( std::unique_ptr< const Type > pointed, const Tokenizer::Token *token ) :
-            pointed(std::move(pointed)), token(token)
+        Pointer( NodeIndex<Type> pointed, Tokenizer::TokenRef token ) :
+            pointed(pointed), token(token)
         {}
     };
     std::variant<std::monostate, Identifier, Array, Pointer> type;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
     SourceLocation getLocation() const;
 };
 
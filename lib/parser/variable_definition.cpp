@@ -16,37 +16,38 @@ namespace NonTerminals {
 
 using namespace InternalNonTerminals;
 
-size_t VariableDeclBody::parse(Slice<const Tokenizer::Token> source) {
+ParseResult VariableDeclBody::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    tokensConsumed += name.parse(source);
-    expectToken( Tokenizer::Tokens::OP_COLON, source, tokensConsumed, "Expected \":\" after variable name", "Unexpected EOF" );
-    tokensConsumed += type.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, name.parse(source) );
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::OP_COLON, source, tokensConsumed, "Expected \":\" after variable name", "Unexpected EOF" );
+    RULE_PARSE( tokensConsumed, type.parse( source.subslice(tokensConsumed) ) );
 
     RULE_LEAVE();
 }
 
-size_t VariableDefinition::parse(Slice<const Tokenizer::Token> source) {
+ParseResult VariableDefinition::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
-    expectToken( Tokenizer::Tokens::RESERVED_DEF, source, tokensConsumed, "Variable definition does not start with def keyword",
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::RESERVED_DEF, source, tokensConsumed, "Variable definition does not start with def keyword",
             "Unexpected EOF" );
 
-    tokensConsumed += body.parse(source.subslice(tokensConsumed));
+    RULE_PARSE( tokensConsumed, body.parse(source.subslice(tokensConsumed)) );
 
-    try {
-        size_t provisionalConsumed = tokensConsumed;
-
-        expectToken( Tokenizer::Tokens::OP_ASSIGN, source, provisionalConsumed, "", "" );
-
-        // XXX parse outside the catch
+    size_t provisionalConsumed = tokensConsumed;
+    if( wishForToken( Tokenizer::Tokens::OP_ASSIGN, source, provisionalConsumed ) ) {
+        // XXX A bad initial value should be reported as such, rather than as a missing semicolon
         Expression initValue;
-        provisionalConsumed += initValue.parse( source.subslice(provisionalConsumed) );
-
-        this->initValue = safenew<Expression>( std::move(initValue) );
-        tokensConsumed = provisionalConsumed;
-    } catch( parser_error &err ) {
-        EXCEPTION_CAUGHT(err);
+        ParseResult result = initValue.parse( source.subslice(provisionalConsumed) );
+
+        if( result ) {
+            this->initValue = ParseArena::makeNode<Expression>( std::move(initValue) );
+            tokensConsumed = provisionalConsumed + result.tokensConsumed();
+        } else {
+            RULE_BACKTRACK( result );
+        }
     }
 
     RULE_LEAVE();
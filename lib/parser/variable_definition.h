@@ -12,8 +12,6 @@
 #include "parser/base.h"
 #include "parser/type.h"
 
-#include <memory>
-
 namespace NonTerminals {
 
 struct Expression;
@@ -22,14 +20,14 @@ struct VariableDeclBody : public NonTerminal {
     Identifier name;
     Type type;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
 };
 
 struct VariableDefinition : public NonTerminal {
     VariableDeclBody body;
-    std::unique_ptr<Expression> initValue;
+    NodeIndex<Expression> initValue;
 
-    size_t parse(Slice<const Tokenizer::Token> source) override final;
+    ParseResult parse(Tokenizer::TokenSlice source) override final;
 };
 
 } // NonTerminals
@@ -0,0 +1,261 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "dummy_codegen_impl.h"
+
+#include "ast/ast.h"
+#include "parse_tree_cache.h"
+#include "parser/module.h"
+#include "token_stream.h"
+
+#include "bench/bench.h"
+#include "ut/nested_source.h"
+
+#include <practical/errors.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace {
+
+// Generate a module whose functions are mostly long arithmetic and logical expressions
+std::string expressionHeavySource( size_t numFunctions ) {
+    static const char *statements[] = {
+        "result = a + b * c - d / 2;",
+        "result = ( a << 2 ) + ( b >> 1 ) * ( c - 1 ) % 7;",
+        "flag = a < b && b <= c || !( c == d ) && a != 0;",
+        "result += f( a, b + 1, c * 2 ) - f( d, -a, ~b );",
+        "result = expect!U32( a ) * expect!U32( b + c );",
+        "x;",
+        "42;",
+    };
+    static constexpr size_t NumStatements = sizeof(statements)/sizeof(statements[0]);
+
+    std::ostringstream source;
+    for( size_t i=0; i<numFunctions; ++i ) {
+        source << "def func" << i << "( a : U32, b : U32, c : U32, d : U32 ) -> U32 {\n";
+        for( size_t j=0; j<16; ++j )
+            source << "    " << statements[ (i+j) % NumStatements ] << "\n";
+        source << "    result\n}\n\n";
+    }
+
+    return source.str();
+}
+
+} // Anonymous namespace
+
+BENCHMARK(expressions) {
+    static constexpr size_t NumFunctions = 2000;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    auto tokens = Tokenizer::TokenStream::tokenize( String( sourceText ) );
+
+    double time = Bench::measure( [&]() {
+                NonTerminals::Module module;
+                NonTerminals::ParseMemo memo;
+                NonTerminals::ParseMemo::Scope memoScope( memo );
+
+                NonTerminals::ParseResult result = module.parse( tokens );
+                if( !result ) {
+                    std::cerr << "Benchmark source failed to parse: " << result.getError().msg << "\n";
+                    abort();
+                }
+                Bench::doNotOptimize( module );
+            } );
+
+    Bench::report( "parse (expression heavy)", time, tokens.size(), "token" );
+}
+
+BENCHMARK(parallelParse) {
+    static constexpr size_t NumFunctions = 2000;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    size_t numTokens = Tokenizer::TokenStream::tokenize( String( sourceText ) ).size();
+
+    for( unsigned threads : { 1, 0 } ) {
+        PracticalSemanticAnalyzer::CompilerArguments arguments;
+        arguments.parserThreads = threads;
+
+        double time = Bench::measure( [&]() {
+                    NonTerminals::Module module;
+                    module.parse( String( sourceText ), arguments );
+                    Bench::doNotOptimize( module );
+                } );
+
+        Bench::report(
+                threads==1 ? "tokenize+parse, 1 thread" : "tokenize+parse, parser thread per core",
+                time, numTokens, "token" );
+    }
+}
+
+BENCHMARK(lazyFunctionBodies) {
+    static constexpr size_t NumFunctions = 2000;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    size_t numTokens = Tokenizer::TokenStream::tokenize( String( sourceText ) ).size();
+
+    for( bool lazy : { false, true } ) {
+        PracticalSemanticAnalyzer::CompilerArguments arguments;
+        arguments.lazyFunctionBodies = lazy;
+
+        // Only the declarations are looked at, like a pass that collects the module's symbols would
+        double time = Bench::measure( [&]() {
+                    NonTerminals::Module module;
+                    module.parse( String( sourceText ), arguments );
+                    Bench::doNotOptimize( module.functionDefinitions.back().decl );
+                } );
+
+        Bench::report(
+                lazy ? "tokenize+parse declarations, lazy bodies" : "tokenize+parse declarations, eager bodies",
+                time, numTokens, "token" );
+    }
+}
+
+BENCHMARK(parseTreeTeardown) {
+    static constexpr size_t NumFunctions = 2000;
+    static constexpr unsigned Repetitions = 5;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    auto tokens = Tokenizer::TokenStream::tokenize( String( sourceText ) );
+
+    // Each repetition destroys a different tree, so parse all of them up front
+    std::vector< std::unique_ptr<NonTerminals::Module> > modules;
+    for( unsigned i=0; i<Repetitions; ++i ) {
+        auto &module = modules.emplace_back( safenew<NonTerminals::Module>() );
+        NonTerminals::ParseResult result = module->parse( tokens );
+        if( !result ) {
+            std::cerr << "Benchmark source failed to parse: " << result.getError().msg << "\n";
+            abort();
+        }
+    }
+
+    double time = Bench::measure( [&]() {
+                modules.pop_back();
+            }, Repetitions );
+
+    Bench::report( "parse tree teardown (expression heavy)", time, tokens.size(), "token" );
+}
+
+BENCHMARK(deepNesting) {
+    static constexpr size_t Depth = 100000;
+
+    struct Shape {
+        const char *name, *open, *close;
+        // Nested parentheses are deeper than the nesting limit allows past parsing
+        const char *compileName;
+    };
+    static const Shape shapes[] = {
+        { "parse 100k nested parentheses", "(", ")", nullptr },
+        { "parse 100k long operator chain", "x + ", "", "compile 100k long operator chain" },
+    };
+
+    for( const Shape &shape : shapes ) {
+        std::string sourceText = UT::nested( shape.open, "x", shape.close, Depth );
+
+        auto tokens = Tokenizer::TokenStream::tokenize( String( sourceText ) );
+
+        double time = Bench::measure( [&]() {
+                    NonTerminals::Module module;
+                    NonTerminals::ParseResult result = module.parse( tokens );
+                    if( !result ) {
+                        std::cerr << "Benchmark source failed to parse: " << result.getError().msg << "\n";
+                        abort();
+                    }
+                    Bench::doNotOptimize( module );
+                } );
+
+        Bench::report( shape.name, time, tokens.size(), "token" );
+
+        if( shape.compileName==nullptr )
+            continue;
+
+        prepareDummyCodeGen();
+
+        PracticalSemanticAnalyzer::CompilerArguments arguments;
+        NonTerminals::Module module;
+        module.parse( String( sourceText ), arguments );
+
+        DummyModuleGen moduleGen;
+        time = Bench::measure( [&]() {
+                    try {
+                        AST::AST ast;
+                        ast.codeGen( module, &moduleGen, arguments );
+                    } catch( PracticalSemanticAnalyzer::compile_error &error ) {
+                        std::cerr << "Benchmark source failed to compile: " << error.what() << "\n";
+                        abort();
+                    }
+                } );
+
+        Bench::report( shape.compileName, time, tokens.size(), "token" );
+    }
+}
+
+BENCHMARK(parserTrace) {
+    static constexpr size_t NumFunctions = 2000;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    size_t numTokens = Tokenizer::TokenStream::tokenize( String( sourceText ) ).size();
+
+    for( size_t records : { 0, 64*1024 } ) {
+        PracticalSemanticAnalyzer::CompilerArguments arguments;
+        arguments.parserTraceRecords = records;
+
+        double time = Bench::measure( [&]() {
+                    NonTerminals::Module module;
+                    module.parse( String( sourceText ), arguments );
+                    Bench::doNotOptimize( module );
+                } );
+
+        Bench::report( records==0 ? "tokenize+parse, untraced" : "tokenize+parse, traced", time, numTokens, "token" );
+    }
+}
+
+BENCHMARK(parseTreeCache) {
+    static constexpr size_t NumFunctions = 2000;
+
+    std::string sourceText = expressionHeavySource( NumFunctions );
+    size_t numTokens = Tokenizer::TokenStream::tokenize( String( sourceText ) ).size();
+
+    char directory[] = "/tmp/parser_bench.XXXXXX";
+    if( mkdtemp( directory )==nullptr )
+        return;
+
+    PracticalSemanticAnalyzer::CompilerArguments arguments;
+    double time = Bench::measure( [&]() {
+                NonTerminals::Module module;
+                module.parse( String( sourceText ), arguments );
+                Bench::doNotOptimize( module );
+            } );
+    Bench::report( "tokenize+parse", time, numTokens, "token" );
+
+    arguments.parseTreeCache = directory;
+    {
+        NonTerminals::Module module;
+        module.parse( String( sourceText ), arguments );
+    }
+    struct stat entryStat;
+    if( stat( NonTerminals::ParseTreeCache::entryPath( String( sourceText ), arguments ).c_str(), &entryStat )==0 ) {
+        Bench::reportSize( "cache entry size", entryStat.st_size, numTokens, "token" );
+        Bench::reportSize( "cache entry size", entryStat.st_size, sourceText.size(), "source byte" );
+    }
+    time = Bench::measure( [&]() {
+                NonTerminals::Module module;
+                module.parse( String( sourceText ), arguments );
+                Bench::doNotOptimize( module );
+            } );
+    Bench::report( "cache load", time, numTokens, "token" );
+
+    std::string command = std::string("rm -rf ") + directory;
+    if( system( command.c_str() )!=0 )
+        std::cerr << "Failed to remove " << directory << "\n";
+}
@@ -2,100 +2,71 @@
 
 #include <practical/errors.h>
 
-#if VERBOSE_PARSING
-size_t PARSER_RECURSION_DEPTH;
-#endif
-
 namespace InternalNonTerminals {
 
-bool skipWS(Slice<const Tokenizer::Token> source, size_t &index) {
-    bool moved = false;
-
-    while( index<source.size() &&
-            (source[index].token == Tokenizer::Tokens::WS || source[index].token == Tokenizer::Tokens::COMMENT_LINE_END ||
-             source[index].token == Tokenizer::Tokens::COMMENT_MULTILINE) )
-    {
-        index++;
-        moved = true;
-    }
-
-    return moved;
-}
-
-// Consumes the next token, optionally reporting EOF
-const Tokenizer::Token *nextToken(Slice<const Tokenizer::Token> source, size_t &index, const char *msg) {
-    skipWS(source, index);
+// Consumes the next token. Returns a null token at EOF
+Tokenizer::TokenRef nextToken(Tokenizer::TokenSlice source, size_t &index) {
+    if( index==source.size() )
+        return Tokenizer::TokenRef();
 
-    if( index==source.size() ) {
-        if( msg==nullptr )
-            return nullptr;
-        else
-            throw parser_error(msg, SourceLocation());
-    }
-
-    return &source[index++];
+    return source[index++];
 }
 
-const Tokenizer::Token &expectToken(
-        Tokenizer::Tokens expected, Slice<const Tokenizer::Token> source, size_t &index, const char *mismatchMsg,
-        const char *eofMsg)
+ParseError unexpectedToken(
+        Tokenizer::TokenSlice source, size_t index, const char *mismatchMsg, const char *eofMsg)
 {
-    if( eofMsg==nullptr )
-        eofMsg=mismatchMsg;
-
-    const Tokenizer::Token *currentToken = nextToken( source, index, eofMsg );
-    ASSERT( currentToken!=nullptr ) << "Unexpected EOF condition when searching for token";
+    if( index>=source.size() )
+        return ParseError{ .msg = eofMsg!=nullptr ? eofMsg : mismatchMsg, .location = SourceLocation() };
 
-    if( currentToken->token!=expected ) {
-        index--;
-        throw parser_error(mismatchMsg, currentToken->location);
-    }
+    return ParseError{ .msg = mismatchMsg, .location = source[index].location() };
+}
 
-    return *currentToken;
+ParseError nestingTooDeep(Tokenizer::TokenSlice source) {
+    return ParseError{
+            .msg = "Nesting too deep",
+            .location = source.size()>0 ? source[0].location() : SourceLocation(),
+            .kind = ParseError::Kind::NestingTooDeep };
 }
 
-const Tokenizer::Token *wishForToken(
+Tokenizer::TokenRef wishForToken(
         Tokenizer::Tokens expected,
-        Slice<const Tokenizer::Token> source,
+        Tokenizer::TokenSlice source,
         size_t &index,
         bool consumeTokens)
 {
-    size_t indexCopy = index;
-    skipWS( source, indexCopy );
-
-    if( indexCopy>=source.size() ) {
-        return nullptr;
+    if( index>=source.size() ) {
+        return Tokenizer::TokenRef();
     }
 
-    if( source[indexCopy].token == expected ) {
-        const Tokenizer::Token *ret = &source[indexCopy];
+    if( source.kind(index) == expected ) {
+        Tokenizer::TokenRef ret = source[index];
 
         if( consumeTokens )
-            index = indexCopy + 1;
+            index++;
 
         return ret;
     }
 
-    return nullptr;
+    return Tokenizer::TokenRef();
 }
 
-size_t ExpressionOrStatement::parse(Slice<const Tokenizer::Token> source) {
+ParseResult ExpressionOrStatement::parse(Tokenizer::TokenSlice source) {
     RULE_ENTER(source);
 
     if( wishForToken( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed, false ) ) {
         CompoundExpressionOrStatement parsed;
-        tokensConsumed = parsed.parse(source);
+        RULE_PARSE( tokensConsumed, parsed.parse(source) );
 
         if( parsed.isStatement() )
-            content.emplace<Statement>( safenew<CompoundStatement>(parsed.removeStatement()) );
+            content.emplace<Statement>( ParseArena::makeNode<CompoundStatement>(parsed.removeStatement()) );
         else
-            content.emplace<NonTerminals::Expression>( safenew<CompoundExpression>(parsed.removeExpression()) );
+            content.emplace<NonTerminals::Expression>( ParseArena::makeNode<CompoundExpression>(parsed.removeExpression()) );
 
         RULE_LEAVE();
     }
 
     Expression expression;
-    tokensConsumed = expression.parse(source);
+    RULE_PARSE( tokensConsumed, expression.parse(source) );
 
     if( wishForToken( Tokenizer::Tokens::SEMICOLON, source, tokensConsumed ) )
         content.emplace<Statement>( std::move(expression) );
@@ -105,30 +76,32 @@ size_t ExpressionOrStatement::parse(Slice<const Tokenizer::Token> source) {
     RULE_LEAVE();
 }
 
-size_t ConditionalExpressionOrStatement::parse(Slice<const Tokenizer::Token> source ) {
+ParseResult ConditionalExpressionOrStatement::parse(Tokenizer::TokenSlice source ) {
     return parse( source, ExpectedResult::Unknown );
 }
 
-size_t ConditionalExpressionOrStatement::parse(Slice<const Tokenizer::Token> source, ExpectedResult result ) {
+ParseResult ConditionalExpressionOrStatement::parse(Tokenizer::TokenSlice source, ExpectedResult result ) {
     RULE_ENTER(source);
 
-    auto ifToken = expectToken(
-            Tokenizer::Tokens::RESERVED_IF, source, tokensConsumed,
-            "Condition must start with 'if'", "EOF searching for condition" );
+    Tokenizer::TokenRef ifToken = wishForToken( Tokenizer::Tokens::RESERVED_IF, source, tokensConsumed );
+    if( !ifToken )
+        RULE_FAIL( unexpectedToken(
+                    source, tokensConsumed, "Condition must start with 'if'", "EOF searching for condition" ) );
 
     Expression condition;
 
-    expectToken( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed, "Expecting '(' after if" );
-    tokensConsumed += condition.parse( source.subslice(tokensConsumed) );
-    expectToken( Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Expecting ')' at end of condition" );
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_ROUND_OPEN, source, tokensConsumed, "Expecting '(' after if" );
+    RULE_PARSE( tokensConsumed, condition.parse( source.subslice(tokensConsumed) ) );
+    RULE_EXPECT_TOKEN(
+            Tokenizer::Tokens::BRACKET_ROUND_CLOSE, source, tokensConsumed, "Expecting ')' at end of condition" );
 
     ExpressionOrStatement ifClause;
-    tokensConsumed += ifClause.parse( source.subslice(tokensConsumed) );
+    RULE_PARSE( tokensConsumed, ifClause.parse( source.subslice(tokensConsumed) ) );
 
-    std::unique_ptr<ExpressionOrStatement> elseClause;
+    ExpressionOrStatement *elseClause = nullptr;
     if( wishForToken(Tokenizer::Tokens::RESERVED_ELSE, source, tokensConsumed) ) {
-        elseClause = safenew<ExpressionOrStatement>();
-        tokensConsumed += elseClause->parse( source.subslice(tokensConsumed) );
+        elseClause = ParseArena::make<ExpressionOrStatement>();
+        RULE_PARSE( tokensConsumed, elseClause->parse( source.subslice(tokensConsumed) ) );
     }
 
     if( result==ExpectedResult::Unknown )
@@ -139,33 +112,38 @@ size_t ConditionalExpressionOrStatement::parse(Slice<const Tokenizer::Token> sou
     case ExpectedResult::Statement:
         {
             if( ! ifClause.isStatement() )
-                throw parser_error(
-                        "condition must have statement (not expression) as \"then\" clause", ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "condition must have statement (not expression) as \"then\" clause",
+                        .location = ifToken.location() } );
 
             if( elseClause && !elseClause->isStatement() )
-                throw parser_error(
-                        "condition must have statement (not expression) as \"else\" clause", ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "condition must have statement (not expression) as \"else\" clause",
+                        .location = ifToken.location() } );
 
             auto &statement=this->condition.emplace<Statement::ConditionalStatement>();
-            statement.condition=std::move(condition);
-            statement.ifClause = safenew<Statement>( ifClause.removeStatement() );
+            statement.condition = ParseArena::makeNode<Expression>( std::move(condition) );
+            statement.ifClause = ParseArena::makeNode<Statement>( ifClause.removeStatement() );
             if( elseClause )
-                statement.elseClause = safenew<Statement>( elseClause->removeStatement() );
+                statement.elseClause = ParseArena::makeNode<Statement>( elseClause->removeStatement() );
         }
         break;
     case ExpectedResult::Expression:
         {
             if( ifClause.isStatement() )
-                throw parser_error(
-                        "condition must have expression (not statement) as \"then\" clause", ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "condition must have expression (not statement) as \"then\" clause",
+                        .location = ifToken.location() } );
 
             if( !elseClause )
-                throw parser_error(
-                        "conditional expression must have an \"else\" clause", ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "conditional expression must have an \"else\" clause",
+                        .location = ifToken.location() } );
 
             if( elseClause->isStatement() )
-                throw parser_error(
-                        "condition must have expression (not statement) as \"else\" clause", ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "condition must have expression (not statement) as \"else\" clause",
+                        .location = ifToken.location() } );
 
             auto &expression = this->condition.emplace<ConditionalExpression>();
             expression.condition = std::move(condition);
@@ -173,13 +151,13 @@ size_t ConditionalExpressionOrStatement::parse(Slice<const Tokenizer::Token> sou
             expression.elseClause = elseClause->removeExpression();
 
             if(
-                    ! std::get_if< std::unique_ptr<CompoundExpression> >(& expression.ifClause.value) ||
-                    ! std::get_if< std::unique_ptr<CompoundExpression> >(& expression.elseClause.value)
+                    ! std::get_if< NodeIndex<CompoundExpression> >(& expression.ifClause.value) ||
+                    ! std::get_if< NodeIndex<CompoundExpression> >(& expression.elseClause.value)
               )
             {
-                throw parser_error(
-                        "Conditional expression must use compound expressions for \"then\" and \"else\" clauses",
-                        ifToken.location);
+                RULE_FAIL( ParseError{
+                        .msg = "Conditional expression must use compound expressions for \"then\" and \"else\" clauses",
+                        .location = ifToken.location() } );
             }
         }
         break;
@@ -205,31 +183,37 @@ CompoundExpression CompoundExpressionOrStatement::removeExpression() {
     return CompoundExpression( std::move( std::get<CompoundExpression>(content) ) );
 }
 
-size_t CompoundExpressionOrStatement::parseInternal(Slice<const Tokenizer::Token> source, ParseType parseType) {
+ParseResult CompoundExpressionOrStatement::parseInternal(Tokenizer::TokenSlice source, ParseType parseType) {
     RULE_ENTER(source);
 
-    expectToken( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed, "Expected {",
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_CURLY_OPEN, source, tokensConsumed, "Expected {",
             "EOF while parsing compound statement" );
 
     StatementList statementList;
-    tokensConsumed += statementList.parse(source.subslice(tokensConsumed));
+    RULE_PARSE( tokensConsumed, statementList.parse(source.subslice(tokensConsumed)) );
 
-    try {
-        if( parseType!=ParseType::Statement ) {
-            Expression expression;
-            tokensConsumed += expression.parse(source.subslice(tokensConsumed));
+    if( parseType==ParseType::Either && !Lookahead::canStart( Lookahead::Rule::Expression, source, tokensConsumed ) ) {
+        Lookahead::predicted();
+        parseType = ParseType::Statement;
+    }
 
+    if( parseType!=ParseType::Statement ) {
+        Expression expression;
+        ParseResult result = expression.parse(source.subslice(tokensConsumed));
+
+        if( result ) {
+            tokensConsumed += result.tokensConsumed();
             parseType=ParseType::Expression;
 
             content.emplace<CompoundExpression>( std::move(statementList), std::move(expression) );
-        }
-    } catch( parser_error &err ) {
-        if( parseType==ParseType::Expression )
-            throw;
+        } else {
+            if( parseType==ParseType::Expression )
+                RULE_FAIL( result.getError() );
 
-        EXCEPTION_CAUGHT(err);
+            RULE_BACKTRACK( result );
 
-        parseType = ParseType::Statement;
+            parseType = ParseType::Statement;
+        }
     }
 
     ASSERT( parseType!=ParseType::Either );
@@ -237,7 +221,7 @@ size_t CompoundExpressionOrStatement::parseInternal(Slice<const Tokenizer::Token
         content.emplace<CompoundStatement>( std::move(statementList) );
     }
 
-    expectToken( Tokenizer::Tokens::BRACKET_CURLY_CLOSE, source, tokensConsumed, "Expected }",
+    RULE_EXPECT_TOKEN( Tokenizer::Tokens::BRACKET_CURLY_CLOSE, source, tokensConsumed, "Expected }",
             "Unmatched {" );
 
     RULE_LEAVE();
@@ -9,41 +9,53 @@
 #ifndef PARSER_INTERNAL_H
 #define PARSER_INTERNAL_H
 
+#include "lookahead.h"
 #include "parser.h"
+#include "parser_trace.h"
 
-#if VERBOSE_PARSING
-extern size_t PARSER_RECURSION_DEPTH;
-
+// Every rule starts with RULE_ENTER and returns through RULE_LEAVE or RULE_FAIL. These record the rule into the parser
+// trace active on the current thread, if there is one.
 #define RULE_ENTER(source) \
-    size_t RECURSION_CURRENT_DEPTH = PARSER_RECURSION_DEPTH++; \
-    for( size_t I=0; I<RECURSION_CURRENT_DEPTH; ++I ) std::cout<<"  "; \
-    if( source.size()>0 ) \
-        std::cout<<"Processing " << __PRETTY_FUNCTION__ << " of " << source[0].token << " at " << source[0].location << "\n" ;\
-    else\
-        std::cout<<"Processing " << __PRETTY_FUNCTION__ << " at EOF\n" ;\
+    static ParserTrace::RuleSite RULE_TRACE_SITE( __PRETTY_FUNCTION__ ); \
+    ParserTrace::record( RULE_TRACE_SITE, ParserTrace::Event::Enter, source ); \
     size_t tokensConsumed = 0
 
 #define RULE_LEAVE() \
-    PARSER_RECURSION_DEPTH = RECURSION_CURRENT_DEPTH; \
-    for( size_t I=0; I<RECURSION_CURRENT_DEPTH; ++I ) std::cout<<"  "; \
-    std::cout<<"Leaving " << __PRETTY_FUNCTION__ << " consumed " << tokensConsumed << "\n"; \
-    this->parsedSlice = source.subslice(0, tokensConsumed); \
-    return tokensConsumed
-
-#define EXCEPTION_CAUGHT(ex) \
-    PARSER_RECURSION_DEPTH = RECURSION_CURRENT_DEPTH + 1; \
-    for( size_t I=0; I<RECURSION_CURRENT_DEPTH; ++I ) std::cout<<"  "; \
-    std::cout<< __PRETTY_FUNCTION__ << " caught " << ex.what() << "\n"
-
-#else
-
-#define RULE_ENTER(source) size_t tokensConsumed = 0
-#define RULE_LEAVE() \
+    ParserTrace::record( RULE_TRACE_SITE, ParserTrace::Event::Leave, source, tokensConsumed ); \
     this->parsedSlice = source.subslice(0, tokensConsumed); \
     return tokensConsumed
-#define EXCEPTION_CAUGHT(ex)
 
-#endif
+#define RULE_FAIL(...) \
+    do { \
+        ParserTrace::record( RULE_TRACE_SITE, ParserTrace::Event::Fail, source ); \
+        return ParseResult( __VA_ARGS__ ); \
+    } while(false)
+
+// Run a sub-rule's parse and add the tokens it consumed to counter. If the sub-rule failed, so does the current rule.
+#define RULE_PARSE(counter, parseCall) \
+    do { \
+        ParseResult RULE_PARSE_RESULT = (parseCall); \
+        if( !RULE_PARSE_RESULT ) \
+            RULE_FAIL( RULE_PARSE_RESULT.getError() ); \
+        counter += RULE_PARSE_RESULT.tokensConsumed(); \
+    } while(false)
+
+// Consume a token of the expected type. If the next token is anything else, the current rule fails.
+#define RULE_EXPECT_TOKEN(expected, tokens, index, ...) \
+    do { \
+        if( !wishForToken( expected, tokens, index ) ) \
+            RULE_FAIL( unexpectedToken( tokens, index, __VA_ARGS__ ) ); \
+    } while(false)
+
+// Give up on an alternative that failed to parse, so that the current rule can try the next one. Only syntax errors
+// can be recovered from this way. Any other error fails the current rule as well.
+#define RULE_BACKTRACK(result) \
+    do { \
+        if( !(result).getError().isSyntax() ) \
+            RULE_FAIL( (result).getError() ); \
+        Lookahead::backtracked(); \
+        ParserTrace::record( RULE_TRACE_SITE, ParserTrace::Event::Backtrack, source ); \
+    } while(false)
 
 namespace InternalNonTerminals {
     using namespace NonTerminals;
@@ -54,22 +66,23 @@ namespace InternalNonTerminals {
         Expression,
     };
 
-    bool skipWS(Slice<const Tokenizer::Token> source, size_t &index);
-    const Tokenizer::Token *nextToken(Slice<const Tokenizer::Token> source, size_t &index, const char *msg = nullptr);
-    const Tokenizer::Token &expectToken(
-            Tokenizer::Tokens expected, Slice<const Tokenizer::Token> source, size_t &index, const char *mismatchMsg,
-            const char *eofMsg = nullptr);
+    Tokenizer::TokenRef nextToken(Tokenizer::TokenSlice source, size_t &index);
+    // The error to report when the token at index is not the one expected (or there is no token at index)
+    ParseError unexpectedToken(
+            Tokenizer::TokenSlice source, size_t index, const char *mismatchMsg, const char *eofMsg = nullptr);
+    // The error to report when a rule starting at source is nested deeper than NestingLimit allows
+    ParseError nestingTooDeep(Tokenizer::TokenSlice source);
 
-    const Tokenizer::Token *wishForToken(
+    Tokenizer::TokenRef wishForToken(
             Tokenizer::Tokens expected,
-            Slice<const Tokenizer::Token> source,
+            Tokenizer::TokenSlice source,
             size_t &index,
             bool consumeTokens = true);
 
     struct ExpressionOrStatement : public NonTerminal {
         std::variant<std::monostate, Expression, Statement> content;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
 
         bool isStatement() const {
             ASSERT( content.index()!=0 )<<
@@ -96,8 +109,8 @@ namespace InternalNonTerminals {
                 Statement::ConditionalStatement
             > condition;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final;
-        size_t parse(Slice<const Tokenizer::Token> source, ExpectedResult result);
+        ParseResult parse(Tokenizer::TokenSlice source) override final;
+        ParseResult parse(Tokenizer::TokenSlice source, ExpectedResult result);
 
         bool isStatement() const {
             ASSERT( condition.index()!=0 )<<
@@ -116,13 +129,13 @@ namespace InternalNonTerminals {
     struct CompoundExpressionOrStatement : public NonTerminal {
         std::variant<std::monostate, CompoundExpression, CompoundStatement> content;
 
-        size_t parse(Slice<const Tokenizer::Token> source) override final {
+        ParseResult parse(Tokenizer::TokenSlice source) override final {
             return parseInternal(source, ParseType::Either);
         }
-        size_t parseExpression(Slice<const Tokenizer::Token> source) {
+        ParseResult parseExpression(Tokenizer::TokenSlice source) {
             return parseInternal(source, ParseType::Expression);
         }
-        size_t parseStatement(Slice<const Tokenizer::Token> source) {
+        ParseResult parseStatement(Tokenizer::TokenSlice source) {
             return parseInternal(source, ParseType::Statement);
         }
 
@@ -132,7 +145,7 @@ namespace InternalNonTerminals {
 
     private:
         enum class ParseType { Either, Statement, Expression };
-        size_t parseInternal(Slice<const Tokenizer::Token> source, ParseType parseType);
+        ParseResult parseInternal(Tokenizer::TokenSlice source, ParseType parseType);
     };
 } // InternalNonTerminals
 
@@ -0,0 +1,94 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class ParserLazyTest : public CppUnit::TestFixture  {
+    static void parse(NonTerminals::Module &module, const std::string &source) {
+        UT::parse( module, source, UT::arguments( &UT::CompilerArguments::lazyFunctionBodies, true ) );
+    }
+
+    void bodyParsedOnAccess() {
+        std::string source =
+                "def f( x : U32 ) -> U32 { x + 1 }\n"
+                "def g( x : U32 ) -> U32 { if( x>3 ) { f( x ); } }\n"
+                "struct Point {\n    def x : S32;\n}\n";
+
+        NonTerminals::Module module;
+        parse( module, source );
+
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==2 );
+        CPPUNIT_ASSERT( module.structureDefinitions.size()==1 );
+        CPPUNIT_ASSERT( module.functionDefinitions[1].getName()==toSlice("g") );
+        // The whole definition is accounted for, even though the body was not parsed
+        CPPUNIT_ASSERT( module.functionDefinitions[1].getNTTokens().size()==24 );
+
+        NonTerminals::ParseArena::Scope arenaScope( module.arena );
+        const auto &expressionBody = module.functionDefinitions[0].getBody();
+        CPPUNIT_ASSERT( std::holds_alternative<NonTerminals::CompoundExpression>( expressionBody ) );
+        CPPUNIT_ASSERT( &module.functionDefinitions[0].getBody() == &expressionBody );
+        CPPUNIT_ASSERT( std::holds_alternative<NonTerminals::CompoundStatement>(
+                    module.functionDefinitions[1].getBody() ) );
+    }
+
+    void errorOnAccess() {
+        std::string source =
+                "def good() -> U32 { 3 }\n"
+                "def broken() -> U32 { 3 + }\n";
+
+        NonTerminals::Module module;
+        parse( module, source );
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==2 );
+
+        NonTerminals::ParseArena::Scope arenaScope( module.arena );
+        module.functionDefinitions[0].getBody();
+        UT::expectThrow<PracticalSemanticAnalyzer::parser_error>(
+                [&]() { module.functionDefinitions[1].getBody(); }, "Broken body parsed without errors" );
+    }
+
+    void mismatchedBracketError() {
+        std::string source =
+                "def f() -> U32 {\n"
+                "    3 )\n"
+                "}\n"
+                "def g() -> U32 { 4 }\n";
+
+        NonTerminals::Module eager, lazy;
+        std::string eagerError = UT::expectThrow<PracticalSemanticAnalyzer::parser_error>(
+                [&]() { UT::parse( eager, source ); }, "Mismatched brackets parsed without errors" ).what();
+        std::string lazyError = UT::expectThrow<PracticalSemanticAnalyzer::parser_error>(
+                [&]() { parse( lazy, source ); }, "Mismatched brackets parsed lazily without errors" ).what();
+
+        // A body whose brackets do not match is parsed right away, so the error is the same
+        CPPUNIT_ASSERT_EQUAL( eagerError, lazyError );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserLazyTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserLazyTest>(
+                    "bodyParsedOnAccess",
+                    &ParserLazyTest::bodyParsedOnAccess ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserLazyTest>(
+                    "errorOnAccess",
+                    &ParserLazyTest::errorOnAccess ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserLazyTest>(
+                    "mismatchedBracketError",
+                    &ParserLazyTest::mismatchedBracketError ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserLazyTest );
@@ -0,0 +1,47 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parser_memo.h"
+
+#include <algorithm>
+
+namespace NonTerminals {
+
+ParseMemo::Scope::Scope(ParseMemo &memo) : previous(active) {
+    active = &memo;
+}
+
+ParseMemo::Scope::~Scope() {
+    active = previous;
+}
+
+ParseMemo::Speculation::Speculation(ParseMemo *memo, Speculative speculative) :
+    memo(memo), previous(memo->speculative)
+{
+    memo->speculative = speculative;
+}
+
+ParseMemo::Speculation::Speculation(Speculative speculative) : memo(active) {
+    if( memo==nullptr )
+        return;
+
+    previous = memo->speculative;
+    memo->speculative = std::max( previous, speculative );
+}
+
+ParseMemo::Speculation::~Speculation() {
+    if( memo!=nullptr )
+        memo->speculative = previous;
+}
+
+void ParseMemo::forgetActive() {
+    if( active!=nullptr )
+        active->entries.clear();
+}
+
+} // namespace NonTerminals
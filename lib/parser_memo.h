@@ -0,0 +1,194 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef PARSER_MEMO_H
+#define PARSER_MEMO_H
+
+#include "nocopy.h"
+#include "parse_arena.h"
+#include "parser/base.h"
+
+#include <practical/defines.h>
+
+#include <functional>
+#include <unordered_map>
+
+namespace NonTerminals {
+
+// Packrat style memoization of parse results, so that backtracking does not parse the same tokens with the same rule
+// over and over again.
+//
+// Results are kept per rule and token range. A failure is simply returned again. Most successes are never parsed
+// again, so they are only kept while a Speculation is active: a rule that might still fail after its parts parsed (e.g.
+// a statement that turns out to be a conditional expression) marks them speculative, as its caller is likely to parse
+// the same tokens with another rule next. A kept success is a copy of the parsed node in the active ParseArena, and each
+// later parse of the same rule at the same place gets a copy of it. Nodes only point at their children, which live in
+// the arena and are not changed once parsed, so copies share them.
+//
+// Memoization is only done while a Scope is active on the current thread. Without one, rules parse normally.
+class ParseMemo : private NoCopy {
+public:
+    enum class Rule : uint8_t {
+        Expression,
+        Statement,
+    };
+
+    // Which successes a speculative parse keeps
+    enum class Speculative : uint8_t {
+        No,
+        Outermost,      // Only that of the first memoized rule entered
+        Whole,          // Those of all memoized rules entered, however deep
+    };
+
+    struct Statistics {
+        size_t lookups = 0;
+        size_t hits = 0;
+
+        double hitRate() const {
+            return lookups==0 ? 0 : double(hits) / lookups;
+        }
+
+        // How many times a memoized rule was actually parsed
+        size_t evaluations() const {
+            return lookups - hits;
+        }
+
+        Statistics &operator+=(const Statistics &rhs) {
+            lookups += rhs.lookups;
+            hits += rhs.hits;
+
+            return *this;
+        }
+    };
+
+    // Make memo the active memo of the current thread for the scope's lifetime
+    class Scope : private NoCopy {
+        ParseMemo *previous;
+
+    public:
+        explicit Scope(ParseMemo &memo);
+        ~Scope();
+    };
+
+    // Mark the parses done on the current thread during the speculation's lifetime as speculative. A speculation inside
+    // another keeps at least what the outer one does.
+    class Speculation : private NoCopy {
+        ParseMemo *memo;
+        Speculative previous;
+
+        friend ParseMemo;
+        Speculation(ParseMemo *memo, Speculative speculative);
+
+    public:
+        explicit Speculation(Speculative speculative);
+        ~Speculation();
+    };
+
+private:
+    // The token range is kept as indexes into its stream
+    struct Key {
+        const Tokenizer::TokenStream *stream;
+        size_t begin, end;
+        Rule rule;
+
+        bool operator==(const Key &rhs) const {
+            return stream==rhs.stream && begin==rhs.begin && end==rhs.end && rule==rhs.rule;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            size_t seed = std::hash<const Tokenizer::TokenStream *>{}( key.stream );
+            combine( seed, key.begin );
+            combine( seed, key.end );
+            combine( seed, static_cast<size_t>( key.rule ) );
+
+            return seed;
+        }
+
+        static void combine(size_t &seed, size_t value) {
+            seed ^= std::hash<size_t>{}( value ) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+        }
+    };
+
+    struct Entry {
+        ParseResult result;
+        // The node of a successful parse. Lives in the active ParseArena
+        const NonTerminal *node = nullptr;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    Statistics statistics;
+    Speculative speculative = Speculative::No;
+
+    static inline thread_local ParseMemo *active = nullptr;
+
+public:
+    ParseMemo() = default;
+
+    const Statistics &getStatistics() const {
+        return statistics;
+    }
+
+    // Forget all results of the active memo, if any. Use when the parser will not backtrack before the current
+    // position again. Statistics are kept.
+    static void forgetActive();
+
+    // Parse nonTerminal using parseFunc, unless rule was already parsed over the same tokens
+    template<typename NT, typename ParseFunc>
+    static ParseResult memoize(Rule rule, NT &nonTerminal, Tokenizer::TokenSlice source, ParseFunc parseFunc) {
+        ParseMemo *memo = active;
+        if( memo==nullptr )
+            return parseFunc();
+
+        Key key = makeKey( rule, source );
+        memo->statistics.lookups++;
+
+        auto iter = memo->entries.find( key );
+        if( iter!=memo->entries.end() ) {
+            const Entry &entry = iter->second;
+            memo->statistics.hits++;
+
+            if( entry.result ) {
+                nonTerminal = NT( static_cast<const NT &>( *entry.node ) );
+                nonTerminal.parsedSlice = source.subslice( 0, entry.result.tokensConsumed() );
+            }
+
+            return entry.result;
+        }
+
+        // parseFunc might add entries, so iter cannot be reused
+        Speculative speculative = memo->speculative;
+        ParseResult result = 0;
+        {
+            Speculation nested( memo, speculative==Speculative::Outermost ? Speculative::No : speculative );
+            result = parseFunc();
+        }
+
+        if( result && speculative==Speculative::No )
+            return result;
+
+        Entry entry{ .result = result };
+        if( result )
+            entry.node = ParseArena::make<NT>( static_cast<const NT &>( nonTerminal ) );
+        memo->entries.insert_or_assign( key, entry );
+
+        return result;
+    }
+
+private:
+    static Key makeKey(Rule rule, Tokenizer::TokenSlice source) {
+        return Key{
+                .stream = source.getStream(), .begin = source.getStart(), .end = source.getStart() + source.size(),
+                .rule = rule };
+    }
+};
+
+} // namespace NonTerminals
+
+#endif // PARSER_MEMO_H
@@ -0,0 +1,151 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <map>
+#include <string>
+
+class ParserMemoTest : public CppUnit::TestFixture  {
+    // Conditional expressions nested depth deep. Each one is first parsed as a statement, and then again as an
+    // expression, so without memoization parsing time doubles with each level
+    static std::string nestedConditions(size_t depth) {
+        std::string body = "x";
+        for( size_t i=0; i<depth; ++i )
+            body = "if( x ) { " + body + " } else { x }";
+
+        return "def f( x : Bool ) -> Bool { " + body + " }";
+    }
+
+    static NonTerminals::ParseMemo::Statistics parseStatistics(const std::string &source) {
+        NonTerminals::Module module;
+        UT::parse( module, source );
+
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==1 );
+        return module.memoStatistics;
+    }
+
+    void nestedConditionsLinear() {
+        auto shallow = parseStatistics( nestedConditions(10) );
+        auto deep = parseStatistics( nestedConditions(100) );
+
+        CPPUNIT_ASSERT( shallow.hits>0 );
+        // Ten times the nesting must cost no more than ten times the evaluations, plus a constant
+        CPPUNIT_ASSERT( deep.evaluations() <= 10*shallow.evaluations() + 10 );
+    }
+
+    void disabled() {
+        std::string source = nestedConditions(10);
+        NonTerminals::Module module;
+        UT::parse( module, source, UT::arguments( &UT::CompilerArguments::parserMemoization, false ) );
+
+        CPPUNIT_ASSERT( module.functionDefinitions.size()==1 );
+        CPPUNIT_ASSERT( module.memoStatistics.lookups==0 );
+    }
+
+    // How many times the rules whose name contains ruleName were entered
+    static size_t ruleEntries(const ParserTrace::Trace &trace, const std::string &ruleName) {
+        const std::vector<ParserTrace::RuleCounters> &counters = trace.getCounters();
+
+        size_t entries = 0;
+        for( uint16_t rule=1; rule<counters.size(); ++rule ) {
+            if( ParserTrace::ruleName( rule ).find( ruleName )!=std::string::npos )
+                entries += counters[rule].hits;
+        }
+
+        return entries;
+    }
+
+    void successReused() {
+        static const char source[] = "a + b * c";
+        Tokenizer::TokenStream tokens = Tokenizer::TokenStream::tokenize( String( source, sizeof(source)-1 ) );
+
+        NonTerminals::ParseArena arena;
+        NonTerminals::ParseArena::Scope arenaScope( arena );
+        NonTerminals::ParseMemo memo;
+        NonTerminals::ParseMemo::Scope memoScope( memo );
+        ParserTrace::Trace trace;
+        ParserTrace::Trace::Scope traceScope( trace, tokens );
+
+        // Not kept unless the parse is speculative
+        NonTerminals::Expression discarded;
+        CPPUNIT_ASSERT( discarded.parse( tokens ) );
+        CPPUNIT_ASSERT( ruleEntries( trace, "Expression::parseUncached" )==1 );
+
+        NonTerminals::Expression first, second;
+        NonTerminals::ParseResult firstResult = 0;
+        {
+            NonTerminals::ParseMemo::Speculation speculation( NonTerminals::ParseMemo::Speculative::Outermost );
+            firstResult = first.parse( tokens );
+        }
+        NonTerminals::ParseResult secondResult = second.parse( tokens );
+
+        CPPUNIT_ASSERT( firstResult && secondResult );
+        CPPUNIT_ASSERT( firstResult.tokensConsumed()==secondResult.tokensConsumed() );
+        CPPUNIT_ASSERT( ruleEntries( trace, "Expression::parseUncached" )==2 );
+        CPPUNIT_ASSERT( memo.getStatistics().hits==1 );
+
+        // The second parse is a copy of the first, sharing its operands
+        auto firstOperator = std::get_if<NonTerminals::Expression::BinaryOperator>( &first.value );
+        auto secondOperator = std::get_if<NonTerminals::Expression::BinaryOperator>( &second.value );
+        CPPUNIT_ASSERT( firstOperator && secondOperator );
+        CPPUNIT_ASSERT( firstOperator->operands==secondOperator->operands );
+        CPPUNIT_ASSERT( second.getNTTokens().size()==first.getNTTokens().size() );
+    }
+
+    // Each memoized rule is entered at most once per token it starts at, however the parser backtracks
+    void ruleEntriesPerPosition() {
+        std::string source = nestedConditions(30) +
+                "\ndef g( x : S32 ) -> S32 { def y : S32 = x * 2; y + x; if( y > x ) { y } else { x + 1 } }\n";
+        NonTerminals::Module module;
+        UT::parse( module, source, UT::arguments( &UT::CompilerArguments::parserTraceRecords, 1024*1024 ) );
+        CPPUNIT_ASSERT( module.trace );
+
+        std::map< std::pair<uint16_t, uint32_t>, size_t > entries;
+        module.trace->forEach( [&]( const ParserTrace::Record &record ) {
+                    if( record.event==ParserTrace::Event::Enter )
+                        entries[ std::make_pair( record.rule, record.tokenIndex ) ]++;
+                } );
+
+        size_t memoizedEntries = 0;
+        for( const auto &entry : entries ) {
+            const std::string &rule = ParserTrace::ruleName( entry.first.first );
+            if( rule.find( "Expression::parseUncached" )==std::string::npos &&
+                    rule.find( "Statement::parseUncached" )==std::string::npos )
+                continue;
+
+            memoizedEntries += entry.second;
+            CPPUNIT_ASSERT_MESSAGE( rule + " entered " + std::to_string( entry.second ) + " times at token " +
+                        std::to_string( entry.first.second ), entry.second==1 );
+        }
+        CPPUNIT_ASSERT( memoizedEntries>0 );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserMemoTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserMemoTest>(
+                    "nestedConditionsLinear",
+                    &ParserMemoTest::nestedConditionsLinear ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserMemoTest>(
+                    "disabled",
+                    &ParserMemoTest::disabled ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserMemoTest>(
+                    "successReused",
+                    &ParserMemoTest::successReused ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserMemoTest>(
+                    "ruleEntriesPerPosition",
+                    &ParserMemoTest::ruleEntriesPerPosition ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserMemoTest );
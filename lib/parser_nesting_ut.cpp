@@ -0,0 +1,54 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class ParserNestingTest : public CppUnit::TestFixture  {
+    static void parse(const std::string &source, size_t maxNestingDepth) {
+        NonTerminals::Module module;
+        UT::parse(
+                module, source,
+                UT::arguments( &UT::CompilerArguments::maxNestingDepth, maxNestingDepth ) );
+    }
+
+    void deepOperatorsParse() {
+        // Neither parentheses nor operator chains recurse, so they are not limited by the nesting depth
+        parse( UT::nested( "(", "x", ")", 100000 ), 10 );
+        parse( UT::nested( "x + ", "x", "", 100000 ), 10 );
+        parse( UT::nested( "- ", "x", "", 100000 ), 10 );
+    }
+
+    void tooDeep() {
+        std::string source = UT::nested( "f(", "x", ")", 100 );
+        parse( source, 200 );
+
+        UT::expectThrow<PracticalSemanticAnalyzer::NestingTooDeep>(
+                [&]() { parse( source, 50 ); }, "Nesting deeper than the limit parsed without errors" );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserNestingTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserNestingTest>(
+                    "deepOperatorsParse",
+                    &ParserNestingTest::deepOperatorsParse ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserNestingTest>(
+                    "tooDeep",
+                    &ParserNestingTest::tooDeep ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserNestingTest );
@@ -0,0 +1,116 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ParserParallelTest : public CppUnit::TestFixture  {
+    // Big enough to be split between several threads
+    static std::string manyDefinitions(size_t numFunctions) {
+        std::ostringstream source;
+        source << "decl (\"C\") puts( s : C8@ ) -> S32;\n";
+        source << "struct Point {\n    def x : S32;\n    def y : S32;\n}\n";
+
+        for( size_t i=0; i<numFunctions; ++i ) {
+            source << "def func" << i << "( a : U32, b : U32[3] ) -> U32 {\n";
+            source << "    def c : U32 = a * 2 + f( a, b );\n";
+            source << "    if( c>a ) { c } else { if( a<3 ) { a } else { c - a } }\n";
+            source << "}\n";
+        }
+
+        return source.str();
+    }
+
+    static void parse(NonTerminals::Module &module, const std::string &source, unsigned threads) {
+        UT::parse( module, source, UT::arguments( &UT::CompilerArguments::parserThreads, threads ) );
+    }
+
+    static std::string parseError(const std::string &source, unsigned threads) {
+        NonTerminals::Module module;
+        return UT::expectThrow<PracticalSemanticAnalyzer::parser_error>(
+                [&]() { parse( module, source, threads ); }, "Source parsed without errors" ).what();
+    }
+
+    void sameAsSequential() {
+        std::string source = manyDefinitions(2000);
+
+        NonTerminals::Module sequential, parallel;
+        parse( sequential, source, 1 );
+        parse( parallel, source, 4 );
+
+        CPPUNIT_ASSERT( parallel.functionDefinitions.size()==2000 );
+        CPPUNIT_ASSERT( parallel.functionDefinitions.size()==sequential.functionDefinitions.size() );
+        CPPUNIT_ASSERT( parallel.functionDeclarations.size()==1 );
+        CPPUNIT_ASSERT( parallel.structureDefinitions.size()==1 );
+
+        for( size_t i=0; i<sequential.functionDefinitions.size(); ++i ) {
+            auto sequentialTokens = sequential.functionDefinitions[i].getNTTokens();
+            auto parallelTokens = parallel.functionDefinitions[i].getNTTokens();
+
+            CPPUNIT_ASSERT( sequential.functionDefinitions[i].getName()==parallel.functionDefinitions[i].getName() );
+            CPPUNIT_ASSERT( sequentialTokens.getStart()==parallelTokens.getStart() );
+            CPPUNIT_ASSERT( sequentialTokens.size()==parallelTokens.size() );
+        }
+
+        CPPUNIT_ASSERT( sequential.memoStatistics.lookups==parallel.memoStatistics.lookups );
+        CPPUNIT_ASSERT( sequential.memoStatistics.hits==parallel.memoStatistics.hits );
+    }
+
+    void errorSameAsSequential() {
+        std::string source = manyDefinitions(1000) + "def broken() -> U32 { 3 + }\n" + manyDefinitions(1000);
+
+        CPPUNIT_ASSERT( parseError( source, 4 )==parseError( source, 1 ) );
+    }
+
+    void concurrentParses() {
+        // The parses share the worker pool
+        std::string source = manyDefinitions(1000);
+
+        std::vector<size_t> numFunctions( 4 );
+        std::vector<std::thread> threads;
+        for( size_t i=0; i<numFunctions.size(); ++i ) {
+            threads.emplace_back( [&, i]() {
+                        NonTerminals::Module module;
+                        parse( module, source, 4 );
+                        numFunctions[i] = module.functionDefinitions.size();
+                    } );
+        }
+
+        for( std::thread &thread : threads )
+            thread.join();
+
+        for( size_t count : numFunctions )
+            CPPUNIT_ASSERT( count==1000 );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserParallelTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserParallelTest>(
+                    "sameAsSequential",
+                    &ParserParallelTest::sameAsSequential ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserParallelTest>(
+                    "errorSameAsSequential",
+                    &ParserParallelTest::errorSameAsSequential ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserParallelTest>(
+                    "concurrentParses",
+                    &ParserParallelTest::concurrentParses ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserParallelTest );
@@ -0,0 +1,117 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <practical/errors.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class ParserRecoveryTest : public CppUnit::TestFixture  {
+    static const std::string brokenSource;
+
+    // Parse source, which must fail, and return the location of the error thrown
+    static SourceLocation parse(
+            NonTerminals::Module &module, const std::string &source, size_t maxErrors, bool lazyFunctionBodies = false)
+    {
+        UT::CompilerArguments arguments = UT::arguments( &UT::CompilerArguments::maxErrors, maxErrors );
+        arguments.lazyFunctionBodies = lazyFunctionBodies;
+
+        auto error = UT::expectThrow<PracticalSemanticAnalyzer::parser_error>(
+                [&]() { UT::parse( module, source, arguments ); }, "Broken source parsed without errors" );
+        return error.getLocation();
+    }
+
+    void allErrors() {
+        NonTerminals::Module module;
+        SourceLocation thrown = parse( module, brokenSource, 20 );
+
+        CPPUNIT_ASSERT( module.errors.size()==4 );
+        CPPUNIT_ASSERT( module.errors[0].location==thrown );
+
+        unsigned lines[] = { 2, 4, 8, 10 };
+        for( unsigned i=0; i<4; ++i )
+            CPPUNIT_ASSERT( module.errors[i].location.line==lines[i] );
+    }
+
+    void errorCap() {
+        NonTerminals::Module capped, single;
+        SourceLocation cappedThrown = parse( capped, brokenSource, 2 );
+        SourceLocation singleThrown = parse( single, brokenSource, 1 );
+
+        CPPUNIT_ASSERT( capped.errors.size()==2 );
+        CPPUNIT_ASSERT( single.errors.empty() );
+        CPPUNIT_ASSERT( cappedThrown==singleThrown );
+    }
+
+    void lazyBodies() {
+        // The parse itself only fails on g's header, but the errors inside f's body are found all the same
+        NonTerminals::Module eager, lazy;
+        SourceLocation eagerThrown = parse( eager, brokenSource, 20 );
+        SourceLocation lazyThrown = parse( lazy, brokenSource, 20, true );
+
+        CPPUNIT_ASSERT( lazyThrown==eagerThrown );
+        CPPUNIT_ASSERT( lazy.errors.size()==eager.errors.size() );
+        for( size_t i=0; i<eager.errors.size(); ++i ) {
+            CPPUNIT_ASSERT( lazy.errors[i].location==eager.errors[i].location );
+            CPPUNIT_ASSERT_EQUAL( std::string( eager.errors[i].msg ), std::string( lazy.errors[i].msg ) );
+        }
+    }
+
+    void nestedConditionals() {
+        // The recovery backtracks through every level of the conditionals. Each level must only be parsed once.
+        std::string body = "{ 1 + }";
+        for( unsigned i=0; i<500; ++i )
+            body = "{ if( a ) " + body + " else { 2 } }";
+        std::string source = "def f( a : Bool ) -> U32 " + body + "\n";
+
+        NonTerminals::Module recovered, single;
+        SourceLocation recoveredThrown = parse( recovered, source, 20 );
+        SourceLocation singleThrown = parse( single, source, 1 );
+
+        CPPUNIT_ASSERT( recovered.errors.size()==1 );
+        CPPUNIT_ASSERT( recoveredThrown==singleThrown );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserRecoveryTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserRecoveryTest>(
+                    "allErrors",
+                    &ParserRecoveryTest::allErrors ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserRecoveryTest>(
+                    "errorCap",
+                    &ParserRecoveryTest::errorCap ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserRecoveryTest>(
+                    "lazyBodies",
+                    &ParserRecoveryTest::lazyBodies ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserRecoveryTest>(
+                    "nestedConditionals",
+                    &ParserRecoveryTest::nestedConditionals ) );
+        return suiteOfTests;
+    }
+};
+
+// One error in each of two statements, one in a global definition's header and one between definitions
+const std::string ParserRecoveryTest::brokenSource =
+        "def f( x : U32 ) -> U32 {\n"
+        "    def y : U32 = x + ;\n"
+        "    y = y * 2;\n"
+        "    if( y>3 ) { y = 3; } else { y = ( 4; }\n"
+        "    y\n"
+        "}\n"
+        "\n"
+        "def g( x : U32, ) -> U32 { x }\n"
+        "def h() -> U32 { 1 }\n"
+        "}\n"
+        "def k() -> U32 { 2 }\n";
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserRecoveryTest );
@@ -0,0 +1,190 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "parser_trace.h"
+
+#include "asserts.h"
+
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+
+namespace ParserTrace {
+
+namespace {
+
+std::mutex registryLock;
+// Rule names, indexed by rule id. Id 0 is never assigned. A deque, so that names don't move as rules are added.
+std::deque<std::string> ruleNames{ "" };
+
+uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+// "virtual NonTerminals::ParseResult NonTerminals::Expression::parse(Tokenizer::TokenSlice)" becomes
+// "NonTerminals::Expression::parse"
+std::string shortName(const char *function) {
+    std::string name( function );
+
+    size_t end = name.find('(');
+    if( end==std::string::npos )
+        return name;
+
+    size_t start = name.rfind( ' ', end );
+    start = start==std::string::npos ? 0 : start+1;
+
+    return name.substr( start, end-start );
+}
+
+// Records are written as JSON strings. Rule names need no escaping.
+const char *eventName(Event event) {
+    switch( event ) {
+    case Event::Enter:
+        return "enter";
+    case Event::Leave:
+        return "leave";
+    case Event::Fail:
+        return "fail";
+    case Event::Backtrack:
+        return "backtrack";
+    }
+
+    ABORT() << "Unknown trace event " << static_cast<unsigned>(event);
+}
+
+} // Anonymous namespace
+
+uint16_t RuleSite::getId() {
+    uint16_t ret = id.load( std::memory_order_relaxed );
+    if( ret!=0 )
+        return ret;
+
+    std::lock_guard<std::mutex> guard( registryLock );
+    ret = id.load( std::memory_order_relaxed );
+    if( ret==0 ) {
+        ASSERT( ruleNames.size() <= std::numeric_limits<uint16_t>::max() ) << "Too many traced rules";
+        ret = ruleNames.size();
+        ruleNames.emplace_back( shortName(function) );
+        id.store( ret, std::memory_order_relaxed );
+    }
+
+    return ret;
+}
+
+const std::string &ruleName(uint16_t id) {
+    std::lock_guard<std::mutex> guard( registryLock );
+    ASSERT( id<ruleNames.size() ) << "Unknown rule id " << id;
+
+    return ruleNames[id];
+}
+
+Trace::Scope::Scope(Trace &trace, Tokenizer::TokenSlice tokens) : previous(activeTrace) {
+    trace.firstToken = tokens.getStart();
+    trace.startTime = now();
+    activeTrace = &trace;
+}
+
+Trace::Scope::~Scope() {
+    activeTrace = previous;
+}
+
+Trace::Trace(size_t capacity) : capacity(capacity) {
+    if( capacity>0 )
+        records = std::unique_ptr<Record[]>( new Record[capacity] );
+}
+
+void Trace::record(RuleSite &site, Event event, Tokenizer::TokenSlice source, size_t consumed) {
+    uint16_t rule = site.getId();
+    if( rule>=counters.size() )
+        counters.resize( rule+1 );
+
+    RuleCounters &ruleCounters = counters[rule];
+    switch( event ) {
+    case Event::Enter:
+        ruleCounters.hits++;
+        break;
+    case Event::Fail:
+        ruleCounters.failures++;
+        break;
+    case Event::Backtrack:
+        ruleCounters.backtracks++;
+        break;
+    case Event::Leave:
+        break;
+    }
+
+    if( capacity==0 )
+        return;
+
+    Record &record = records[next];
+    record.time = now() - startTime;
+    record.tokenIndex = source.getStart() - firstToken;
+    record.consumed = consumed;
+    record.rule = rule;
+    record.event = event;
+
+    if( ++next==capacity ) {
+        next = 0;
+        wrapped = true;
+    }
+}
+
+void Trace::dumpText(std::ostream &out) const {
+    size_t depth = 0;
+
+    forEach( [&]( const Record &record ) {
+                if( record.event==Event::Leave || record.event==Event::Fail ) {
+                    // The matching enter may have been overwritten
+                    if( depth>0 )
+                        depth--;
+                }
+
+                out << std::string( depth*2, ' ' ) << eventName(record.event) << " " << ruleName(record.rule) <<
+                        " at token " << record.tokenIndex;
+                if( record.event==Event::Leave )
+                    out << " consumed " << record.consumed;
+                out << "\n";
+
+                if( record.event==Event::Enter )
+                    depth++;
+            } );
+}
+
+void Trace::dumpChromeTrace(std::ostream &out) const {
+    out << "{\"traceEvents\":[";
+
+    const char *separator = "\n";
+    forEach( [&]( const Record &record ) {
+                out << separator << "{\"name\":\"" << ruleName(record.rule) << "\",\"pid\":1,\"tid\":1,\"ts\":" <<
+                        record.time/1000 << "." << record.time/100%10 << record.time/10%10 << record.time%10 << ",";
+                switch( record.event ) {
+                case Event::Enter:
+                    out << "\"ph\":\"B\",\"args\":{\"token\":" << record.tokenIndex << "}";
+                    break;
+                case Event::Leave:
+                    out << "\"ph\":\"E\",\"args\":{\"consumed\":" << record.consumed << "}";
+                    break;
+                case Event::Fail:
+                    out << "\"ph\":\"E\",\"args\":{\"failed\":true}";
+                    break;
+                case Event::Backtrack:
+                    out << "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"backtrack\":true,\"token\":" << record.tokenIndex << "}";
+                    break;
+                }
+                out << "}";
+
+                separator = ",\n";
+            } );
+
+    out << "\n]}\n";
+}
+
+} // Namespace ParserTrace
@@ -0,0 +1,120 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef PARSER_TRACE_H
+#define PARSER_TRACE_H
+
+#include "nocopy.h"
+#include "token_stream.h"
+
+#include <practical/slice.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Records what the parser does into a ring buffer that can be dumped after the parse. Tracing is switched on at run
+// time, by making a trace active on the current thread. While no trace is active, each rule pays a single branch.
+namespace ParserTrace {
+
+// A place in the parser's source that traces a rule. Every RULE_ENTER has one.
+class RuleSite : private NoCopy {
+    const char *function;
+    std::atomic<uint16_t> id{0};
+
+public:
+    // Constant initialized, so a static RuleSite costs nothing until a trace first records it
+    constexpr explicit RuleSite(const char *function) : function(function) {}
+
+    // The site's rule id. Ids are assigned the first time a site is traced, and start at 1.
+    uint16_t getId();
+};
+
+// The name of the rule with the given id
+const std::string &ruleName(uint16_t id);
+
+enum class Event : uint8_t {
+    Enter,
+    Leave,
+    Fail,
+    Backtrack,
+};
+
+struct Record {
+    // Nanoseconds since the trace was started
+    uint64_t time;
+    uint32_t tokenIndex;
+    // Tokens consumed by a rule that left successfully
+    uint32_t consumed;
+    uint16_t rule;
+    Event event;
+};
+
+struct RuleCounters {
+    size_t hits = 0;
+    size_t failures = 0;
+    size_t backtracks = 0;
+};
+
+class Trace : private NoCopy {
+    std::unique_ptr<Record[]> records;
+    size_t capacity = 0, next = 0;
+    bool wrapped = false;
+    uint64_t startTime = 0;
+    std::vector<RuleCounters> counters;
+    size_t firstToken = 0;
+
+public:
+    // Make the trace active on the current thread for the scope's lifetime. Token indexes are relative to tokens.
+    class Scope : private NoCopy {
+        Trace *previous;
+
+    public:
+        Scope(Trace &trace, Tokenizer::TokenSlice tokens);
+        ~Scope();
+    };
+
+    // Keep the last capacity records. A trace with no capacity records nothing, but still counts.
+    explicit Trace(size_t capacity = 0);
+
+    void record(RuleSite &site, Event event, Tokenizer::TokenSlice source, size_t consumed = 0);
+
+    // The counters of each rule, indexed by rule id
+    const std::vector<RuleCounters> &getCounters() const {
+        return counters;
+    }
+
+    // One line per record, indented by rule nesting, oldest first
+    void dumpText(std::ostream &out) const;
+    // JSON for chrome://tracing and compatible viewers
+    void dumpChromeTrace(std::ostream &out) const;
+
+    template<typename Visitor>
+    void forEach(Visitor &&visitor) const {
+        if( wrapped ) {
+            for( size_t i=next; i<capacity; ++i )
+                visitor( records[i] );
+        }
+        for( size_t i=0; i<next; ++i )
+            visitor( records[i] );
+    }
+};
+
+// Defined inline with a constant initializer, so that record needs no thread local initialization wrapper
+inline thread_local Trace *activeTrace = nullptr;
+
+inline void record(RuleSite &site, Event event, Tokenizer::TokenSlice source, size_t consumed = 0) {
+    if( activeTrace!=nullptr )
+        activeTrace->record( site, event, source, consumed );
+}
+
+} // Namespace ParserTrace
+
+#endif // PARSER_TRACE_H
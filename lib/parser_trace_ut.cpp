@@ -0,0 +1,101 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "ut/parse_helpers.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sstream>
+#include <string>
+
+class ParserTraceTest : public CppUnit::TestFixture  {
+    static const std::string source;
+
+    static void parse(NonTerminals::Module &module, size_t records) {
+        UT::parse( module, source, UT::arguments( &UT::CompilerArguments::parserTraceRecords, records ) );
+    }
+
+    void wholeParse() {
+        NonTerminals::Module module;
+        parse( module, 64*1024 );
+        CPPUNIT_ASSERT( module.trace );
+
+        // Every rule entered was left, and the module rule encloses all the others
+        size_t numRecords = 0, depth = 0;
+        ParserTrace::Record first{}, last{};
+        module.trace->forEach( [&]( const ParserTrace::Record &record ) {
+                    if( numRecords++==0 )
+                        first = record;
+                    last = record;
+
+                    if( record.event==ParserTrace::Event::Enter ) {
+                        depth++;
+                    } else if( record.event!=ParserTrace::Event::Backtrack ) {
+                        CPPUNIT_ASSERT( depth>0 );
+                        depth--;
+                    }
+                } );
+        CPPUNIT_ASSERT( numRecords>0 );
+        CPPUNIT_ASSERT( depth==0 );
+        CPPUNIT_ASSERT( ParserTrace::ruleName( first.rule )=="NonTerminals::Module::parse" );
+        CPPUNIT_ASSERT( last.event==ParserTrace::Event::Leave );
+        CPPUNIT_ASSERT( last.consumed==module.tokens.size() );
+
+        const ParserTrace::RuleCounters &counters = module.trace->getCounters()[first.rule];
+        CPPUNIT_ASSERT( counters.hits==1 );
+        CPPUNIT_ASSERT( counters.failures==0 );
+
+        std::ostringstream chromeTrace;
+        module.trace->dumpChromeTrace( chromeTrace );
+        CPPUNIT_ASSERT( chromeTrace.str().find( "{\"name\":\"NonTerminals::Module::parse\"" )!=std::string::npos );
+    }
+
+    void ringBuffer() {
+        NonTerminals::Module full, lastOnly;
+        parse( full, 64*1024 );
+        parse( lastOnly, 10 );
+
+        std::vector<ParserTrace::Record> fullRecords, lastRecords;
+        full.trace->forEach( [&]( const ParserTrace::Record &record ) { fullRecords.push_back( record ); } );
+        lastOnly.trace->forEach( [&]( const ParserTrace::Record &record ) { lastRecords.push_back( record ); } );
+
+        CPPUNIT_ASSERT( lastRecords.size()==10 );
+        for( size_t i=0; i<10; ++i ) {
+            const ParserTrace::Record &expected = fullRecords[ fullRecords.size()-10+i ];
+            CPPUNIT_ASSERT( lastRecords[i].rule==expected.rule );
+            CPPUNIT_ASSERT( lastRecords[i].event==expected.event );
+            CPPUNIT_ASSERT( lastRecords[i].tokenIndex==expected.tokenIndex );
+        }
+
+        // Counters are kept for the whole parse
+        CPPUNIT_ASSERT( lastOnly.trace->getCounters().size()==full.trace->getCounters().size() );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ParserTraceTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserTraceTest>(
+                    "wholeParse",
+                    &ParserTraceTest::wholeParse ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<ParserTraceTest>(
+                    "ringBuffer",
+                    &ParserTraceTest::ringBuffer ) );
+        return suiteOfTests;
+    }
+};
+
+const std::string ParserTraceTest::source =
+        "def f( x : U32 ) -> U32 {\n"
+        "    def y : U32 = x + 3;\n"
+        "    y = y * 2;\n"
+        "    if( y>3 ) { y = 3; } else { y = f( 4 ); }\n"
+        "    y\n"
+        "}\n";
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ParserTraceTest );
@@ -6,7 +6,7 @@
  * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
  * home directory.
  */
-#include "tokenizer.h"
+#include "token_stream.h"
 
 #include <practical/errors.h>
 
@@ -45,34 +45,34 @@ SymbolNotFound::SymbolNotFound(String symbol, const SourceLocation &location)
     setMsg( buf.str().c_str() );
 }
 
-CannotTakeValueOfFunction::CannotTakeValueOfFunction(const Tokenizer::Token *identifier) :
-    compile_error(identifier->location)
+CannotTakeValueOfFunction::CannotTakeValueOfFunction(const Tokenizer::TokenRef &identifier) :
+    compile_error(identifier.location())
 {
     std::stringstream buf;
 
-    buf<<"Trying to evaluate "<<identifier->text<<" which is of a callable type";
+    buf<<"Trying to evaluate "<<identifier.text()<<" which is of a callable type";
 
     setMsg( buf.str().c_str() );
 }
 
-TryToCallNonCallable::TryToCallNonCallable(const Tokenizer::Token *identifier) :
-    compile_error(identifier->location)
+TryToCallNonCallable::TryToCallNonCallable(const Tokenizer::TokenRef &identifier) :
+    compile_error(identifier.location())
 {
     std::stringstream buf;
 
-    buf<<"Trying to call "<<identifier->text<<" which is not of a callable type";
+    buf<<"Trying to call "<<identifier.text()<<" which is not of a callable type";
 
     setMsg( buf.str().c_str() );
 }
 
-NoMatchingOverload::NoMatchingOverload(const Tokenizer::Token *identifier) :
-    compile_error(identifier->location)
+NoMatchingOverload::NoMatchingOverload(const Tokenizer::TokenRef &identifier) :
+    compile_error(identifier.location())
 {
     setMsg( "Trying to call function with no matching overload" );
 }
 
-AmbiguousOverloads::AmbiguousOverloads(const Tokenizer::Token *identifier) :
-    compile_error(identifier->location)
+AmbiguousOverloads::AmbiguousOverloads(const Tokenizer::TokenRef &identifier) :
+    compile_error(identifier.location())
 {
     setMsg( "Trying to call function with ambiguous overload resolution" );
 }
@@ -14,6 +14,7 @@
 #include "parser.h"
 
 #include <practical/defines.h>
+#include <practical/errors.h>
 #include <practical/practical.h>
 
 DEF_TYPED_NS( PracticalSemanticAnalyzer, ModuleId );
@@ -104,43 +105,8 @@ bool StaticType::Struct::operator==( const Struct &rhs ) const {
 }
 
 bool StaticType::operator==( const StaticType &rhs ) const {
-    if( this==&rhs )
-        return true;
-
-    auto leftType = getType();
-    auto rightType = rhs.getType();
-
-    if( getFlags()!=rhs.getFlags() )
-        return false;
-
-    if( leftType.index() != rightType.index() )
-        return false;
-
-    struct Visitor {
-        StaticType::Types rightTypes;
-
-        bool operator()( const Scalar *scalar ) {
-            return (*scalar)==*( std::get<const Scalar *>( rightTypes ) );
-        }
-
-        bool operator()( const StaticType::Function *function ) {
-            return (*function)==*( std::get<const Function *>( rightTypes ) );
-        }
-
-        bool operator()( const StaticType::Pointer *pointer ) {
-            return (*pointer)==*( std::get<const Pointer *>( rightTypes ) );
-        }
-
-        bool operator()( const StaticType::Array *array ) {
-            return (*array)==*( std::get<const Array *>( rightTypes ) );
-        }
-
-        bool operator()( const StaticType::Struct *strct ) {
-            return (*strct)==*( std::get<const StaticType::Struct *>( rightTypes ) );
-        }
-    };
-
-    return std::visit( Visitor{ .rightTypes = rhs.getType() }, getType() );
+    // Structurally equal types are a single instance
+    return this==&rhs;
 }
 
 std::ostream &operator<<(std::ostream &out, StaticType::CPtr type) {
@@ -209,7 +175,12 @@ void prepare( BuiltinContextGen *ctxGen ) {
     AST::AST::prepare(ctxGen);
 }
 
-int compile(std::string path, const CompilerArguments *arguments, ModuleGen *codeGen) {
+static void report( std::vector<Diagnostic> &diagnostics, const compile_error &error ) {
+    diagnostics.emplace_back( Diagnostic{ .location = error.getLocation(), .message = error.what() } );
+}
+
+int compile(std::string path, const CompilerArguments *arguments, ModuleGen *codeGen, std::vector<Diagnostic> *diagnostics)
+{
     // Load file into memory
     Mmap<MapMode::ReadOnly> sourceFile(path);
 
@@ -217,12 +188,42 @@ int compile(std::string path, const CompilerArguments *arguments, ModuleGen *cod
 
     // Parse + symbols lookup
     ASSERT( AST::AST::prepared() )<<"compile called without calling prepare first";
-    auto tokenizedModule = Tokenizer::Tokenizer::tokenize( sourceFile.getSlice<const char>() );
+    CompilerArguments defaultArguments;
+    if( arguments==nullptr )
+        arguments = &defaultArguments;
+    // Only the first error can be thrown, so there is no point looking for more
+    CompilerArguments singleErrorArguments;
+    if( diagnostics==nullptr && arguments->maxErrors>1 ) {
+        singleErrorArguments = *arguments;
+        singleErrorArguments.maxErrors = 1;
+        arguments = &singleErrorArguments;
+    }
     NonTerminals::Module module;
-    module.parse( tokenizedModule );
+    try {
+        module.parse( sourceFile.getSlice<const char>(), *arguments );
+
+        // And that other thing
+        ast.codeGen( module, codeGen, *arguments );
+    } catch( compile_error &error ) {
+        if( diagnostics==nullptr )
+            throw;
 
-    // And that other thing
-    ast.codeGen( module, codeGen );
+        if( module.errors.empty() ) {
+            report( *diagnostics, error );
+
+            return 1;
+        }
+
+        for( const NonTerminals::ParseError &parseError : module.errors ) {
+            try {
+                parseError.raise();
+            } catch( compile_error &syntaxError ) {
+                report( *diagnostics, syntaxError );
+            }
+        }
+
+        return module.errors.size();
+    }
 
     return 0;
 }
@@ -233,11 +234,8 @@ using namespace PracticalSemanticAnalyzer;
 
 namespace std {
 
-static size_t indent = 0;
 size_t hash< StaticType >::operator()(const StaticType &type) const {
-    size_t ret = AST::downCast( &type )->getHash();
-    indent--;
-    return ret;
+    return AST::downCast( &type )->getHash();
 }
 
 } // namespace std
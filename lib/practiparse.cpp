@@ -6,6 +6,7 @@
  * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
  * home directory.
  */
+#include <fstream>
 #include <iostream>
 #include <variant>
 
@@ -13,6 +14,9 @@
 
 #include "parser/module.h"
 #include "mmap.h"
+#include "token_stream.h"
+
+#include <practical/errors.h>
 
 size_t indentWidth = 3;
 
@@ -26,7 +30,7 @@ std::ostream &indent( std::ostream &out, size_t depth ) {
 using namespace NonTerminals;
 
 void dumpIdentifier( const NonTerminals::Identifier &id, size_t depth ) {
-    indent(std::cout, depth) << "Identifier "<<*id.identifier<<"\n";
+    indent(std::cout, depth) << "Identifier "<<id.identifier<<"\n";
 }
 
 void dumpType( const NonTerminals::Type &type, size_t depth ) {
@@ -75,7 +79,7 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
 
         Visitor( size_t depth, std::ostream &out ) : depth(depth), out(out) {}
 
-        void operator()( const std::unique_ptr<::NonTerminals::CompoundExpression> &compound ) {
+        void operator()( NonTerminals::NodeIndex<::NonTerminals::CompoundExpression> compound ) {
             indent(out, depth) << "Compound expression Statements:\n";
             for( const auto &statement: compound->statementList.statements ) {
                 dumpParseTree( statement, depth+1 );
@@ -85,7 +89,7 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
                 dumpParseTree( compound->expression, depth+1 );
         }
 
-        void operator()( const Literal &literal ) {
+        void operator()( NonTerminals::NodeIndex<Literal> literal ) {
             struct Visitor2 {
                 const Visitor &_this;
 
@@ -105,24 +109,24 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
                 }
 
                 void operator()( const NonTerminals::LiteralString &literal ) {
-                    indent(_this.out, _this.depth) << "Literal string "<<literal.token->text<<"\n";
+                    indent(_this.out, _this.depth) << "Literal string "<<literal.token.text()<<"\n";
                 }
             };
 
-            std::visit( Visitor2{ ._this = *this }, literal.literal );
+            std::visit( Visitor2{ ._this = *this }, literal->literal );
         }
 
-        void operator()( const Identifier &id ) {
-            dumpIdentifier( id, depth );
+        void operator()( NonTerminals::NodeIndex<Identifier> id ) {
+            dumpIdentifier( *id, depth );
         }
 
         void operator()( const NonTerminals::Expression::UnaryOperator &op ) {
-            indent( out, depth )<<"Unary "<<*op.op<<"\n";
+            indent( out, depth )<<"Unary "<<op.op<<"\n";
             dumpParseTree( *op.operand, depth+1 );
         }
 
         void operator()( const NonTerminals::Expression::BinaryOperator &op ) {
-            indent( out, depth )<<"Binary "<<*op.op<<"\n";
+            indent( out, depth )<<"Binary "<<op.op<<"\n";
             indent( out, depth )<<"Operand 1:\n";
             dumpParseTree( *op.operands[0], depth+1 );
             indent( out, depth )<<"Operand 2:\n";
@@ -130,9 +134,9 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
         }
 
         void operator()( const NonTerminals::Expression::CastOperator &op ) {
-            indent( out, depth )<<"Cast "<<*op.op<<"\n";
+            indent( out, depth )<<"Cast "<<op.op<<"\n";
             indent( out, depth )<<"Type:\n";
-            dumpType( op.destType, depth+1 );
+            dumpType( *op.destType, depth+1 );
             indent( out, depth )<<"Expression:\n";
             dumpParseTree( *op.expression, depth+1 );
         }
@@ -141,10 +145,10 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
             indent(out, depth) << "Function call:\n";
             dumpParseTree( *func.expression, depth+1 );
             indent(out, depth) << "Arguments:\n";
-            dumpParseTree( func.arguments, depth+1 );
+            dumpParseTree( *func.arguments, depth+1 );
         }
 
-        void operator()( const std::unique_ptr<NonTerminals::ConditionalExpression> &condition ) {
+        void operator()( NonTerminals::NodeIndex<NonTerminals::ConditionalExpression> condition ) {
             indent(out, depth) << "Condition expression:\n";
             dumpParseTree( condition->condition, depth+1 );
             indent(out, depth) << "If clause:\n";
@@ -153,9 +157,9 @@ void dumpParseTree( const NonTerminals::Expression &node, size_t depth ) {
             dumpParseTree( condition->elseClause, depth+1 );
         }
 
-        void operator()( const NonTerminals::Type &type ) {
+        void operator()( NonTerminals::NodeIndex<NonTerminals::Type> type ) {
             indent(out, depth) << "Type:\n";
-            dumpType( type, depth+1 );
+            dumpType( *type, depth+1 );
         }
     };
 
@@ -166,6 +170,38 @@ void dumpParseTree( const NonTerminals::Module &module, size_t depth=0 ) {
     ABORT()<<"TODO implement";
 }
 
+void printMemoStatistics( const NonTerminals::ParseMemo::Statistics &statistics ) {
+    std::cerr << "Parser memoization: " << statistics.lookups << " lookups, " << statistics.hits << " hits (" <<
+            statistics.hitRate()*100 << "%)\n";
+}
+
+void printLookaheadStatistics( const Lookahead::Statistics &statistics ) {
+    std::cerr << "Parser lookahead: " << statistics.predictions << " predicted alternatives, " <<
+            statistics.backtracks << " speculative attempts backtracked\n";
+}
+
+void printTrace( const ParserTrace::Trace &trace, const char *chromeTracePath, bool printCounters ) {
+    std::cerr << "Parser trace:\n";
+    trace.dumpText( std::cerr );
+
+    if( chromeTracePath!=nullptr ) {
+        std::ofstream chromeTrace( chromeTracePath );
+        trace.dumpChromeTrace( chromeTrace );
+    }
+
+    if( printCounters ) {
+        std::cerr << "Parser rules (hits/failures/backtracks):\n";
+        const auto &counters = trace.getCounters();
+        for( uint16_t rule=1; rule<counters.size(); ++rule ) {
+            if( counters[rule].hits==0 )
+                continue;
+
+            std::cerr << "  " << ParserTrace::ruleName(rule) << ": " << counters[rule].hits << "/" <<
+                    counters[rule].failures << "/" << counters[rule].backtracks << "\n";
+        }
+    }
+}
+
 void help() {
     std::cout <<
             "Practiparse: exercise the Practical parser\n"
@@ -173,15 +209,24 @@ void help() {
             "Options:\n"
             "-c\tArgument is the actual program source, instead of the file name\n"
             "-W\tSource is the whole program, rather than a single expression\n"
-            "-i<num>\tSet the per-level indent mount\n";
+            "-i<num>\tSet the per-level indent mount\n"
+            "-e<num>\tReport at most num syntax errors in a whole program\n"
+            "-m\tDisable parser memoization\n"
+            "-s\tPrint parser memoization and lookahead statistics, and per rule counters when tracing\n"
+            "-t<num>\tTrace the parser, printing its last num steps\n"
+            "-T<file>\tAlso write the parser trace to file, in Chrome trace format\n"
+            "-C<dir>\tKeep parsed whole programs in dir, and load them from there when the source did not change\n";
 }
 
 int main(int argc, char *argv[]) {
     bool singleExpression = true;
     bool argumentSource = false;
+    bool printStatistics = false;
+    const char *chromeTracePath = nullptr;
+    PracticalSemanticAnalyzer::CompilerArguments arguments;
     int opt;
 
-    while( (opt=getopt(argc, argv, "Wchi:?")) != -1 ) {
+    while( (opt=getopt(argc, argv, "Wchi:e:mst:T:C:?")) != -1 ) {
         switch( opt ) {
         case 'W':
             singleExpression = false;
@@ -192,6 +237,24 @@ int main(int argc, char *argv[]) {
         case 'i':
             indentWidth = strtoul( optarg, nullptr, 10 );
             break;
+        case 'e':
+            arguments.maxErrors = strtoul( optarg, nullptr, 10 );
+            break;
+        case 'm':
+            arguments.parserMemoization = false;
+            break;
+        case 's':
+            printStatistics = true;
+            break;
+        case 't':
+            arguments.parserTraceRecords = strtoul( optarg, nullptr, 10 );
+            break;
+        case 'T':
+            chromeTracePath = optarg;
+            break;
+        case 'C':
+            arguments.parseTreeCache = optarg;
+            break;
         case '?':
             help();
             return 0;
@@ -202,6 +265,9 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if( chromeTracePath!=nullptr && arguments.parserTraceRecords==0 )
+        arguments.parserTraceRecords = 64*1024;
+
     if( optind == argc ) {
         std::cerr << "No argument" << std::endl;
         help();
@@ -219,18 +285,66 @@ int main(int argc, char *argv[]) {
             textSource = fileSource->getSlice<const char>();
         }
 
-        // Tokenize
-        auto tokens = Tokenizer::Tokenizer::tokenize( textSource );
-
         // Parse
         if( singleExpression ) {
+            auto tokens = Tokenizer::TokenStream::tokenize( textSource );
+
+            NonTerminals::ParseArena arena;
+            NonTerminals::ParseArena::Scope arenaScope( arena );
             NonTerminals::Expression exp;
-            exp.parse( tokens );
+            NonTerminals::ParseMemo memo;
+            std::unique_ptr<NonTerminals::ParseMemo::Scope> memoScope;
+            if( arguments.parserMemoization )
+                memoScope = safenew<NonTerminals::ParseMemo::Scope>( memo );
+
+            Lookahead::Statistics lookaheadStatistics;
+            Lookahead::Scope lookaheadScope( lookaheadStatistics );
+
+            std::unique_ptr<ParserTrace::Trace> trace;
+            std::unique_ptr<ParserTrace::Trace::Scope> traceScope;
+            if( arguments.parserTraceRecords>0 ) {
+                trace = safenew<ParserTrace::Trace>( arguments.parserTraceRecords );
+                traceScope = safenew<ParserTrace::Trace::Scope>( *trace, tokens );
+            }
+
+            NonTerminals::ParseResult result = exp.parse( tokens );
+            if( printStatistics ) {
+                printMemoStatistics( memo.getStatistics() );
+                printLookaheadStatistics( lookaheadStatistics );
+            }
+            if( trace )
+                printTrace( *trace, chromeTracePath, printStatistics );
+            if( !result )
+                result.getError().raise();
             std::cout<<"Successfully parsed. Dumping parse tree:\n";
             dumpParseTree( exp );
         } else {
             NonTerminals::Module module;
-            module.parse( tokens );
+            try {
+                module.parse( textSource, arguments );
+            } catch( PracticalSemanticAnalyzer::compile_error &error ) {
+                if( module.trace )
+                    printTrace( *module.trace, chromeTracePath, printStatistics );
+
+                if( module.errors.size()<=1 )
+                    throw;
+
+                for( const NonTerminals::ParseError &parseError : module.errors ) {
+                    try {
+                        parseError.raise();
+                    } catch( PracticalSemanticAnalyzer::compile_error &syntaxError ) {
+                        std::cerr << "Parsing failed: " << syntaxError.what() << "\n";
+                    }
+                }
+
+                return 1;
+            }
+            if( printStatistics ) {
+                printMemoStatistics( module.memoStatistics );
+                printLookaheadStatistics( module.lookaheadStatistics );
+            }
+            if( module.trace )
+                printTrace( *module.trace, chromeTracePath, printStatistics );
             std::cout<<"Successfully parsed. Dumping parse tree:\n";
             dumpParseTree( module );
         }
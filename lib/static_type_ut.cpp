@@ -0,0 +1,186 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "dummy_codegen_impl.h"
+
+#include "ast/ast.h"
+#include "ast/static_type.h"
+#include "ast/struct.h"
+#include "parser/module.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <thread>
+
+class StaticTypeTest : public CppUnit::TestFixture  {
+    using Type = AST::StaticTypeImpl;
+
+    static Type::CPtr builtin( const char *name ) {
+        prepareDummyCodeGen();
+
+        return AST::AST::getBuiltinCtx().lookupType( String(name) );
+    }
+
+    static Type::CPtr function( Type::CPtr returnType, std::vector<Type::CPtr> &&argumentTypes ) {
+        return Type::intern( AST::FunctionTypeImpl( std::move(returnType), std::move(argumentTypes) ) );
+    }
+
+    void interning() {
+        Type::CPtr u8 = builtin( "U8" ), u16 = builtin( "U16" ), u32 = builtin( "U32" );
+
+        Type::CPtr pointer = Type::intern( AST::PointerTypeImpl( u8 ) );
+        CPPUNIT_ASSERT( pointer==Type::intern( AST::PointerTypeImpl( u8 ) ) );
+        CPPUNIT_ASSERT( pointer!=Type::intern( AST::PointerTypeImpl( u16 ) ) );
+        CPPUNIT_ASSERT(
+                Type::intern( AST::PointerTypeImpl( pointer ) ) ==
+                Type::intern( AST::PointerTypeImpl( Type::intern( AST::PointerTypeImpl( u8 ) ) ) ) );
+
+        Type::CPtr array = Type::intern( AST::ArrayTypeImpl( u8, 4 ) );
+        CPPUNIT_ASSERT( array==Type::intern( AST::ArrayTypeImpl( u8, 4 ) ) );
+        CPPUNIT_ASSERT( array!=Type::intern( AST::ArrayTypeImpl( u8, 5 ) ) );
+        CPPUNIT_ASSERT( array!=Type::intern( AST::ArrayTypeImpl( u16, 4 ) ) );
+
+        Type::CPtr func = function( u32, { u8, u16 } );
+        CPPUNIT_ASSERT( func==function( u32, { u8, u16 } ) );
+        CPPUNIT_ASSERT( func!=function( u32, { u16, u8 } ) );
+        CPPUNIT_ASSERT( func!=function( u16, { u8, u16 } ) );
+        CPPUNIT_ASSERT( func!=function( u32, { u8 } ) );
+
+        // Composed of interned types, so interned as well
+        Type::CPtr samePointer = Type::intern( AST::PointerTypeImpl( u8 ) );
+        Type::CPtr sameArray = Type::intern( AST::ArrayTypeImpl( u8, 4 ) );
+        CPPUNIT_ASSERT( function( pointer, { array } )==function( samePointer, { sameArray } ) );
+
+        // Flag variants are created once per type
+        StaticType::CPtr reference = pointer->addFlags( StaticType::Flags::Reference );
+        CPPUNIT_ASSERT( reference==samePointer->addFlags( StaticType::Flags::Reference ) );
+    }
+
+    void structDerivedTypes() {
+        Type::CPtr u8 = builtin( "U8" );
+        AST::LookupContext ctx( &AST::AST::getBuiltinCtx() );
+
+        // Types made of a struct are interned for as long as they are used, and don't keep the struct alive
+        Type::CPtr strct = Type::allocate( AST::StructTypeImpl( String("S"), &ctx ) );
+        {
+            Type::CPtr pointer = Type::intern( AST::PointerTypeImpl( strct ) );
+            Type::CPtr array = Type::intern( AST::ArrayTypeImpl( strct, 3 ) );
+            Type::CPtr func = function( u8, { u8, pointer } );
+            CPPUNIT_ASSERT( pointer==Type::intern( AST::PointerTypeImpl( strct ) ) );
+            CPPUNIT_ASSERT( array==Type::intern( AST::ArrayTypeImpl( strct, 3 ) ) );
+            CPPUNIT_ASSERT( func==function( u8, { u8, pointer } ) );
+            CPPUNIT_ASSERT( pointer->addFlags( StaticType::Flags::Reference ) ==
+                    Type::intern( AST::PointerTypeImpl( strct ) )->addFlags( StaticType::Flags::Reference ) );
+            CPPUNIT_ASSERT( strct->use_count()>1 );
+        }
+        CPPUNIT_ASSERT_EQUAL( 1, int(strct->use_count()) );
+
+        // Interned anew once freed
+        Type::CPtr pointer = Type::intern( AST::PointerTypeImpl( strct ) );
+        CPPUNIT_ASSERT( pointer==Type::intern( AST::PointerTypeImpl( strct ) ) );
+        CPPUNIT_ASSERT_EQUAL( 2, int(strct->use_count()) );
+        pointer.reset();
+        CPPUNIT_ASSERT_EQUAL( 1, int(strct->use_count()) );
+
+        // Types made only of builtin types are shared, and kept
+        const Type *builtinPointer = Type::intern( AST::PointerTypeImpl( u8 ) ).get();
+        CPPUNIT_ASSERT( builtinPointer==Type::intern( AST::PointerTypeImpl( u8 ) ).get() );
+    }
+
+    void concurrentInterning() {
+        Type::CPtr u8 = builtin( "U8" ), u16 = builtin( "U16" );
+
+        static constexpr size_t NumThreads = 8, NumTypes = 200;
+        std::vector< std::vector<StaticType::CPtr> > results( NumThreads );
+        std::vector<std::thread> threads;
+        for( size_t thread=0; thread<NumThreads; ++thread ) {
+            threads.emplace_back( [&, thread]() {
+                for( size_t i=0; i<NumTypes; ++i ) {
+                    Type::CPtr array = Type::intern( AST::ArrayTypeImpl( u8, i ) );
+                    Type::CPtr pointer = Type::intern( AST::PointerTypeImpl( array ) );
+
+                    results[thread].emplace_back( array );
+                    results[thread].emplace_back( pointer->addFlags( StaticType::Flags::Mutable ) );
+                    results[thread].emplace_back( u16->addFlags( StaticType::Flags::Reference ) );
+                    results[thread].emplace_back( function( u16, { pointer, u8 } ) );
+                }
+            } );
+        }
+        for( auto &thread : threads )
+            thread.join();
+
+        for( size_t thread=1; thread<NumThreads; ++thread )
+            CPPUNIT_ASSERT( results[thread]==results[0] );
+    }
+
+    void concurrentModules() {
+        prepareDummyCodeGen();
+
+        // The builtin types, and the types composed of them, are shared by all modules
+        static const char source[] =
+                "struct Point {\n"
+                "    def x : S32;\n"
+                "    def y : S32 = -1;\n"
+                "}\n"
+                "\n"
+                "def square( v : S32 ) -> S32 {\n"
+                "    v * v\n"
+                "}\n"
+                "\n"
+                "def main() -> S32 {\n"
+                "    def a : S32[4];\n"
+                "    def point : Point;\n"
+                "    def b : S32 = { 1 };\n"
+                "    def p : S32@ = b&;\n"
+                "    if( p@ == 0 ) {\n"
+                "        square( 42 );\n"
+                "    } else\n"
+                "        square( b );\n"
+                "    def c : S32 = if( b == 1 ) { 1 } else { 2 };\n"
+                "    c\n"
+                "}\n";
+
+        std::vector<std::thread> threads;
+        for( size_t thread=0; thread<8; ++thread ) {
+            threads.emplace_back( []() {
+                for( size_t i=0; i<20; ++i ) {
+                    CompilerArguments arguments;
+                    NonTerminals::Module module;
+                    module.parse( String( source, sizeof(source)-1 ), arguments );
+
+                    DummyModuleGen moduleGen;
+                    AST::AST ast;
+                    ast.codeGen( module, &moduleGen, arguments );
+                }
+            } );
+        }
+        for( auto &thread : threads )
+            thread.join();
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "StaticTypeTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<StaticTypeTest>(
+                    "interning",
+                    &StaticTypeTest::interning ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<StaticTypeTest>(
+                    "structDerivedTypes",
+                    &StaticTypeTest::structDerivedTypes ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<StaticTypeTest>(
+                    "concurrentInterning",
+                    &StaticTypeTest::concurrentInterning ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<StaticTypeTest>(
+                    "concurrentModules",
+                    &StaticTypeTest::concurrentModules ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( StaticTypeTest );
@@ -0,0 +1,223 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "symbol.h"
+
+#include "asserts.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Names are kept in blocks that never move, so that reading a name needs no lock. Block i holds FirstBlockSize<<i
+// names, so that a table with few names stays small, and the blocks cover all 31 bit indexes.
+static constexpr unsigned FirstBlockBits = 6;
+static constexpr size_t FirstBlockSize = 1<<FirstBlockBits;
+static constexpr size_t NumBlocks = 31 - FirstBlockBits + 1;
+// Spellings are copied into chunks of this size. Longer spellings get a chunk of their own.
+static constexpr size_t ChunkSize = 64*1024;
+// Modules intern from few threads at a time. The process wide table is looked in by all of them.
+static constexpr size_t ModuleShards = 8;
+static constexpr size_t ProcessWideShards = 64;
+// Set in the ids of symbols interned into a module's table, clear in those of the process wide table
+static constexpr uint32_t ModuleBit = 1u<<31;
+
+// Interning locks only the shard the spelling hashes to
+struct Shard {
+    std::mutex lock;
+    std::unordered_map< String, uint32_t > ids;
+    std::vector< std::unique_ptr<char[]> > chunks;
+    size_t chunkUsed = 0;
+
+    String copy(String spelling) {
+        if( spelling.size()>ChunkSize/4 ) {
+            chunks.emplace_back( new char[ spelling.size() ] );
+            memcpy( chunks.back().get(), spelling.get(), spelling.size() );
+
+            return String( chunks.back().get(), spelling.size() );
+        }
+
+        if( chunks.empty() || chunkUsed+spelling.size() > ChunkSize ) {
+            chunks.emplace_back( new char[ChunkSize] );
+            chunkUsed = 0;
+        }
+
+        char *name = chunks.back().get() + chunkUsed;
+        memcpy( name, spelling.get(), spelling.size() );
+        chunkUsed += spelling.size();
+
+        return String( name, spelling.size() );
+    }
+};
+
+// Most spellings are interned many times over. A small cache per thread saves taking the shard lock for them.
+struct CacheEntry {
+    size_t hash;
+    uint64_t serial;
+    Symbol symbol;
+};
+static constexpr size_t CacheSize = 1024;
+thread_local CacheEntry cache[CacheSize];
+
+std::atomic<uint64_t> nextSerial{1};
+
+// Block i starts at index FirstBlockSize*(2^i - 1)
+unsigned blockOf(uint32_t index) {
+    return 63 - __builtin_clzll( uint64_t(index) + FirstBlockSize ) - FirstBlockBits;
+}
+
+size_t offsetInBlock(uint32_t index, unsigned block) {
+    return uint64_t(index) + FirstBlockSize - ( uint64_t(FirstBlockSize) << block );
+}
+
+} // Anonymous namespace
+
+struct SymbolTable::Impl {
+    // ModuleBit for a module's table, 0 for the process wide one
+    const uint32_t idBase;
+    // Looked in before adding a spelling. Null for the process wide table.
+    SymbolTable *const processWide;
+
+    const size_t numShards;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<uint32_t> nextIndex{1};
+    std::atomic<String *> blocks[NumBlocks] = {};
+
+    Impl(uint32_t idBase, SymbolTable *processWide, size_t numShards) :
+        idBase(idBase), processWide(processWide), numShards(numShards), shards( new Shard[numShards] )
+    {}
+
+    Shard &shardOf(size_t hash) {
+        return shards[ ( hash / CacheSize ) % numShards ];
+    }
+
+    ~Impl() {
+        for( std::atomic<String *> &block : blocks )
+            delete[] block.load( std::memory_order_relaxed );
+    }
+
+    String *block(unsigned block) {
+        std::atomic<String *> &slot = blocks[block];
+
+        String *names = slot.load( std::memory_order_acquire );
+        if( names!=nullptr )
+            return names;
+
+        std::unique_ptr<String[]> newNames( new String[ FirstBlockSize<<block ] );
+        if( slot.compare_exchange_strong( names, newNames.get(), std::memory_order_acq_rel ) )
+            return newNames.release();
+
+        // Another thread got there first
+        return names;
+    }
+};
+
+SymbolTable::SymbolTable(ProcessWide) :
+    impl( new Impl( 0, nullptr, ProcessWideShards ) ),
+    serial( nextSerial.fetch_add( 1, std::memory_order_relaxed ) )
+{}
+
+SymbolTable::SymbolTable() :
+    impl( new Impl( ModuleBit, &processWide(), ModuleShards ) ),
+    serial( nextSerial.fetch_add( 1, std::memory_order_relaxed ) )
+{}
+
+SymbolTable::~SymbolTable() {
+    ASSERT( active!=this ) << "Symbol table destroyed while active";
+}
+
+SymbolTable &SymbolTable::processWide() {
+    // Constructed on first use, so that symbols can be interned during static initialization
+    static SymbolTable *instance = new SymbolTable( ProcessWide{} );
+
+    return *instance;
+}
+
+Symbol SymbolTable::intern(String spelling) {
+    size_t hash = std::hash<String>()( spelling );
+
+    CacheEntry &cached = cache[ hash % CacheSize ];
+    if( cached.symbol && cached.serial==serial && cached.hash==hash && getName( cached.symbol )==spelling )
+        return cached.symbol;
+
+    Shard &shard = impl->shardOf( hash );
+
+    Symbol symbol;
+    {
+        std::unique_lock<std::mutex> lock( shard.lock );
+
+        auto iter = shard.ids.find( spelling );
+        if( iter!=shard.ids.end() ) {
+            symbol = Symbol( iter->second );
+        } else if( impl->processWide!=nullptr && ( symbol = impl->processWide->find( spelling, hash ) ) ) {
+            // The process wide name outlives this table
+            shard.ids.emplace( impl->processWide->getName( symbol ), symbol.id );
+        } else {
+            uint32_t index = impl->nextIndex.fetch_add( 1, std::memory_order_relaxed );
+            ASSERT( index<ModuleBit ) << "Too many distinct identifiers";
+
+            String name = shard.copy( spelling );
+            unsigned block = blockOf( index );
+            impl->block( block )[ offsetInBlock( index, block ) ] = name;
+            symbol = Symbol( impl->idBase | index );
+            shard.ids.emplace( name, symbol.id );
+        }
+    }
+
+    cached.hash = hash;
+    cached.serial = serial;
+    cached.symbol = symbol;
+
+    return symbol;
+}
+
+String SymbolTable::getName(Symbol symbol) const {
+    if( !symbol )
+        return String();
+
+    if( ( symbol.id & ModuleBit ) != impl->idBase ) {
+        ASSERT( impl->processWide!=nullptr ) << "Symbol " << symbol.id << " of a module's table named outside of it";
+        return impl->processWide->getName( symbol );
+    }
+
+    uint32_t index = symbol.id & ~ModuleBit;
+    ASSERT( index<impl->nextIndex.load( std::memory_order_relaxed ) ) << "Symbol " << symbol.id << " is not of this table";
+    unsigned block = blockOf( index );
+    String *names = impl->blocks[block].load( std::memory_order_acquire );
+    ASSERT( names!=nullptr ) << "Symbol " << symbol.id << " is not of this table";
+
+    return names[ offsetInBlock( index, block ) ];
+}
+
+Symbol SymbolTable::find(String spelling, size_t hash) {
+    Shard &shard = impl->shardOf( hash );
+    std::unique_lock<std::mutex> lock( shard.lock );
+
+    auto iter = shard.ids.find( spelling );
+    if( iter==shard.ids.end() )
+        return Symbol();
+
+    return Symbol( iter->second );
+}
+
+Symbol Symbol::intern(String spelling) {
+    return SymbolTable::getActive().intern( spelling );
+}
+
+String Symbol::getName() const {
+    return SymbolTable::getActive().getName( *this );
+}
+
+std::ostream &operator<<(std::ostream &out, Symbol symbol) {
+    return out << symbol.getName();
+}
@@ -0,0 +1,137 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include "nocopy.h"
+
+#include <practical/slice.h>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+// An interned identifier spelling. Each distinct spelling is interned once per SymbolTable, so two symbols from the
+// same table are equal exactly when their spellings are, and comparing or hashing a symbol is comparing or hashing a 32
+// bit id.
+//
+// Symbols are interned into, and named by, the table active on the current thread. See SymbolTable.
+//
+// A symbol's id only means something together with the table it came from. Every module's table hands out the same
+// ids, so symbols of two modules can be equal though their spellings differ, and naming a symbol while another
+// module's table is active gives some other spelling, or fails if that table has fewer names. Only symbols of the
+// process wide table mean the same in every table.
+class Symbol {
+    uint32_t id = 0;
+
+    constexpr explicit Symbol(uint32_t id) : id(id) {}
+
+    friend class SymbolTable;
+
+public:
+    // The null symbol, which has no spelling
+    constexpr Symbol() = default;
+
+    // The symbol spelled spelling in the active table, adding it if it's new. The spelling is copied.
+    static Symbol intern(String spelling);
+
+    // Valid for the life of the table the symbol was interned into
+    String getName() const;
+
+    uint32_t getId() const {
+        return id;
+    }
+
+    explicit operator bool() const {
+        return id!=0;
+    }
+
+    bool operator==(Symbol that) const {
+        return id==that.id;
+    }
+
+    bool operator!=(Symbol that) const {
+        return id!=that.id;
+    }
+
+    bool operator<(Symbol that) const {
+        return id<that.id;
+    }
+};
+
+// The spellings interned for one module, freed with it. Spellings that are already in the process wide table (the
+// builtin types and operators, interned while preparing) get the process wide symbol, so a module's symbols can be
+// looked up in the builtin context. Spellings added to the process wide table after a module's table was asked for them
+// are not seen by that module.
+//
+// Interning is thread safe. Getting a symbol's name takes no lock.
+class SymbolTable : private NoCopy {
+    struct Impl;
+
+    std::unique_ptr<Impl> impl;
+    // Tells tables apart in the per thread cache, even ones allocated at the same address
+    uint64_t serial;
+
+    static inline thread_local SymbolTable *active = nullptr;
+
+    struct ProcessWide {};
+    explicit SymbolTable(ProcessWide);
+
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    Symbol intern(String spelling);
+    String getName(Symbol symbol) const;
+
+    // The table of symbols interned while no other table is active. Lives as long as the process.
+    static SymbolTable &processWide();
+
+    // The table Symbol::intern and Symbol::getName use on the current thread
+    static SymbolTable &getActive() {
+        return active!=nullptr ? *active : processWide();
+    }
+
+    // Whether a Scope made some table active on the current thread
+    static bool isScoped() {
+        return active!=nullptr;
+    }
+
+    // Make table the active table of the current thread for the scope's lifetime
+    class Scope : private NoCopy {
+        SymbolTable *previous;
+
+    public:
+        explicit Scope(SymbolTable &table) : previous(active) {
+            active = &table;
+        }
+
+        ~Scope() {
+            active = previous;
+        }
+    };
+
+private:
+    // The symbol spelled spelling, or the null symbol if it was not interned into this table
+    Symbol find(String spelling, size_t hash);
+};
+
+std::ostream &operator<<(std::ostream &out, Symbol symbol);
+
+namespace std {
+    template<>
+    struct hash< Symbol > {
+        size_t operator()( Symbol symbol ) const {
+            return symbol.getId() * FibonacciHashMultiplier;
+        }
+    };
+}
+
+#endif // SYMBOL_H
@@ -0,0 +1,127 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "symbol.h"
+#include "token_stream.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+class SymbolTest : public CppUnit::TestFixture  {
+    void interning() {
+        std::string first = "someIdentifier", second = "someIdentifier";
+
+        Symbol symbol = Symbol::intern( first );
+        CPPUNIT_ASSERT( symbol );
+        CPPUNIT_ASSERT( Symbol::intern( second )==symbol );
+        CPPUNIT_ASSERT( Symbol::intern( "someOtherIdentifier" )!=symbol );
+
+        // The name is a copy, which outlives the spelling it was interned from
+        first.assign( first.size(), 'x' );
+        CPPUNIT_ASSERT( symbol.getName()==String("someIdentifier") );
+        CPPUNIT_ASSERT( symbol.getName().get()!=second.c_str() );
+
+        CPPUNIT_ASSERT( !Symbol() );
+        CPPUNIT_ASSERT( Symbol().getName().size()==0 );
+    }
+
+    void identifierTokens() {
+        std::string source = "def a : U32 = a + b;";
+        Tokenizer::TokenStream tokens = Tokenizer::TokenStream::tokenize( source );
+
+        // Tokenized outside of any module, so the identifiers are not added to the process wide table
+        CPPUNIT_ASSERT( &tokens.getSymbolTable()!=&SymbolTable::processWide() );
+        SymbolTable::Scope scope( tokens.getSymbolTable() );
+
+        CPPUNIT_ASSERT( tokens.symbol(1)==Symbol::intern("a") );
+        CPPUNIT_ASSERT( tokens.symbol(1).getName()==String("a") );
+        CPPUNIT_ASSERT( tokens.symbol(1)==tokens.symbol(5) );
+        CPPUNIT_ASSERT( tokens.symbol(3)==Symbol::intern("U32") );
+        CPPUNIT_ASSERT( tokens.symbol(7)==Symbol::intern("b") );
+        // Only identifiers have symbols
+        CPPUNIT_ASSERT( !tokens.symbol(0) );
+        CPPUNIT_ASSERT( !tokens.symbol(6) );
+    }
+
+    void moduleTables() {
+        Symbol builtin = Symbol::intern( "moduleTablesBuiltin" );
+
+        std::string source = "a moduleTablesBuiltin a";
+        Symbol local;
+        {
+            SymbolTable table;
+            SymbolTable::Scope scope( table );
+
+            // Spellings the process wide table already has keep their symbol
+            CPPUNIT_ASSERT( Symbol::intern( "moduleTablesBuiltin" )==builtin );
+            CPPUNIT_ASSERT( builtin.getName()==String("moduleTablesBuiltin") );
+
+            Tokenizer::TokenStream tokens = Tokenizer::TokenStream::tokenize( source );
+            local = Symbol::intern( "a" );
+            CPPUNIT_ASSERT( tokens.symbol(0)==local );
+            CPPUNIT_ASSERT( tokens.symbol(1)==builtin );
+            CPPUNIT_ASSERT( tokens.symbol(2)==local );
+            CPPUNIT_ASSERT( local.getName()==String("a") );
+        }
+
+        // A new table knows nothing of the old one's spellings, even ones the thread cached
+        SymbolTable table;
+        SymbolTable::Scope scope( table );
+        Symbol again = Symbol::intern( "a" );
+        CPPUNIT_ASSERT( again.getName()==String("a") );
+        CPPUNIT_ASSERT( Symbol::intern( "moduleTablesBuiltin" )==builtin );
+    }
+
+    void concurrentInterning() {
+        static constexpr size_t NumThreads = 8, NumSpellings = 5000;
+
+        std::vector< std::vector<Symbol> > symbols( NumThreads );
+        std::vector<std::thread> threads;
+        for( size_t thread=0; thread<NumThreads; ++thread ) {
+            threads.emplace_back( [&symbols, thread]() {
+                        for( size_t i=0; i<NumSpellings; ++i ) {
+                            std::string spelling = "concurrent" + std::to_string( i );
+                            symbols[thread].push_back( Symbol::intern( spelling ) );
+                        }
+                    } );
+        }
+        for( std::thread &thread : threads )
+            thread.join();
+
+        for( size_t i=0; i<NumSpellings; ++i ) {
+            for( size_t thread=1; thread<NumThreads; ++thread )
+                CPPUNIT_ASSERT( symbols[thread][i]==symbols[0][i] );
+
+            CPPUNIT_ASSERT( symbols[0][i].getName()==String( "concurrent" + std::to_string( i ) ) );
+        }
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "SymbolTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<SymbolTest>(
+                    "interning",
+                    &SymbolTest::interning ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<SymbolTest>(
+                    "identifierTokens",
+                    &SymbolTest::identifierTokens ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<SymbolTest>(
+                    "moduleTables",
+                    &SymbolTest::moduleTables ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<SymbolTest>(
+                    "concurrentInterning",
+                    &SymbolTest::concurrentInterning ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SymbolTest );
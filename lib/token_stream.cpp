@@ -0,0 +1,309 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "token_stream.h"
+
+#include "asserts.h"
+
+#include <practical/errors.h>
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <thread>
+
+using PracticalSemanticAnalyzer::tokenizer_error;
+
+namespace Tokenizer {
+
+// Rough average sizes, used to pre-size the arrays from the file's length so that they rarely need to grow
+static constexpr size_t BytesPerToken = 6;
+static constexpr size_t BytesPerTrivia = 8;
+// Files are not split into chunks smaller than this. Smaller chunks don't justify the cost of starting a thread.
+static constexpr size_t MinChunkSize = 256*1024;
+
+// First index in [0, count) for which pred is true, or count if there is none. pred must be false for all indexes
+// before that one and true for all indexes after it.
+template<typename Pred>
+static size_t firstIndexWhere(size_t count, Pred pred) {
+    size_t low = 0, high = count;
+    while( low<high ) {
+        size_t middle = low + (high-low)/2;
+        if( pred(middle) )
+            high = middle;
+        else
+            low = middle+1;
+    }
+
+    return low;
+}
+
+TokenStream TokenStream::tokenize(String source, unsigned threads) {
+    if( source.size() > std::numeric_limits<uint32_t>::max() )
+        throw tokenizer_error("Source file too big", SourceLocation{ .line=1, .col=1 });
+
+    if( !SymbolTable::isScoped() ) {
+        // Otherwise the identifiers would stay in the process wide table for as long as the process lives
+        std::shared_ptr<SymbolTable> ownSymbols = std::make_shared<SymbolTable>();
+        SymbolTable::Scope symbolScope( *ownSymbols );
+
+        TokenStream stream = tokenize( source, threads );
+        stream.ownSymbols = std::move( ownSymbols );
+
+        return stream;
+    }
+
+    if( threads==0 )
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+
+    size_t numChunks = std::min<size_t>( threads, source.size() / MinChunkSize );
+    if( numChunks>1 )
+        return tokenizeParallel( source, numChunks );
+
+    return tokenizeSequential( source, SymbolTable::getActive() );
+}
+
+TokenStream TokenStream::restore(
+        String source, std::vector<Tokens> &&kinds, std::vector<uint32_t> &&offsets, std::vector<uint32_t> &&lengths)
+{
+    ASSERT( kinds.size()==offsets.size() && kinds.size()==lengths.size() ) << "Restored token arrays differ in size";
+
+    TokenStream stream(source, SymbolTable::getActive());
+    stream.kinds = std::move(kinds);
+    stream.offsets = std::move(offsets);
+    stream.lengths = std::move(lengths);
+    stream.symbols.reserve( stream.size() );
+    for( size_t i=0; i<stream.size(); ++i )
+        stream.symbols.push_back( stream.tokenSymbol( stream.kinds[i], stream.text(i) ) );
+    stream.lineIndex = LineIndex(source);
+
+    return stream;
+}
+
+TokenStream TokenStream::tokenizeSequential(String source, SymbolTable &symbolTable) {
+    TokenStream stream(source, symbolTable);
+
+    size_t expectedTokens = source.size() / BytesPerToken + 1;
+    stream.kinds.reserve( expectedTokens );
+    stream.offsets.reserve( expectedTokens );
+    stream.lengths.reserve( expectedTokens );
+    stream.symbols.reserve( expectedTokens );
+    stream.trivia.reserve( source.size() / BytesPerTrivia + 1 );
+
+    Tokenizer tokenizer(source);
+    while( tokenizer.next() ) {
+        Slice<const char> text = tokenizer.currentTokenText();
+        uint32_t offset = tokenizer.currentOffset();
+        uint32_t length = text.size();
+        Tokens kind = tokenizer.currentToken();
+
+        stream.push( kind, offset, length );
+    }
+
+    stream.lineIndex = tokenizer.getLineIndex();
+
+    return stream;
+}
+
+TokenStream TokenStream::tokenizeParallel(String source, size_t numChunks) {
+    // Each chunk indexes its own lines. The splitter's locations would only appear in errors it ignores.
+    Tokenizer splitter( source, LineIndex() );
+    std::vector<size_t> splitPoints = splitter.findSplitPoints( numChunks );
+    splitPoints.push_back( source.size() );
+
+    // The chunks are tokenized on other threads, so their symbols must be interned into this thread's table
+    SymbolTable &symbolTable = SymbolTable::getActive();
+    std::vector<TokenStream> chunks( splitPoints.size(), TokenStream(source, symbolTable) );
+    std::vector<std::exception_ptr> errors( splitPoints.size() );
+
+    auto tokenizeChunk = [&]( size_t chunk ) {
+        size_t start = chunk==0 ? 0 : splitPoints[chunk-1];
+        try {
+            chunks[chunk] = tokenizeSequential( source.subslice( start, splitPoints[chunk] ), symbolTable );
+        } catch(...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve( splitPoints.size()-1 );
+    for( size_t chunk=1; chunk<splitPoints.size(); ++chunk )
+        threads.emplace_back( tokenizeChunk, chunk );
+    tokenizeChunk( 0 );
+
+    for( std::thread &thread : threads )
+        thread.join();
+
+    for( const std::exception_ptr &error : errors ) {
+        if( error ) {
+            // Let the sequential tokenizer report the error, so that it is the same error a single threaded run would
+            // report
+            return tokenizeSequential( source, symbolTable );
+        }
+    }
+
+    TokenStream stream(source, symbolTable);
+    for( size_t chunk=0; chunk<chunks.size(); ++chunk ) {
+        size_t start = chunk==0 ? 0 : splitPoints[chunk-1];
+        stream.append( chunks[chunk], 0, 0, start );
+
+        // Chunks start at the start of a line
+        if( chunk==0 )
+            stream.lineIndex = std::move( chunks[chunk].lineIndex );
+        else
+            stream.lineIndex.append( chunks[chunk].lineIndex, start );
+    }
+
+    return stream;
+}
+
+TokenStream::Update TokenStream::retokenize(String newSource, const Edit &edit) const {
+    ASSERT( edit.offset + edit.removedLength <= source.size() ) << "Edit outside of the source";
+    ASSERT( newSource.size() == source.size() - edit.removedLength + edit.insertedText.size() ) <<
+            "Edited source doesn't match the edit";
+
+    if( newSource.size() > std::numeric_limits<uint32_t>::max() )
+        throw tokenizer_error("Source file too big", SourceLocation{ .line=1, .col=1 });
+
+    // Whether tokenizing the element starting at offset reads anything at or after the edit. If not, tokenizing the
+    // new source produces the same element.
+    auto affected = [&edit]( uint32_t offset, uint32_t length ) {
+        return offset + std::max<size_t>( length, Tokenizer::MaxOperatorLength ) >= edit.offset;
+    };
+    size_t firstToken = firstIndexWhere( size(), [&]( size_t index ) {
+                return affected( offsets[index], lengths[index] );
+            } );
+    size_t firstTrivia = firstIndexWhere( trivia.size(), [&]( size_t index ) {
+                return affected( trivia[index].offset, trivia[index].length );
+            } );
+
+    // Every element before the first affected one is kept. The element containing the edit's offset is always
+    // affected, so we restart at or before it.
+    size_t restart = edit.offset;
+    if( firstToken<size() )
+        restart = std::min<size_t>( restart, offsets[firstToken] );
+    if( firstTrivia<trivia.size() )
+        restart = std::min<size_t>( restart, trivia[firstTrivia].offset );
+
+    Update update{
+            .stream = TokenStream(newSource, *symbolTable), .firstChanged = firstToken, .oldEnd = size(), .newEnd = 0 };
+    TokenStream &stream = update.stream;
+    stream.ownSymbols = ownSymbols;
+    stream.kinds.assign( kinds.begin(), kinds.begin() + firstToken );
+    stream.offsets.assign( offsets.begin(), offsets.begin() + firstToken );
+    stream.lengths.assign( lengths.begin(), lengths.begin() + firstToken );
+    stream.symbols.assign( symbols.begin(), symbols.begin() + firstToken );
+    stream.trivia.assign( trivia.begin(), trivia.begin() + firstTrivia );
+
+    Tokenizer tokenizer( newSource, lineIndex.edited( edit.offset, edit.removedLength, edit.insertedText ) );
+    tokenizer.restorePosition( Tokenizer::SavedPoint{ .position=restart } );
+
+    const size_t editEnd = edit.offset + edit.insertedText.size();
+    const int64_t shift = int64_t(edit.insertedText.size()) - int64_t(edit.removedLength);
+    size_t oldToken = firstToken, oldTrivia = firstTrivia;
+    bool resynced = false;
+    while( tokenizer.next() ) {
+        size_t offset = tokenizer.currentOffset();
+        if( offset>=editEnd ) {
+            // Past the edit, the new source is the same as the old one. If an old element started at the same place,
+            // so will all the ones that follow it.
+            size_t oldOffset = offset - shift;
+            while( oldToken<size() && offsets[oldToken]<oldOffset )
+                oldToken++;
+            while( oldTrivia<trivia.size() && trivia[oldTrivia].offset<oldOffset )
+                oldTrivia++;
+
+            if(
+                    ( oldToken<size() && offsets[oldToken]==oldOffset ) ||
+                    ( oldTrivia<trivia.size() && trivia[oldTrivia].offset==oldOffset ) )
+            {
+                resynced = true;
+                break;
+            }
+        }
+
+        stream.push( tokenizer.currentToken(), offset, tokenizer.currentTokenText().size() );
+    }
+
+    if( !resynced ) {
+        oldToken = size();
+        oldTrivia = trivia.size();
+    }
+
+    update.oldEnd = oldToken;
+    update.newEnd = stream.size();
+    stream.append( *this, oldToken, oldTrivia, shift );
+    stream.lineIndex = tokenizer.getLineIndex();
+
+    // Tokenizing restarted a little before the edit, and might have only resynchronized a little after it. Don't
+    // report tokens that came out the same.
+    while(
+            update.firstChanged<update.oldEnd && update.firstChanged<update.newEnd &&
+            offsets[update.firstChanged] + lengths[update.firstChanged] <= edit.offset &&
+            kinds[update.firstChanged]==stream.kinds[update.firstChanged] &&
+            offsets[update.firstChanged]==stream.offsets[update.firstChanged] &&
+            lengths[update.firstChanged]==stream.lengths[update.firstChanged] )
+    {
+        update.firstChanged++;
+    }
+    while(
+            update.oldEnd>update.firstChanged && update.newEnd>update.firstChanged &&
+            stream.offsets[update.newEnd-1] >= editEnd &&
+            kinds[update.oldEnd-1]==stream.kinds[update.newEnd-1] &&
+            offsets[update.oldEnd-1] + shift == stream.offsets[update.newEnd-1] &&
+            lengths[update.oldEnd-1]==stream.lengths[update.newEnd-1] )
+    {
+        update.oldEnd--;
+        update.newEnd--;
+    }
+
+    return update;
+}
+
+void TokenStream::erase(size_t begin, size_t end) {
+    ASSERT( begin<=end && end<=size() ) << "Erasing tokens [" << begin << ", " << end << ") of " << size();
+
+    kinds.erase( kinds.begin() + begin, kinds.begin() + end );
+    offsets.erase( offsets.begin() + begin, offsets.begin() + end );
+    lengths.erase( lengths.begin() + begin, lengths.begin() + end );
+    symbols.erase( symbols.begin() + begin, symbols.begin() + end );
+}
+
+void TokenStream::push(Tokens kind, uint32_t offset, uint32_t length) {
+    if( isTrivia(kind) ) {
+        trivia.push_back( Trivia{ .offset=offset, .length=length, .kind=kind } );
+    } else {
+        kinds.push_back( kind );
+        offsets.push_back( offset );
+        lengths.push_back( length );
+        symbols.push_back( tokenSymbol( kind, source.subslice( offset, offset+length ) ) );
+    }
+}
+
+void TokenStream::append(const TokenStream &other, size_t firstToken, size_t firstTrivia, int64_t shift) {
+    kinds.insert( kinds.end(), other.kinds.begin() + firstToken, other.kinds.end() );
+    lengths.insert( lengths.end(), other.lengths.begin() + firstToken, other.lengths.end() );
+    symbols.insert( symbols.end(), other.symbols.begin() + firstToken, other.symbols.end() );
+
+    offsets.reserve( offsets.size() + other.offsets.size() - firstToken );
+    for( size_t i=firstToken; i<other.offsets.size(); ++i )
+        offsets.push_back( uint32_t(other.offsets[i] + shift) );
+
+    trivia.reserve( trivia.size() + other.trivia.size() - firstTrivia );
+    for( size_t i=firstTrivia; i<other.trivia.size(); ++i ) {
+        const Trivia &entry = other.trivia[i];
+        trivia.push_back( Trivia{ .offset = uint32_t(entry.offset + shift), .length = entry.length, .kind = entry.kind } );
+    }
+}
+
+} // namespace Tokenizer
+
+std::ostream &operator<<(std::ostream &out, Tokenizer::TokenRef token) {
+    out<<token.kind()<<" ("<<token.text()<<") at "<<token.location();
+    return out;
+}
@@ -0,0 +1,282 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "asserts.h"
+#include "line_index.h"
+#include "symbol.h"
+#include "tokenizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace Tokenizer {
+
+// Compact representation of a tokenized source file.
+//
+// Tokens are kept as parallel arrays rather than as an array of Token. White space and comments ("trivia") are kept
+// in a separate table, so that the parser never has to see them. Locations are not stored, and are computed from the
+// offsets using the file's line index. Identifiers are interned once, as they are added to the stream, into the symbol
+// table that was active when the stream was created. A stream tokenized while no table is active (i.e. outside of any
+// module) gets a table of its own, shared by its copies and freed with the last of them.
+class TokenStream {
+public:
+    struct Trivia {
+        uint32_t offset;
+        uint32_t length;
+        Tokens kind;
+    };
+
+private:
+    String source;
+    std::shared_ptr<SymbolTable> ownSymbols;
+    SymbolTable *symbolTable = &SymbolTable::getActive();
+
+    std::vector<Tokens> kinds;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    // Null for all tokens but identifiers
+    std::vector<Symbol> symbols;
+
+    std::vector<Trivia> trivia;
+
+    LineIndex lineIndex;
+
+public:
+    // A change to the source: removedLength bytes at offset were replaced with insertedText
+    struct Edit {
+        size_t offset;
+        size_t removedLength;
+        String insertedText;
+    };
+
+    struct Update;
+
+    // With more than one thread, large files are split into chunks that are tokenized in parallel. The result is
+    // identical to tokenizing with a single thread.
+    static TokenStream tokenize(String source, unsigned threads = 1);
+
+    // The stream of source's tokens, as found by an earlier tokenize of it (e.g. one kept in a cache). Trivia is not
+    // restored. Identifiers are interned again.
+    static TokenStream restore(
+            String source, std::vector<Tokens> &&kinds, std::vector<uint32_t> &&offsets,
+            std::vector<uint32_t> &&lengths);
+
+    // An empty stream
+    TokenStream() = default;
+
+    // Tokenize newSource, which must be this stream's source with edit applied. Only the text from the last token
+    // the edit could not have affected, up to the point where the tokens line up with this stream's again, is
+    // actually tokenized. The rest is copied from this stream. New identifiers are interned into this stream's table.
+    //
+    // Throws tokenizer_error if the edited source fails to tokenize.
+    Update retokenize(String newSource, const Edit &edit) const;
+
+    // The table the stream's symbols are interned into. Symbols are named by the active table, so activate this one to
+    // name them.
+    SymbolTable &getSymbolTable() const {
+        return *symbolTable;
+    }
+
+    size_t size() const {
+        return kinds.size();
+    }
+
+    Tokens kind(size_t index) const {
+        return kinds[index];
+    }
+
+    uint32_t offset(size_t index) const {
+        return offsets[index];
+    }
+
+    uint32_t length(size_t index) const {
+        return lengths[index];
+    }
+
+    String text(size_t index) const {
+        return source.subslice( offsets[index], offsets[index] + lengths[index] );
+    }
+
+    SourceLocation location(size_t index) const {
+        return lineIndex.location( offsets[index] );
+    }
+
+    const LineIndex &getLineIndex() const {
+        return lineIndex;
+    }
+
+    Symbol symbol(size_t index) const {
+        return symbols[index];
+    }
+
+    Token token(size_t index) const {
+        return Token{
+                .text = text(index), .token = kind(index), .location = location(index) };
+    }
+
+    const std::vector<Trivia> &getTrivia() const {
+        return trivia;
+    }
+
+    // Remove tokens [begin, end). The tokens that remain keep their offsets, and so their text and locations.
+    void erase(size_t begin, size_t end);
+
+    static bool isTrivia(Tokens kind) {
+        return kind==Tokens::WS || kind==Tokens::COMMENT_LINE_END || kind==Tokens::COMMENT_MULTILINE;
+    }
+
+private:
+    TokenStream(String source, SymbolTable &symbolTable) : source(source), symbolTable(&symbolTable) {}
+
+    static TokenStream tokenizeSequential(String source, SymbolTable &symbolTable);
+    static TokenStream tokenizeParallel(String source, size_t numChunks);
+
+    // The symbol to keep for a token of kind kind with the specified text
+    Symbol tokenSymbol(Tokens kind, String text) const {
+        return kind==Tokens::IDENTIFIER ? symbolTable->intern( text ) : Symbol();
+    }
+
+    void push(Tokens kind, uint32_t offset, uint32_t length);
+    // Append other's tokens and trivia, starting at the specified indexes, with their offsets moved by shift
+    void append(const TokenStream &other, size_t firstToken, size_t firstTrivia, int64_t shift);
+};
+
+// Tokens [firstChanged, oldEnd) of the previous stream were replaced by tokens [firstChanged, newEnd) of stream.
+// Tokens from oldEnd onwards are the same as the ones from newEnd onwards, only moved by the edit.
+struct TokenStream::Update {
+    TokenStream stream;
+    size_t firstChanged;
+    size_t oldEnd;
+    size_t newEnd;
+};
+
+// One of a TokenStream's tokens, by index. This is what the parse tree keeps of a token: anything beyond its kind and
+// offset is computed from the stream when asked for. A default constructed reference refers to no token.
+class TokenRef {
+    const TokenStream *stream = nullptr;
+    uint32_t index = 0;
+
+public:
+    TokenRef() = default;
+    TokenRef(const TokenStream &stream, size_t index) : stream(&stream), index(index) {}
+
+    explicit operator bool() const {
+        return stream!=nullptr;
+    }
+
+    bool operator==(const TokenRef &rhs) const {
+        return stream==rhs.stream && index==rhs.index;
+    }
+
+    bool operator!=(const TokenRef &rhs) const {
+        return !( *this==rhs );
+    }
+
+    const TokenStream &getStream() const {
+        return *stream;
+    }
+
+    size_t getIndex() const {
+        return index;
+    }
+
+    Tokens kind() const {
+        return stream->kind(index);
+    }
+
+    uint32_t offset() const {
+        return stream->offset(index);
+    }
+
+    String text() const {
+        return stream->text(index);
+    }
+
+    SourceLocation location() const {
+        return stream->location(index);
+    }
+
+    Symbol symbol() const {
+        return stream->symbol(index);
+    }
+};
+
+// A range of a TokenStream's tokens. This is what NonTerminals parse.
+class TokenSlice {
+    const TokenStream *stream = nullptr;
+    uint32_t start = 0, length = 0;
+
+public:
+    TokenSlice() = default;
+    /* implicit */ TokenSlice(const TokenStream &stream) : stream(&stream), length(stream.size()) {}
+
+    size_t size() const {
+        return length;
+    }
+
+    Tokens kind(size_t index) const {
+        ASSERT( index<length ) << "Token " << index << " of a slice of " << length;
+        return stream->kind( start+index );
+    }
+
+    TokenRef operator[](size_t index) const {
+        ASSERT( index<length ) << "Token " << index << " of a slice of " << length;
+        return TokenRef( *stream, start+index );
+    }
+
+    TokenSlice subslice(size_t begin) const {
+        return subslice( begin, length );
+    }
+
+    TokenSlice subslice(size_t begin, size_t end) const {
+        TokenSlice ret = *this;
+        if( end<=begin ) {
+            ret.start += std::min<size_t>( begin, length );
+            ret.length = 0;
+
+            return ret;
+        }
+
+        ASSERT( end<=length ) << "Subslice ending at " << end << " of a slice of " << length;
+        ret.start += begin;
+        ret.length = end - begin;
+
+        return ret;
+    }
+
+    const TokenStream *getStream() const {
+        return stream;
+    }
+
+    // The index, in the stream, of the slice's first token
+    size_t getStart() const {
+        return start;
+    }
+};
+
+} // namespace Tokenizer
+
+std::ostream &operator<<(std::ostream &out, Tokenizer::TokenRef token);
+
+namespace std {
+    template<>
+    struct hash< Tokenizer::TokenRef > {
+        size_t operator()( Tokenizer::TokenRef token ) const {
+            return token.getIndex() * FibonacciHashMultiplier;
+        }
+    };
+}
+
+#endif // TOKEN_STREAM_H
@@ -9,30 +9,30 @@
 #include <tokenizer.h>
 
 #include "asserts.h"
+#include "tokenizer_scan.h"
 
 #include <practical/errors.h>
 
-#include <regex>
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <array>
 
 using PracticalSemanticAnalyzer::tokenizer_error;
 
 namespace Tokenizer {
 
-static const std::unordered_set<char> operatorChars = {
-    '~', '!', '#', '/', '$', '%', '^', '&', '*', '-', '=', '+', '<', '>', '.', '|', ':', '@' };
-static const std::unordered_map<String, Tokens> operators {
+namespace {
+
+struct OperatorDefinition {
+    const char *text;
+    Tokens token;
+};
+
+constexpr OperatorDefinition operatorDefinitions[] = {
     // Precedence 1
     { "::", Tokens::OP_DOUBLE_COLON },
     // Precedence 2
     { "++", Tokens::OP_PLUS_PLUS },
     { "--", Tokens::OP_MINUS_MINUS },
-    { "(", Tokens::BRACKET_ROUND_OPEN },
-    { ")", Tokens::BRACKET_ROUND_CLOSE },
-    { "[", Tokens::BRACKET_SQUARE_OPEN },
-    { "]", Tokens::BRACKET_SQUARE_CLOSE },
     { ".", Tokens::OP_DOT },
     { "->", Tokens::OP_ARROW },
     { "@", Tokens::OP_PTR },
@@ -80,12 +80,101 @@ static const std::unordered_map<String, Tokens> operators {
     // Miscellany
     { "+++", Tokens::OP_RUNON_ERROR },
     { "---", Tokens::OP_RUNON_ERROR },
-    { "&=", Tokens::OP_ASSIGN_BIT_AND },
     { ":", Tokens::OP_COLON },
     { "//", Tokens::COMMENT_LINE_END },
     { "/*", Tokens::COMMENT_MULTILINE },
 };
-static const std::unordered_map<std::string, Tokens> reservedWords {
+
+// Characters that start an operator. Brackets are handled directly by Tokenizer::next
+constexpr char operatorChars[] = "~!#/$%^&*-=+<>.|:@";
+
+// Longest match trie over operatorDefinitions, built at compile time.
+//
+// Each node is a prefix of at least one operator. token is ERR for prefixes that aren't, themselves, operators.
+class OperatorTrie {
+public:
+    static constexpr size_t NumChars = sizeof(operatorChars)-1;
+    static constexpr size_t MaxNodes = 64;
+    static constexpr uint8_t Root = 0;
+    // The root is never anyone's child, so we can use its index to mark a missing child
+    static constexpr uint8_t NoNode = Root;
+
+private:
+    static constexpr uint8_t NotOperatorChar = 0xff;
+
+    std::array< uint8_t, 256 > charIndex{};
+    std::array< std::array< uint8_t, NumChars >, MaxNodes > children{};
+    std::array< Tokens, MaxNodes > tokens{};
+    size_t numNodes = 1;
+
+public:
+    constexpr OperatorTrie() {
+        for( uint8_t &index : charIndex )
+            index = NotOperatorChar;
+        for( size_t i=0; i<NumChars; ++i )
+            charIndex[ static_cast<unsigned char>(operatorChars[i]) ] = i;
+
+        for( Tokens &token : tokens )
+            token = Tokens::ERR;
+
+        for( const OperatorDefinition &definition : operatorDefinitions ) {
+            uint8_t node = Root;
+            for( const char *chr = definition.text; *chr!='\0'; ++chr ) {
+                uint8_t &next = children[node][ charIndex[ static_cast<unsigned char>(*chr) ] ];
+                if( next==NoNode )
+                    next = numNodes++;
+                node = next;
+            }
+
+            tokens[node] = definition.token;
+        }
+    }
+
+    constexpr bool isOperatorChar( char chr ) const {
+        return charIndex[ static_cast<unsigned char>(chr) ] != NotOperatorChar;
+    }
+
+    constexpr uint8_t child( uint8_t node, char chr ) const {
+        uint8_t index = charIndex[ static_cast<unsigned char>(chr) ];
+        if( index==NotOperatorChar )
+            return NoNode;
+
+        return children[node][index];
+    }
+
+    constexpr Tokens token( uint8_t node ) const {
+        return tokens[node];
+    }
+
+    constexpr size_t size() const {
+        return numNodes;
+    }
+};
+
+constexpr OperatorTrie operatorTrie;
+
+constexpr size_t maxOperatorLength() {
+    size_t longest = 0;
+    for( const OperatorDefinition &definition : operatorDefinitions ) {
+        size_t length = 0;
+        while( definition.text[length]!='\0' )
+            length++;
+
+        longest = std::max( longest, length );
+    }
+
+    return longest;
+}
+static_assert( maxOperatorLength()==Tokenizer::MaxOperatorLength, "Tokenizer::MaxOperatorLength is out of date" );
+// Overflowing MaxNodes would fail the constexpr evaluation above, but make the error message clearer
+static_assert( operatorTrie.size()<=OperatorTrie::MaxNodes, "Operator trie too small" );
+
+struct ReservedWordDefinition {
+    const char *text;
+    Tokens token;
+};
+
+constexpr ReservedWordDefinition reservedWordDefinitions[] = {
     { "def", Tokens::RESERVED_DEF },
     { "decl", Tokens::RESERVED_DECL },
     { "expect", Tokens::RESERVED_EXPECT },
@@ -98,18 +187,79 @@ static const std::unordered_map<std::string, Tokens> reservedWords {
     { "struct", Tokens::RESERVED_STRUCT },
 };
 
+// Perfect hash over the reserved words, built at compile time.
+//
+// The hash only looks at the first and last characters, so an identifier is classified with at most one length
+// check and one comparison against a single candidate. Adding a reserved word that collides with an existing one
+// fails the build, in which case the hash function needs to change.
+class ReservedWordTable {
+public:
+    static constexpr size_t NumSlots = 16;
+
+private:
+    std::array< const char *, NumSlots > texts{};
+    std::array< size_t, NumSlots > lengths{};
+    std::array< Tokens, NumSlots > tokens{};
+    bool collision = false;
+
+    static constexpr size_t hash( char first, char last ) {
+        return ( static_cast<unsigned char>(first)*4 + static_cast<unsigned char>(last) ) % NumSlots;
+    }
+
+public:
+    constexpr ReservedWordTable() {
+        for( Tokens &token : tokens )
+            token = Tokens::IDENTIFIER;
+
+        for( const ReservedWordDefinition &definition : reservedWordDefinitions ) {
+            size_t length = 0;
+            while( definition.text[length]!='\0' )
+                ++length;
+
+            size_t slot = hash( definition.text[0], definition.text[length-1] );
+            if( texts[slot]!=nullptr )
+                collision = true;
+
+            texts[slot] = definition.text;
+            lengths[slot] = length;
+            tokens[slot] = definition.token;
+        }
+    }
+
+    constexpr bool hasCollisions() const {
+        return collision;
+    }
+
+    // Returns Tokens::IDENTIFIER if text is not a reserved word. text must not be empty
+    Tokens lookup( Slice<const char> text ) const {
+        size_t slot = hash( text[0], text[text.size()-1] );
+        if( lengths[slot]!=text.size() )
+            return Tokens::IDENTIFIER;
+
+        for( size_t i=0; i<text.size(); ++i ) {
+            if( texts[slot][i]!=text[i] )
+                return Tokens::IDENTIFIER;
+        }
+
+        return tokens[slot];
+    }
+};
+
+constexpr ReservedWordTable reservedWords;
+static_assert( !reservedWords.hasCollisions(), "Reserved words hash collision" );
+
+} // anonymous namespace
 
 bool Tokenizer::next() {
     if( file.size()==position ) {
         // We've reached our EOF
-        tokenLocation = location;
+        tokenStart = position;
         return false;
     }
 
     token = Tokens::ERR;
 
-    SourceLocation startLocation = location;
-    size_t tokenStart = position;
+    tokenStart = position;
     char currentChar = file[tokenStart];
     if(isWS(currentChar)) {
         consumeWS();
@@ -137,7 +287,7 @@ bool Tokenizer::next() {
     } else if(currentChar=='}') {
         nextChar();
         token = Tokens::BRACKET_CURLY_CLOSE;
-    } else if(operatorChars.find(currentChar) != operatorChars.end()) {
+    } else if(operatorTrie.isOperatorChar(currentChar)) {
         consumeOp();
     } else if(currentChar=='"') {
         consumeStringLiteral();
@@ -147,10 +297,9 @@ bool Tokenizer::next() {
         consumeIdentifier();
     } else {
         tokenText = file.subslice(tokenStart, tokenStart+1);
-        throw tokenizer_error("Invalid character encountered", startLocation);
+        throw tokenizer_error("Invalid character encountered", lineIndex.location(tokenStart));
     }
     tokenText = file.subslice(tokenStart, position);
-    tokenLocation = startLocation;
     ASSERT( token!=Tokens::ERR );
 
     return true;
@@ -161,51 +310,101 @@ std::vector<Token> Tokenizer::tokenize(String source) {
 
     Tokenizer tokenizer(source);
 
+    // Tokens are produced in increasing offset order, so their lines can be found without searching the whole index
+    size_t line = 0;
     while( tokenizer.next() ) {
-        tokens.push_back(tokenizer.current());
+        tokens.push_back( Token{
+                .text = tokenizer.currentTokenText(),
+                .token = tokenizer.currentToken(),
+                .location = tokenizer.lineIndex.location( tokenizer.currentOffset(), line ) } );
     }
 
     return tokens;
 }
 
+std::vector<size_t> Tokenizer::findSplitPoints(size_t numChunks) {
+    std::vector<size_t> splitPoints;
+    if( numChunks<2 )
+        return splitPoints;
+
+    SavedPoint savedPosition = savePosition();
+    size_t savedTokenStart = tokenStart;
+
+    size_t chunkSize = file.size() / numChunks;
+    size_t target = chunkSize;
+    position = 0;
+
+    try {
+        while( splitPoints.size()+1 < numChunks && position<file.size() ) {
+            // Strings and comments can only start with '"' or '/'. Until the next one of those, every new line not
+            // followed by white space is also the start of a token.
+            size_t special = position + Scan::findEitherByte( file.subslice(position), '"', '/' );
+
+            size_t searchStart = position;
+            while( splitPoints.size()+1 < numChunks ) {
+                searchStart = std::max( searchStart, target );
+                if( searchStart>=special )
+                    break;
+
+                size_t newLine = searchStart + Scan::findByte( file.subslice(searchStart, special), '\n' );
+                if( newLine>=special )
+                    break;
+
+                size_t candidate = newLine+1;
+                if( candidate<file.size() && !isWS(file[candidate]) ) {
+                    splitPoints.push_back( candidate );
+                    target = (splitPoints.size()+1) * chunkSize;
+                }
+                searchStart = candidate;
+            }
+
+            if( special>=file.size() )
+                break;
+
+            // Let the tokenizer itself skip over the string, comment or operator
+            position = special;
+            next();
+        }
+    } catch( tokenizer_error & ) {
+        // The file will fail to tokenize. We might as well let that happen in the last chunk we found.
+    }
+
+    restorePosition( savedPosition );
+    tokenStart = savedTokenStart;
+
+    return splitPoints;
+}
+
 void Tokenizer::consumeWS() {
     token = Tokens::WS;
-    while( nextChar() && isWS(file[position]) )
-        ;
+    advance( 1 + Scan::whitespaceRun( file.subslice(position+1) ) );
 }
 
 void Tokenizer::consumeOp() {
     auto startPosition = position;
-    auto startLocation = location;
 
+    // Walk the trie for as long as the text is a prefix of some operator, remembering the longest complete operator
     auto lastIdentified = savePosition();
     bool found = false;
-    bool foundLastRound = false;
 
-    do {
-        if( foundLastRound ) {
-            lastIdentified = savePosition();
-            foundLastRound = false;
-        }
-
-        auto op = file.subslice(startPosition, position+1);
+    uint8_t node = OperatorTrie::Root;
+    while( position<file.size() ) {
+        node = operatorTrie.child( node, file[position] );
+        if( node==OperatorTrie::NoNode )
+            break;
 
-        auto opIter = operators.find(op);
-        if( opIter != operators.end() ) {
-            token = opIter->second;
+        nextChar();
+        if( operatorTrie.token(node)!=Tokens::ERR ) {
+            token = operatorTrie.token(node);
+            lastIdentified = savePosition();
             found = true;
-            foundLastRound = true;
         }
-    } while( nextChar() && operatorChars.find(file[position])!=operatorChars.end() );
-
-    if( foundLastRound ) {
-        lastIdentified = savePosition();
-        foundLastRound = false;
     }
 
     if( !found ) {
         // Man am I going to regret this error message
-        throw tokenizer_error("Practical does not support inventing weird operators", startLocation);
+        throw tokenizer_error("Practical does not support inventing weird operators",
+                lineIndex.location(startPosition));
     }
 
     restorePosition( lastIdentified );
@@ -213,18 +412,18 @@ void Tokenizer::consumeOp() {
     switch( token ) {
     case Tokens::ERR:
         ABORT() << "consumeOp found operator \"" << file.subslice(startPosition, position) << "\" at " <<
-                startLocation << " but token returned was ERR";
+                lineIndex.location(startPosition) << " but token returned was ERR";
         break;
     case Tokens::OP_RUNON_ERROR:
         throw tokenizer_error(
                 "The compiler refuses to guess which combination of operators you meant. Disambiguate the code with spaces",
-                startLocation);
+                lineIndex.location(startPosition));
         break;
     case Tokens::COMMENT_LINE_END:
         consumeLineComment();
         break;
     case Tokens::COMMENT_MULTILINE:
-        consumeNestableComment( SavedPoint{ .location=startLocation, .position=startPosition } );
+        consumeNestableComment( SavedPoint{ .position=startPosition } );
         break;
     default:
         // Successful matching, nothing else to do
@@ -238,7 +437,7 @@ void Tokenizer::consumeStringLiteral() {
         if( file[position]=='\\' ) {
             moreData = nextChar();
         } else if( file[position]=='\n' ) {
-            throw tokenizer_error("Naked new line in string literal", location);
+            throw tokenizer_error("Naked new line in string literal", lineIndex.location(position));
         }
     }
 
@@ -247,63 +446,220 @@ void Tokenizer::consumeStringLiteral() {
         nextChar();
         token = Tokens::LITERAL_STRING;
     } else
-        throw tokenizer_error("Unterminated string", location);
+        throw tokenizer_error("Unterminated string", lineIndex.location(position));
 }
 
-void Tokenizer::consumeNumericLiteral() {
-    SourceLocation startLocation = location;
-    size_t startPos = position;
-    // Consume all relevant characters, whether legal in an integer literal or not. Sort everything else later.
-    while( nextChar() && (isDigit(file[position]) || isIdentifierAlpha(file[position])) ) {
+namespace {
+
+// Character classes relevant to numeric literals. Anything that isn't a digit or an identifier character ends the
+// literal.
+enum class NumericClass : uint8_t {
+    Digit01,
+    Digit27,
+    Digit89,
+    Underscore,
+    LetterB,            // b, B: binary prefix and a hex digit
+    LetterE,            // e, E: exponent and a hex digit
+    LetterHex,          // Remaining hex digits: a, c, d, f, A, C, D, F
+    LetterX,            // x, X: hex prefix
+    LetterO,            // o: octal prefix
+    LetterOther,
+    End,
+
+    NumClasses
+};
+
+enum class NumericState : uint8_t {
+    Zero,               // A lone "0"
+    Decimal,            // [0-9]+
+    DecimalUnderscore,  // [0-9][0-9_]* with at least one underscore
+    ExponentStart,      // [0-9]+[eE]
+    Exponent,           // [0-9]+[eE][0-9_]+
+    HexStart,           // 0[xX]
+    Hex,
+    BinaryStart,        // 0[bB]
+    Binary,
+    OctalStart,         // 0o
+    Octal,
+    Invalid,
+
+    NumStates
+};
+
+static constexpr size_t NumNumericClasses = static_cast<size_t>(NumericClass::NumClasses);
+static constexpr size_t NumNumericStates = static_cast<size_t>(NumericState::NumStates);
+
+constexpr NumericClass classifyNumericChar( unsigned char chr ) {
+    if( chr=='0' || chr=='1' )
+        return NumericClass::Digit01;
+    if( chr>='2' && chr<='7' )
+        return NumericClass::Digit27;
+    if( chr=='8' || chr=='9' )
+        return NumericClass::Digit89;
+    if( chr=='_' )
+        return NumericClass::Underscore;
+    if( chr=='b' || chr=='B' )
+        return NumericClass::LetterB;
+    if( chr=='e' || chr=='E' )
+        return NumericClass::LetterE;
+    if( (chr>='a' && chr<='f') || (chr>='A' && chr<='F') )
+        return NumericClass::LetterHex;
+    if( chr=='x' || chr=='X' )
+        return NumericClass::LetterX;
+    if( chr=='o' )
+        return NumericClass::LetterO;
+    if( (chr>='a' && chr<='z') || (chr>='A' && chr<='Z') )
+        return NumericClass::LetterOther;
+
+    return NumericClass::End;
+}
+
+constexpr NumericState numericTransition( NumericState state, NumericClass cls ) {
+    const bool decimalDigit =
+            cls==NumericClass::Digit01 || cls==NumericClass::Digit27 || cls==NumericClass::Digit89;
+    const bool hexDigit = decimalDigit ||
+            cls==NumericClass::LetterB || cls==NumericClass::LetterE || cls==NumericClass::LetterHex;
+
+    switch( state ) {
+    case NumericState::Zero:
+        if( cls==NumericClass::LetterX )
+            return NumericState::HexStart;
+        if( cls==NumericClass::LetterB )
+            return NumericState::BinaryStart;
+        if( cls==NumericClass::LetterO )
+            return NumericState::OctalStart;
+        [[fallthrough]];
+    case NumericState::Decimal:
+        if( decimalDigit )
+            return NumericState::Decimal;
+        if( cls==NumericClass::Underscore )
+            return NumericState::DecimalUnderscore;
+        if( cls==NumericClass::LetterE )
+            return NumericState::ExponentStart;
+        return NumericState::Invalid;
+    case NumericState::DecimalUnderscore:
+        if( decimalDigit || cls==NumericClass::Underscore )
+            return NumericState::DecimalUnderscore;
+        return NumericState::Invalid;
+    case NumericState::ExponentStart:
+    case NumericState::Exponent:
+        if( decimalDigit || cls==NumericClass::Underscore )
+            return NumericState::Exponent;
+        return NumericState::Invalid;
+    case NumericState::HexStart:
+    case NumericState::Hex:
+        if( hexDigit || cls==NumericClass::Underscore )
+            return NumericState::Hex;
+        return NumericState::Invalid;
+    case NumericState::BinaryStart:
+    case NumericState::Binary:
+        if( cls==NumericClass::Digit01 || cls==NumericClass::Underscore )
+            return NumericState::Binary;
+        return NumericState::Invalid;
+    case NumericState::OctalStart:
+    case NumericState::Octal:
+        // XXX Only 0 and 1 are accepted as octal digits
+        if( cls==NumericClass::Digit01 || cls==NumericClass::Underscore )
+            return NumericState::Octal;
+        return NumericState::Invalid;
+    case NumericState::Invalid:
+    case NumericState::NumStates:
+        break;
     }
 
-    static std::regex re10("^([0-9][0-9_]*)");
-    static std::regex reFp("^(\\.[0-9]+)|(([0-9]+)(\\.([0-9]*))?)([eE][-+]?[0-9_]+)?");
-    static std::regex re16("^0[xX]([0-9a-fA-F_]+)");
-    static std::regex re2("^0[bB]([01_]+)");
-    static std::regex re8("^0[o]([01_]+)");
-
-    const char *start = &file[startPos];
-    // The strange math is to avoid violating bounds checks in case this is the last thing in the file
-    const char *end = file.get() + position;
-    if( std::regex_match( start, end, re10 ) ) {
-        token = Tokens::LITERAL_INT_10;
-    } else if( std::regex_match( start, end, reFp ) ) {
-        token = Tokens::LITERAL_FP;
-    } else if( std::regex_match( start, end, re16 ) ) {
-        token = Tokens::LITERAL_INT_16;
-    } else if( std::regex_match( start, end, re2 ) ) {
-        token = Tokens::LITERAL_INT_2;
-    } else if( std::regex_match( start, end, re8 ) ) {
-        token = Tokens::LITERAL_INT_8;
-    } else {
-        throw tokenizer_error("Invalid numeric literal", startLocation);
+    return NumericState::Invalid;
+}
+
+constexpr Tokens numericAcceptToken( NumericState state ) {
+    switch( state ) {
+    case NumericState::Zero:
+    case NumericState::Decimal:
+    case NumericState::DecimalUnderscore:
+        return Tokens::LITERAL_INT_10;
+    case NumericState::Exponent:
+        return Tokens::LITERAL_FP;
+    case NumericState::Hex:
+        return Tokens::LITERAL_INT_16;
+    case NumericState::Binary:
+        return Tokens::LITERAL_INT_2;
+    case NumericState::Octal:
+        return Tokens::LITERAL_INT_8;
+    default:
+        return Tokens::ERR;
     }
 }
 
-void Tokenizer::consumeIdentifier() {
-    std::string id;
+struct NumericDfa {
+    std::array< NumericClass, 256 > charClass{};
+    std::array< std::array< NumericState, NumNumericClasses >, NumNumericStates > transitions{};
+    std::array< Tokens, NumNumericStates > accept{};
+
+    constexpr NumericDfa() {
+        for( size_t chr=0; chr<charClass.size(); ++chr )
+            charClass[chr] = classifyNumericChar( chr );
+
+        for( size_t state=0; state<NumNumericStates; ++state ) {
+            for( size_t cls=0; cls<NumNumericClasses; ++cls ) {
+                transitions[state][cls] =
+                        numericTransition( static_cast<NumericState>(state), static_cast<NumericClass>(cls) );
+            }
 
-    id += file[position];
-    while( nextChar() && (isIdentifierAlpha(file[position]) || isDigit(file[position])) ) {
-        id += file[position];
+            accept[state] = numericAcceptToken( static_cast<NumericState>(state) );
+        }
     }
+};
 
-    auto tokenIter = reservedWords.find( id );
-    if( tokenIter != reservedWords.end() ) {
-        token = tokenIter->second;
-    } else {
-        token = Tokens::IDENTIFIER;
+static constexpr NumericDfa numericDfa;
+
+// Classify the numeric literal text starts with, and return its length. Every digit or identifier character is part of
+// the literal, whether legal in it or not. Illegal characters drive the state machine to Invalid.
+size_t scanNumericLiteral( String text, Tokens &token ) {
+    NumericState state = text[0]=='0' ? NumericState::Zero : NumericState::Decimal;
+    size_t length = 1;
+    for( ; length<text.size(); ++length ) {
+        NumericClass cls = numericDfa.charClass[ static_cast<unsigned char>(text[length]) ];
+        if( cls==NumericClass::End )
+            break;
+
+        state = numericDfa.transitions[ static_cast<size_t>(state) ][ static_cast<size_t>(cls) ];
     }
+
+    token = numericDfa.accept[ static_cast<size_t>(state) ];
+    return length;
+}
+
+} // anonymous namespace
+
+Tokens Tokenizer::classifyNumericLiteral(String literal) {
+    Tokens token;
+    if( scanNumericLiteral( literal, token )!=literal.size() )
+        return Tokens::ERR;
+
+    return token;
+}
+
+void Tokenizer::consumeNumericLiteral() {
+    size_t startPosition = position;
+
+    advance( scanNumericLiteral( file.subslice(position), token ) );
+    if( token==Tokens::ERR )
+        throw tokenizer_error("Invalid numeric literal", lineIndex.location(startPosition));
+}
+
+void Tokenizer::consumeIdentifier() {
+    size_t startPosition = position;
+    advance( 1 + Scan::identifierRun( file.subslice(position+1) ) );
+
+    token = reservedWords.lookup( file.subslice(startPosition, position) );
 }
 
 void Tokenizer::consumeLineComment() {
-    while( nextChar() && file[position]!='\n' )
-        ;
+    advance( 1 + Scan::findByte( file.subslice(position+1), '\n' ) );
 }
 
 void Tokenizer::consumeNestableComment(SavedPoint startPoint) {
-    while( nextChar() ) {
+    // Only '/' and '*' can open or close a comment. Skip everything else in bulk.
+    while( advance( 1 + Scan::findEitherByte( file.subslice(position+1), '/', '*' ) ) ) {
         SavedPoint recursiveStartPoint = savePosition();
 
         // Nested comment
@@ -316,7 +672,7 @@ void Tokenizer::consumeNestableComment(SavedPoint startPoint) {
         }
     }
 
-    throw tokenizer_error("Unterminated multi-line comment", startPoint.location);
+    throw tokenizer_error("Unterminated multi-line comment", lineIndex.location(startPoint.position));
 }
 
 bool Tokenizer::nextChar() {
@@ -324,22 +680,27 @@ bool Tokenizer::nextChar() {
     if( position>=file.size() )
         return false;
 
-    if( file[position]=='\n' ) {
-        location.col=0;
-        location.line++;
-    }
     position++;
-    location.col++;
+
+    return position<file.size();
+}
+
+bool Tokenizer::advance(size_t count) {
+    // Allow continued calling after EOF already reached
+    if( position>=file.size() )
+        return false;
+
+    ASSERT( position+count<=file.size() ) << "Tokenizer advanced past end of file";
+    position += count;
 
     return position<file.size();
 }
 
 Tokenizer::SavedPoint Tokenizer::savePosition() {
-    return SavedPoint{ .location=location, .position=position };
+    return SavedPoint{ .position=position };
 }
 
 void Tokenizer::restorePosition(Tokenizer::SavedPoint position) {
-    location = position.location;
     this->position = position.position;
 }
 
@@ -9,19 +9,23 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include "line_index.h"
+
 #include <practical/defines.h>
 #include <practical/practical.h>
 #include <practical/slice.h>
 
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 using PracticalSemanticAnalyzer::SourceLocation;
 
 namespace Tokenizer {
 
-enum class Tokens {
+enum class Tokens : uint8_t {
     ERR, // Error in parsing
     WS, // White space
     COMMENT_LINE_END,
@@ -110,19 +114,27 @@ struct Token {
 class Tokenizer {
 private:
     Slice<const char> file;
-    SourceLocation location;
+    LineIndex lineIndex;
     size_t position=0;
-    SourceLocation tokenLocation;
+    size_t tokenStart=0;
     Tokens token;
     Slice<const char> tokenText;
 
+public:
+    // Tokens carry no state from one to the next, so the position is all that is needed to resume tokenizing
     struct SavedPoint {
-        SourceLocation location;
         size_t position;
     };
 
-public:
-    Tokenizer(String file) : file(file), location{ .line=1, .col=1 } {
+    // Length of the longest operator. Recognizing an operator reads up to one character beyond that, even if the
+    // operator found is shorter. All other tokens read at most one character past their end.
+    static constexpr size_t MaxOperatorLength = 3;
+
+    Tokenizer(String file) : file(file), lineIndex(file) {
+    }
+
+    // For when the line index of file is already known
+    Tokenizer(String file, LineIndex lineIndex) : file(file), lineIndex(std::move(lineIndex)) {
     }
 
     bool next();
@@ -141,8 +153,17 @@ public:
         return token;
     }
 
+    // Computed on demand from the line index
     SourceLocation currentLocation() const {
-        return tokenLocation;
+        return lineIndex.location(tokenStart);
+    }
+
+    size_t currentOffset() const {
+        return tokenStart;
+    }
+
+    const LineIndex &getLineIndex() const {
+        return lineIndex;
     }
 
     Slice<const char> currentTokenText() const {
@@ -151,6 +172,17 @@ public:
 
     static std::vector<Token> tokenize(String source);
 
+    // The token a whole numeric literal is, or ERR if it is not a valid one. literal must start with a digit.
+    static Tokens classifyNumericLiteral(String literal);
+
+    // Find up to numChunks-1 offsets at which the file can be split, so that each part can be tokenized
+    // independently and produce the same tokens. Split points are always at the start of a line, outside of strings
+    // and comments, and at the start of a token.
+    std::vector<size_t> findSplitPoints(size_t numChunks);
+
+    SavedPoint savePosition();
+    void restorePosition(SavedPoint position);
+
 private:
     // XXX all of the is* functions here are ASCII
     static bool isWS(char chr) {
@@ -176,8 +208,8 @@ private:
     void consumeNestableComment(SavedPoint startPoint);
 
     bool nextChar();
-    SavedPoint savePosition();
-    void restorePosition(SavedPoint position);
+    // Skip count characters at once
+    bool advance(size_t count);
 };
 
 } // namespace Tokenizer
@@ -0,0 +1,156 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "tokenizer.h"
+#include "tokenizer_scan.h"
+
+#include "bench/bench.h"
+
+#include <practical/errors.h>
+
+#include <regex>
+#include <sstream>
+
+namespace {
+
+// Generate a source consisting almost entirely of numeric literals of all bases
+std::string literalHeavySource( size_t numLiterals ) {
+    static const char *literals[] = {
+        "0", "7", "42", "1_000_000", "18446744073709551615", "0x1f", "0XdeadBEEF", "0x_ff_ff", "0b1010", "0B1111_0000",
+        "0o101", "1e10", "25E3_0", "123456789",
+    };
+    static constexpr size_t NumLiterals = sizeof(literals)/sizeof(literals[0]);
+
+    std::ostringstream source;
+    for( size_t i=0; i<numLiterals; ++i ) {
+        source << literals[i % NumLiterals] << ( i%16 == 15 ? "\n" : " " );
+    }
+
+    return source.str();
+}
+
+// The classification used before the numeric literal scanner became table driven. Kept here as a reference point.
+Tokenizer::Tokens regexClassify( const std::string &literal ) {
+    static std::regex re10("^([0-9][0-9_]*)");
+    static std::regex reFp("^(\\.[0-9]+)|(([0-9]+)(\\.([0-9]*))?)([eE][-+]?[0-9_]+)?");
+    static std::regex re16("^0[xX]([0-9a-fA-F_]+)");
+    static std::regex re2("^0[bB]([01_]+)");
+    static std::regex re8("^0[o]([01_]+)");
+
+    if( std::regex_match( literal, re10 ) )
+        return Tokenizer::Tokens::LITERAL_INT_10;
+    if( std::regex_match( literal, reFp ) )
+        return Tokenizer::Tokens::LITERAL_FP;
+    if( std::regex_match( literal, re16 ) )
+        return Tokenizer::Tokens::LITERAL_INT_16;
+    if( std::regex_match( literal, re2 ) )
+        return Tokenizer::Tokens::LITERAL_INT_2;
+    if( std::regex_match( literal, re8 ) )
+        return Tokenizer::Tokens::LITERAL_INT_8;
+
+    return Tokenizer::Tokens::ERR;
+}
+
+// Generate a source resembling a generated table: long identifiers, deep indentation and comment blocks
+std::string tableLikeSource( size_t numRows ) {
+    std::ostringstream source;
+
+    source << "/* This file is automatically generated.\n * Do not edit.\n */\n";
+    for( size_t i=0; i<numRows; ++i ) {
+        if( i%64 == 0 )
+            source << "\n                // Section " << i/64 << " of the generated lookup table, covering entries " <<
+                    i << " onwards\n";
+        source << "                generated_lookup_table_entry_" << i << "        some_rather_long_field_name_" << i%7 <<
+                " /* row " << i << ", nothing important to see in here */\n";
+    }
+
+    return source.str();
+}
+
+} // Anonymous namespace
+
+BENCHMARK(numericLiterals) {
+    static constexpr size_t NumLiterals = 200000;
+
+    std::string sourceText = literalHeavySource( NumLiterals );
+    String source( sourceText );
+
+    std::vector<Tokenizer::Token> tokens;
+    double tokenizeTime = Bench::measure( [&]() {
+                tokens = Tokenizer::Tokenizer::tokenize( source );
+            } );
+
+    std::vector<std::string> literals;
+    for( const Tokenizer::Token &token : tokens ) {
+        if( token.token!=Tokenizer::Tokens::WS )
+            literals.emplace_back( sliceToString( token.text ) );
+    }
+
+    // Both classifiers are timed on the same, already extracted, literals
+    std::vector<Tokenizer::Tokens> dfaResults( literals.size() );
+    double dfaTime = Bench::measure( [&]() {
+                for( size_t i=0; i<literals.size(); ++i )
+                    dfaResults[i] = Tokenizer::Tokenizer::classifyNumericLiteral( String( literals[i] ) );
+                Bench::doNotOptimize( dfaResults );
+            } );
+
+    std::vector<Tokenizer::Tokens> regexResults( literals.size() );
+    double regexTime = Bench::measure( [&]() {
+                for( size_t i=0; i<literals.size(); ++i )
+                    regexResults[i] = regexClassify( literals[i] );
+                Bench::doNotOptimize( regexResults );
+            } );
+
+    size_t literalIndex = 0;
+    for( const Tokenizer::Token &token : tokens ) {
+        if( token.token==Tokenizer::Tokens::WS )
+            continue;
+
+        if( token.token!=dfaResults[literalIndex] || token.token!=regexResults[literalIndex] ) {
+            std::cerr << "Classification mismatch for literal \"" << token.text << "\"\n";
+            abort();
+        }
+        ++literalIndex;
+    }
+
+    Bench::report( "tokenize whole source (table driven scanner)", tokenizeTime, literals.size(), "literal" );
+    Bench::report( "classify literal (table driven)", dfaTime, literals.size(), "literal" );
+    Bench::report( "classify literal (regex, previous)", regexTime, literals.size(), "literal" );
+}
+
+BENCHMARK(whitespaceIdentifiersComments) {
+    static constexpr size_t NumRows = 100000;
+
+    std::string sourceText = tableLikeSource( NumRows );
+    String source( sourceText );
+
+    static const struct {
+        Tokenizer::Scan::Implementation implementation;
+        const char *name;
+    } implementations[] = {
+        { Tokenizer::Scan::Implementation::Scalar, "tokenize (scalar scanning)" },
+        { Tokenizer::Scan::Implementation::SSE2, "tokenize (SSE2 scanning)" },
+        { Tokenizer::Scan::Implementation::AVX2, "tokenize (AVX2 scanning)" },
+    };
+
+    Tokenizer::Scan::Implementation original = Tokenizer::Scan::activeImplementation();
+    for( const auto &implementation : implementations ) {
+        if( !Tokenizer::Scan::selectImplementation( implementation.implementation ) ) {
+            std::cout << implementation.name << ": not supported on this CPU\n";
+            continue;
+        }
+
+        std::vector<Tokenizer::Token> tokens;
+        double time = Bench::measure( [&]() {
+                    tokens = Tokenizer::Tokenizer::tokenize( source );
+                } );
+
+        Bench::report( implementation.name, time, sourceText.size(), "byte" );
+    }
+    Tokenizer::Scan::selectImplementation( original );
+}
@@ -0,0 +1,374 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "tokenizer_scan.h"
+
+#include <atomic>
+
+#if defined(__x86_64__)
+#define TOKENIZER_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Tokenizer::Scan {
+
+namespace {
+
+struct Kernels {
+    Implementation implementation;
+    size_t (*whitespaceRun)( const char *begin, const char *end );
+    size_t (*identifierRun)( const char *begin, const char *end );
+    size_t (*findByte)( const char *begin, const char *end, char chr );
+    size_t (*findEitherByte)( const char *begin, const char *end, char chr1, char chr2 );
+    NewlineCount (*countNewlines)( const char *begin, const char *end );
+};
+
+// Scalar implementation. Also used for the tails of the vector implementations
+bool isWS( char chr ) {
+    return chr==' ' || chr=='\n' || chr=='\r' || chr=='\t';
+}
+
+bool isIdentifierChar( char chr ) {
+    return (chr>='A' && chr<='Z') || (chr>='a' && chr<='z') || (chr>='0' && chr<='9') || chr=='_';
+}
+
+size_t scalarWhitespaceRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    while( ptr<end && isWS(*ptr) )
+        ++ptr;
+
+    return ptr - begin;
+}
+
+size_t scalarIdentifierRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    while( ptr<end && isIdentifierChar(*ptr) )
+        ++ptr;
+
+    return ptr - begin;
+}
+
+size_t scalarFindByte( const char *begin, const char *end, char chr ) {
+    const char *ptr = begin;
+    while( ptr<end && *ptr!=chr )
+        ++ptr;
+
+    return ptr - begin;
+}
+
+size_t scalarFindEitherByte( const char *begin, const char *end, char chr1, char chr2 ) {
+    const char *ptr = begin;
+    while( ptr<end && *ptr!=chr1 && *ptr!=chr2 )
+        ++ptr;
+
+    return ptr - begin;
+}
+
+NewlineCount scalarCountNewlines( const char *begin, const char *end ) {
+    NewlineCount ret;
+
+    for( const char *ptr = begin; ptr<end; ++ptr ) {
+        if( *ptr=='\n' ) {
+            ret.count++;
+            ret.lastOffset = ptr - begin;
+        }
+    }
+
+    return ret;
+}
+
+const Kernels scalarKernels{
+    Implementation::Scalar,
+    scalarWhitespaceRun, scalarIdentifierRun, scalarFindByte, scalarFindEitherByte, scalarCountNewlines
+};
+
+#if TOKENIZER_SCAN_X86
+// The vector kernels compute a bit mask of the bytes that match, one bit per byte, and then use bit scanning to find
+// the first match. Only whole vectors that lie inside the buffer are loaded. The remainder is handled by the scalar
+// code.
+
+// SSE2 is part of the x86-64 baseline, and needs no run time detection
+__m128i sse2WhitespaceBytes( __m128i data ) {
+    __m128i ws = _mm_or_si128(
+            _mm_cmpeq_epi8( data, _mm_set1_epi8(' ') ),
+            _mm_cmpeq_epi8( data, _mm_set1_epi8('\n') ) );
+    ws = _mm_or_si128( ws, _mm_cmpeq_epi8( data, _mm_set1_epi8('\r') ) );
+    return _mm_or_si128( ws, _mm_cmpeq_epi8( data, _mm_set1_epi8('\t') ) );
+}
+
+__m128i sse2IdentifierBytes( __m128i data ) {
+    // Bytes with the high bit set compare as negative, and so fall outside all of the ranges below
+    __m128i lower = _mm_or_si128( data, _mm_set1_epi8(0x20) );
+    __m128i alpha = _mm_and_si128(
+            _mm_cmpgt_epi8( lower, _mm_set1_epi8('a'-1) ),
+            _mm_cmplt_epi8( lower, _mm_set1_epi8('z'+1) ) );
+    __m128i digit = _mm_and_si128(
+            _mm_cmpgt_epi8( data, _mm_set1_epi8('0'-1) ),
+            _mm_cmplt_epi8( data, _mm_set1_epi8('9'+1) ) );
+    __m128i underscore = _mm_cmpeq_epi8( data, _mm_set1_epi8('_') );
+
+    return _mm_or_si128( _mm_or_si128( alpha, digit ), underscore );
+}
+
+size_t sse2WhitespaceRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    for( ; end-ptr >= 16; ptr += 16 ) {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ptr) );
+        unsigned mismatch = ~_mm_movemask_epi8( sse2WhitespaceBytes(data) ) & 0xffff;
+        if( mismatch!=0 )
+            return ptr - begin + __builtin_ctz(mismatch);
+    }
+
+    return ptr - begin + scalarWhitespaceRun( ptr, end );
+}
+
+size_t sse2IdentifierRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    for( ; end-ptr >= 16; ptr += 16 ) {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ptr) );
+        unsigned mismatch = ~_mm_movemask_epi8( sse2IdentifierBytes(data) ) & 0xffff;
+        if( mismatch!=0 )
+            return ptr - begin + __builtin_ctz(mismatch);
+    }
+
+    return ptr - begin + scalarIdentifierRun( ptr, end );
+}
+
+size_t sse2FindByte( const char *begin, const char *end, char chr ) {
+    const char *ptr = begin;
+    __m128i needle = _mm_set1_epi8(chr);
+    for( ; end-ptr >= 16; ptr += 16 ) {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ptr) );
+        unsigned match = _mm_movemask_epi8( _mm_cmpeq_epi8( data, needle ) );
+        if( match!=0 )
+            return ptr - begin + __builtin_ctz(match);
+    }
+
+    return ptr - begin + scalarFindByte( ptr, end, chr );
+}
+
+size_t sse2FindEitherByte( const char *begin, const char *end, char chr1, char chr2 ) {
+    const char *ptr = begin;
+    __m128i needle1 = _mm_set1_epi8(chr1), needle2 = _mm_set1_epi8(chr2);
+    for( ; end-ptr >= 16; ptr += 16 ) {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ptr) );
+        unsigned match = _mm_movemask_epi8(
+                _mm_or_si128( _mm_cmpeq_epi8( data, needle1 ), _mm_cmpeq_epi8( data, needle2 ) ) );
+        if( match!=0 )
+            return ptr - begin + __builtin_ctz(match);
+    }
+
+    return ptr - begin + scalarFindEitherByte( ptr, end, chr1, chr2 );
+}
+
+NewlineCount sse2CountNewlines( const char *begin, const char *end ) {
+    NewlineCount ret;
+    const char *ptr = begin;
+    __m128i newline = _mm_set1_epi8('\n');
+    for( ; end-ptr >= 16; ptr += 16 ) {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ptr) );
+        unsigned match = _mm_movemask_epi8( _mm_cmpeq_epi8( data, newline ) );
+        if( match!=0 ) {
+            ret.count += __builtin_popcount(match);
+            ret.lastOffset = ptr - begin + 31 - __builtin_clz(match);
+        }
+    }
+
+    NewlineCount tail = scalarCountNewlines( ptr, end );
+    if( tail.count!=0 ) {
+        ret.count += tail.count;
+        ret.lastOffset = ptr - begin + tail.lastOffset;
+    }
+
+    return ret;
+}
+
+const Kernels sse2Kernels{
+    Implementation::SSE2,
+    sse2WhitespaceRun, sse2IdentifierRun, sse2FindByte, sse2FindEitherByte, sse2CountNewlines
+};
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET __m256i avx2WhitespaceBytes( __m256i data ) {
+    __m256i ws = _mm256_or_si256(
+            _mm256_cmpeq_epi8( data, _mm256_set1_epi8(' ') ),
+            _mm256_cmpeq_epi8( data, _mm256_set1_epi8('\n') ) );
+    ws = _mm256_or_si256( ws, _mm256_cmpeq_epi8( data, _mm256_set1_epi8('\r') ) );
+    return _mm256_or_si256( ws, _mm256_cmpeq_epi8( data, _mm256_set1_epi8('\t') ) );
+}
+
+AVX2_TARGET __m256i avx2IdentifierBytes( __m256i data ) {
+    // AVX2 has no signed "less than" byte compare. "a<b" is expressed as "b>a"
+    __m256i lower = _mm256_or_si256( data, _mm256_set1_epi8(0x20) );
+    __m256i alpha = _mm256_and_si256(
+            _mm256_cmpgt_epi8( lower, _mm256_set1_epi8('a'-1) ),
+            _mm256_cmpgt_epi8( _mm256_set1_epi8('z'+1), lower ) );
+    __m256i digit = _mm256_and_si256(
+            _mm256_cmpgt_epi8( data, _mm256_set1_epi8('0'-1) ),
+            _mm256_cmpgt_epi8( _mm256_set1_epi8('9'+1), data ) );
+    __m256i underscore = _mm256_cmpeq_epi8( data, _mm256_set1_epi8('_') );
+
+    return _mm256_or_si256( _mm256_or_si256( alpha, digit ), underscore );
+}
+
+AVX2_TARGET size_t avx2WhitespaceRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    for( ; end-ptr >= 32; ptr += 32 ) {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ptr) );
+        unsigned mismatch = ~static_cast<unsigned>( _mm256_movemask_epi8( avx2WhitespaceBytes(data) ) );
+        if( mismatch!=0 )
+            return ptr - begin + __builtin_ctz(mismatch);
+    }
+
+    return ptr - begin + sse2WhitespaceRun( ptr, end );
+}
+
+AVX2_TARGET size_t avx2IdentifierRun( const char *begin, const char *end ) {
+    const char *ptr = begin;
+    for( ; end-ptr >= 32; ptr += 32 ) {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ptr) );
+        unsigned mismatch = ~static_cast<unsigned>( _mm256_movemask_epi8( avx2IdentifierBytes(data) ) );
+        if( mismatch!=0 )
+            return ptr - begin + __builtin_ctz(mismatch);
+    }
+
+    return ptr - begin + sse2IdentifierRun( ptr, end );
+}
+
+AVX2_TARGET size_t avx2FindByte( const char *begin, const char *end, char chr ) {
+    const char *ptr = begin;
+    __m256i needle = _mm256_set1_epi8(chr);
+    for( ; end-ptr >= 32; ptr += 32 ) {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ptr) );
+        unsigned match = _mm256_movemask_epi8( _mm256_cmpeq_epi8( data, needle ) );
+        if( match!=0 )
+            return ptr - begin + __builtin_ctz(match);
+    }
+
+    return ptr - begin + sse2FindByte( ptr, end, chr );
+}
+
+AVX2_TARGET size_t avx2FindEitherByte( const char *begin, const char *end, char chr1, char chr2 ) {
+    const char *ptr = begin;
+    __m256i needle1 = _mm256_set1_epi8(chr1), needle2 = _mm256_set1_epi8(chr2);
+    for( ; end-ptr >= 32; ptr += 32 ) {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ptr) );
+        unsigned match = _mm256_movemask_epi8(
+                _mm256_or_si256( _mm256_cmpeq_epi8( data, needle1 ), _mm256_cmpeq_epi8( data, needle2 ) ) );
+        if( match!=0 )
+            return ptr - begin + __builtin_ctz(match);
+    }
+
+    return ptr - begin + sse2FindEitherByte( ptr, end, chr1, chr2 );
+}
+
+AVX2_TARGET NewlineCount avx2CountNewlines( const char *begin, const char *end ) {
+    NewlineCount ret;
+    const char *ptr = begin;
+    __m256i newline = _mm256_set1_epi8('\n');
+    for( ; end-ptr >= 32; ptr += 32 ) {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ptr) );
+        unsigned match = _mm256_movemask_epi8( _mm256_cmpeq_epi8( data, newline ) );
+        if( match!=0 ) {
+            ret.count += __builtin_popcount(match);
+            ret.lastOffset = ptr - begin + 31 - __builtin_clz(match);
+        }
+    }
+
+    NewlineCount tail = sse2CountNewlines( ptr, end );
+    if( tail.count!=0 ) {
+        ret.count += tail.count;
+        ret.lastOffset = ptr - begin + tail.lastOffset;
+    }
+
+    return ret;
+}
+
+#undef AVX2_TARGET
+
+const Kernels avx2Kernels{
+    Implementation::AVX2,
+    avx2WhitespaceRun, avx2IdentifierRun, avx2FindByte, avx2FindEitherByte, avx2CountNewlines
+};
+#endif // TOKENIZER_SCAN_X86
+
+const Kernels *kernelsFor( Implementation implementation ) {
+    switch( implementation ) {
+    case Implementation::Scalar:
+        return &scalarKernels;
+#if TOKENIZER_SCAN_X86
+    case Implementation::SSE2:
+        return &sse2Kernels;
+    case Implementation::AVX2:
+        if( __builtin_cpu_supports("avx2") )
+            return &avx2Kernels;
+        break;
+#else
+    default:
+        break;
+#endif
+    }
+
+    return nullptr;
+}
+
+const Kernels *bestKernels() {
+    for( Implementation implementation : { Implementation::AVX2, Implementation::SSE2 } ) {
+        const Kernels *kernels = kernelsFor( implementation );
+        if( kernels!=nullptr )
+            return kernels;
+    }
+
+    return &scalarKernels;
+}
+
+// Tokenizing threads read it while selectImplementation may change it. The kernels themselves are constants, so relaxed
+// access is enough.
+std::atomic<const Kernels *> activeKernels{ bestKernels() };
+
+const Kernels *currentKernels() {
+    return activeKernels.load( std::memory_order_relaxed );
+}
+
+} // Anonymous namespace
+
+size_t whitespaceRun( Slice<const char> text ) {
+    return currentKernels()->whitespaceRun( text.begin(), text.end() );
+}
+
+size_t identifierRun( Slice<const char> text ) {
+    return currentKernels()->identifierRun( text.begin(), text.end() );
+}
+
+size_t findByte( Slice<const char> text, char chr ) {
+    return currentKernels()->findByte( text.begin(), text.end(), chr );
+}
+
+size_t findEitherByte( Slice<const char> text, char chr1, char chr2 ) {
+    return currentKernels()->findEitherByte( text.begin(), text.end(), chr1, chr2 );
+}
+
+NewlineCount countNewlines( Slice<const char> text ) {
+    return currentKernels()->countNewlines( text.begin(), text.end() );
+}
+
+Implementation activeImplementation() {
+    return currentKernels()->implementation;
+}
+
+bool selectImplementation( Implementation implementation ) {
+    const Kernels *kernels = kernelsFor( implementation );
+    if( kernels==nullptr )
+        return false;
+
+    activeKernels.store( kernels, std::memory_order_relaxed );
+    return true;
+}
+
+} // namespace Tokenizer::Scan
@@ -0,0 +1,48 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef TOKENIZER_SCAN_H
+#define TOKENIZER_SCAN_H
+
+#include <practical/slice.h>
+
+#include <cstddef>
+
+// Bulk character scanning kernels used by the tokenizer's hot loops.
+//
+// On x86-64 the kernels process 16 (SSE2) or 32 (AVX2) bytes per step. The AVX2 variant is selected at run time
+// when the CPU supports it. On other architectures a scalar implementation is used.
+namespace Tokenizer::Scan {
+
+enum class Implementation { Scalar, SSE2, AVX2 };
+
+struct NewlineCount {
+    size_t count = 0;
+    // Offset of the last newline character. Only meaningful if count is not 0
+    size_t lastOffset = 0;
+};
+
+// Length of the prefix of text made entirely of white space characters (space, tab, CR and LF)
+size_t whitespaceRun( Slice<const char> text );
+// Length of the prefix of text made entirely of identifier characters ([A-Za-z0-9_])
+size_t identifierRun( Slice<const char> text );
+// Offset of the first occurance of chr in text, or text.size() if not found
+size_t findByte( Slice<const char> text, char chr );
+// Offset of the first occurance of either chr1 or chr2 in text, or text.size() if neither is found
+size_t findEitherByte( Slice<const char> text, char chr1, char chr2 );
+NewlineCount countNewlines( Slice<const char> text );
+
+// The implementation currently in use
+Implementation activeImplementation();
+// Force a specific implementation. Returns false (and changes nothing) if the CPU doesn't support it. Safe to call
+// while other threads tokenize.
+bool selectImplementation( Implementation implementation );
+
+} // namespace Tokenizer::Scan
+
+#endif // TOKENIZER_SCAN_H
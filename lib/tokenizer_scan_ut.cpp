@@ -0,0 +1,92 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "tokenizer_scan.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <random>
+#include <string>
+
+using namespace Tokenizer;
+
+class TokenizerScanTest : public CppUnit::TestFixture  {
+    struct Results {
+        size_t whitespaceRun, identifierRun, findByte, findEitherByte;
+        Scan::NewlineCount newlines;
+    };
+
+    static Results scan( Slice<const char> text ) {
+        Results results;
+        results.whitespaceRun = Scan::whitespaceRun( text );
+        results.identifierRun = Scan::identifierRun( text );
+        results.findByte = Scan::findByte( text, '\n' );
+        results.findEitherByte = Scan::findEitherByte( text, '/', '*' );
+        results.newlines = Scan::countNewlines( text );
+
+        return results;
+    }
+
+    // Compare each vector implementation against the scalar one over every offset and length of a random buffer, so
+    // that matches fall in all vector lanes as well as in the scalar tails
+    void compareImplementations() {
+        // Runs are long enough to cross vector boundaries. Includes characters adjacent to the classified ranges
+        static const char *fragments[] = {
+            " ", "\n", "\r\n", "\t", "  \n    ", "a", "Z", "_", "09", "identifier_123", "/", "*", "/*", "*/", "@", "[",
+            "`", "{", ":", "\x80", "\xff", "\x7f",
+        };
+        static constexpr size_t NumFragments = sizeof(fragments)/sizeof(fragments[0]);
+
+        std::mt19937 random(1);
+        std::string buffer;
+        while( buffer.size()<300 ) {
+            const char *fragment = fragments[ random() % NumFragments ];
+            size_t repeat = random() % 40 + 1;
+            for( size_t i=0; i<repeat; ++i )
+                buffer += fragment;
+        }
+
+        Scan::Implementation original = Scan::activeImplementation();
+        for( Scan::Implementation implementation : { Scan::Implementation::SSE2, Scan::Implementation::AVX2 } ) {
+            for( size_t start=0; start<buffer.size(); ++start ) {
+                for( size_t end=start; end<=buffer.size() && end-start<=100; ++end ) {
+                    Slice<const char> text( buffer.c_str()+start, end-start );
+
+                    CPPUNIT_ASSERT( Scan::selectImplementation( Scan::Implementation::Scalar ) );
+                    Results expected = scan( text );
+
+                    if( !Scan::selectImplementation( implementation ) )
+                        continue;
+                    Results actual = scan( text );
+
+                    CPPUNIT_ASSERT_EQUAL( expected.whitespaceRun, actual.whitespaceRun );
+                    CPPUNIT_ASSERT_EQUAL( expected.identifierRun, actual.identifierRun );
+                    CPPUNIT_ASSERT_EQUAL( expected.findByte, actual.findByte );
+                    CPPUNIT_ASSERT_EQUAL( expected.findEitherByte, actual.findEitherByte );
+                    CPPUNIT_ASSERT_EQUAL( expected.newlines.count, actual.newlines.count );
+                    if( expected.newlines.count!=0 )
+                        CPPUNIT_ASSERT_EQUAL( expected.newlines.lastOffset, actual.newlines.lastOffset );
+                }
+            }
+        }
+
+        Scan::selectImplementation( original );
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "TokenizerScanTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerScanTest>(
+                    "compareImplementations",
+                    &TokenizerScanTest::compareImplementations ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TokenizerScanTest );
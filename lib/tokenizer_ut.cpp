@@ -7,6 +7,7 @@
  * home directory.
  */
 #include "tokenizer.h"
+#include "token_stream.h"
 
 #include "mmap.h"
 #include "ut/dirscan.h"
@@ -16,6 +17,8 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <algorithm>
+#include <memory>
+#include <random>
 #include <regex>
 
 class TokenizerTest : public CppUnit::TestFixture  {
@@ -222,6 +225,196 @@ class TokenizerTest : public CppUnit::TestFixture  {
         }
     }
 
+    void tokenStream() {
+        static const char source[] = "def main() -> U32 { // Comment\n    /* Another */ return 0; }\n";
+
+        std::vector<Tokenizer::Token> allTokens = Tokenizer::Tokenizer::tokenize( source );
+        Tokenizer::TokenStream stream = Tokenizer::TokenStream::tokenize( source );
+
+        CPPUNIT_ASSERT_EQUAL( allTokens.size(), stream.size() + stream.getTrivia().size() );
+
+        size_t significant = 0, trivia = 0;
+        for( const Tokenizer::Token &token : allTokens ) {
+            if( Tokenizer::TokenStream::isTrivia( token.token ) ) {
+                const Tokenizer::TokenStream::Trivia &entry = stream.getTrivia()[trivia++];
+                CPPUNIT_ASSERT_EQUAL( token.token, entry.kind );
+                CPPUNIT_ASSERT_EQUAL( size_t(token.text.get() - source), size_t(entry.offset) );
+                CPPUNIT_ASSERT_EQUAL( token.text.size(), size_t(entry.length) );
+            } else {
+                // What the parser sees of the token
+                Tokenizer::TokenRef parserToken = Tokenizer::TokenSlice( stream )[significant++];
+                CPPUNIT_ASSERT_EQUAL( token.token, parserToken.kind() );
+                CPPUNIT_ASSERT( token.text.get()==parserToken.text().get() );
+                CPPUNIT_ASSERT_EQUAL( token.text.size(), parserToken.text().size() );
+                CPPUNIT_ASSERT_EQUAL( token.location, parserToken.location() );
+            }
+        }
+    }
+
+    static void compareStreams( const Tokenizer::TokenStream &expected, const Tokenizer::TokenStream &actual ) {
+        CPPUNIT_ASSERT_EQUAL( expected.size(), actual.size() );
+        for( size_t i=0; i<expected.size(); ++i ) {
+            CPPUNIT_ASSERT_EQUAL( expected.kind(i), actual.kind(i) );
+            CPPUNIT_ASSERT_EQUAL( expected.offset(i), actual.offset(i) );
+            CPPUNIT_ASSERT_EQUAL( expected.length(i), actual.length(i) );
+            CPPUNIT_ASSERT_EQUAL( expected.location(i), actual.location(i) );
+        }
+
+        CPPUNIT_ASSERT_EQUAL( expected.getTrivia().size(), actual.getTrivia().size() );
+        for( size_t i=0; i<expected.getTrivia().size(); ++i ) {
+            CPPUNIT_ASSERT_EQUAL( expected.getTrivia()[i].kind, actual.getTrivia()[i].kind );
+            CPPUNIT_ASSERT_EQUAL( expected.getTrivia()[i].offset, actual.getTrivia()[i].offset );
+            CPPUNIT_ASSERT_EQUAL( expected.getTrivia()[i].length, actual.getTrivia()[i].length );
+        }
+    }
+
+    void parallelTokenStream() {
+        // Multi-line comments and strings make a lot of the new lines in here unsafe to split at
+        static const char *fragments[] = {
+            "def function() -> U32 {\n",
+            "    return 12;\n",
+            "}\n",
+            "/* Multi line\ncomment /* with a nested\n comment */ in it\n*/\n",
+            "    \"A string with an escaped \\\nnew line\";\n",
+            "// Line comment /* not a multi line one\n",
+            "\n\n",
+        };
+        static constexpr size_t NumFragments = sizeof(fragments)/sizeof(fragments[0]);
+
+        std::string source;
+        for( size_t i=0; source.size() < 4*1024*1024; ++i )
+            source += fragments[ (i*i + i/3) % NumFragments ];
+
+        Tokenizer::TokenStream sequential = Tokenizer::TokenStream::tokenize( source, 1 );
+        for( unsigned threads : { 2, 3, 7 } ) {
+            Tokenizer::TokenStream parallel = Tokenizer::TokenStream::tokenize( source, threads );
+
+            compareStreams( sequential, parallel );
+            CPPUNIT_ASSERT_EQUAL( sequential.getLineIndex().numLines(), parallel.getLineIndex().numLines() );
+        }
+
+        // Split points must be at a token start
+        Tokenizer::Tokenizer splitter( source );
+        std::vector<size_t> splitPoints = splitter.findSplitPoints( 7 );
+        CPPUNIT_ASSERT_EQUAL( size_t(6), splitPoints.size() );
+        size_t trivia = 0, token = 0;
+        for( size_t splitPoint : splitPoints ) {
+            while( token<sequential.size() && sequential.offset(token)<splitPoint )
+                token++;
+            while( trivia<sequential.getTrivia().size() && sequential.getTrivia()[trivia].offset<splitPoint )
+                trivia++;
+
+            CPPUNIT_ASSERT(
+                    ( token<sequential.size() && sequential.offset(token)==splitPoint ) ||
+                    ( trivia<sequential.getTrivia().size() && sequential.getTrivia()[trivia].offset==splitPoint ) );
+        }
+    }
+
+    void incrementalTokenStream() {
+        // A single edit inside a literal only changes that literal
+        {
+            static const char source[] = "def main() -> U32 {\n    return 1 + 2;\n}\n";
+            static const char edited[] = "def main() -> U32 {\n    return 13 + 2;\n}\n";
+            Tokenizer::TokenStream stream = Tokenizer::TokenStream::tokenize( source );
+            Tokenizer::TokenStream::Update update = stream.retokenize(
+                    edited, Tokenizer::TokenStream::Edit{ .offset=32, .removedLength=0, .insertedText="3" } );
+
+            compareStreams( Tokenizer::TokenStream::tokenize( edited ), update.stream );
+            CPPUNIT_ASSERT_EQUAL( size_t(8), update.firstChanged );
+            CPPUNIT_ASSERT_EQUAL( size_t(9), update.oldEnd );
+            CPPUNIT_ASSERT_EQUAL( size_t(9), update.newEnd );
+        }
+
+        // Random edits, including ones that open and close comments and strings
+        static const char *fragments[] = {
+            "def", "a", "1", "0x", "e", " ", "\n", "/", "*", "/*", "*/", "//", "\"", "+", "=", "<", ">", "-", "(", ")",
+            "{", ";", "@",
+        };
+        static constexpr size_t NumFragments = sizeof(fragments)/sizeof(fragments[0]);
+
+        std::mt19937 random(1);
+        // Streams refer to their source, so alternate between two buffers
+        std::string sources[2];
+        unsigned current = 0;
+        sources[current] = "def function(a : U32) -> U32 {\n    return a<<2 + 0x1e;\n}\n/* Comment */ \"string\"\n";
+        Tokenizer::TokenStream stream = Tokenizer::TokenStream::tokenize( sources[current] );
+
+        for( unsigned iteration=0; iteration<2000; ++iteration ) {
+            const std::string &source = sources[current];
+            std::string &edited = sources[1-current];
+
+            // Never touch the final new line, so that the file never ends inside a token
+            size_t offset = random() % source.size();
+            size_t removedLength = std::min<size_t>( random() % 5, source.size() - 1 - offset );
+            std::string inserted;
+            for( unsigned i = random() % 5; i>0; --i )
+                inserted += fragments[ random() % NumFragments ];
+
+            edited = source.substr( 0, offset ) + inserted + source.substr( offset + removedLength );
+
+            std::unique_ptr<Tokenizer::TokenStream> expected;
+            try {
+                expected = std::make_unique<Tokenizer::TokenStream>( Tokenizer::TokenStream::tokenize( edited ) );
+            } catch( PracticalSemanticAnalyzer::tokenizer_error & ) {
+            }
+
+            Tokenizer::TokenStream::Edit edit{
+                .offset=offset, .removedLength=removedLength, .insertedText=String(edited).subslice(offset, offset + inserted.size()) };
+            try {
+                Tokenizer::TokenStream::Update update = stream.retokenize( edited, edit );
+                CPPUNIT_ASSERT_MESSAGE( "Incremental tokenization succeeded where full tokenization failed", expected );
+                compareStreams( *expected, update.stream );
+
+                CPPUNIT_ASSERT( update.firstChanged<=update.oldEnd && update.firstChanged<=update.newEnd );
+                CPPUNIT_ASSERT_EQUAL( stream.size() - update.oldEnd, update.stream.size() - update.newEnd );
+                for( size_t i=0; i<update.firstChanged; ++i ) {
+                    CPPUNIT_ASSERT_EQUAL( stream.kind(i), update.stream.kind(i) );
+                    CPPUNIT_ASSERT_EQUAL( stream.text(i), update.stream.text(i) );
+                }
+                for( size_t i=0; update.oldEnd+i<stream.size(); ++i ) {
+                    CPPUNIT_ASSERT_EQUAL( stream.kind(update.oldEnd+i), update.stream.kind(update.newEnd+i) );
+                    CPPUNIT_ASSERT_EQUAL( stream.text(update.oldEnd+i), update.stream.text(update.newEnd+i) );
+                }
+
+                stream = update.stream;
+                current = 1-current;
+            } catch( PracticalSemanticAnalyzer::tokenizer_error & ) {
+                CPPUNIT_ASSERT_MESSAGE( "Incremental tokenization failed where full tokenization succeeded", !expected );
+            }
+        }
+    }
+
+    void lineIndex() {
+        static const char source[] = "ab\n\ncd\r\n\tx\n";
+        Tokenizer::LineIndex index( source );
+
+        CPPUNIT_ASSERT_EQUAL( size_t(5), index.numLines() );
+
+        static const SourceLocation expected[] = {
+            { 1, 1 }, { 1, 2 }, { 1, 3 },
+            { 2, 1 },
+            { 3, 1 }, { 3, 2 }, { 3, 3 }, { 3, 4 },
+            { 4, 1 }, { 4, 2 }, { 4, 3 },
+            { 5, 1 },
+        };
+        static_assert( sizeof(expected)/sizeof(expected[0]) == sizeof(source), "Test data size mismatch" );
+
+        size_t line = 0;
+        for( size_t offset=0; offset<sizeof(source); ++offset ) {
+            CPPUNIT_ASSERT_EQUAL( expected[offset], index.location(offset) );
+            CPPUNIT_ASSERT_EQUAL( expected[offset], index.location(offset, line) );
+        }
+
+        // The same text, indexed in two parts split after a new line
+        static constexpr size_t SplitPoint = 4;
+        Tokenizer::LineIndex merged( String( source, SplitPoint ) );
+        merged.append( Tokenizer::LineIndex( String( source+SplitPoint, sizeof(source)-SplitPoint ) ), SplitPoint );
+
+        CPPUNIT_ASSERT_EQUAL( index.numLines(), merged.numLines() );
+        for( size_t offset=0; offset<sizeof(source); ++offset )
+            CPPUNIT_ASSERT_EQUAL( expected[offset], merged.location(offset) );
+    }
+
 public:
     static CppUnit::Test *suite()
     {
@@ -229,6 +422,18 @@ public:
         suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerTest>(
                     "test",
                     &TokenizerTest::test ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerTest>(
+                    "tokenStream",
+                    &TokenizerTest::tokenStream ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerTest>(
+                    "parallelTokenStream",
+                    &TokenizerTest::parallelTokenStream ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerTest>(
+                    "incrementalTokenStream",
+                    &TokenizerTest::incrementalTokenStream ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<TokenizerTest>(
+                    "lineIndex",
+                    &TokenizerTest::lineIndex ) );
         return suiteOfTests;
     }
 };
@@ -0,0 +1,33 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef UT_NESTED_SOURCE_H
+#define UT_NESTED_SOURCE_H
+
+#include <string>
+
+namespace UT {
+
+// A function of x whose body is open depth times, then inner, then close depth times
+inline std::string nested(const std::string &open, const std::string &inner, const std::string &close, size_t depth)
+{
+    std::string source = "def f( x : U8 ) -> U64 {\n  ";
+    source.reserve( source.size() + depth*( open.size() + close.size() ) + inner.size() + 4 );
+    for( size_t i=0; i<depth; ++i )
+        source += open;
+    source += inner;
+    for( size_t i=0; i<depth; ++i )
+        source += close;
+    source += "\n}\n";
+
+    return source;
+}
+
+} // namespace UT
+
+#endif // UT_NESTED_SOURCE_H
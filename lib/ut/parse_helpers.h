@@ -0,0 +1,59 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef UT_PARSE_HELPERS_H
+#define UT_PARSE_HELPERS_H
+
+#include "ut/nested_source.h"
+
+#include "parser/module.h"
+
+#include <practical/practical.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <utility>
+
+namespace UT {
+
+using PracticalSemanticAnalyzer::CompilerArguments;
+
+// Compiler arguments with a single field changed from its default
+template<typename T, typename V>
+CompilerArguments arguments(T CompilerArguments::*field, V value)
+{
+    CompilerArguments result;
+    result.*field = value;
+
+    return result;
+}
+
+inline void parse(
+        NonTerminals::Module &module,
+        const std::string &source,
+        const CompilerArguments &arguments = CompilerArguments())
+{
+    module.parse( String(source.c_str(), source.size()), arguments );
+}
+
+// Run code, which must throw Error, and return the error thrown
+template<typename Error, typename Code>
+Error expectThrow(Code code, const std::string &failMessage) {
+    try {
+        code();
+    } catch( Error &error ) {
+        return std::move( error );
+    }
+
+    CPPUNIT_FAIL( failMessage );
+}
+
+} // namespace UT
+
+#endif // UT_PARSE_HELPERS_H
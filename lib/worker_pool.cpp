@@ -0,0 +1,108 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+struct WorkerPool::Batch {
+    const std::function<void(size_t)> &job;
+    const size_t numJobs;
+    // The next job to start
+    std::atomic<size_t> next{0};
+
+    std::mutex lock;
+    std::condition_variable allFinished;
+    size_t finished = 0;
+
+    Batch(const std::function<void(size_t)> &job, size_t numJobs) : job(job), numJobs(numJobs) {}
+
+    bool exhausted() const {
+        return next.load( std::memory_order_relaxed )>=numJobs;
+    }
+};
+
+WorkerPool::WorkerPool(unsigned numWorkers) {
+    workers.reserve( numWorkers );
+    for( unsigned i=0; i<numWorkers; ++i )
+        workers.emplace_back( &WorkerPool::workerLoop, this );
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for( std::thread &worker : workers )
+        worker.join();
+}
+
+WorkerPool &WorkerPool::get() {
+    static WorkerPool pool( std::max( std::thread::hardware_concurrency(), 1u ) - 1 );
+
+    return pool;
+}
+
+void WorkerPool::run(size_t numJobs, const std::function<void(size_t)> &job) {
+    if( numJobs==0 )
+        return;
+
+    auto batch = std::make_shared<Batch>( job, numJobs );
+    if( numJobs>1 && !workers.empty() ) {
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            pending.push_back( batch );
+        }
+        wake.notify_all();
+    }
+
+    // Whatever the workers are busy with, the batch gets done by this thread if no one else
+    work( *batch );
+
+    std::unique_lock<std::mutex> guard( batch->lock );
+    batch->allFinished.wait( guard, [&]() { return batch->finished==numJobs; } );
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> guard( lock );
+    while( true ) {
+        wake.wait( guard, [this]() { return stopping || !pending.empty(); } );
+        if( stopping )
+            return;
+
+        std::shared_ptr<Batch> batch = pending.front();
+        if( batch->exhausted() ) {
+            // Its last jobs may still be running, but they no longer need workers
+            pending.pop_front();
+            continue;
+        }
+
+        guard.unlock();
+        work( *batch );
+        guard.lock();
+    }
+}
+
+void WorkerPool::work(Batch &batch) {
+    size_t done = 0;
+    for( size_t index = batch.next++; index<batch.numJobs; index = batch.next++ ) {
+        batch.job( index );
+        done++;
+    }
+
+    if( done==0 )
+        return;
+
+    std::lock_guard<std::mutex> guard( batch.lock );
+    batch.finished += done;
+    if( batch.finished==batch.numJobs )
+        batch.allFinished.notify_all();
+}
@@ -0,0 +1,53 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * To the extent header files enjoy copyright protection, this file is file is copyright (C) 2020 by its authors
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "nocopy.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads shared by all compilations, so that parsing a module in parallel does not start threads of its own. There is
+// one less worker than the hardware has threads, as the thread asking for the work does its share of it.
+class WorkerPool : private NoCopy {
+    struct Batch;
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    // Batches that may still have jobs no one started
+    std::deque< std::shared_ptr<Batch> > pending;
+    bool stopping = false;
+
+public:
+    explicit WorkerPool(unsigned numWorkers);
+    ~WorkerPool();
+
+    static WorkerPool &get();
+
+    size_t numWorkers() const {
+        return workers.size();
+    }
+
+    // Call job(i) for every i from 0 to numJobs-1, on the workers and on the calling thread. Returns once all calls have
+    // returned. Jobs must not throw. Thread safe.
+    void run(size_t numJobs, const std::function<void(size_t)> &job);
+
+private:
+    void workerLoop();
+    static void work(Batch &batch);
+};
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,73 @@
+/* This file is part of the Practical programming langauge. https://github.com/Practical/practical-sa
+ *
+ * This file is file is copyright (C) 2020 by its authors.
+ * You can see the file's authors in the AUTHORS file in the project's home repository.
+ *
+ * This is available under the Boost license. The license's text is available under the LICENSE file in the project's
+ * home directory.
+ */
+#include "worker_pool.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class WorkerPoolTest : public CppUnit::TestFixture  {
+    // Run numJobs jobs, and check each ran exactly once
+    static void runJobs( WorkerPool &pool, size_t numJobs ) {
+        std::vector< std::atomic<unsigned> > runs( numJobs );
+        pool.run( numJobs, [&]( size_t job ) { runs[job]++; } );
+
+        for( const std::atomic<unsigned> &count : runs )
+            CPPUNIT_ASSERT( count==1 );
+    }
+
+    void allJobsRun() {
+        WorkerPool pool( 3 );
+
+        runJobs( pool, 0 );
+        runJobs( pool, 1 );
+        runJobs( pool, 1000 );
+    }
+
+    void noWorkers() {
+        WorkerPool pool( 0 );
+
+        runJobs( pool, 100 );
+    }
+
+    void concurrentRuns() {
+        WorkerPool pool( 3 );
+
+        std::vector<std::thread> threads;
+        for( unsigned i=0; i<4; ++i ) {
+            threads.emplace_back( [&pool]() {
+                        for( unsigned run=0; run<50; ++run )
+                            runJobs( pool, 100 );
+                    } );
+        }
+
+        for( std::thread &thread : threads )
+            thread.join();
+    }
+
+public:
+    static CppUnit::Test *suite()
+    {
+        CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "WorkerPoolTest" );
+        suiteOfTests->addTest( new CppUnit::TestCaller<WorkerPoolTest>(
+                    "allJobsRun",
+                    &WorkerPoolTest::allJobsRun ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<WorkerPoolTest>(
+                    "noWorkers",
+                    &WorkerPoolTest::noWorkers ) );
+        suiteOfTests->addTest( new CppUnit::TestCaller<WorkerPoolTest>(
+                    "concurrentRuns",
+                    &WorkerPoolTest::concurrentRuns ) );
+        return suiteOfTests;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( WorkerPoolTest );